@@ -0,0 +1,18 @@
+#!/bin/sh
+
+# Write the C source embedding the given builtins in tpcc, with the
+# builtins each one calls, so a compilation writes only the used ones
+
+echo "// generated from $* by $0"
+echo '#include "builtins.h"'
+echo
+echo 'const EmbeddedBuiltin embedded_builtins[] = {'
+for f in "$@"; do
+    calls=$(grep -o '\<call[[:space:]]\+[A-Za-z_][A-Za-z0-9_]*' "$f" | awk '{print $2}' | sort -u \
+            | sed 's/.*/"&", /' | tr -d '\n')
+    echo "    {\"$(basename "$f" .asm)\", (const char*[]){${calls}NULL},"
+    sed 's/\r$//; s/\\/\\\\/g; s/"/\\"/g; s/^/     "/; s/$/\\n"/' "$f"
+    echo '    },'
+done
+echo '    {NULL, NULL, NULL}'
+echo '};'
@@ -0,0 +1,55 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#define ARENA_CHUNK_SIZE 65536
+
+typedef struct Chunk {          // block of memory owned by an arena
+    struct Chunk* next;         // next chunk of the arena
+    size_t size;                // usable size of the chunk
+    size_t used;                // bytes already given in the chunk
+    max_align_t data[];         // memory given by the arena
+} Chunk;
+
+typedef struct {                // bump-pointer allocator
+    Chunk* first;               // first chunk, where allocation restarts
+    Chunk* current;             // chunk where memory is given
+    size_t bytes;               // bytes given since the last reset
+    size_t nb_chunks;           // number of owned chunks
+} Arena;
+
+/**
+ * @brief Initiate an empty arena. Chunks are allocated when needed
+ * 
+ * @param arena arena to initiate
+ */
+void init_arena(Arena* arena);
+
+/**
+ * @brief Give memory from an arena. Memory is only freed when the whole
+ *        arena is reset or freed
+ * 
+ * @param arena arena giving memory
+ * @param size number of bytes
+ * @return pointer to the memory, aligned for any type
+ *         NULL if fail due to memory error
+ */
+void* arena_alloc(Arena* arena, size_t size);
+
+/**
+ * @brief Give back every memory of an arena at once. Chunks are kept to be
+ *        reused by the next allocations
+ * 
+ * @param arena arena to reset
+ */
+void reset_arena(Arena* arena);
+
+/**
+ * @brief Free chunks owned by an arena
+ * 
+ * @param arena arena to free
+ */
+void free_arena(Arena* arena);
+
+#endif
@@ -4,14 +4,33 @@
 #include <stdbool.h>
 #include <stdio.h>
 
+#include "context.h"
+
 typedef struct {
     bool help;
     bool tree;
     bool err;
     bool symbols;
-    char* name;
+    bool stats;         // print statistics of compilations
+    bool tokens;        // print tokens of the given file
+    bool fast_lexer;    // scan with the hand-written lexer instead of flex
+    bool stream;        // compile each function as soon as it is parsed
+    bool cache_stats;   // print statistics of the cache
+    CommentLevel comments; // comments written in the nasm
+    OutputFormat format; // file written for each source
+    CodegenMode codegen; // generation of the nasm of functions
+    bool dump_ir;       // print the IR of each function
+    bool perf_map;      // write the perf map of the program run in memory
+    char* cache_dir;    // directory of the cached functions, NULL if none
+    char* server;       // socket to serve compile requests on, NULL if none
+    char* client;       // socket of the server compiling the files, NULL if
+                        // compiled by this process
+    int repeat;         // times each file is sent to the server, 0 to only
+                        // compile it once
+    int jobs;           // number of files compiled at the same time
+    int nb_files;       // number of given files
+    char** files;       // given files, none for the standard input
     char* ouput;
-    FILE* source;
 } Args;
 
 /**
@@ -0,0 +1,107 @@
+#ifndef ASSEMBLE_H
+#define ASSEMBLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "context.h"
+
+/*
+ * The assembler encodes the nasm written by tpcc, builtins included, into
+ * x86-64 machine code, so that objects and executables are written without
+ * nasm nor a linker. It reads the instructions and operands tpcc writes as
+ * nasm does: labels starting with a dot belong to the label before them,
+ * and quoted characters are their codes
+ */
+
+typedef enum {                  // sections of an assembled program
+    SECTION_NONE,               // label used but not defined yet
+    SECTION_TEXT,               // code
+    SECTION_BSS,                // zeroed data
+} SectionId;
+
+typedef struct {                // label of the nasm
+    const char* name;           // name in the nasm, not null terminated
+    int len;                    // length of the name
+    int parent;                 // label a local label belongs to, else -1
+    bool global;                // if declared with `global`
+    SectionId section;          // section of the label
+    size_t offset;              // offset of the label in its section
+} AsmSymbol;
+
+typedef enum {                  // address written in the code
+    FIXUP_REL32,                // 32 bits, relative to the end of the field
+    FIXUP_ABS32S,               // 32 bits absolute, sign extended
+    FIXUP_ABS64,                // 64 bits absolute
+} FixupKind;
+
+typedef struct {                // address of a label written in the code
+    FixupKind kind;             // how the address is written
+    size_t offset;              // offset of the field in the code
+    int symbol;                 // label addressed
+    long addend;                // added to the address of the label
+    int line;                   // line of the instruction in the nasm
+} Fixup;
+
+typedef struct {                // assembled program
+    unsigned char* text;        // code
+    size_t text_len;            // length of the code
+    size_t text_max;            // capacity of the code
+    size_t bss_len;             // length of the zeroed data
+    int nb_symbols;             // number of labels
+    int max_symbols;            // capacity of the labels
+    AsmSymbol* symbols;         // labels
+    int nb_buckets;             // size of the hash table, a power of 2
+    int* buckets;               // hash table of labels, -1 for empty buckets
+    int nb_fixups;              // number of fixups
+    int max_fixups;             // capacity of the fixups
+    Fixup* fixups;              // addresses known once the sections are
+                                // placed, the code only jumps within itself
+} Object;
+
+/**
+ * @brief Assemble the nasm of a program. Names of the labels point in the
+ *        nasm, which must outlive the object
+ *
+ * @param ctx compilation context, reporting the errors
+ * @param obj object to fill, freed by the caller with `free_object`
+ * @param nasm nasm of the program
+ * @param len length of the nasm
+ * @return 1 if success
+ *         0 if the nasm cannot be assembled or if memory runs out
+ */
+int assemble(Context* ctx, Object* obj, const char* nasm, size_t len);
+
+/**
+ * @brief Find a label defined outside of any other
+ *
+ * @param obj assembled program
+ * @param name name of the label
+ * @return index of the label
+ *         -1 if not defined
+ */
+int find_symbol(const Object* obj, const char* name);
+
+/**
+ * @brief Write the addresses of the labels in the code, once the sections
+ *        are placed in memory
+ *
+ * @param ctx compilation context, reporting the errors
+ * @param obj assembled program
+ * @param text_address address of the code
+ * @param bss_address address of the zeroed data
+ * @return 1 if success
+ *         0 if a 32 bits address is out of range
+ */
+int place_object(Context* ctx, Object* obj, uint64_t text_address,
+                 uint64_t bss_address);
+
+/**
+ * @brief Free memory allocated for an assembled program
+ *
+ * @param obj assembled program
+ */
+void free_object(Object* obj);
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stddef.h>
+
+#include "context.h"
+
+/**
+ * @brief Compute the name of the written file, in the current directory: the
+ *        name of the source with the extension of the format, none for an
+ *        executable
+ * 
+ * @param name source file path, NULL for standard input
+ * @param format format of the written file
+ * @param filename set to the name of the written file
+ * @param size size of filename
+ * @return 1 if success
+ *         0 if the name does not fit in filename
+ */
+int output_name(const char* name, OutputFormat format, char* filename,
+                size_t size);
+
+/**
+ * @brief Find the files written to the same file of the current directory
+ *        as an earlier file, as `other/x.tpc` is after `dir/x.tpc`. Only the
+ *        earliest of them is compiled
+ * 
+ * @param format format of the written files
+ * @param files paths of the source files
+ * @param nb_files number of files
+ * @param shared set for each file to the index of the earlier file written
+ *               to the same file, -1 if there is none
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+int shared_outputs(OutputFormat format, char* files[], int nb_files,
+                   int* shared);
+
+/**
+ * @brief Report a file which is not compiled since an earlier file is
+ *        written to the same file
+ * 
+ * @param format format of the written files
+ * @param name path of the file not compiled
+ * @param earlier path of the earlier file
+ */
+void shared_output_error(OutputFormat format, const char* name,
+                         const char* earlier);
+
+/**
+ * @brief Compile a file and write its nasm in the current directory, with
+ *        the name of the source file
+ * 
+ * @param ctx compilation context
+ * @param name path of the source file, NULL for the standard input
+ * @return 0 if success
+ *         SYNTAX_ERROR, SEMANTIC_ERROR or OTHER_ERROR else
+ */
+int compile_file(Context* ctx, const char* name);
+
+/**
+ * @brief Compile several files at the same time using a pool of workers.
+ *        Diagnostics are printed grouped by file, in the order of the files
+ * 
+ * @param options initiated context whose options are given to each file
+ * @param files paths of the source files
+ * @param nb_files number of files
+ * @param jobs number of workers
+ * @return highest error code among the compilations
+ */
+int compile_batch(const Context* options, char* files[], int nb_files,
+                  int jobs);
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef BINARY_H
+#define BINARY_H
+
+#include <stddef.h>
+
+#include "context.h"
+
+/**
+ * @brief Assemble the nasm of a program and write it as an ELF64 object, to
+ *        link without the C runtime, or as a static executable starting at
+ *        `_start`, as given by `ctx->format`. Neither nasm nor a linker is
+ *        needed, the builtins being part of the nasm
+ *
+ * @param ctx compilation context, reporting the errors
+ * @param filename path of the written file
+ * @param nasm nasm of the program
+ * @param len length of the nasm
+ * @return 1 if success
+ *         0 if the nasm cannot be assembled or the file cannot be written
+ */
+int write_binary(Context* ctx, const char* filename, const char* nasm,
+                 size_t len);
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef BUILTINS_H
+#define BUILTINS_H
+
+#include <stddef.h>
+
+typedef struct {                // builtin function compiled in tpcc
+    const char* name;           // name of the builtin, NULL after the last
+    const char** calls;         // builtins it calls, ended by NULL
+    const char* nasm;           // nasm of the builtin
+} EmbeddedBuiltin;
+
+// builtins of the builtin directory, generated by builtin/embed.sh
+extern const EmbeddedBuiltin embedded_builtins[];
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <stdio.h>
+
+#include "context.h"
+#include "source.h"
+#include "table.h"
+#include "tree.h"
+
+typedef struct {                // function loaded from a pack
+    uint64_t key;               // key of the function, 0 for an empty bucket
+    bool used;                  // if written by the compilation
+    size_t offset;              // offset of the nasm in the pack
+    size_t len;                 // length of the nasm
+} CacheEntry;
+
+struct Cache {                  // functions cached for a source
+    Source pack;                // pack loaded from the cache directory
+    CacheEntry* entries;        // loaded functions, hashed by key
+    int nb_buckets;             // size of entries, a power of 2
+    int nb_entries;             // number of loaded functions
+    char* added;                // functions generated by the compilation
+    size_t added_len;           // length of added
+    FILE* added_out;            // stream writing added
+    pthread_mutex_t lock;       // lock on used entries and added functions
+};
+
+/**
+ * @brief Load the pack of the compiled source from the cache directory of
+ *        the context, in `ctx->cache`. A pack holds the functions of the
+ *        recent compilations of the source
+ *
+ * @param ctx compilation context
+ * @return 1 if success, even if the source was never cached
+ *         0 if fail due to memory error
+ */
+int open_cache(Context* ctx);
+
+/**
+ * @brief Add the functions written by the compilation to the pack of the
+ *        compiled source, then free the cache of the context. The pack is
+ *        rewritten without its unused functions once they are most of it
+ *
+ * @param ctx compilation context
+ * @param complete if the compilation succeeded. Otherwise the pack is not
+ *                 rewritten, since unused functions may not have been reached
+ */
+void close_cache(Context* ctx, bool complete);
+
+/**
+ * @brief Compute the key of a function in the cache, from its tree and the
+ *        signatures of the globals and functions it names. Positions in the
+ *        source are not part of the key, so moving a function keeps its key
+ *
+ * @param ctx compilation context
+ * @param scope symbols seen by the function, with the function itself
+ * @param node head node of the function (the 'DeclFonct' label)
+ * @return key of the function
+ */
+uint64_t function_key(Context* ctx, const Scope* scope, node_t node);
+
+/**
+ * @brief Find a function in the cache of the context. The cache may be
+ *        shared by contexts generating functions on several threads
+ *
+ * @param ctx compilation context, whose cache is open
+ * @param key key of the function
+ * @param len set to the length of the nasm
+ * @return nasm of the function, owned by the cache
+ *         NULL if the function is not cached
+ */
+const char* cached_function(Context* ctx, uint64_t key, size_t* len);
+
+/**
+ * @brief Add a generated function to the cache of the context
+ *
+ * @param ctx compilation context, whose cache is open
+ * @param key key of the function
+ * @param nasm nasm of the function
+ * @param len length of the nasm
+ */
+void cache_function(Context* ctx, uint64_t key, const char* nasm, size_t len);
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef CONTEXT_H
+#define CONTEXT_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "arena.h"
+#include "intern.h"
+#include "tree.h"
+
+#define NB_ERROR_TYPES 3
+#define NB_PEEPHOLE_RULES 23            // rules of the peephole optimizer
+
+typedef struct Stream Stream;
+typedef struct Cache Cache;
+typedef struct EmitBuffer EmitBuffer;
+
+typedef enum {                          // comments written in the nasm
+    COMMENTS_NONE,                      // no comment
+    COMMENTS_BRIEF,                     // a comment heading each function,
+                                        // statement and boolean operator
+    COMMENTS_FULL,                      // a comment explaining each group of
+                                        // instructions
+} CommentLevel;
+
+typedef enum {                          // file written for a source
+    FORMAT_NASM,                        // nasm, assembled by nasm
+    FORMAT_OBJECT,                      // ELF64 object, assembled by tpcc
+    FORMAT_EXECUTABLE,                  // ELF64 static executable, assembled
+                                        // and linked by tpcc
+    FORMAT_RUN,                         // none, assembled and run in memory
+                                        // by tpcc
+} OutputFormat;
+
+typedef enum {                          // generation of the nasm of functions
+    CODEGEN_WALK,                       // straight from the tree, as a stack
+                                        // machine
+    CODEGEN_IR,                         // from the IR of the function, in SSA
+                                        // form
+} CodegenMode;
+
+typedef struct {                        // statistics of a compilation
+    size_t arena_bytes;                 // bytes of the identifiers in the arena
+    size_t arena_chunks;                // chunks owned by the arena
+    size_t tree_nodes;                  // nodes of the tree
+    size_t tree_bytes;                  // bytes of the columns of the tree
+    size_t cache_hits;                  // functions read from the cache
+    size_t cache_misses;                // functions generated and cached
+    size_t cache_read_bytes;            // bytes of nasm read from the cache
+    size_t cache_written_bytes;         // bytes of nasm written to the cache
+    size_t peephole_rules[NB_PEEPHOLE_RULES]; // times each rule of the
+                                        // peephole optimizer was applied
+} Stats;
+
+typedef struct Context {                // state of a single compilation
+    const char* filename;               // name of the compiled source
+    const char* source;                 // source text, token spans refer to it
+    int error_count[NB_ERROR_TYPES];    // number of reported errors by type
+    int lineno;                         // current line of the lexer
+    int colno;                          // current column of the lexer
+    int prevcolno;                      // column before the last token
+    int label;                          // next free label of the function
+    int jobs;                           // threads generating the functions
+    bool parse_error;                   // if an action reported a syntax error
+    bool print_tree;                    // print the abstract tree once parsed
+    bool print_symbols;                 // print the symbol tables once filled
+    bool print_stats;                   // print statistics once compiled
+    bool print_tokens;                  // print the tokens before parsing
+    bool fast_lexer;                    // scan with the hand-written lexer
+    bool stream_functions;              // compile each function once parsed
+    bool print_cache_stats;             // print cache statistics once compiled
+    CommentLevel comments;              // comments written in the nasm
+    OutputFormat format;                // file written for the source
+    CodegenMode codegen;                // generation of the nasm of functions
+    bool dump_ir;                       // print the IR of each function
+    bool perf_map;                      // name the code run in memory for
+                                        // perf, in /tmp/perf-<pid>.map
+    int status;                         // result of the main function run
+                                        // in memory
+    const char* cache_dir;              // directory of the cached functions,
+                                        // NULL if not cached
+    Cache* cache;                       // functions cached for the source,
+                                        // NULL until the first is generated
+    Arena* arena;                       // arena of the names, NULL for a new one
+    InternTable idents;                 // identifiers of the compilation
+    Tree tree;                          // abstract tree of the compilation
+    Stream* stream;                     // streamed compilation, NULL if the
+                                        // whole tree is built first
+    Stats stats;                        // statistics of the compilation
+    FILE* out;                          // nasm target
+    EmitBuffer* emit;                   // nasm not written to the target yet,
+                                        // NULL if written directly
+    FILE* err;                          // diagnostics target
+} Context;
+
+/**
+ * @brief Initiate a compilation context. A context holds every state of a
+ *        compilation, so that several compilations can run at the same time
+ *        as long as they do not share their context
+ * 
+ * @param ctx context to initiate
+ * @param filename name of the compiled source, used in diagnostics
+ */
+void init_context(Context* ctx, const char* filename);
+
+/**
+ * @brief Display the statistics of a compilation
+ * 
+ * @param ctx compilation context
+ */
+void print_stats(const Context* ctx);
+
+/**
+ * @brief Display the statistics of the cache of a compilation
+ * 
+ * @param ctx compilation context
+ */
+void print_cache_stats(const Context* ctx);
+
+#endif
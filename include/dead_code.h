@@ -0,0 +1,43 @@
+#ifndef DEAD_CODE_H
+#define DEAD_CODE_H
+
+#include "context.h"
+#include "table.h"
+#include "tree.h"
+
+/*
+ * Once simplified, the instructions which are never run are removed: those
+ * after a return, the branches of an `if` on a constant and the `while` on
+ * 0. An assignation of a local or a parameter which is never read is
+ * removed too, its value being kept when it calls a function. In a whole
+ * program, the functions which are not reached by calls from main are then
+ * removed
+ */
+
+/**
+ * @brief Remove the dead instructions and assignations of a simplified
+ *        function
+ *
+ * @param ctx compilation context
+ * @param fun function, with its parameters and locals
+ * @param node head node of the function (the 'DeclFonct' label)
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+int eliminate_dead_code(Context* ctx, const Function* fun, node_t node);
+
+/**
+ * @brief Remove the dead code of every function of a simplified program,
+ *        then the functions not reached from main. A function, builtins
+ *        included, is then used only if it is reached
+ *
+ * @param ctx compilation context
+ * @param collection functions of the program
+ * @param tree root of the tree of the program
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+int eliminate_dead_tree(Context* ctx, FunctionCollection* collection,
+                        node_t tree);
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef EMIT_H
+#define EMIT_H
+
+#include <stddef.h>
+#include <string.h>
+
+#include "context.h"
+
+#define EMIT_BUFFER_SIZE (1 << 16)
+
+/*
+ * The emitter writes the nasm of a context without formatting it: the
+ * instructions are pre-formatted strings, and only their numbers and names
+ * are written in between. They are copied in a large buffer, written to
+ * the nasm target once full or flushed
+ */
+
+struct EmitBuffer {             // nasm written but not flushed yet
+    char data[EMIT_BUFFER_SIZE];
+    size_t len;                 // length of the buffered nasm
+};
+
+/**
+ * @brief Buffer the nasm of a context until the emitter is closed. A
+ *        context copied by another thread needs its own buffer
+ *
+ * @param ctx compilation context
+ * @param buffer buffer of the nasm, kept until the emitter is closed
+ */
+void open_emitter(Context* ctx, EmitBuffer* buffer);
+
+/**
+ * @brief Write the buffered nasm to the nasm target. The buffer is flushed
+ *        before the target of the context changes
+ *
+ * @param ctx compilation context
+ */
+void flush_emitter(Context* ctx);
+
+/**
+ * @brief Flush the buffered nasm, then write the next nasm directly
+ *
+ * @param ctx compilation context
+ */
+void close_emitter(Context* ctx);
+
+/**
+ * @brief Write pre-formatted nasm
+ *
+ * @param ctx compilation context
+ * @param text nasm to write
+ */
+void emit(Context* ctx, const char* text);
+
+// pre-formatted nasm, whose length is known once compiled
+#define EMIT(ctx, literal) emit_bytes(ctx, literal, sizeof(literal) - 1)
+
+/**
+ * @brief Write nasm of a known length, not copied in the buffer if it has no
+ *        room for it. Called by `emit_bytes` only
+ *
+ * @param ctx compilation context
+ * @param data nasm to write
+ * @param len length of the nasm
+ */
+void emit_unbuffered(Context* ctx, const char* data, size_t len);
+
+/**
+ * @brief Write nasm of a known length. Inlined, since most instructions are
+ *        written by parts of a few bytes
+ *
+ * @param ctx compilation context
+ * @param data nasm to write
+ * @param len length of the nasm
+ */
+static inline void emit_bytes(Context* ctx, const char* data, size_t len) {
+    EmitBuffer* buffer = ctx->emit;
+    if (buffer && len <= EMIT_BUFFER_SIZE - buffer->len) {
+        memcpy(buffer->data + buffer->len, data, len);
+        buffer->len += len;
+    } else {
+        emit_unbuffered(ctx, data, len);
+    }
+}
+
+/**
+ * @brief Write an integer in decimal
+ *
+ * @param ctx compilation context
+ * @param value integer to write
+ */
+void emit_int(Context* ctx, long value);
+
+/**
+ * @brief Write the name of a label, as in `.L<function>_<number>`
+ *
+ * @param ctx compilation context
+ * @param fun name of the function of the label
+ * @param label number of the label in the function
+ */
+void emit_label(Context* ctx, const char* fun, int label);
+
+/**
+ * @brief Write a comment on its own line, after an empty line, if the
+ *        comments of the context reach its level. Only written comments are
+ *        formatted
+ *
+ * @param ctx compilation context
+ * @param level lowest level writing the comment
+ * @param format template of the comment, whose holes are `%s` for strings,
+ *               `%d` for integers and `%c` for characters
+ */
+void emit_comment(Context* ctx, CommentLevel level, const char* format, ...);
+
+/**
+ * @brief Write a comment at the end of an instruction, before its new line,
+ *        if every comment is written
+ *
+ * @param ctx compilation context
+ * @param text comment
+ */
+void emit_note(Context* ctx, const char* text);
+
+#endif
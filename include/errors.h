@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 
+#include "context.h"
 #include "types.h"
 
 // colors
@@ -32,34 +33,31 @@ typedef struct {                // error
     char message[ERROR_LEN];    // associate message
 } Error;
 
-/**
- * @brief Initiate error collection
- * 
- * @param source current parsed file
- */
-void init_error(const char* source);
-
 /**
  * @brief Print a memory error message
  * 
+ * @param ctx compilation context
  */
-void memory_error(void);
+void memory_error(Context* ctx);
 
 /**
  * @brief Print an error message when a symbol is already declared
  * 
+ * @param ctx compilation context
  * @param symbol symbol already declared
  * @param line line where the error is triggered
  * @param col column where the error is triggered
  * @param last_line line where the symbol was previously defined
  */
-void already_declared_error(const char* symbol, int line, int col, int last_line);
+void already_declared_error(Context* ctx, const char* symbol, int line, int col,
+                            int last_line);
 
 /**
  * @brief Print an error message when a function hasn't its presume return type
  *        (for function like 'main') or when a return expression type is the
  *        wrong one
  * 
+ * @param ctx compilation context
  * @param type type of errors
  * @param symbol function name
  * @param current_type actual return type
@@ -67,43 +65,48 @@ void already_declared_error(const char* symbol, int line, int col, int last_line
  * @param line line where the error is triggered
  * @param col column where the error is triggered
  */
-void wrong_rtype_error(ErrorType type, const char* symbol,
-                       t_type current_type, t_type expected_type,
-                       int line, int col);
+void wrong_rtype_error(Context* ctx, ErrorType type, const char* symbol,
+                       t_type current_type, t_type expected_type, int line,
+                       int col);
 
 /**
  * @brief Print an error message when using a symbol which is not is the
  *        symbol tables
  * 
+ * @param ctx compilation context
  * @param symbol undefined symbol
  * @param line line where the error is triggered
  * @param col column where the error is triggered
  */
-void use_of_undeclare_symbol(ErrorType type, const char* symbol, int line,
-                             int col);
+void use_of_undeclare_symbol(Context* ctx, ErrorType type, const char* symbol,
+                             int line, int col);
 
 /**
  * @brief Print a message when a symbol is not used
  * 
+ * @param ctx compilation context
  * @param symbol unused symbol
  * @param line line where the message is triggered
  * @param col column where the message is triggered
  */
-void unused_symbol(const char* symbol, int line, int col);
+void unused_symbol(Context* ctx, const char* symbol, int line, int col);
 
 /**
  * @brief Print a message when a symbol inside a function is not used
  * 
+ * @param ctx compilation context
  * @param function function where the symbol is declared
  * @param symbol unused symbol
  * @param line line where the message is triggered
  * @param col column where the message is triggered
  */
-void unused_symbol_in_function(const char* function, const char* symbol, int line, int col);
+void unused_symbol_in_function(Context* ctx, const char* function,
+                               const char* symbol, int line, int col);
 
 /**
  * @brief Print a message when assignation is incorrect
  * 
+ * @param ctx compilation context
  * @param type type of errors
  * @param symbol name of variable
  * @param dest_type type of the assignation
@@ -111,58 +114,69 @@ void unused_symbol_in_function(const char* function, const char* symbol, int lin
  * @param line line where the message is triggered
  * @param col column where the message is triggered
  */
-void assignation_error(ErrorType type, const char* symbol, t_type dest_type, t_type source_type, int line, int col);
+void assignation_error(Context* ctx, ErrorType type, const char* symbol,
+                       t_type dest_type, t_type source_type, int line, int col);
 
 /**
  * @brief Print a message when a function redefine a builtin function
  * 
+ * @param ctx compilation context
  * @param function array of functions
  * @param line line where the message is triggered
  * @param col column where the message is triggered
  */
-void redefinition_of_builtin_functions(const char* function, int line, int col);
+void redefinition_of_builtin_functions(Context* ctx, const char* function,
+                                       int line, int col);
 
 /**
  * @brief Print a message when index is incorrect
  * 
+ * @param ctx compilation context
  * @param name name of array
  * @param access_type type of the access index
  * @param line line where the message is triggered
  * @param col column where the message is triggered
  */
-void incorrect_array_access(const char* name, t_type access_type, int line, int col);
+void incorrect_array_access(Context* ctx, const char* name, t_type access_type,
+                            int line, int col);
 
 /**
  * @brief Print a message when operation with invalid types
  * 
+ * @param ctx compilation context
  * @param operation symbol of operation
  * @param type type
  * @param line line where the message is triggered
  * @param col column where the message is triggered
  */
-void invalid_operation(const char* operation, t_type type, int line, int col);
+void invalid_operation(Context* ctx, const char* operation, t_type type,
+                       int line, int col);
 
 /**
  * @brief Print a message when invalid condition
  * 
+ * @param ctx compilation context
  * @param type condition type at the moment
  * @param line line where the message is triggered
  * @param col column where the message is triggered
  */
-void invalid_condition(t_type type, int line, int col);
+void invalid_condition(Context* ctx, t_type type, int line, int col);
 
 /**
  * @brief Print a message when a type check occurs on non int or char values 
  * 
+ * @param ctx compilation context
  * @param function name of function
  * @param line line where the message is triggered
  * @param col column where the message is triggered
  */
-void incorrect_function_call(const char* function, int line, int col);
+void incorrect_function_call(Context* ctx, const char* function, int line,
+                             int col);
 
 /**
  * @brief Print a message when a actual parameter is different that type of function's parameter
  * 
+ * @param ctx compilation context
  * @param type type of errors
  * @param function name of function
  * @param param_name name of parameter
@@ -171,59 +185,86 @@ void incorrect_function_call(const char* function, int line, int col);
  * @param line line where the message is triggered
  * @param col column where the message is triggered
  */
-void invalid_parameter_type(ErrorType type, const char* function,
+void invalid_parameter_type(Context* ctx, ErrorType type, const char* function,
                             const char* param_name, t_type expected,
                             t_type current, int line, int col);
 
 /**
  * @brief Print a message when type symbol is incorrect than expected type
  * 
+ * @param ctx compilation context
  * @param symbol name of symbol
  * @param sym_type type of symbol
  * @param expected_type expected type
  * @param line line where the message is triggered
  * @param col column where the message is triggered
  */
-void incorrect_symbol_use(const char* symbol, t_type sym_type, t_type expected_type, int line, int col);
+void incorrect_symbol_use(Context* ctx, const char* symbol, t_type sym_type,
+                          t_type expected_type, int line, int col);
 
 /**
  * @brief Print a message when declaration of a array is incorrect
  * 
+ * @param ctx compilation context
  * @param symbol name of symbol
  * @param line line where the message is triggered
  * @param col column where the message is triggered
  */
-void incorrect_array_decl(const char* symbol, int line, int col);
+void incorrect_array_decl(Context* ctx, const char* symbol, int line, int col);
+
+/**
+ * @brief Print a warning when a division or a modulo is by a constant zero
+ * 
+ * @param ctx compilation context
+ * @param operation operator, '/' or '%'
+ * @param line line where the message is triggered
+ * @param col column where the message is triggered
+ */
+void division_by_zero(Context* ctx, const char* operation, int line, int col);
+
+/**
+ * @brief Print an error of the assembler, on the nasm written by tpcc
+ * 
+ * @param ctx compilation context
+ * @param line line of the nasm, 0 if the error is not on a line
+ * @param message description of the error
+ */
+void assembly_error(Context* ctx, int line, const char* message);
 
 /**
  * @brief Print custom message
  * 
+ * @param ctx compilation context
  * @param type error type
  * @param message custom message
  */
-void error(ErrorType type, const char* message);
+void error(Context* ctx, ErrorType type, const char* message);
 
 /**
  * @brief Print custom message with custom line and column
  * 
+ * @param ctx compilation context
  * @param type error type
  * @param message custom message
  * @param line custom line
  * @param col custom column
  */
-void line_error(ErrorType type, const char* message, int line, int col);
+void line_error(Context* ctx, ErrorType type, const char* message, int line,
+                int col);
 
 /**
  * @brief Check if any errors has been registered
  * 
+ * @param ctx compilation context
  * @return
  */
-bool fatal_error(void);
+bool fatal_error(Context* ctx);
 
 /**
  * @brief Print compilation rapport
  * 
+ * @param ctx compilation context
  */
-void print_rapport(void);
+void print_rapport(Context* ctx);
 
 #endif
@@ -0,0 +1,21 @@
+#ifndef GEN_IR_H
+#define GEN_IR_H
+
+#include "context.h"
+#include "ir.h"
+#include "regalloc.h"
+
+/**
+ * @brief Write the nasm of a function from its IR in SSA form. Each
+ *        register is in the register of the processor or the slot of the
+ *        frame it is given, and the phis are copied at the end of the
+ *        predecessors
+ *
+ * @param ctx compilation context
+ * @param ir IR of the function, well formed
+ * @param alloc locations of the registers of the function
+ */
+void write_ir_function(Context* ctx, const IrFunction* ir,
+                       const RegAlloc* alloc);
+
+#endif
@@ -1,17 +1,53 @@
 #ifndef GEN_NASM_H
 #define GEN_NASM_H
 
+#include <stdio.h>
+
+#include "context.h"
 #include "tree.h"
 #include "table.h"
 
 /**
  * @brief Function to generate nasm file
  * 
- * @param output name of file
+ * @param ctx compilation context
+ * @param out nasm target
  * @param globals symbols table
  * @param collection array of functions
  * @param tree pointer to tree
  */
-void gen_nasm(char* output, const Table* globals, const FunctionCollection* collection, const Node* tree);
+void gen_nasm(Context* ctx, FILE* out, const Table* globals,
+              const FunctionCollection* collection, node_t tree);
+
+/**
+ * @brief Generate the nasm header, before functions generated one by one
+ * 
+ * @param ctx compilation context
+ * @param out nasm target
+ * @param globals symbols table, complete
+ * @param collection array of functions
+ */
+void gen_nasm_init(Context* ctx, FILE* out, const Table* globals,
+                   const FunctionCollection* collection);
+
+/**
+ * @brief Generate the nasm of a single function, after the header
+ * 
+ * @param ctx compilation context
+ * @param globals symbols table
+ * @param collection array of functions, with the functions it calls
+ * @param node head node of the function (the 'DeclFonct' label)
+ */
+void gen_nasm_function(Context* ctx, const Table* globals,
+                       const FunctionCollection* collection, node_t node);
+
+/**
+ * @brief Generate the builtins called by the functions generated one by
+ *        one, once all of them are
+ * 
+ * @param ctx compilation context
+ * @param collection array of functions, whose builtins are marked if used
+ */
+void gen_nasm_end(Context* ctx, const FunctionCollection* collection);
 
 #endif
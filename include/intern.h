@@ -0,0 +1,55 @@
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <stddef.h>
+
+typedef int ident_t;            // id of an interned identifier
+
+typedef struct Context Context;
+
+typedef struct {                // table of the identifiers of a compilation
+    int nb_idents;              // number of interned identifiers
+    int max_idents;             // maximum number of identifiers
+    int nb_buckets;             // size of the hash table, a power of 2
+    const char** names;         // names of the identifiers, by id
+    unsigned int* hashes;       // hash of the identifiers, by id
+    ident_t* buckets;           // hash table of ids, -1 for empty buckets
+} InternTable;
+
+/**
+ * @brief Initiate an empty table of identifiers
+ * 
+ * @param table table to initiate
+ */
+void init_intern_table(InternTable* table);
+
+/**
+ * @brief Get the id of an identifier. Each distinct identifier has its own
+ *        id, so identifiers can be compared by their ids. Names are copied
+ *        in the arena of the context, so they live as long as the tree
+ * 
+ * @param ctx compilation context
+ * @param str identifier, not necessarily null terminated
+ * @param len length of the identifier
+ * @return id of the identifier
+ *         -1 if fail due to memory error
+ */
+ident_t intern(Context* ctx, const char* str, size_t len);
+
+/**
+ * @brief Get the name of an identifier
+ * 
+ * @param ctx compilation context
+ * @param id id of the identifier
+ * @return name of the identifier
+ */
+const char* ident_name(const Context* ctx, ident_t id);
+
+/**
+ * @brief Free memory allocated for a table of identifiers, and empty it
+ * 
+ * @param table table to free
+ */
+void free_intern_table(InternTable* table);
+
+#endif
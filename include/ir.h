@@ -0,0 +1,168 @@
+#ifndef IR_H
+#define IR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "context.h"
+#include "intern.h"
+#include "table.h"
+#include "tree.h"
+
+/*
+ * The IR of a function is a control flow graph of basic blocks, each one a
+ * list of three-address instructions over virtual registers, ended by a
+ * jump, a branch or a return. It is built from the checked tree, then put
+ * in SSA form: the scalar locals and parameters live in registers, each
+ * register is defined once, and phi instructions at the head of the blocks
+ * merge the values of a variable coming from their predecessors. Arrays and
+ * globals stay in memory
+ */
+
+typedef int vreg_t;             // virtual register, numbered from 1
+
+#define NO_VREG 0               // no register, never defined
+
+typedef enum {                  // operations of the instructions
+    IR_NOP,                     // nothing, removed once the IR is built
+    IR_CONST,                   // dst = imm
+    IR_PARAM,                   // dst = value of the parameter var
+    IR_NEG,                     // dst = -a
+    IR_ADD,                     // dst = a + b
+    IR_SUB,                     // dst = a - b
+    IR_MUL,                     // dst = a * b
+    IR_DIV,                     // dst = a / b
+    IR_MOD,                     // dst = a % b
+    IR_EQ,                      // dst = a == b
+    IR_NE,                      // dst = a != b
+    IR_LT,                      // dst = a < b
+    IR_LE,                      // dst = a <= b
+    IR_GT,                      // dst = a > b
+    IR_GE,                      // dst = a >= b
+    IR_NOT,                     // dst = a == 0
+    IR_BOOL,                    // dst = a != 0
+    IR_LOAD,                    // dst = var, or var[a] for an array
+    IR_STORE,                   // var = a, or var[b] = a for an array
+    IR_ADDR,                    // dst = address of the array var
+    IR_CALL,                    // dst = callee(operands), dst if not void
+    IR_PHI,                     // dst = operand of the predecessor run
+    IR_JUMP,                    // go to the first successor
+    IR_BRANCH,                  // go to the first successor if a != 0,
+                                // else to the second one
+    IR_RET,                     // return a, or nothing without a
+} IrOp;
+
+typedef struct {                // variable of a function
+    ident_t name;               // name, unset for a temporary of the lowering
+    bool array;                 // if an array, addressed by its elements
+    bool promoted;              // if kept in registers once in SSA form
+    bool global;                // if addressed from `globals`, else from rbp
+    bool indirect;              // if an array given as parameter, whose
+                                // address is stored at the offset
+    int offset;                 // offset of the variable, or of the address
+                                // of its first element
+    const Entry* entry;         // symbol of the variable, NULL for a
+                                // temporary
+} IrVar;
+
+typedef struct {                // three-address instruction
+    IrOp op;                    // operation
+    vreg_t dst;                 // defined register, NO_VREG if none
+    vreg_t a;                   // first operand, NO_VREG if none
+    vreg_t b;                   // second operand, NO_VREG if none
+    long imm;                   // constant of IR_CONST
+    int var;                    // variable of memory accesses and phis
+    ident_t callee;             // function called by IR_CALL
+    int first_operand;          // operands of calls and phis, in the
+    int nb_operands;            // operands of the function
+} IrInstr;
+
+typedef struct {                // basic block
+    IrInstr* instrs;            // instructions, phis first, terminator last
+    int nb_instrs;              // number of instructions
+    int max_instrs;             // capacity of the instructions
+    int succs[2];               // successors, the branch target first
+    int nb_succs;               // number of successors
+    int* preds;                 // predecessors, in the order of phi operands
+    int nb_preds;               // number of predecessors
+    int max_preds;              // capacity of the predecessors
+    int idom;                   // immediate dominator, -1 for the entry
+} IrBlock;
+
+typedef struct {                // function in IR
+    const Function* fun;        // symbols of the function
+    IrBlock* blocks;            // blocks, the entry first
+    int nb_blocks;              // number of blocks
+    int max_blocks;             // capacity of the blocks
+    IrVar* vars;                // variables accessed by the function
+    int nb_vars;                // number of variables
+    int max_vars;               // capacity of the variables
+    vreg_t* operands;           // operands of calls and phis
+    int nb_operands;            // number of operands
+    int max_operands;           // capacity of the operands
+    int nb_vregs;               // number of registers, NO_VREG included
+} IrFunction;
+
+/**
+ * @brief Build the IR of a checked function, in SSA form
+ *
+ * @param ctx compilation context
+ * @param scope symbols seen by the function, with the function itself
+ * @param node head node of the function (the 'DeclFonct' label)
+ * @param ir IR to fill, freed by the caller with `free_ir`
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+int build_ir(Context* ctx, const Scope* scope, node_t node, IrFunction* ir);
+
+/**
+ * @brief Reserve operands for a call or a phi, set to NO_VREG
+ *
+ * @param ctx compilation context
+ * @param ir IR of the function
+ * @param nb_operands number of operands
+ * @return index of the first operand in the operands of the function
+ *         -1 if fail due to memory error
+ */
+int add_operands(Context* ctx, IrFunction* ir, int nb_operands);
+
+/**
+ * @brief Check that the IR of a function is well formed: blocks end with
+ *        their single terminator, predecessors match the successors, the
+ *        immediate dominators are right and each register is defined once,
+ *        before all its uses
+ *
+ * @param ir IR to check
+ * @param why set to the first broken rule, if any
+ * @param size size of why
+ * @return 1 if the IR is well formed
+ *         0 else
+ */
+int verify_ir(const IrFunction* ir, char* why, size_t size);
+
+/**
+ * @brief Print the IR of a function on the standard output
+ *
+ * @param ctx compilation context
+ * @param ir IR to print
+ */
+void print_ir(Context* ctx, const IrFunction* ir);
+
+/**
+ * @brief Free memory allocated for the IR of a function
+ *
+ * @param ir
+ */
+void free_ir(IrFunction* ir);
+
+/**
+ * @brief Tell if an instruction ends its block
+ *
+ * @param op operation of the instruction
+ * @return true for jumps, branches and returns
+ */
+static inline bool is_terminator(IrOp op) {
+    return op == IR_JUMP || op == IR_BRANCH || op == IR_RET;
+}
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <stddef.h>
+
+#include "context.h"
+
+/**
+ * @brief Assemble the nasm of a program in memory and call its `main`, with
+ *        the builtins it uses. The result of `main` is set in `ctx->status`,
+ *        and the labels of the code are written in `/tmp/perf-<pid>.map`
+ *        if `ctx->perf_map` is set
+ *
+ * @param ctx compilation context, reporting the errors
+ * @param nasm nasm of the program
+ * @param len length of the nasm
+ * @return 1 if the program ran
+ *         0 if it cannot be assembled or loaded
+ */
+int run_program(Context* ctx, const char* nasm, size_t len);
+
+#endif
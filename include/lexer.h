@@ -0,0 +1,47 @@
+#ifndef LEXER_H
+#define LEXER_H
+
+#include "context.h"
+#include "source.h"
+
+/**
+ * @brief Create a scanner reading tokens in place from a source. Cursor
+ *        position is tracked in the given context, and tokens values are
+ *        spans in the text of the source
+ * 
+ * @param ctx compilation context
+ * @param source source code to scan
+ * @param scanner created scanner
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+int init_scanner(Context* ctx, Source* source, void** scanner);
+
+/**
+ * @brief Free memory allocated for a scanner
+ * 
+ * @param scanner scanner to free
+ */
+void free_scanner(void* scanner);
+
+/**
+ * @brief Create a hand-written scanner reading tokens in place from a
+ *        source. It gives the same tokens and cursor positions as the flex
+ *        scanner, but skips separators and comments by blocks of bytes
+ * 
+ * @param ctx compilation context
+ * @param source source code to scan
+ * @param scanner created scanner
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+int init_fast_scanner(Context* ctx, Source* source, void** scanner);
+
+/**
+ * @brief Free memory allocated for a hand-written scanner
+ * 
+ * @param scanner scanner to free
+ */
+void free_fast_scanner(void* scanner);
+
+#endif
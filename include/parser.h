@@ -1,17 +1,30 @@
 #ifndef PARSER_H
 #define PARSER_H
 
-#include <stdio.h>
-
+#include "context.h"
+#include "source.h"
 #include "tree.h"
 
 /**
- * @brief Function parsing a file
+ * @brief Function parsing a loaded source
  * 
- * @param source 
+ * @param ctx compilation context
+ * @param source source code, scanned in place
  * @param tree 
  * @return int 
  */
-int parse_file(FILE* source, Node** tree);
+int parse_source(Context* ctx, Source* source, node_t* tree);
+
+/**
+ * @brief Print the tokens of a source, each one with the line, column and
+ *        previous column of the cursor after it. The cursor of the context
+ *        is set back to the start of the source
+ * 
+ * @param ctx compilation context, which chooses the scanner
+ * @param source source code, scanned in place
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+int print_tokens(Context* ctx, Source* source);
 
 #endif
@@ -0,0 +1,37 @@
+#ifndef PEEPHOLE_H
+#define PEEPHOLE_H
+
+#include <stddef.h>
+
+#include "context.h"
+
+/*
+ * The nasm of each function is read back as a list of lines, then rewritten
+ * by a table of rules until none applies. A rule matches a window of 1 to 4
+ * consecutive instructions and labels, comments being skipped, and writes
+ * other instructions instead when its guard holds, as when a register it
+ * drops is not read before being written again
+ */
+
+/**
+ * @brief Rewrite the nasm of a function with the rules of the peephole
+ *        optimizer until none applies, then write it. The rules applied are
+ *        counted in the statistics of the context
+ *
+ * @param ctx compilation context
+ * @param nasm nasm of the function, as generated
+ * @param len length of the nasm
+ * @return 1 if success
+ *         0 if fail due to memory error, nothing is written
+ */
+int write_peephole(Context* ctx, const char* nasm, size_t len);
+
+/**
+ * @brief Give the name of a rule of the peephole optimizer
+ *
+ * @param rule index of the rule, below `NB_PEEPHOLE_RULES`
+ * @return name of the rule
+ */
+const char* peephole_rule_name(int rule);
+
+#endif
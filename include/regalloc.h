@@ -0,0 +1,58 @@
+#ifndef REGALLOC_H
+#define REGALLOC_H
+
+#include "context.h"
+#include "ir.h"
+
+/*
+ * The registers of the IR in SSA form are given registers of the processor
+ * by a linear scan over the blocks in the order they are written. A value
+ * lives from its definition to its last use, through the blocks found back
+ * from its uses up to its definition, and values living at once are given
+ * different registers. A value living across a call keeps a register the
+ * calls do not change, and when none is left the value living the longest
+ * gets a slot of the frame.
+ * rax, rcx and rdx are kept for the code of the instructions, and the
+ * registers of the arguments for the calls
+ */
+
+typedef enum {                  // registers of the processor given to values
+    REG_R12,                    // kept by the functions and the builtins,
+    REG_R13,                    // saved by the functions using them
+    REG_R14,
+    REG_R15,
+    REG_RBX,                    // changed by the calls, rbx by putint and
+    REG_R10,                    // r11 by the system calls
+    REG_R11,
+    NB_REGS
+} MachineReg;
+
+#define NB_KEPT_REGS 4          // registers kept by the calls, the first ones
+
+typedef struct {                // registers of a function
+    int* locs;                  // location of each register of the IR: a
+                                // MachineReg, or NB_REGS + its slot
+    int nb_slots;               // number of slots of the spilled values
+    unsigned used;              // mask of the MachineReg given to values
+} RegAlloc;
+
+/**
+ * @brief Give a register of the processor or a slot of the frame to each
+ *        register of the IR of a function. Running out of memory is not
+ *        reported, the function being then generated from its tree
+ *
+ * @param ir IR of the function, well formed
+ * @param alloc locations to fill, freed by the caller with `free_regalloc`
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+int allocate_registers(const IrFunction* ir, RegAlloc* alloc);
+
+/**
+ * @brief Free memory allocated for the registers of a function
+ *
+ * @param alloc
+ */
+void free_regalloc(RegAlloc* alloc);
+
+#endif
@@ -6,11 +6,48 @@
 /**
  * @brief Sacred function of semantic things
  * 
+ * @param ctx compilation context
  * @param globals symbol table
  * @param collection array of function symbol
  * @param tree pointer of the start of tree
  * @return int 
  */
-int check_sem(Table* globals, FunctionCollection* collection, Node* tree);
+int check_sem(Context* ctx, Table* globals, FunctionCollection* collection,
+              node_t tree);
+
+/**
+ * @brief Report the unused parameters and locals of a single function, once
+ *        its symbol tables are created
+ * 
+ * @param ctx compilation context
+ * @param fun function to check, whose locals are sorted
+ */
+void check_function_unused(Context* ctx, Function* fun);
+
+/**
+ * @brief Check the semantic of a single function, once its symbol tables
+ *        are created and all the functions it calls are declared
+ * 
+ * @param ctx compilation context
+ * @param globals symbol table, sorted the first time
+ * @param collection array of function symbol
+ * @param fun function to check
+ * @param node head node of the function (the 'DeclFonct' label)
+ * @return 0 in case of error else 1 if success
+ */
+int check_function_sem(Context* ctx, Table* globals, FunctionCollection* collection,
+                       Function* fun, node_t node);
+
+/**
+ * @brief End the semantic check of functions checked one by one, by
+ *        checking the main function and reporting unused globals
+ * 
+ * @param ctx compilation context
+ * @param globals symbol table, sorted if it is not yet
+ * @param collection array of function symbol
+ * @return 0 in case of error else 1 if success
+ */
+int check_sem_end(Context* ctx, Table* globals,
+                  const FunctionCollection* collection);
 
 #endif
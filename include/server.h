@@ -0,0 +1,87 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stdint.h>
+
+#include "context.h"
+
+// bumped whenever requests or replies change
+#define SERVER_VERSION 3
+
+#define REQUEST_STATS       0x1     // print statistics of the compilation
+#define REQUEST_CACHE_STATS 0x2     // print statistics of the cache
+#define REQUEST_FAST_LEXER  0x4     // scan with the hand-written lexer
+#define REQUEST_STREAM      0x8     // compile each function once parsed
+#define REQUEST_CODEGEN_IR  0x10    // generate the functions from their IR
+
+typedef struct {                // compile request, followed by its strings
+    uint32_t version;           // SERVER_VERSION of the client
+    uint32_t flags;             // REQUEST_* options
+    uint32_t name_len;          // length of the name used in diagnostics
+    uint32_t path_len;          // length of the path of the source read by
+                                // the server, 0 if the source follows
+    uint32_t cache_dir_len;     // length of the cache directory, 0 if none
+    uint32_t comments;          // CommentLevel of the nasm
+    uint64_t source_len;        // length of the source following the strings
+} Request;
+
+typedef enum {                  // kind of a chunk of a reply
+    CHUNK_ASM,                  // part of the generated nasm
+    CHUNK_DIAGNOSTICS,          // part of the diagnostics
+    CHUNK_RESULT,               // result of the compilation, last chunk
+} ReplyKind;
+
+typedef struct {                // header of a chunk of a reply
+    uint32_t kind;              // ReplyKind of the chunk
+    uint32_t len;               // length of the data following the header
+} ReplyChunk;
+
+typedef struct {                // data of the CHUNK_RESULT chunk
+    int32_t res;                // result of the compilation
+    int32_t error_count[NB_ERROR_TYPES]; // number of reported errors by type
+    Stats stats;                // statistics of the compilation
+} Result;
+
+/**
+ * @brief Serve compile requests on a Unix domain socket until the process
+ *        is killed. Each worker keeps its arena from a request to the
+ *        next. Sources given by path are read by the server, relative
+ *        paths from its working directory
+ *
+ * @param path path of the socket, replaced if it is a stale socket
+ * @param jobs number of requests served at the same time
+ * @return OTHER_ERROR if the server cannot start
+ */
+int run_server(const char* path, int jobs);
+
+/**
+ * @brief Compile files through a server, and write their nasm in the
+ *        current directory, as if they were compiled by this process
+ *
+ * @param options initiated context whose options are sent to the server
+ * @param path path of the socket of the server
+ * @param files paths of the source files, none for the standard input
+ * @param nb_files number of files
+ * @return highest error code among the compilations
+ */
+int run_client(const Context* options, const char* path, char* files[],
+               int nb_files);
+
+/**
+ * @brief Send the same requests many times through several connections at
+ *        once, and print the rate of requests and their latencies. The
+ *        nasm is received but not written
+ *
+ * @param options initiated context whose options are sent to the server
+ * @param path path of the socket of the server
+ * @param files paths of the source files, none for the standard input
+ * @param nb_files number of files
+ * @param repeat number of times each file is sent
+ * @param jobs number of connections at the same time
+ * @return 0 if every request succeeded
+ *         OTHER_ERROR else
+ */
+int run_load(const Context* options, const char* path, char* files[],
+             int nb_files, int repeat, int jobs);
+
+#endif
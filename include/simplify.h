@@ -0,0 +1,62 @@
+#ifndef SIMPLIFY_H
+#define SIMPLIFY_H
+
+#include <stdbool.h>
+
+#include "context.h"
+#include "tree.h"
+#include "walk.h"
+
+/*
+ * Once checked, the expressions of a function are simplified in place: the
+ * operations on constants are computed as the program would, `x + 0`,
+ * `x * 1` or `!!x` in a condition become `x`, and characters become numbers.
+ * A division by a constant zero is reported and kept, as it traps when run
+ */
+
+/**
+ * @brief Simplify the expressions of a checked function
+ *
+ * @param ctx compilation context
+ * @param node head node of the function (the 'DeclFonct' label)
+ */
+void simplify_function(Context* ctx, node_t node);
+
+/**
+ * @brief Simplify the expressions of every function of a checked program
+ *
+ * @param ctx compilation context
+ * @param tree root of the tree of the program
+ */
+void simplify_tree(Context* ctx, node_t tree);
+
+/**
+ * @brief Initiate a walk looking for side effects in expressions
+ *
+ * @param walk walk to initiate, freed with `free_walk`
+ * @param ctx compilation context
+ */
+void init_effects(Walk* walk, Context* ctx);
+
+/**
+ * @brief Initiate a walk looking for side effects, or for accesses to array
+ *        elements, whose index may be out of the array when the expression
+ *        is guarded by a condition
+ *
+ * @param walk walk to initiate, freed with `free_walk`
+ * @param ctx compilation context
+ */
+void init_traps(Walk* walk, Context* ctx);
+
+/**
+ * @brief Check if the evaluation of an expression may have a side effect, a
+ *        call or a division which may trap, in which case it cannot be
+ *        dropped
+ *
+ * @param effects walk initiated by `init_effects` or `init_traps`
+ * @param node expression
+ * @return true if it may have one
+ */
+bool has_side_effect(Walk* effects, node_t node);
+
+#endif
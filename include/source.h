@@ -0,0 +1,53 @@
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// flex scans in place a buffer ended by two null bytes
+#define SOURCE_PADDING 2
+
+typedef struct {                // token position in the source code
+    size_t offset;              // offset of the first character, which may
+                                // be past 4 GiB in a large generated source
+    size_t len;                 // number of characters
+} Span;
+
+typedef struct {                // source code to compile
+    char* text;                 // text followed by SOURCE_PADDING null bytes
+    size_t len;                 // length of the text without padding
+    size_t size;                // size of the mapping or of the buffer
+    bool mapped;                // if text is mapped from the file
+} Source;
+
+/**
+ * @brief Load the whole content of a file. Regular files are mapped in
+ *        memory, others (standard input, pipes) are read into a buffer
+ * 
+ * @param source loaded source
+ * @param file file to load
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+int load_source(Source* source, FILE* file);
+
+/**
+ * @brief Load a source code held in memory
+ * 
+ * @param source loaded source
+ * @param src source code
+ * @param len length of the source code in bytes
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+int copy_source(Source* source, const char* src, size_t len);
+
+/**
+ * @brief Free memory allocated or mapped for a source
+ * 
+ * @param source source to free
+ */
+void free_source(Source* source);
+
+#endif
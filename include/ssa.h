@@ -0,0 +1,34 @@
+#ifndef SSA_H
+#define SSA_H
+
+#include "context.h"
+#include "ir.h"
+
+/**
+ * @brief Put the IR of a function in SSA form, once lowered from the tree.
+ *        Unreachable blocks are dropped, the other ones kept in the order
+ *        they are laid out. Loads and stores of the promoted variables
+ *        become registers merged by phis, then copies of single use values
+ *        and instructions whose value is never used are removed
+ *
+ * @param ctx compilation context
+ * @param ir IR of the function
+ * @param layout blocks in the order they are written
+ * @param nb_layout number of blocks in layout
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+int build_ssa(Context* ctx, IrFunction* ir, const int* layout, int nb_layout);
+
+/**
+ * @brief Compute the immediate dominators of the blocks of a function
+ *
+ * @param ir IR of the function
+ * @param idom set to the immediate dominator of each block, -1 for the
+ *             entry and -2 for the blocks not reachable from it
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+int compute_dominators(const IrFunction* ir, int* idom);
+
+#endif
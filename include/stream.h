@@ -0,0 +1,107 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "context.h"
+#include "table.h"
+#include "tree.h"
+
+typedef enum {                  // diagnostics held for a part of the source,
+                                // reported in this order as for the whole tree
+    HELD_DECLARATIONS,          // declaring the globals or a function
+    HELD_UNUSED,                // unused parameters and locals of a function
+    HELD_CHECKS,                // checking a function
+} HeldKind;
+
+typedef struct {                // diagnostics held for a part of the source
+    HeldKind kind;              // part of the compilation held
+    int fun;                    // index of the function in the collection,
+                                // -1 for the globals
+    size_t start;               // start in the held diagnostics
+    size_t end;                 // end in the held diagnostics
+    int count[NB_ERROR_TYPES];  // number of the diagnostics by type
+} HeldSection;
+
+typedef struct Stream {         // functions compiled as soon as they are parsed
+    bool failed;                // if an error stopped the compilation
+    bool stopped;               // if a wrong declaration stopped the
+                                // declarations too
+    int failed_at;              // first function of the collection whose
+                                // check failed, the next ones not being
+                                // checked, INT_MAX if none
+    FILE* out;                  // nasm target
+    Table globals;              // global variables
+    FunctionCollection functions; // signatures of the functions
+    node_t* pending;            // functions calling functions not declared yet
+    int nb_pending;             // number of pending functions
+    int max_pending;            // capacity of pending functions
+    FILE* err;                  // diagnostics target of the context
+    FILE* held;                 // diagnostics held until the source is parsed
+    char* held_buf;             // content of held
+    size_t held_len;            // length of held_buf
+    HeldSection* sections;      // parts of the held diagnostics
+    int nb_sections;            // number of sections
+    int max_sections;           // capacity of sections
+} Stream;
+
+/**
+ * @brief Initiate a streamed compilation
+ *
+ * @param ctx compilation context
+ * @param stream stream to initiate
+ * @param out nasm target, written function by function
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+int init_stream(Context* ctx, Stream* stream, FILE* out);
+
+/**
+ * @brief Free a streamed compilation
+ *
+ * @param stream
+ */
+void free_stream(Stream* stream);
+
+/**
+ * @brief Declare the global variables and write the nasm header, once the
+ *        first function is parsed
+ *
+ * @param ctx compilation context, whose stream is started
+ * @param node head node of the globals (the 'DeclVars' label)
+ */
+void start_stream(Context* ctx, node_t node);
+
+/**
+ * @brief Compile a function as soon as it is parsed, then free its nodes.
+ *        A function calling functions which are not declared yet keeps its
+ *        nodes and is compiled by `end_stream`
+ *
+ * @param ctx compilation context, whose stream is started
+ * @param node head node of the function (the 'DeclFonct' label)
+ */
+void stream_function(Context* ctx, node_t node);
+
+/**
+ * @brief Drop the diagnostics of the functions checked before a syntax
+ *        error, which are not reported when the whole tree is compiled
+ *
+ * @param ctx compilation context
+ */
+void cancel_stream(Context* ctx);
+
+/**
+ * @brief Compile the pending functions, now that all functions are
+ *        declared, end the semantic check of the program and write the used
+ *        builtins. The diagnostics held while parsing are reported in the
+ *        order of the whole tree: the declarations, main, the unused
+ *        symbols, then the checks of the functions up to the first failing
+ *
+ * @param ctx compilation context
+ * @return 1 if success
+ *         0 if an error stopped the compilation
+ */
+int end_stream(Context* ctx);
+
+#endif
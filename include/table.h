@@ -3,6 +3,8 @@
 
 #include <stdbool.h>
 
+#include "context.h"
+#include "intern.h"
 #include "tree.h"
 #include "types.h"
 
@@ -15,7 +17,7 @@ typedef struct {            // variable
     int decl_col;           // declaration column
     int size;               // size in bytes
     t_type type;            // type of variable
-    char name[IDENT_LEN];   // variable name
+    ident_t name;           // variable name
 } Entry;
 
 typedef struct {            // symbol table
@@ -32,20 +34,27 @@ typedef struct {            // symbol table for functions
     int decl_line;          // declaration line
     int decl_col;           // declaration column
     t_type r_type;          // returned type
-    char name[IDENT_LEN];   // function name
+    ident_t name;           // function name
     Table parameters;       // parameters
     Table locals;           // locals
 } Function;
 
 typedef struct {            // array of symbol table for functions
-    bool sorted;            // if functions has been sorted by name
     int cur_len;            // current number of stored functions
     int max_len;            // maximum length 
+    int nb_indexes;         // length of indexes
+    int* indexes;           // index of functions by name id, -1 if none
     Function* funcs;        // functions array
 } FunctionCollection;
 
+typedef struct {            // symbols seen by the instructions of a function
+    const Table* globals;   // global variables
+    const FunctionCollection* collection;
+    const Function* fun;    // function, with its parameters and locals
+} Scope;
+
 /**
- * @brief Function to compare 2 entries based on their names
+ * @brief Function to compare 2 entries based on the ids of their names
  * 
  * @param entry1
  * @param entry2 
@@ -53,18 +62,17 @@ typedef struct {            // array of symbol table for functions
  */
 int compare_entries(const void* entry1, const void* entry2);
 
-int compare_functions(const void* fun1, const void* fun2);
 int compare_ident_entry(const void* ident, const void* entry);
-int compare_ident_fun(const void* ident, const void* fun);
 
 /**
  * @brief Create a table structure that contains entries
  * 
+ * @param ctx compilation context
  * @param table table to create
  * @return 1 if success
  *         0 if failed due to memory error
  */
-int init_table(Table* table);
+int init_table(Context* ctx, Table* table);
 
 /**
  * @brief Check if an identifiant is in the given table.
@@ -74,32 +82,34 @@ int init_table(Table* table);
  * @return index of the entry of the given identifiant if it is in the table
  *         else -1
  */
-int is_in_table(const Table* table, const char ident[IDENT_LEN]);
+int is_in_table(const Table* table, ident_t ident);
 
-Entry* get_entry(const Table* table, const char ident[IDENT_LEN]);
+Entry* get_entry(const Table* table, ident_t ident);
 
 /**
  * @brief Create a collection of functions 
  * 
+ * @param ctx compilation context
  * @param collection collection to create
  * @return 1 if success
  *         0 if error due to memory error
  */
-int init_function_collection(FunctionCollection* collection);
+int init_function_collection(Context* ctx, FunctionCollection* collection);
 
 /**
- * @brief Check if a function identifiant is in the given collection
+ * @brief Check if a function identifiant is in the given collection, in
+ *        constant time
  * 
  * @param collection collection to search 
  * @param ident identifiant to check
  * @return index of the entry of the given identifiant if it is in the table
  *         else -1
  */
-int is_in_collection(const FunctionCollection* collection, const char ident[IDENT_LEN]);
+int is_in_collection(const FunctionCollection* collection, ident_t ident);
 
-Entry* find_entry(const Table* globals, const Function* fun, const char ident[IDENT_LEN]);
+Entry* find_entry(const Table* globals, const Function* fun, ident_t ident);
 
-Function* get_function(const FunctionCollection* collection, const char ident[IDENT_LEN]);
+Function* get_function(const FunctionCollection* collection, ident_t ident);
 
 /**
  * @brief Free allocated memory for table
@@ -108,6 +118,13 @@ Function* get_function(const FunctionCollection* collection, const char ident[ID
  */
 void free_table(Table* table);
 
+/**
+ * @brief Free allocated memory for the tables of a function
+ * 
+ * @param fun function to free
+ */
+void free_function(Function* fun);
+
 /**
  * @brief Free allocated memory for functions
  *        Free also their tables
@@ -119,26 +136,68 @@ void free_collection(FunctionCollection* collection);
 /**
  * @brief Create a symbols table for the given tree
  * 
+ * @param ctx compilation context
  * @param globals table for globals variables
  * @param collection collection of functions
  * @param node root
  * @return 1 if success
  *         0 if fail due to memory error
  */
-int create_tables(Table* globals, FunctionCollection* collection, Node* node);
+int create_tables(Context* ctx, Table* globals, FunctionCollection* collection,
+                  node_t node);
+
+/**
+ * @brief Create the symbol table of the global variables
+ * 
+ * @param ctx compilation context
+ * @param globals table for globals variables
+ * @param collection collection of functions, with the builtin ones
+ * @param node head node with the 'DeclVars' label
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+int create_globals_table(Context* ctx, Table* globals,
+                         FunctionCollection* collection, node_t node);
+
+/**
+ * @brief Create the symbol tables of a single function, once the globals
+ *        are declared, and insert it in the collection
+ * 
+ * @param ctx compilation context
+ * @param globals table for globals variables
+ * @param collection collection of functions
+ * @param node head node with the 'DeclFonct' label
+ * @param forward_calls set to the number of calls to functions which are
+ *                      not declared yet
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+int create_function_tables(Context* ctx, Table* globals,
+                           FunctionCollection* collection, node_t node,
+                           int* forward_calls);
 
 /**
  * @brief Print symbol table content
  * 
+ * @param ctx compilation context
  * @param table table to print
  */
-void print_table(Table table);
+void print_table(const Context* ctx, Table table);
+
+/**
+ * @brief Print the symbol tables of a function
+ * 
+ * @param ctx compilation context
+ * @param fun function to print
+ */
+void print_function(const Context* ctx, const Function* fun);
 
 /**
  * @brief Print function collection content
  * 
+ * @param ctx compilation context
  * @param collection collection to print
  */
-void print_collection(FunctionCollection collection);
+void print_collection(const Context* ctx, FunctionCollection collection);
 
 #endif
@@ -0,0 +1,60 @@
+#ifndef TPCC_H
+#define TPCC_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "context.h"
+#include "source.h"
+
+#define SYNTAX_ERROR   1
+#define SEMANTIC_ERROR 2
+#define OTHER_ERROR    3
+
+/**
+ * @brief Compile a TPC source held in memory into nasm. Every state of the
+ *        compilation is stored in `ctx`, so different contexts can be used
+ *        from different threads at the same time
+ * 
+ * @param ctx compilation context, initiated with `init_context`
+ * @param src source code
+ * @param len length of the source code in bytes
+ * @param out_buf set to an allocated string containing the generated nasm,
+ *                or NULL if no nasm was generated. Must be freed by the caller
+ * @return 0 if success
+ *         SYNTAX_ERROR, SEMANTIC_ERROR or OTHER_ERROR else
+ */
+int tpcc_compile_buffer(Context* ctx, const char* src, size_t len,
+                        char** out_buf);
+
+/**
+ * @brief Compile a loaded source into nasm, without copying it. Tokens of
+ *        the source are read in place, so the source must stay loaded during
+ *        the compilation. The tree is built in `ctx->arena`, reset once
+ *        compiled so that it can be reused, or in a temporary arena if NULL
+ * 
+ * @param ctx compilation context, initiated with `init_context`
+ * @param source source loaded with `load_source` or `copy_source`
+ * @param out_buf set to an allocated string containing the generated nasm,
+ *                or NULL if no nasm was generated. Must be freed by the caller
+ * @return 0 if success
+ *         SYNTAX_ERROR, SEMANTIC_ERROR or OTHER_ERROR else
+ */
+int tpcc_compile_source(Context* ctx, Source* source, char** out_buf);
+
+/**
+ * @brief Compile a loaded source into nasm, function by function. Each
+ *        function is checked and written to `out` as soon as it is parsed,
+ *        then its nodes are freed, so the tree only holds a function at a
+ *        time. Functions calling functions declared later are kept until
+ *        the end of the source. On error, `out` may hold a partial nasm
+ * 
+ * @param ctx compilation context, initiated with `init_context`
+ * @param source source loaded with `load_source` or `copy_source`
+ * @param out nasm target
+ * @return 0 if success
+ *         SYNTAX_ERROR, SEMANTIC_ERROR or OTHER_ERROR else
+ */
+int tpcc_compile_stream(Context* ctx, Source* source, FILE* out);
+
+#endif
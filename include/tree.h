@@ -2,10 +2,13 @@
 #define TREE_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
+#include "intern.h"
 #include "types.h"
 
-#define IDENT_LEN 64
+#define IDENT_LEN 64  // maximum length of identifiers, terminator included
 
 typedef enum {
     If,
@@ -46,36 +49,120 @@ typedef enum {
 
 typedef union {
     int num;
-    char ident[IDENT_LEN];
+    ident_t ident;      // interned identifier, operator or character
 } Value;
 
-typedef struct Node {
-    int colno;
-    int lineno;
-    label_t label;
-    t_type type;
-    Value val;
-    struct Node *firstChild, *nextSibling;
-} Node;
+typedef uint32_t node_t;    // id of a node in the tree of its context
 
-Node *makeNode(label_t label);
+#define NO_NODE 0           // id of no node, never given to a node
+
+typedef struct {                // abstract tree, as one column by field
+    node_t nb_nodes;            // number of nodes, NO_NODE included
+    node_t max_nodes;           // capacity of the columns
+    unsigned char* labels;      // label_t of the nodes
+    unsigned char* types;       // t_type of the nodes
+    Value* vals;
+    int* linenos;
+    int* colnos;
+    node_t* first_children;
+    node_t* next_siblings;
+    node_t* last_siblings;      // tail of the siblings, cached on the first
+} Tree;
+
+/**
+ * @brief Initiate a tree, with a capacity guessed from the source length.
+ *        Columns grow as nodes are made
+ * 
+ * @param t tree to initiate
+ * @param len length of the source
+ * @return 0 if it runs out of memory, 1 otherwise
+ */
+int init_tree(Tree* t, size_t len);
+
+/**
+ * @brief Free the columns of a tree, so all its nodes at once
+ * 
+ * @param t 
+ */
+void free_tree(Tree* t);
+
+/**
+ * @brief Free the last nodes of a tree, from nb_nodes on, so the next nodes
+ *        reuse their place. The columns keep their capacity
+ * 
+ * @param t 
+ * @param nb_nodes number of nodes kept
+ */
+void truncate_tree(Tree* t, node_t nb_nodes);
+
+/**
+ * @brief Compute the memory taken by the columns of a tree
+ * 
+ * @param t 
+ * @return size in bytes
+ */
+size_t tree_bytes(const Tree* t);
 
 /**
- * @brief Make a node which contains a value
+ * @brief Make a node in the tree of the context. Nodes are freed all at
+ *        once with the tree
  * 
+ * @param ctx compilation context, which gives the node position and tree
+ * @param label 
+ * @return id of the node
+ */
+node_t makeNode(Context* ctx, label_t label);
+
+/**
+ * @brief Make a node which contains a value, in the tree of the context
+ * 
+ * @param ctx compilation context, which gives the node position and tree
  * @param val 
  * @param type 
- * @return Node* 
+ * @return id of the node
+ */
+node_t makeNodeWithValue(Context* ctx, Value val, label_t label);
+void setAsArray(Context* ctx, node_t node);
+/**
+ * @brief Append a node, and its own siblings, at the end of the siblings of
+ *        a node. Tail of the siblings is cached, so appending to the same
+ *        node takes a constant time
+ * 
+ * @param ctx compilation context
+ * @param node first node of the siblings
+ * @param sibling node to append
+ */
+void addSibling(Context* ctx, node_t node, node_t sibling);
+
+/**
+ * @brief Append a node, and its own siblings, at the end of the children
+ *        of a node, in constant time
+ * 
+ * @param ctx compilation context
+ * @param parent 
+ * @param child 
+ */
+void addChild(Context* ctx, node_t parent, node_t child);
+
+/**
+ * @brief Replace a node by another one, usually one of its descendants. The
+ *        node keeps its place among its siblings, its type and its position
+ * 
+ * @param ctx compilation context
+ * @param node replaced node
+ * @param by node taking its place
  */
-Node *makeNodeWithValue(Value val, label_t label);
-void setAsArray(Node* node);
-void addSibling(Node *node, Node *sibling);
-void addChild(Node *parent, Node *child);
-void deleteTree(Node*node);
-void printTree(Node *node);
-
-#define FIRSTCHILD(node) node->firstChild
-#define SECONDCHILD(node) node->firstChild->nextSibling
-#define THIRDCHILD(node) node->firstChild->nextSibling->nextSibling
+void replaceNode(Context* ctx, node_t node, node_t by);
+void printTree(Context* ctx, node_t node);
+
+#define NODE_LABEL(ctx, node) (ctx)->tree.labels[node]
+#define NODE_TYPE(ctx, node) (ctx)->tree.types[node]
+#define NODE_VAL(ctx, node) (ctx)->tree.vals[node]
+#define NODE_LINENO(ctx, node) (ctx)->tree.linenos[node]
+#define NODE_COLNO(ctx, node) (ctx)->tree.colnos[node]
+#define NEXTSIBLING(ctx, node) (ctx)->tree.next_siblings[node]
+#define FIRSTCHILD(ctx, node) (ctx)->tree.first_children[node]
+#define SECONDCHILD(ctx, node) NEXTSIBLING(ctx, FIRSTCHILD(ctx, node))
+#define THIRDCHILD(ctx, node) NEXTSIBLING(ctx, SECONDCHILD(ctx, node))
 
 #endif
@@ -0,0 +1,120 @@
+#ifndef WALK_H
+#define WALK_H
+
+#include <stdbool.h>
+
+#include "context.h"
+#include "tree.h"
+
+typedef struct {                // visit of a node, or of a list of siblings
+    node_t node;                // visited node, or next node of the list
+    int step;                   // number of times the visit was resumed
+    bool list;                  // if the frame visits a list of siblings
+    node_t cursor;              // node kept by the visit between its steps
+    int data[3];                // values kept by the visit between its steps
+} Frame;
+
+typedef struct Walk Walk;
+
+/**
+ * @brief Visit of a node by a pass. It is called once the node is reached,
+ *        with a step of 0, and resumed with the next step each time the
+ *        child it scheduled has been visited. The visit of the node ends at
+ *        the first step which does not schedule anything
+ *
+ * @param walk walk visiting the node
+ * @param frame frame of the node, where the visit keeps its state
+ * @return 0 to stop the walk, 1 otherwise
+ */
+typedef int (*Visit)(Walk* walk, Frame* frame);
+
+typedef enum {
+    SCHEDULE_NONE,
+    SCHEDULE_NODE,
+    SCHEDULE_LIST,
+    SCHEDULE_REVERSED_LIST,
+    SCHEDULE_BREAK
+} Schedule;
+
+struct Walk {                   // iterative traversal of a tree
+    Context* ctx;
+    Visit visit;                // visit of each node by the pass
+    void* pass;                 // state of the pass walking the tree
+    Frame* frames;              // explicit stack of the visits, on the heap
+    int depth;                  // number of frames in the stack
+    int max_depth;              // capacity of the stack
+    Schedule schedule;          // what the current step asked to visit
+    node_t scheduled;           // node or first node scheduled
+};
+
+/**
+ * @brief Initiate a walk. Its stack is kept between the trees it walks
+ *
+ * @param walk walk to initiate
+ * @param ctx compilation context, which holds the tree
+ * @param visit visit of each node
+ * @param pass state of the pass, given to the visits
+ */
+void init_walk(Walk* walk, Context* ctx, Visit visit, void* pass);
+
+/**
+ * @brief Free the stack of a walk
+ *
+ * @param walk
+ */
+void free_walk(Walk* walk);
+
+/**
+ * @brief Visit a node and its siblings, and all their descendants scheduled
+ *        by the visits. The native stack does not grow with the depth of
+ *        the tree nor with the length of the lists
+ *
+ * @param walk
+ * @param first first node of the list
+ * @return 0 if a visit stopped the walk, 1 otherwise
+ */
+int walk_tree(Walk* walk, node_t first);
+
+/**
+ * @brief Schedule the visit of a node, before the next step of the current
+ *        visit. Nothing is visited for NO_NODE, but the visit is resumed
+ *
+ * @param walk
+ * @param node
+ */
+void visit_node(Walk* walk, node_t node);
+
+/**
+ * @brief Schedule the visit of a node and of its siblings, in order
+ *
+ * @param walk
+ * @param first first node of the list
+ */
+void visit_list(Walk* walk, node_t first);
+
+/**
+ * @brief Schedule the visit of a node and of its siblings, from the last
+ *        one to the first one
+ *
+ * @param walk
+ * @param first first node of the list
+ */
+void visit_reversed_list(Walk* walk, node_t first);
+
+/**
+ * @brief End the current visit, and skip the siblings of its node which
+ *        are not visited yet in their list
+ *
+ * @param walk
+ */
+void break_list(Walk* walk);
+
+/**
+ * @brief Tell if the current step scheduled a visit
+ *
+ * @param walk
+ * @return true if the visit will be resumed
+ */
+bool visit_scheduled(const Walk* walk);
+
+#endif
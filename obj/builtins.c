@@ -0,0 +1,200 @@
+// generated from builtin/getchar.asm builtin/getint.asm builtin/putchar.asm builtin/putint.asm by builtin/embed.sh
+#include "builtins.h"
+
+const EmbeddedBuiltin embedded_builtins[] = {
+    {"getchar", (const char*[]){NULL},
+     "; registre de retour de fonction : rax\n"
+     "getchar:\n"
+     "    ; convention d'appel AMD 64\n"
+     "    push    rbp\n"
+     "    mov     rbp, rsp       \n"
+     "    \n"
+     "    ; On réserve dans la pile un octet pour stocker la valeur\n"
+     "    sub     rsp, 8\n"
+     "    mov     qword [rsp], 0\n"
+     "\n"
+     "    ; Appel systeme pour récupérer le prochain charactere\n"
+     "    mov     rax, 0          ; read\n"
+     "    mov     rdi, 0          ; stdin\n"
+     "    mov     rsi, rsp        ; adresse de retour\n"
+     "    mov     rdx, 1          ; taille de la lecture\n"
+     "    syscall\n"
+     "    \n"
+     "    ; On met le charactere recupere dans rax\n"
+     "    pop     rax\n"
+     "\n"
+     "    ; Restitution de la pile\n"
+     "    mov     rsp, rbp\n"
+     "    pop     rbp\n"
+     "    \n"
+     "    ret\n"
+    },
+    {"getint", (const char*[]){"getchar", NULL},
+     "; Brief: getint\n"
+     ";    lit sur l'entrée standard un nombre \n"
+     "; Arguments:\n"
+     ";   aucun\n"
+     "; retourne:\n"
+     ";   un int\n"
+     "\n"
+     "; Registres utilisés\n"
+     "; r11: nombre de characteres lus\n"
+     "; r12: flag si le nombre entré est négatif\n"
+     "; r13: stocke le résultat temporaire\n"
+     "; rax: valeurs de retour de 'getchar' et de 'getint'\n"
+     "getint:\n"
+     "    ; conventions d'appels AMD64 \n"
+     "    push    rbp             ; sauvegarde le pointeur de base\n"
+     "    mov     rbp, rsp        ; rbp = rsp\n"
+     "\n"
+     "    ; On sauvegarde les registres non volatils\n"
+     "    push    r11\n"
+     "    push    r12\n"
+     "    push    r13\n"
+     "\n"
+     "    call    getchar         ; récupère le premier character\n"
+     "\n"
+     "    mov     r11, 0          ; Initialise la longueur du nombre\n"
+     "    mov     r12, 0          ; Initialise les flags\n"
+     "    mov     r13, 0          ; Initialise le résultat\n"
+     "    \n"
+     "    cmp     rax, '-'\n"
+     "    jne     check_gint      ; rax n'est pas '-', c'est donc un nombre. On passe directement à la conversion \n"
+     "    mov     r12, 1          ; r12 possède le flag 'nombre negatif' \n"
+     "\n"
+     "next_char_gint:\n"
+     "    call    getchar         ; récupère le prochain character dans rax\n"
+     "\n"
+     "check_gint:\n"
+     "    ; On vérifie si le charactère est un chiffre/la saisie est terminée\n"
+     "    cmp     rax, 0\n"
+     "    je      final_gint     ; rax == '\\0'\n"
+     "    cmp     rax, '0'       ; \n"
+     "    jl      final_gint     ; rax < '0'\n"
+     "    cmp     rax, '9'       ; \n"
+     "    jg      final_gint     ; rax > '9'\n"
+     "\n"
+     "convert_gint: \n"
+     "    ; Conversion du 'char' rax en int et ajout au résultat\n"
+     "\n"
+     "    imul    r13, 10        ; r13 *= 10\n"
+     "    sub     rax, '0'       ; rax = int(rax)\n"
+     "    add     r13, rax       ; r13 += rax\n"
+     "    inc     r11            ; r11++ \n"
+     "    jmp     next_char_gint\n"
+     "\n"
+     "final_gint:\n"
+     "    ; Prépare la sortie de fonction\n"
+     "    mov     rax, r13       ; on met le résultat dans le registre de retour\n"
+     "\n"
+     "    cmp     r12, 1         ; on regarde si le flag 'neg' sur r12 est renseigné\n"
+     "    jne     quit_gint      ; pas négatif, on quitte normalement\n"
+     "    neg     rax            ; c'est négatif, on lui applique la fonction 'neg'\n"
+     "\n"
+     "quit_gint:\n"
+     "    ; Détermine quelle sortie appeler en cas d'erreur et de sortie correcte\n"
+     "    cmp     r11, 0\n"
+     "    je      exit_failure_gint\n"
+     "    \n"
+     "    ; On restaure les registres non volatils\n"
+     "    pop     r13\n"
+     "    pop     r12\n"
+     "    pop     r11\n"
+     "\n"
+     "    mov     rsp, rbp       ; restore stack\n"
+     "    pop     rbp\n"
+     "    ret\n"
+     "\n"
+     "exit_failure_gint:\n"
+     "    ; Sortie en cas d'erreur\n"
+     "    mov     rax, 60        ; rax = 60\n"
+     "    mov     rdi, 5         ; rdi = 5\n"
+     "    syscall\n"
+    },
+    {"putchar", (const char*[]){NULL},
+     "; registre d'argument de fonction : rdi\n"
+     "putchar:\n"
+     "    ; convention d'appel AMD64\n"
+     "    push    rbp\n"
+     "    mov     rbp, rsp\n"
+     "    \n"
+     "    ; on met sur la pile le caractère a afficher\n"
+     "    push    rdi\n"
+     "\n"
+     "    ; Appel systeme d'affichage\n"
+     "    mov     rdi, 1   ; stdout\n"
+     "    mov     rax, 1   ; stdout\n"
+     "    mov     rsi, rsp ; charactere a afficher\n"
+     "    mov     rdx, 1   ; taille de la variable à écrire\n"
+     "    syscall          ; appel à write\n"
+     "\n"
+     "    ; restauration de la pile\n"
+     "    mov     rsp, rbp\n"
+     "    pop     rbp\n"
+     "    \n"
+     "    ret\n"
+    },
+    {"putint", (const char*[]){"putchar", NULL},
+     "; rax: int à afficher \n"
+     "; rbx: diviseur\n"
+     "; rdx: reste de la division\n"
+     "; r12: length\n"
+     "putint:\n"
+     "    ; convention d'appel AMD64\n"
+     "    push    rbp\n"
+     "    mov     rbp, rsp\n"
+     "\n"
+     "    ; On sauvegarde les registres non volatils\n"
+     "    push    r12\n"
+     "\n"
+     "    ; Initialisation des registres\n"
+     "    mov     rax, rdi        ; sauvegarde de l'entier à afficher\n"
+     "    mov     rbx, 10         ; diviseur\n"
+     "    mov     r12, 0\n"
+     "\n"
+     "    cmp     rax, 0\n"
+     "    je      print_zero      ; on veut juste afficher 0 et quitter\n"
+     "    jge     loop_label_pint ; si l'entier à afficher est plus grand que 0, on l'affiche directement\n"
+     "\n"
+     "    ; manage negatives\n"
+     "    push    rax             ; save rax\n"
+     "    mov     rdi, '-'\n"
+     "    call    putchar         ; print the neg sign\n"
+     "    pop     rax\n"
+     "    neg     rax\n"
+     "    jmp     loop_label_pint\n"
+     "\n"
+     "print_zero:\n"
+     "    mov     rdi, '0'\n"
+     "    call    putchar\n"
+     "    jmp     exit_pint\n"
+     "\n"
+     "loop_label_pint:\n"
+     "    cmp     rax, 0\n"
+     "    je      print_pint\n"
+     "    mov     rdx, 0          ; initialise le reste\n"
+     "    idiv    rbx             ; rax = rax // rbx, rdx = rax % rbx\n"
+     "    add     rdx, '0'        ; rdx += '0'\n"
+     "    push    rdx\n"
+     "    inc     r12\n"
+     "    jmp     loop_label_pint\n"
+     "\n"
+     "print_pint:\n"
+     "    cmp     r12, 0\n"
+     "    je      exit_pint\n"
+     "\n"
+     "    pop     rdi\n"
+     "    call    putchar\n"
+     "\n"
+     "    dec     r12\n"
+     "    jmp     print_pint\n"
+     "\n"
+     "exit_pint:\n"
+     "    pop     r12\n"
+     "\n"
+     "    mov     rsp, rbp        ; restore pile\n"
+     "    pop     rbp\n"
+     "    ret\n"
+    },
+    {NULL, NULL, NULL}
+};
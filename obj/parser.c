@@ -0,0 +1,1965 @@
+/* A Bison parser, made by GNU Bison 3.8.2.  */
+
+/* Bison implementation for Yacc-like parsers in C
+
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
+   Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* As a special exception, you may create a larger work that contains
+   part or all of the Bison parser skeleton and distribute that work
+   under terms of your choice, so long as that work isn't itself a
+   parser generator using the skeleton or a modified version thereof
+   as a parser skeleton.  Alternatively, if you modify or redistribute
+   the parser skeleton itself, you may (at your option) remove this
+   special exception, which will cause the skeleton and the resulting
+   Bison output files to be licensed under the GNU General Public
+   License without this special exception.
+
+   This special exception was added by the Free Software Foundation in
+   version 2.2 of Bison.  */
+
+/* C LALR(1) parser skeleton written by Richard Stallman, by
+   simplifying the original so-called "semantic" parser.  */
+
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
+
+/* All symbols defined below should begin with yy or YY, to avoid
+   infringing on user name space.  This should be done even for local
+   variables, as they might otherwise be expanded by user macros.
+   There are some unavoidable exceptions within include files to
+   define necessary library symbols; they are noted "INFRINGES ON
+   USER NAME SPACE" below.  */
+
+/* Identify Bison output, and Bison version.  */
+#define YYBISON 30802
+
+/* Bison version string.  */
+#define YYBISON_VERSION "3.8.2"
+
+/* Skeleton name.  */
+#define YYSKELETON_NAME "yacc.c"
+
+/* Pure parsers.  */
+#define YYPURE 2
+
+/* Push parsers.  */
+#define YYPUSH 0
+
+/* Pull parsers.  */
+#define YYPULL 1
+
+
+
+
+/* First part of user prologue.  */
+#line 1 "src/parser.y"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "tree.h"
+#include "context.h"
+#include "intern.h"
+#include "lexer.h"
+#include "parser.h"
+#include "stream.h"
+
+// the parser stack grows on the heap, so nesting is only bounded by memory
+#define YYMAXDEPTH 100000000
+
+/**
+ * @brief Set a value with the type of int
+ */
+Value to_int(int n);
+
+/**
+ * @brief Set a value with an identifier, interned in the context
+ */
+static Value make_ident(Context* ctx, const char* text, size_t len);
+
+/**
+ * @brief Set a value with an identifier
+ */
+Value to_ident(Context* ctx, const char* str);
+
+/**
+ * @brief Set a value with an identifier, from a token of the source
+ */
+Value span_to_ident(Context* ctx, Span span);
+
+/**
+ * @brief Wrap a parsed function in a 'DeclFonct' node added to the list, or
+ *        compile it at once if streamed, then return NO_NODE
+ */
+static node_t add_function(Context* ctx, node_t list, node_t head);
+
+
+#line 114 "obj/parser.c"
+
+# ifndef YY_CAST
+#  ifdef __cplusplus
+#   define YY_CAST(Type, Val) static_cast<Type> (Val)
+#   define YY_REINTERPRET_CAST(Type, Val) reinterpret_cast<Type> (Val)
+#  else
+#   define YY_CAST(Type, Val) ((Type) (Val))
+#   define YY_REINTERPRET_CAST(Type, Val) ((Type) (Val))
+#  endif
+# endif
+# ifndef YY_NULLPTR
+#  if defined __cplusplus
+#   if 201103L <= __cplusplus
+#    define YY_NULLPTR nullptr
+#   else
+#    define YY_NULLPTR 0
+#   endif
+#  else
+#   define YY_NULLPTR ((void*)0)
+#  endif
+# endif
+
+#include "tokens.h"
+/* Symbol kind.  */
+enum yysymbol_kind_t
+{
+  YYSYMBOL_YYEMPTY = -2,
+  YYSYMBOL_YYEOF = 0,                      /* "end of file"  */
+  YYSYMBOL_YYerror = 1,                    /* error  */
+  YYSYMBOL_YYUNDEF = 2,                    /* "invalid token"  */
+  YYSYMBOL_IF = 3,                         /* IF  */
+  YYSYMBOL_WHILE = 4,                      /* WHILE  */
+  YYSYMBOL_RETURN = 5,                     /* RETURN  */
+  YYSYMBOL_ELSE = 6,                       /* ELSE  */
+  YYSYMBOL_TYPE = 7,                       /* TYPE  */
+  YYSYMBOL_VOID = 8,                       /* VOID  */
+  YYSYMBOL_AND = 9,                        /* AND  */
+  YYSYMBOL_OR = 10,                        /* OR  */
+  YYSYMBOL_EQ = 11,                        /* EQ  */
+  YYSYMBOL_ORDER = 12,                     /* ORDER  */
+  YYSYMBOL_ADDSUB = 13,                    /* ADDSUB  */
+  YYSYMBOL_DIVSTAR = 14,                   /* DIVSTAR  */
+  YYSYMBOL_CHARACTER = 15,                 /* CHARACTER  */
+  YYSYMBOL_IDENT = 16,                     /* IDENT  */
+  YYSYMBOL_NUM = 17,                       /* NUM  */
+  YYSYMBOL_18_ = 18,                       /* ';'  */
+  YYSYMBOL_19_ = 19,                       /* ','  */
+  YYSYMBOL_20_ = 20,                       /* '['  */
+  YYSYMBOL_21_ = 21,                       /* ']'  */
+  YYSYMBOL_22_ = 22,                       /* '('  */
+  YYSYMBOL_23_ = 23,                       /* ')'  */
+  YYSYMBOL_24_ = 24,                       /* '{'  */
+  YYSYMBOL_25_ = 25,                       /* '}'  */
+  YYSYMBOL_26_ = 26,                       /* '='  */
+  YYSYMBOL_27_ = 27,                       /* '!'  */
+  YYSYMBOL_YYACCEPT = 28,                  /* $accept  */
+  YYSYMBOL_Prog = 29,                      /* Prog  */
+  YYSYMBOL_DeclVars = 30,                  /* DeclVars  */
+  YYSYMBOL_Declarateurs = 31,              /* Declarateurs  */
+  YYSYMBOL_DeclFoncts = 32,                /* DeclFoncts  */
+  YYSYMBOL_DeclFonct = 33,                 /* DeclFonct  */
+  YYSYMBOL_EnTeteFonct = 34,               /* EnTeteFonct  */
+  YYSYMBOL_Parametres = 35,                /* Parametres  */
+  YYSYMBOL_ListTypVar = 36,                /* ListTypVar  */
+  YYSYMBOL_Corps = 37,                     /* Corps  */
+  YYSYMBOL_SuiteInstr = 38,                /* SuiteInstr  */
+  YYSYMBOL_Instr = 39,                     /* Instr  */
+  YYSYMBOL_Exp = 40,                       /* Exp  */
+  YYSYMBOL_TB = 41,                        /* TB  */
+  YYSYMBOL_FB = 42,                        /* FB  */
+  YYSYMBOL_M = 43,                         /* M  */
+  YYSYMBOL_E = 44,                         /* E  */
+  YYSYMBOL_T = 45,                         /* T  */
+  YYSYMBOL_F = 46,                         /* F  */
+  YYSYMBOL_LValue = 47,                    /* LValue  */
+  YYSYMBOL_Arguments = 48,                 /* Arguments  */
+  YYSYMBOL_ListExp = 49                    /* ListExp  */
+};
+typedef enum yysymbol_kind_t yysymbol_kind_t;
+
+
+
+/* Unqualified %code blocks.  */
+#line 48 "src/parser.y"
+
+int flex_lex(YYSTYPE* lval, void* scanner);
+int fast_lex(YYSTYPE* lval, void* scanner);
+static int yylex(YYSTYPE* lval, void* scanner, Context* ctx);
+void yyerror(void* scanner, Context* ctx, node_t* tree, char* msg);
+
+#line 205 "obj/parser.c"
+
+#ifdef short
+# undef short
+#endif
+
+/* On compilers that do not define __PTRDIFF_MAX__ etc., make sure
+   <limits.h> and (if available) <stdint.h> are included
+   so that the code can choose integer types of a good width.  */
+
+#ifndef __PTRDIFF_MAX__
+# include <limits.h> /* INFRINGES ON USER NAME SPACE */
+# if defined __STDC_VERSION__ && 199901 <= __STDC_VERSION__
+#  include <stdint.h> /* INFRINGES ON USER NAME SPACE */
+#  define YY_STDINT_H
+# endif
+#endif
+
+/* Narrow types that promote to a signed type and that can represent a
+   signed or unsigned integer of at least N bits.  In tables they can
+   save space and decrease cache pressure.  Promoting to a signed type
+   helps avoid bugs in integer arithmetic.  */
+
+#ifdef __INT_LEAST8_MAX__
+typedef __INT_LEAST8_TYPE__ yytype_int8;
+#elif defined YY_STDINT_H
+typedef int_least8_t yytype_int8;
+#else
+typedef signed char yytype_int8;
+#endif
+
+#ifdef __INT_LEAST16_MAX__
+typedef __INT_LEAST16_TYPE__ yytype_int16;
+#elif defined YY_STDINT_H
+typedef int_least16_t yytype_int16;
+#else
+typedef short yytype_int16;
+#endif
+
+/* Work around bug in HP-UX 11.23, which defines these macros
+   incorrectly for preprocessor constants.  This workaround can likely
+   be removed in 2023, as HPE has promised support for HP-UX 11.23
+   (aka HP-UX 11i v2) only through the end of 2022; see Table 2 of
+   <https://h20195.www2.hpe.com/V2/getpdf.aspx/4AA4-7673ENW.pdf>.  */
+#ifdef __hpux
+# undef UINT_LEAST8_MAX
+# undef UINT_LEAST16_MAX
+# define UINT_LEAST8_MAX 255
+# define UINT_LEAST16_MAX 65535
+#endif
+
+#if defined __UINT_LEAST8_MAX__ && __UINT_LEAST8_MAX__ <= __INT_MAX__
+typedef __UINT_LEAST8_TYPE__ yytype_uint8;
+#elif (!defined __UINT_LEAST8_MAX__ && defined YY_STDINT_H \
+       && UINT_LEAST8_MAX <= INT_MAX)
+typedef uint_least8_t yytype_uint8;
+#elif !defined __UINT_LEAST8_MAX__ && UCHAR_MAX <= INT_MAX
+typedef unsigned char yytype_uint8;
+#else
+typedef short yytype_uint8;
+#endif
+
+#if defined __UINT_LEAST16_MAX__ && __UINT_LEAST16_MAX__ <= __INT_MAX__
+typedef __UINT_LEAST16_TYPE__ yytype_uint16;
+#elif (!defined __UINT_LEAST16_MAX__ && defined YY_STDINT_H \
+       && UINT_LEAST16_MAX <= INT_MAX)
+typedef uint_least16_t yytype_uint16;
+#elif !defined __UINT_LEAST16_MAX__ && USHRT_MAX <= INT_MAX
+typedef unsigned short yytype_uint16;
+#else
+typedef int yytype_uint16;
+#endif
+
+#ifndef YYPTRDIFF_T
+# if defined __PTRDIFF_TYPE__ && defined __PTRDIFF_MAX__
+#  define YYPTRDIFF_T __PTRDIFF_TYPE__
+#  define YYPTRDIFF_MAXIMUM __PTRDIFF_MAX__
+# elif defined PTRDIFF_MAX
+#  ifndef ptrdiff_t
+#   include <stddef.h> /* INFRINGES ON USER NAME SPACE */
+#  endif
+#  define YYPTRDIFF_T ptrdiff_t
+#  define YYPTRDIFF_MAXIMUM PTRDIFF_MAX
+# else
+#  define YYPTRDIFF_T long
+#  define YYPTRDIFF_MAXIMUM LONG_MAX
+# endif
+#endif
+
+#ifndef YYSIZE_T
+# ifdef __SIZE_TYPE__
+#  define YYSIZE_T __SIZE_TYPE__
+# elif defined size_t
+#  define YYSIZE_T size_t
+# elif defined __STDC_VERSION__ && 199901 <= __STDC_VERSION__
+#  include <stddef.h> /* INFRINGES ON USER NAME SPACE */
+#  define YYSIZE_T size_t
+# else
+#  define YYSIZE_T unsigned
+# endif
+#endif
+
+#define YYSIZE_MAXIMUM                                  \
+  YY_CAST (YYPTRDIFF_T,                                 \
+           (YYPTRDIFF_MAXIMUM < YY_CAST (YYSIZE_T, -1)  \
+            ? YYPTRDIFF_MAXIMUM                         \
+            : YY_CAST (YYSIZE_T, -1)))
+
+#define YYSIZEOF(X) YY_CAST (YYPTRDIFF_T, sizeof (X))
+
+
+/* Stored state numbers (used for stacks). */
+typedef yytype_int8 yy_state_t;
+
+/* State numbers in computations.  */
+typedef int yy_state_fast_t;
+
+#ifndef YY_
+# if defined YYENABLE_NLS && YYENABLE_NLS
+#  if ENABLE_NLS
+#   include <libintl.h> /* INFRINGES ON USER NAME SPACE */
+#   define YY_(Msgid) dgettext ("bison-runtime", Msgid)
+#  endif
+# endif
+# ifndef YY_
+#  define YY_(Msgid) Msgid
+# endif
+#endif
+
+
+#ifndef YY_ATTRIBUTE_PURE
+# if defined __GNUC__ && 2 < __GNUC__ + (96 <= __GNUC_MINOR__)
+#  define YY_ATTRIBUTE_PURE __attribute__ ((__pure__))
+# else
+#  define YY_ATTRIBUTE_PURE
+# endif
+#endif
+
+#ifndef YY_ATTRIBUTE_UNUSED
+# if defined __GNUC__ && 2 < __GNUC__ + (7 <= __GNUC_MINOR__)
+#  define YY_ATTRIBUTE_UNUSED __attribute__ ((__unused__))
+# else
+#  define YY_ATTRIBUTE_UNUSED
+# endif
+#endif
+
+/* Suppress unused-variable warnings by "using" E.  */
+#if ! defined lint || defined __GNUC__
+# define YY_USE(E) ((void) (E))
+#else
+# define YY_USE(E) /* empty */
+#endif
+
+/* Suppress an incorrect diagnostic about yylval being uninitialized.  */
+#if defined __GNUC__ && ! defined __ICC && 406 <= __GNUC__ * 100 + __GNUC_MINOR__
+# if __GNUC__ * 100 + __GNUC_MINOR__ < 407
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")
+# else
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")              \
+    _Pragma ("GCC diagnostic ignored \"-Wmaybe-uninitialized\"")
+# endif
+# define YY_IGNORE_MAYBE_UNINITIALIZED_END      \
+    _Pragma ("GCC diagnostic pop")
+#else
+# define YY_INITIAL_VALUE(Value) Value
+#endif
+#ifndef YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+# define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+# define YY_IGNORE_MAYBE_UNINITIALIZED_END
+#endif
+#ifndef YY_INITIAL_VALUE
+# define YY_INITIAL_VALUE(Value) /* Nothing. */
+#endif
+
+#if defined __cplusplus && defined __GNUC__ && ! defined __ICC && 6 <= __GNUC__
+# define YY_IGNORE_USELESS_CAST_BEGIN                          \
+    _Pragma ("GCC diagnostic push")                            \
+    _Pragma ("GCC diagnostic ignored \"-Wuseless-cast\"")
+# define YY_IGNORE_USELESS_CAST_END            \
+    _Pragma ("GCC diagnostic pop")
+#endif
+#ifndef YY_IGNORE_USELESS_CAST_BEGIN
+# define YY_IGNORE_USELESS_CAST_BEGIN
+# define YY_IGNORE_USELESS_CAST_END
+#endif
+
+
+#define YY_ASSERT(E) ((void) (0 && (E)))
+
+#if !defined yyoverflow
+
+/* The parser invokes alloca or malloc; define the necessary symbols.  */
+
+# ifdef YYSTACK_USE_ALLOCA
+#  if YYSTACK_USE_ALLOCA
+#   ifdef __GNUC__
+#    define YYSTACK_ALLOC __builtin_alloca
+#   elif defined __BUILTIN_VA_ARG_INCR
+#    include <alloca.h> /* INFRINGES ON USER NAME SPACE */
+#   elif defined _AIX
+#    define YYSTACK_ALLOC __alloca
+#   elif defined _MSC_VER
+#    include <malloc.h> /* INFRINGES ON USER NAME SPACE */
+#    define alloca _alloca
+#   else
+#    define YYSTACK_ALLOC alloca
+#    if ! defined _ALLOCA_H && ! defined EXIT_SUCCESS
+#     include <stdlib.h> /* INFRINGES ON USER NAME SPACE */
+      /* Use EXIT_SUCCESS as a witness for stdlib.h.  */
+#     ifndef EXIT_SUCCESS
+#      define EXIT_SUCCESS 0
+#     endif
+#    endif
+#   endif
+#  endif
+# endif
+
+# ifdef YYSTACK_ALLOC
+   /* Pacify GCC's 'empty if-body' warning.  */
+#  define YYSTACK_FREE(Ptr) do { /* empty */; } while (0)
+#  ifndef YYSTACK_ALLOC_MAXIMUM
+    /* The OS might guarantee only one guard page at the bottom of the stack,
+       and a page size can be as small as 4096 bytes.  So we cannot safely
+       invoke alloca (N) if N exceeds 4096.  Use a slightly smaller number
+       to allow for a few compiler-allocated temporary stack slots.  */
+#   define YYSTACK_ALLOC_MAXIMUM 4032 /* reasonable circa 2006 */
+#  endif
+# else
+#  define YYSTACK_ALLOC YYMALLOC
+#  define YYSTACK_FREE YYFREE
+#  ifndef YYSTACK_ALLOC_MAXIMUM
+#   define YYSTACK_ALLOC_MAXIMUM YYSIZE_MAXIMUM
+#  endif
+#  if (defined __cplusplus && ! defined EXIT_SUCCESS \
+       && ! ((defined YYMALLOC || defined malloc) \
+             && (defined YYFREE || defined free)))
+#   include <stdlib.h> /* INFRINGES ON USER NAME SPACE */
+#   ifndef EXIT_SUCCESS
+#    define EXIT_SUCCESS 0
+#   endif
+#  endif
+#  ifndef YYMALLOC
+#   define YYMALLOC malloc
+#   if ! defined malloc && ! defined EXIT_SUCCESS
+void *malloc (YYSIZE_T); /* INFRINGES ON USER NAME SPACE */
+#   endif
+#  endif
+#  ifndef YYFREE
+#   define YYFREE free
+#   if ! defined free && ! defined EXIT_SUCCESS
+void free (void *); /* INFRINGES ON USER NAME SPACE */
+#   endif
+#  endif
+# endif
+#endif /* !defined yyoverflow */
+
+#if (! defined yyoverflow \
+     && (! defined __cplusplus \
+         || (defined YYSTYPE_IS_TRIVIAL && YYSTYPE_IS_TRIVIAL)))
+
+/* A type that is properly aligned for any stack member.  */
+union yyalloc
+{
+  yy_state_t yyss_alloc;
+  YYSTYPE yyvs_alloc;
+};
+
+/* The size of the maximum gap between one aligned stack and the next.  */
+# define YYSTACK_GAP_MAXIMUM (YYSIZEOF (union yyalloc) - 1)
+
+/* The size of an array large to enough to hold all stacks, each with
+   N elements.  */
+# define YYSTACK_BYTES(N) \
+     ((N) * (YYSIZEOF (yy_state_t) + YYSIZEOF (YYSTYPE)) \
+      + YYSTACK_GAP_MAXIMUM)
+
+# define YYCOPY_NEEDED 1
+
+/* Relocate STACK from its old location to the new one.  The
+   local variables YYSIZE and YYSTACKSIZE give the old and new number of
+   elements in the stack, and YYPTR gives the new location of the
+   stack.  Advance YYPTR to a properly aligned location for the next
+   stack.  */
+# define YYSTACK_RELOCATE(Stack_alloc, Stack)                           \
+    do                                                                  \
+      {                                                                 \
+        YYPTRDIFF_T yynewbytes;                                         \
+        YYCOPY (&yyptr->Stack_alloc, Stack, yysize);                    \
+        Stack = &yyptr->Stack_alloc;                                    \
+        yynewbytes = yystacksize * YYSIZEOF (*Stack) + YYSTACK_GAP_MAXIMUM; \
+        yyptr += yynewbytes / YYSIZEOF (*yyptr);                        \
+      }                                                                 \
+    while (0)
+
+#endif
+
+#if defined YYCOPY_NEEDED && YYCOPY_NEEDED
+/* Copy COUNT objects from SRC to DST.  The source and destination do
+   not overlap.  */
+# ifndef YYCOPY
+#  if defined __GNUC__ && 1 < __GNUC__
+#   define YYCOPY(Dst, Src, Count) \
+      __builtin_memcpy (Dst, Src, YY_CAST (YYSIZE_T, (Count)) * sizeof (*(Src)))
+#  else
+#   define YYCOPY(Dst, Src, Count)              \
+      do                                        \
+        {                                       \
+          YYPTRDIFF_T yyi;                      \
+          for (yyi = 0; yyi < (Count); yyi++)   \
+            (Dst)[yyi] = (Src)[yyi];            \
+        }                                       \
+      while (0)
+#  endif
+# endif
+#endif /* !YYCOPY_NEEDED */
+
+/* YYFINAL -- State number of the termination state.  */
+#define YYFINAL  3
+/* YYLAST -- Last index in YYTABLE.  */
+#define YYLAST   131
+
+/* YYNTOKENS -- Number of terminals.  */
+#define YYNTOKENS  28
+/* YYNNTS -- Number of nonterminals.  */
+#define YYNNTS  22
+/* YYNRULES -- Number of rules.  */
+#define YYNRULES  56
+/* YYNSTATES -- Number of states.  */
+#define YYNSTATES  117
+
+/* YYMAXUTOK -- Last valid token kind.  */
+#define YYMAXUTOK   272
+
+
+/* YYTRANSLATE(TOKEN-NUM) -- Symbol number corresponding to TOKEN-NUM
+   as returned by yylex, with out-of-bounds checking.  */
+#define YYTRANSLATE(YYX)                                \
+  (0 <= (YYX) && (YYX) <= YYMAXUTOK                     \
+   ? YY_CAST (yysymbol_kind_t, yytranslate[YYX])        \
+   : YYSYMBOL_YYUNDEF)
+
+/* YYTRANSLATE[TOKEN-NUM] -- Symbol number corresponding to TOKEN-NUM
+   as returned by yylex.  */
+static const yytype_int8 yytranslate[] =
+{
+       0,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,    27,     2,     2,     2,     2,     2,     2,
+      22,    23,     2,     2,    19,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,    18,
+       2,    26,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,    20,     2,    21,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,    24,     2,    25,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     1,     2,     3,     4,
+       5,     6,     7,     8,     9,    10,    11,    12,    13,    14,
+      15,    16,    17
+};
+
+#if YYDEBUG
+/* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
+static const yytype_uint8 yyrline[] =
+{
+       0,    73,    73,    80,    83,    86,    87,    91,    94,    97,
+      99,   110,   115,   118,   123,   124,   128,   132,   138,   142,
+     146,   151,   153,   156,   159,   163,   169,   172,   174,   176,
+     177,   178,   180,   184,   186,   190,   192,   196,   198,   202,
+     204,   208,   210,   214,   216,   218,   220,   221,   222,   223,
+     224,   228,   229,   233,   235,   238,   240
+};
+#endif
+
+/** Accessing symbol of state STATE.  */
+#define YY_ACCESSING_SYMBOL(State) YY_CAST (yysymbol_kind_t, yystos[State])
+
+#if YYDEBUG || 0
+/* The user-facing name of the symbol whose (internal) number is
+   YYSYMBOL.  No bounds checking.  */
+static const char *yysymbol_name (yysymbol_kind_t yysymbol) YY_ATTRIBUTE_UNUSED;
+
+/* YYTNAME[SYMBOL-NUM] -- String name of the symbol SYMBOL-NUM.
+   First, the terminals, then, starting at YYNTOKENS, nonterminals.  */
+static const char *const yytname[] =
+{
+  "\"end of file\"", "error", "\"invalid token\"", "IF", "WHILE",
+  "RETURN", "ELSE", "TYPE", "VOID", "AND", "OR", "EQ", "ORDER", "ADDSUB",
+  "DIVSTAR", "CHARACTER", "IDENT", "NUM", "';'", "','", "'['", "']'",
+  "'('", "')'", "'{'", "'}'", "'='", "'!'", "$accept", "Prog", "DeclVars",
+  "Declarateurs", "DeclFoncts", "DeclFonct", "EnTeteFonct", "Parametres",
+  "ListTypVar", "Corps", "SuiteInstr", "Instr", "Exp", "TB", "FB", "M",
+  "E", "T", "F", "LValue", "Arguments", "ListExp", YY_NULLPTR
+};
+
+static const char *
+yysymbol_name (yysymbol_kind_t yysymbol)
+{
+  return yytname[yysymbol];
+}
+#endif
+
+#define YYPACT_NINF (-87)
+
+#define yypact_value_is_default(Yyn) \
+  ((Yyn) == YYPACT_NINF)
+
+#define YYTABLE_NINF (-1)
+
+#define yytable_value_is_error(Yyn) \
+  0
+
+/* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
+   STATE-NUM.  */
+static const yytype_int8 yypact[] =
+{
+     -87,    32,    36,   -87,    24,    33,    71,   -87,   -11,    34,
+      62,    41,    58,   -87,   -87,   -87,    38,    78,   -87,    60,
+      78,    47,    76,    66,    72,   -87,    67,    70,    73,    68,
+      79,     1,   -87,    74,   -87,    85,    80,   -87,    81,    77,
+      82,    35,    39,   -87,   -87,   -87,   -87,    83,    75,    84,
+      86,    55,    55,    55,   -87,    53,   -87,   -87,    55,    55,
+      -3,    89,    91,    93,    90,    92,   -87,   -87,    55,    55,
+      17,    55,   -87,    88,   -87,    -7,     4,   -87,    55,    14,
+     -87,    55,   -87,    55,    55,    55,    55,    55,    13,   100,
+      94,    95,   -87,    20,    97,    42,    42,    96,   -87,    89,
+      91,    93,    90,    92,   -87,   -87,    98,    55,   -87,   -87,
+     105,   -87,   -87,   -87,   100,    42,   -87
+};
+
+/* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
+   Performed when YYTABLE does not specify something else to do.  Zero
+   means the default is an error.  */
+static const yytype_int8 yydefact[] =
+{
+       4,     0,     0,     1,     0,     0,     2,    10,     0,     8,
+       0,     0,     0,     9,     4,    11,     0,     0,     3,     0,
+       0,     0,    22,     0,     0,    14,     0,    15,     5,     0,
+       0,     0,     7,    19,    12,     0,     0,    13,     8,     0,
+       0,     0,    51,    31,    22,    20,    21,     0,     0,     0,
+       0,     0,     0,     0,    48,    51,    47,    29,     0,     0,
+       0,    33,    35,    37,    39,    41,    43,    49,     0,    54,
+       0,     0,    18,    16,     6,     0,     0,    44,    54,     0,
+      45,     0,    28,     0,     0,     0,     0,     0,     0,    56,
+       0,    53,    30,     0,     0,     0,     0,     0,    46,    32,
+      34,    36,    38,    40,    42,    52,     0,     0,    23,    17,
+      24,    26,    50,    27,    55,     0,    25
+};
+
+/* YYPGOTO[NTERM-NUM].  */
+static const yytype_int8 yypgoto[] =
+{
+     -87,   -87,    99,   -87,   -87,   106,   -87,   101,   -87,   -87,
+      87,   -86,   -40,    43,    37,    31,    40,    44,   -51,   -31,
+      45,   -87
+};
+
+/* YYDEFGOTO[NTERM-NUM].  */
+static const yytype_int8 yydefgoto[] =
+{
+       0,     1,     2,    10,     6,     7,     8,    26,    27,    15,
+      31,    46,    89,    61,    62,    63,    64,    65,    66,    67,
+      90,    91
+};
+
+/* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
+   positive, shift that token.  If negative, reduce the rule whose
+   number is the opposite.  If YYTABLE_NINF, syntax error.  */
+static const yytype_int8 yytable[] =
+{
+      47,    60,    77,    81,    39,    40,    41,    81,    80,   110,
+     111,    75,    76,    14,    81,    82,    95,    42,    79,    43,
+      39,    40,    41,    81,    81,    44,    45,    96,    88,   116,
+      81,    93,     3,    42,   105,    43,   104,    98,   108,    47,
+       9,    44,    92,     4,     5,    39,    40,    41,    53,    11,
+      54,    55,    56,    57,    16,    23,    17,    58,    42,    68,
+      43,    69,    59,    20,    47,    47,    44,   114,    53,    17,
+      54,    55,    56,    68,    21,    78,    28,    58,    12,     5,
+      18,    19,    59,    30,    47,    24,    25,    32,    33,    35,
+      34,    37,    49,    36,    48,    38,    72,    50,    83,    51,
+      73,    16,    84,    86,    52,    85,    87,    74,    94,    71,
+      81,   115,    13,    22,   107,   101,   113,   106,   109,   112,
+     100,    29,     0,    97,    99,   102,     0,     0,     0,     0,
+     103,    70
+};
+
+static const yytype_int8 yycheck[] =
+{
+      31,    41,    53,    10,     3,     4,     5,    10,    59,    95,
+      96,    51,    52,    24,    10,    18,    23,    16,    58,    18,
+       3,     4,     5,    10,    10,    24,    25,    23,    68,   115,
+      10,    71,     0,    16,    21,    18,    87,    23,    18,    70,
+      16,    24,    25,     7,     8,     3,     4,     5,    13,    16,
+      15,    16,    17,    18,    20,    17,    22,    22,    16,    20,
+      18,    22,    27,    22,    95,    96,    24,   107,    13,    22,
+      15,    16,    17,    20,    16,    22,    16,    22,     7,     8,
+      18,    19,    27,     7,   115,     7,     8,    21,    16,    19,
+      23,    23,     7,    20,    20,    16,    21,    17,     9,    22,
+      16,    20,    11,    13,    22,    12,    14,    21,    20,    26,
+      10,     6,     6,    14,    19,    84,    18,    23,    21,    23,
+      83,    20,    -1,    78,    81,    85,    -1,    -1,    -1,    -1,
+      86,    44
+};
+
+/* YYSTOS[STATE-NUM] -- The symbol kind of the accessing symbol of
+   state STATE-NUM.  */
+static const yytype_int8 yystos[] =
+{
+       0,    29,    30,     0,     7,     8,    32,    33,    34,    16,
+      31,    16,     7,    33,    24,    37,    20,    22,    18,    19,
+      22,    16,    30,    17,     7,     8,    35,    36,    16,    35,
+       7,    38,    21,    16,    23,    19,    20,    23,    16,     3,
+       4,     5,    16,    18,    24,    25,    39,    47,    20,     7,
+      17,    22,    22,    13,    15,    16,    17,    18,    22,    27,
+      40,    41,    42,    43,    44,    45,    46,    47,    20,    22,
+      38,    26,    21,    16,    21,    40,    40,    46,    22,    40,
+      46,    10,    18,     9,    11,    12,    13,    14,    40,    40,
+      48,    49,    25,    40,    20,    23,    23,    48,    23,    41,
+      42,    43,    44,    45,    46,    21,    23,    19,    18,    21,
+      39,    39,    23,    18,    40,     6,    39
+};
+
+/* YYR1[RULE-NUM] -- Symbol kind of the left-hand side of rule RULE-NUM.  */
+static const yytype_int8 yyr1[] =
+{
+       0,    28,    29,    30,    30,    31,    31,    31,    31,    32,
+      32,    33,    34,    34,    35,    35,    36,    36,    36,    36,
+      37,    38,    38,    39,    39,    39,    39,    39,    39,    39,
+      39,    39,    40,    40,    41,    41,    42,    42,    43,    43,
+      44,    44,    45,    45,    46,    46,    46,    46,    46,    46,
+      46,    47,    47,    48,    48,    49,    49
+};
+
+/* YYR2[RULE-NUM] -- Number of symbols on the right-hand side of rule RULE-NUM.  */
+static const yytype_int8 yyr2[] =
+{
+       0,     2,     2,     4,     0,     3,     6,     4,     1,     2,
+       1,     2,     5,     5,     1,     1,     4,     6,     4,     2,
+       4,     2,     0,     4,     5,     7,     5,     5,     3,     2,
+       3,     1,     3,     1,     3,     1,     3,     1,     3,     1,
+       3,     1,     3,     1,     2,     2,     3,     1,     1,     1,
+       4,     1,     4,     1,     0,     3,     1
+};
+
+
+enum { YYENOMEM = -2 };
+
+#define yyerrok         (yyerrstatus = 0)
+#define yyclearin       (yychar = YYEMPTY)
+
+#define YYACCEPT        goto yyacceptlab
+#define YYABORT         goto yyabortlab
+#define YYERROR         goto yyerrorlab
+#define YYNOMEM         goto yyexhaustedlab
+
+
+#define YYRECOVERING()  (!!yyerrstatus)
+
+#define YYBACKUP(Token, Value)                                    \
+  do                                                              \
+    if (yychar == YYEMPTY)                                        \
+      {                                                           \
+        yychar = (Token);                                         \
+        yylval = (Value);                                         \
+        YYPOPSTACK (yylen);                                       \
+        yystate = *yyssp;                                         \
+        goto yybackup;                                            \
+      }                                                           \
+    else                                                          \
+      {                                                           \
+        yyerror (scanner, ctx, tree, YY_("syntax error: cannot back up")); \
+        YYERROR;                                                  \
+      }                                                           \
+  while (0)
+
+/* Backward compatibility with an undocumented macro.
+   Use YYerror or YYUNDEF. */
+#define YYERRCODE YYUNDEF
+
+
+/* Enable debugging if requested.  */
+#if YYDEBUG
+
+# ifndef YYFPRINTF
+#  include <stdio.h> /* INFRINGES ON USER NAME SPACE */
+#  define YYFPRINTF fprintf
+# endif
+
+# define YYDPRINTF(Args)                        \
+do {                                            \
+  if (yydebug)                                  \
+    YYFPRINTF Args;                             \
+} while (0)
+
+
+
+
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)                    \
+do {                                                                      \
+  if (yydebug)                                                            \
+    {                                                                     \
+      YYFPRINTF (stderr, "%s ", Title);                                   \
+      yy_symbol_print (stderr,                                            \
+                  Kind, Value, scanner, ctx, tree); \
+      YYFPRINTF (stderr, "\n");                                           \
+    }                                                                     \
+} while (0)
+
+
+/*-----------------------------------.
+| Print this symbol's value on YYO.  |
+`-----------------------------------*/
+
+static void
+yy_symbol_value_print (FILE *yyo,
+                       yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, void* scanner, Context* ctx, node_t* tree)
+{
+  FILE *yyoutput = yyo;
+  YY_USE (yyoutput);
+  YY_USE (scanner);
+  YY_USE (ctx);
+  YY_USE (tree);
+  if (!yyvaluep)
+    return;
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  YY_USE (yykind);
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
+}
+
+
+/*---------------------------.
+| Print this symbol on YYO.  |
+`---------------------------*/
+
+static void
+yy_symbol_print (FILE *yyo,
+                 yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, void* scanner, Context* ctx, node_t* tree)
+{
+  YYFPRINTF (yyo, "%s %s (",
+             yykind < YYNTOKENS ? "token" : "nterm", yysymbol_name (yykind));
+
+  yy_symbol_value_print (yyo, yykind, yyvaluep, scanner, ctx, tree);
+  YYFPRINTF (yyo, ")");
+}
+
+/*------------------------------------------------------------------.
+| yy_stack_print -- Print the state stack from its BOTTOM up to its |
+| TOP (included).                                                   |
+`------------------------------------------------------------------*/
+
+static void
+yy_stack_print (yy_state_t *yybottom, yy_state_t *yytop)
+{
+  YYFPRINTF (stderr, "Stack now");
+  for (; yybottom <= yytop; yybottom++)
+    {
+      int yybot = *yybottom;
+      YYFPRINTF (stderr, " %d", yybot);
+    }
+  YYFPRINTF (stderr, "\n");
+}
+
+# define YY_STACK_PRINT(Bottom, Top)                            \
+do {                                                            \
+  if (yydebug)                                                  \
+    yy_stack_print ((Bottom), (Top));                           \
+} while (0)
+
+
+/*------------------------------------------------.
+| Report that the YYRULE is going to be reduced.  |
+`------------------------------------------------*/
+
+static void
+yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp,
+                 int yyrule, void* scanner, Context* ctx, node_t* tree)
+{
+  int yylno = yyrline[yyrule];
+  int yynrhs = yyr2[yyrule];
+  int yyi;
+  YYFPRINTF (stderr, "Reducing stack by rule %d (line %d):\n",
+             yyrule - 1, yylno);
+  /* The symbols being reduced.  */
+  for (yyi = 0; yyi < yynrhs; yyi++)
+    {
+      YYFPRINTF (stderr, "   $%d = ", yyi + 1);
+      yy_symbol_print (stderr,
+                       YY_ACCESSING_SYMBOL (+yyssp[yyi + 1 - yynrhs]),
+                       &yyvsp[(yyi + 1) - (yynrhs)], scanner, ctx, tree);
+      YYFPRINTF (stderr, "\n");
+    }
+}
+
+# define YY_REDUCE_PRINT(Rule)          \
+do {                                    \
+  if (yydebug)                          \
+    yy_reduce_print (yyssp, yyvsp, Rule, scanner, ctx, tree); \
+} while (0)
+
+/* Nonzero means print parse trace.  It is left uninitialized so that
+   multiple parsers can coexist.  */
+int yydebug;
+#else /* !YYDEBUG */
+# define YYDPRINTF(Args) ((void) 0)
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)
+# define YY_STACK_PRINT(Bottom, Top)
+# define YY_REDUCE_PRINT(Rule)
+#endif /* !YYDEBUG */
+
+
+/* YYINITDEPTH -- initial size of the parser's stacks.  */
+#ifndef YYINITDEPTH
+# define YYINITDEPTH 200
+#endif
+
+/* YYMAXDEPTH -- maximum size the stacks can grow to (effective only
+   if the built-in stack extension method is used).
+
+   Do not make this value too large; the results are undefined if
+   YYSTACK_ALLOC_MAXIMUM < YYSTACK_BYTES (YYMAXDEPTH)
+   evaluated with infinite-precision integer arithmetic.  */
+
+#ifndef YYMAXDEPTH
+# define YYMAXDEPTH 10000
+#endif
+
+
+
+
+
+
+/*-----------------------------------------------.
+| Release the memory associated to this symbol.  |
+`-----------------------------------------------*/
+
+static void
+yydestruct (const char *yymsg,
+            yysymbol_kind_t yykind, YYSTYPE *yyvaluep, void* scanner, Context* ctx, node_t* tree)
+{
+  YY_USE (yyvaluep);
+  YY_USE (scanner);
+  YY_USE (ctx);
+  YY_USE (tree);
+  if (!yymsg)
+    yymsg = "Deleting";
+  YY_SYMBOL_PRINT (yymsg, yykind, yyvaluep, yylocationp);
+
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  YY_USE (yykind);
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
+}
+
+
+
+
+
+
+/*----------.
+| yyparse.  |
+`----------*/
+
+int
+yyparse (void* scanner, Context* ctx, node_t* tree)
+{
+/* Lookahead token kind.  */
+int yychar;
+
+
+/* The semantic value of the lookahead symbol.  */
+/* Default value used for initialization, for pacifying older GCCs
+   or non-GCC compilers.  */
+YY_INITIAL_VALUE (static YYSTYPE yyval_default;)
+YYSTYPE yylval YY_INITIAL_VALUE (= yyval_default);
+
+    /* Number of syntax errors so far.  */
+    int yynerrs = 0;
+
+    yy_state_fast_t yystate = 0;
+    /* Number of tokens to shift before error messages enabled.  */
+    int yyerrstatus = 0;
+
+    /* Refer to the stacks through separate pointers, to allow yyoverflow
+       to reallocate them elsewhere.  */
+
+    /* Their size.  */
+    YYPTRDIFF_T yystacksize = YYINITDEPTH;
+
+    /* The state stack: array, bottom, top.  */
+    yy_state_t yyssa[YYINITDEPTH];
+    yy_state_t *yyss = yyssa;
+    yy_state_t *yyssp = yyss;
+
+    /* The semantic value stack: array, bottom, top.  */
+    YYSTYPE yyvsa[YYINITDEPTH];
+    YYSTYPE *yyvs = yyvsa;
+    YYSTYPE *yyvsp = yyvs;
+
+  int yyn;
+  /* The return value of yyparse.  */
+  int yyresult;
+  /* Lookahead symbol kind.  */
+  yysymbol_kind_t yytoken = YYSYMBOL_YYEMPTY;
+  /* The variables used to return semantic value and location from the
+     action routines.  */
+  YYSTYPE yyval;
+
+
+
+#define YYPOPSTACK(N)   (yyvsp -= (N), yyssp -= (N))
+
+  /* The number of symbols on the RHS of the reduced rule.
+     Keep to zero when no symbol should be popped.  */
+  int yylen = 0;
+
+  YYDPRINTF ((stderr, "Starting parse\n"));
+
+  yychar = YYEMPTY; /* Cause a token to be read.  */
+
+  goto yysetstate;
+
+
+/*------------------------------------------------------------.
+| yynewstate -- push a new state, which is found in yystate.  |
+`------------------------------------------------------------*/
+yynewstate:
+  /* In all cases, when you get here, the value and location stacks
+     have just been pushed.  So pushing a state here evens the stacks.  */
+  yyssp++;
+
+
+/*--------------------------------------------------------------------.
+| yysetstate -- set current state (the top of the stack) to yystate.  |
+`--------------------------------------------------------------------*/
+yysetstate:
+  YYDPRINTF ((stderr, "Entering state %d\n", yystate));
+  YY_ASSERT (0 <= yystate && yystate < YYNSTATES);
+  YY_IGNORE_USELESS_CAST_BEGIN
+  *yyssp = YY_CAST (yy_state_t, yystate);
+  YY_IGNORE_USELESS_CAST_END
+  YY_STACK_PRINT (yyss, yyssp);
+
+  if (yyss + yystacksize - 1 <= yyssp)
+#if !defined yyoverflow && !defined YYSTACK_RELOCATE
+    YYNOMEM;
+#else
+    {
+      /* Get the current used size of the three stacks, in elements.  */
+      YYPTRDIFF_T yysize = yyssp - yyss + 1;
+
+# if defined yyoverflow
+      {
+        /* Give user a chance to reallocate the stack.  Use copies of
+           these so that the &'s don't force the real ones into
+           memory.  */
+        yy_state_t *yyss1 = yyss;
+        YYSTYPE *yyvs1 = yyvs;
+
+        /* Each stack pointer address is followed by the size of the
+           data in use in that stack, in bytes.  This used to be a
+           conditional around just the two extra args, but that might
+           be undefined if yyoverflow is a macro.  */
+        yyoverflow (YY_("memory exhausted"),
+                    &yyss1, yysize * YYSIZEOF (*yyssp),
+                    &yyvs1, yysize * YYSIZEOF (*yyvsp),
+                    &yystacksize);
+        yyss = yyss1;
+        yyvs = yyvs1;
+      }
+# else /* defined YYSTACK_RELOCATE */
+      /* Extend the stack our own way.  */
+      if (YYMAXDEPTH <= yystacksize)
+        YYNOMEM;
+      yystacksize *= 2;
+      if (YYMAXDEPTH < yystacksize)
+        yystacksize = YYMAXDEPTH;
+
+      {
+        yy_state_t *yyss1 = yyss;
+        union yyalloc *yyptr =
+          YY_CAST (union yyalloc *,
+                   YYSTACK_ALLOC (YY_CAST (YYSIZE_T, YYSTACK_BYTES (yystacksize))));
+        if (! yyptr)
+          YYNOMEM;
+        YYSTACK_RELOCATE (yyss_alloc, yyss);
+        YYSTACK_RELOCATE (yyvs_alloc, yyvs);
+#  undef YYSTACK_RELOCATE
+        if (yyss1 != yyssa)
+          YYSTACK_FREE (yyss1);
+      }
+# endif
+
+      yyssp = yyss + yysize - 1;
+      yyvsp = yyvs + yysize - 1;
+
+      YY_IGNORE_USELESS_CAST_BEGIN
+      YYDPRINTF ((stderr, "Stack size increased to %ld\n",
+                  YY_CAST (long, yystacksize)));
+      YY_IGNORE_USELESS_CAST_END
+
+      if (yyss + yystacksize - 1 <= yyssp)
+        YYABORT;
+    }
+#endif /* !defined yyoverflow && !defined YYSTACK_RELOCATE */
+
+
+  if (yystate == YYFINAL)
+    YYACCEPT;
+
+  goto yybackup;
+
+
+/*-----------.
+| yybackup.  |
+`-----------*/
+yybackup:
+  /* Do appropriate processing given the current state.  Read a
+     lookahead token if we need one and don't already have one.  */
+
+  /* First try to decide what to do without reference to lookahead token.  */
+  yyn = yypact[yystate];
+  if (yypact_value_is_default (yyn))
+    goto yydefault;
+
+  /* Not known => get a lookahead token if don't already have one.  */
+
+  /* YYCHAR is either empty, or end-of-input, or a valid lookahead.  */
+  if (yychar == YYEMPTY)
+    {
+      YYDPRINTF ((stderr, "Reading a token\n"));
+      yychar = yylex (&yylval, scanner, ctx);
+    }
+
+  if (yychar <= YYEOF)
+    {
+      yychar = YYEOF;
+      yytoken = YYSYMBOL_YYEOF;
+      YYDPRINTF ((stderr, "Now at end of input.\n"));
+    }
+  else if (yychar == YYerror)
+    {
+      /* The scanner already issued an error message, process directly
+         to error recovery.  But do not keep the error token as
+         lookahead, it is too special and may lead us to an endless
+         loop in error recovery. */
+      yychar = YYUNDEF;
+      yytoken = YYSYMBOL_YYerror;
+      goto yyerrlab1;
+    }
+  else
+    {
+      yytoken = YYTRANSLATE (yychar);
+      YY_SYMBOL_PRINT ("Next token is", yytoken, &yylval, &yylloc);
+    }
+
+  /* If the proper action on seeing token YYTOKEN is to reduce or to
+     detect an error, take that action.  */
+  yyn += yytoken;
+  if (yyn < 0 || YYLAST < yyn || yycheck[yyn] != yytoken)
+    goto yydefault;
+  yyn = yytable[yyn];
+  if (yyn <= 0)
+    {
+      if (yytable_value_is_error (yyn))
+        goto yyerrlab;
+      yyn = -yyn;
+      goto yyreduce;
+    }
+
+  /* Count tokens shifted since error; after three, turn off error
+     status.  */
+  if (yyerrstatus)
+    yyerrstatus--;
+
+  /* Shift the lookahead token.  */
+  YY_SYMBOL_PRINT ("Shifting", yytoken, &yylval, &yylloc);
+  yystate = yyn;
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  *++yyvsp = yylval;
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
+
+  /* Discard the shifted token.  */
+  yychar = YYEMPTY;
+  goto yynewstate;
+
+
+/*-----------------------------------------------------------.
+| yydefault -- do the default action for the current state.  |
+`-----------------------------------------------------------*/
+yydefault:
+  yyn = yydefact[yystate];
+  if (yyn == 0)
+    goto yyerrlab;
+  goto yyreduce;
+
+
+/*-----------------------------.
+| yyreduce -- do a reduction.  |
+`-----------------------------*/
+yyreduce:
+  /* yyn is the number of a rule to reduce with.  */
+  yylen = yyr2[yyn];
+
+  /* If YYLEN is nonzero, implement the default value of the action:
+     '$$ = $1'.
+
+     Otherwise, the following line sets YYVAL to garbage.
+     This behavior is undocumented and Bison
+     users should not rely upon it.  Assigning to YYVAL
+     unconditionally makes the parser a bit smaller, and it avoids a
+     GCC warning that YYVAL may be used uninitialized.  */
+  yyval = yyvsp[1-yylen];
+
+
+  YY_REDUCE_PRINT (yyn);
+  switch (yyn)
+    {
+  case 2: /* Prog: DeclVars DeclFoncts  */
+#line 73 "src/parser.y"
+                                            { node_t prog = makeNode(ctx, Prog);
+                                             addChild(ctx, prog, (yyvsp[-1].node));
+                                             addChild(ctx, prog, (yyvsp[0].node));
+                                             *tree = prog;
+                                             }
+#line 1246 "obj/parser.c"
+    break;
+
+  case 3: /* DeclVars: DeclVars TYPE Declarateurs ';'  */
+#line 80 "src/parser.y"
+                                            { node_t t = makeNodeWithValue(ctx, span_to_ident(ctx, (yyvsp[-2].span)), Type);
+                                              addChild(ctx, t, (yyvsp[-1].node));
+                                              addChild(ctx, (yyvsp[-3].node), t); }
+#line 1254 "obj/parser.c"
+    break;
+
+  case 4: /* DeclVars: %empty  */
+#line 83 "src/parser.y"
+                                            { (yyval.node) = makeNode(ctx, DeclVars); }
+#line 1260 "obj/parser.c"
+    break;
+
+  case 5: /* Declarateurs: Declarateurs ',' IDENT  */
+#line 86 "src/parser.y"
+                                            { addSibling(ctx, (yyval.node), makeNodeWithValue(ctx, span_to_ident(ctx, (yyvsp[0].span)), Ident)); }
+#line 1266 "obj/parser.c"
+    break;
+
+  case 6: /* Declarateurs: Declarateurs ',' IDENT '[' NUM ']'  */
+#line 87 "src/parser.y"
+                                            { node_t t = makeNodeWithValue(ctx, span_to_ident(ctx, (yyvsp[-3].span)), Ident);
+                                              setAsArray(ctx, t);
+                                              addChild(ctx, t, makeNodeWithValue(ctx, to_int((yyvsp[-1].num)), Num));
+                                              addSibling(ctx, (yyval.node), t); }
+#line 1275 "obj/parser.c"
+    break;
+
+  case 7: /* Declarateurs: IDENT '[' NUM ']'  */
+#line 91 "src/parser.y"
+                                            { (yyval.node) = makeNodeWithValue(ctx, span_to_ident(ctx, (yyvsp[-3].span)), Ident);
+                                              setAsArray(ctx, (yyval.node));
+                                              addChild(ctx, (yyval.node), makeNodeWithValue(ctx, to_int((yyvsp[-1].num)), Num)); }
+#line 1283 "obj/parser.c"
+    break;
+
+  case 8: /* Declarateurs: IDENT  */
+#line 94 "src/parser.y"
+                                            { (yyval.node) = makeNodeWithValue(ctx, span_to_ident(ctx, (yyvsp[0].span)), Ident); }
+#line 1289 "obj/parser.c"
+    break;
+
+  case 9: /* DeclFoncts: DeclFoncts DeclFonct  */
+#line 97 "src/parser.y"
+                                            { (yyval.node) = (yyvsp[-1].node);
+                                              add_function(ctx, (yyval.node), (yyvsp[0].node)); }
+#line 1296 "obj/parser.c"
+    break;
+
+  case 10: /* DeclFoncts: DeclFonct  */
+#line 99 "src/parser.y"
+                                            { // globals are complete, their DeclVars is below on the stack
+                                              if (ctx->stream) {
+                                                  start_stream(ctx, (yyvsp[-1].node));
+                                              }
+                                              node_t node = add_function(ctx, NO_NODE, (yyvsp[0].node));
+                                              (yyval.node) = makeNode(ctx, DeclFoncts);
+                                              if (node != NO_NODE) {
+                                                  addChild(ctx, (yyval.node), node);
+                                              } }
+#line 1310 "obj/parser.c"
+    break;
+
+  case 11: /* DeclFonct: EnTeteFonct Corps  */
+#line 110 "src/parser.y"
+                                            { (yyval.node) = makeNode(ctx, EnTeteFonct);
+                                              addChild(ctx, (yyval.node), (yyvsp[-1].node));
+                                              addSibling(ctx, (yyval.node), (yyvsp[0].node)); }
+#line 1318 "obj/parser.c"
+    break;
+
+  case 12: /* EnTeteFonct: TYPE IDENT '(' Parametres ')'  */
+#line 115 "src/parser.y"
+                                            { (yyval.node) = makeNodeWithValue(ctx, span_to_ident(ctx, (yyvsp[-4].span)), Type);
+                                              addSibling(ctx, (yyval.node), makeNodeWithValue(ctx, span_to_ident(ctx, (yyvsp[-3].span)), Ident));
+                                              addSibling(ctx, (yyval.node), (yyvsp[-1].node)); }
+#line 1326 "obj/parser.c"
+    break;
+
+  case 13: /* EnTeteFonct: VOID IDENT '(' Parametres ')'  */
+#line 118 "src/parser.y"
+                                            { (yyval.node) = makeNodeWithValue(ctx, span_to_ident(ctx, (yyvsp[-4].span)), Void);
+                                              addSibling(ctx, (yyval.node), makeNodeWithValue(ctx, span_to_ident(ctx, (yyvsp[-3].span)), Ident));
+                                              addSibling(ctx, (yyval.node), (yyvsp[-1].node)); }
+#line 1334 "obj/parser.c"
+    break;
+
+  case 14: /* Parametres: VOID  */
+#line 123 "src/parser.y"
+                                            { (yyval.node) = makeNodeWithValue(ctx, span_to_ident(ctx, (yyvsp[0].span)), Void); }
+#line 1340 "obj/parser.c"
+    break;
+
+  case 15: /* Parametres: ListTypVar  */
+#line 124 "src/parser.y"
+                                            { (yyval.node) = makeNode(ctx, ListTypVar);
+                                              addChild(ctx, (yyval.node), (yyvsp[0].node)); }
+#line 1347 "obj/parser.c"
+    break;
+
+  case 16: /* ListTypVar: ListTypVar ',' TYPE IDENT  */
+#line 128 "src/parser.y"
+                                            { (yyval.node) = (yyvsp[-3].node);
+                                              node_t t = makeNodeWithValue(ctx, span_to_ident(ctx, (yyvsp[-1].span)), Type);
+                                              addChild(ctx, t, makeNodeWithValue(ctx, span_to_ident(ctx, (yyvsp[0].span)), Ident));
+                                              addSibling(ctx, (yyval.node), t); }
+#line 1356 "obj/parser.c"
+    break;
+
+  case 17: /* ListTypVar: ListTypVar ',' TYPE IDENT '[' ']'  */
+#line 132 "src/parser.y"
+                                            { (yyval.node) = (yyvsp[-5].node);
+                                              node_t t = makeNodeWithValue(ctx, span_to_ident(ctx, (yyvsp[-3].span)), Type);
+                                              node_t ident = makeNodeWithValue(ctx, span_to_ident(ctx, (yyvsp[-2].span)), Ident);
+                                              setAsArray(ctx, ident);
+                                              addChild(ctx, t, ident);
+                                              addSibling(ctx, (yyval.node), t); }
+#line 1367 "obj/parser.c"
+    break;
+
+  case 18: /* ListTypVar: TYPE IDENT '[' ']'  */
+#line 138 "src/parser.y"
+                                            { (yyval.node) = makeNodeWithValue(ctx, span_to_ident(ctx, (yyvsp[-3].span)), Type);
+                                              node_t ident = makeNodeWithValue(ctx, span_to_ident(ctx, (yyvsp[-2].span)), Ident);
+                                              setAsArray(ctx, ident);
+                                              addChild(ctx, (yyval.node), ident); }
+#line 1376 "obj/parser.c"
+    break;
+
+  case 19: /* ListTypVar: TYPE IDENT  */
+#line 142 "src/parser.y"
+                                            { (yyval.node) = makeNodeWithValue(ctx, span_to_ident(ctx, (yyvsp[-1].span)), Type);
+                                              addChild(ctx, (yyval.node), makeNodeWithValue(ctx, span_to_ident(ctx, (yyvsp[0].span)), Ident)); }
+#line 1383 "obj/parser.c"
+    break;
+
+  case 20: /* Corps: '{' DeclVars SuiteInstr '}'  */
+#line 146 "src/parser.y"
+                                            { (yyval.node) = makeNode(ctx, Corps);
+                                              addChild(ctx, (yyval.node), (yyvsp[-2].node));
+                                              addSibling(ctx, (yyvsp[-2].node), (yyvsp[-1].node));}
+#line 1391 "obj/parser.c"
+    break;
+
+  case 21: /* SuiteInstr: SuiteInstr Instr  */
+#line 151 "src/parser.y"
+                                            { (yyval.node) = (yyvsp[-1].node);
+                                              addChild(ctx, (yyval.node), (yyvsp[0].node)); }
+#line 1398 "obj/parser.c"
+    break;
+
+  case 22: /* SuiteInstr: %empty  */
+#line 153 "src/parser.y"
+                                            { (yyval.node) = makeNode(ctx, SuiteInstr); }
+#line 1404 "obj/parser.c"
+    break;
+
+  case 23: /* Instr: LValue '=' Exp ';'  */
+#line 156 "src/parser.y"
+                                            { (yyval.node) = makeNodeWithValue(ctx, to_ident(ctx, "="), Assignation);
+                                              addChild(ctx, (yyval.node), (yyvsp[-3].node));
+                                              addSibling(ctx, FIRSTCHILD(ctx, (yyval.node)), (yyvsp[-1].node)); }
+#line 1412 "obj/parser.c"
+    break;
+
+  case 24: /* Instr: IF '(' Exp ')' Instr  */
+#line 159 "src/parser.y"
+                                            { (yyval.node) = makeNode(ctx, If);
+                                              addChild(ctx, (yyval.node), (yyvsp[-2].node));
+                                              addSibling(ctx, (yyvsp[-2].node), (yyvsp[0].node)); 
+                                              addChild(ctx, (yyval.node), makeNode(ctx, EmptyInstr)); }
+#line 1421 "obj/parser.c"
+    break;
+
+  case 25: /* Instr: IF '(' Exp ')' Instr ELSE Instr  */
+#line 163 "src/parser.y"
+                                            { (yyval.node) = makeNode(ctx, If);
+                                              addChild(ctx, (yyval.node), (yyvsp[-4].node));
+                                              addSibling(ctx, (yyvsp[-4].node), (yyvsp[-2].node));
+                                              node_t e = makeNode(ctx, Else);
+                                              addChild(ctx, (yyval.node), e);
+                                              addChild(ctx, e, (yyvsp[0].node)); }
+#line 1432 "obj/parser.c"
+    break;
+
+  case 26: /* Instr: WHILE '(' Exp ')' Instr  */
+#line 169 "src/parser.y"
+                                            { (yyval.node) = makeNode(ctx, While);
+                                              addChild(ctx, (yyval.node), (yyvsp[-2].node));
+                                              addChild(ctx, (yyval.node), (yyvsp[0].node)); }
+#line 1440 "obj/parser.c"
+    break;
+
+  case 27: /* Instr: IDENT '(' Arguments ')' ';'  */
+#line 172 "src/parser.y"
+                                            { (yyval.node) = makeNodeWithValue(ctx, span_to_ident(ctx, (yyvsp[-4].span)), Ident);
+                                              addChild(ctx, (yyval.node), (yyvsp[-2].node)); }
+#line 1447 "obj/parser.c"
+    break;
+
+  case 28: /* Instr: RETURN Exp ';'  */
+#line 174 "src/parser.y"
+                                            { (yyval.node) = makeNode(ctx, Return);
+                                              addChild(ctx, (yyval.node), (yyvsp[-1].node)); }
+#line 1454 "obj/parser.c"
+    break;
+
+  case 29: /* Instr: RETURN ';'  */
+#line 176 "src/parser.y"
+                                            { (yyval.node) = makeNode(ctx, Return); }
+#line 1460 "obj/parser.c"
+    break;
+
+  case 30: /* Instr: '{' SuiteInstr '}'  */
+#line 177 "src/parser.y"
+                                            { (yyval.node) = (yyvsp[-1].node); }
+#line 1466 "obj/parser.c"
+    break;
+
+  case 31: /* Instr: ';'  */
+#line 178 "src/parser.y"
+                                            { (yyval.node) = makeNode(ctx, EmptyInstr); }
+#line 1472 "obj/parser.c"
+    break;
+
+  case 32: /* Exp: Exp OR TB  */
+#line 180 "src/parser.y"
+                                            { node_t n = makeNode(ctx, Or);
+                                              addChild(ctx, n, (yyvsp[-2].node));
+                                              addChild(ctx, n, (yyvsp[0].node));
+                                              (yyval.node) = n; }
+#line 1481 "obj/parser.c"
+    break;
+
+  case 33: /* Exp: TB  */
+#line 184 "src/parser.y"
+                                            { (yyval.node) = (yyvsp[0].node); }
+#line 1487 "obj/parser.c"
+    break;
+
+  case 34: /* TB: TB AND FB  */
+#line 186 "src/parser.y"
+                                            { node_t n = makeNode(ctx, And);
+                                              addChild(ctx, n, (yyvsp[-2].node));
+                                              addChild(ctx, n, (yyvsp[0].node));
+                                              (yyval.node) = n; }
+#line 1496 "obj/parser.c"
+    break;
+
+  case 35: /* TB: FB  */
+#line 190 "src/parser.y"
+                                            { (yyval.node) = (yyvsp[0].node); }
+#line 1502 "obj/parser.c"
+    break;
+
+  case 36: /* FB: FB EQ M  */
+#line 192 "src/parser.y"
+                                            { node_t n = makeNodeWithValue(ctx, span_to_ident(ctx, (yyvsp[-1].span)), Eq);
+                                              addChild(ctx, n, (yyvsp[-2].node));
+                                              addChild(ctx, n, (yyvsp[0].node));
+                                              (yyval.node) = n; }
+#line 1511 "obj/parser.c"
+    break;
+
+  case 37: /* FB: M  */
+#line 196 "src/parser.y"
+                                            { (yyval.node) = (yyvsp[0].node); }
+#line 1517 "obj/parser.c"
+    break;
+
+  case 38: /* M: M ORDER E  */
+#line 198 "src/parser.y"
+                                            { node_t n = makeNodeWithValue(ctx, span_to_ident(ctx, (yyvsp[-1].span)), Order);
+                                              addChild(ctx, n, (yyvsp[-2].node));
+                                              addChild(ctx, n, (yyvsp[0].node));
+                                              (yyval.node) = n; }
+#line 1526 "obj/parser.c"
+    break;
+
+  case 39: /* M: E  */
+#line 202 "src/parser.y"
+                                            { (yyval.node) = (yyvsp[0].node); }
+#line 1532 "obj/parser.c"
+    break;
+
+  case 40: /* E: E ADDSUB T  */
+#line 204 "src/parser.y"
+                                            { node_t n = makeNodeWithValue(ctx, span_to_ident(ctx, (yyvsp[-1].span)), AddSub);
+                                              addChild(ctx, n, (yyvsp[-2].node));
+                                              addChild(ctx, n, (yyvsp[0].node));
+                                              (yyval.node) = n; }
+#line 1541 "obj/parser.c"
+    break;
+
+  case 41: /* E: T  */
+#line 208 "src/parser.y"
+                                            { (yyval.node) = (yyvsp[0].node); }
+#line 1547 "obj/parser.c"
+    break;
+
+  case 42: /* T: T DIVSTAR F  */
+#line 210 "src/parser.y"
+                                            { node_t n = makeNodeWithValue(ctx, span_to_ident(ctx, (yyvsp[-1].span)), DivStar);
+                                              addChild(ctx, n, (yyvsp[-2].node));
+                                              addChild(ctx, n, (yyvsp[0].node));
+                                              (yyval.node) = n; }
+#line 1556 "obj/parser.c"
+    break;
+
+  case 43: /* T: F  */
+#line 214 "src/parser.y"
+                                            { (yyval.node) = (yyvsp[0].node); }
+#line 1562 "obj/parser.c"
+    break;
+
+  case 44: /* F: ADDSUB F  */
+#line 216 "src/parser.y"
+                                            { (yyval.node) = makeNodeWithValue(ctx, span_to_ident(ctx, (yyvsp[-1].span)), AddSub); 
+                                              addChild(ctx, (yyval.node), (yyvsp[0].node)); }
+#line 1569 "obj/parser.c"
+    break;
+
+  case 45: /* F: '!' F  */
+#line 218 "src/parser.y"
+                                            { (yyval.node) = makeNodeWithValue(ctx, to_ident(ctx, "!"), Negation); 
+                                              addChild(ctx, (yyval.node), (yyvsp[0].node)); }
+#line 1576 "obj/parser.c"
+    break;
+
+  case 46: /* F: '(' Exp ')'  */
+#line 220 "src/parser.y"
+                                            { (yyval.node) = (yyvsp[-1].node); }
+#line 1582 "obj/parser.c"
+    break;
+
+  case 47: /* F: NUM  */
+#line 221 "src/parser.y"
+                                            { (yyval.node) = makeNodeWithValue(ctx, to_int((yyvsp[0].num)), Num); }
+#line 1588 "obj/parser.c"
+    break;
+
+  case 48: /* F: CHARACTER  */
+#line 222 "src/parser.y"
+                                            { (yyval.node) = makeNodeWithValue(ctx, span_to_ident(ctx, (yyvsp[0].span)), Character); }
+#line 1594 "obj/parser.c"
+    break;
+
+  case 49: /* F: LValue  */
+#line 223 "src/parser.y"
+                                            { (yyval.node) = (yyvsp[0].node); }
+#line 1600 "obj/parser.c"
+    break;
+
+  case 50: /* F: IDENT '(' Arguments ')'  */
+#line 224 "src/parser.y"
+                                            { (yyval.node) = makeNodeWithValue(ctx, span_to_ident(ctx, (yyvsp[-3].span)), Ident);
+                                              addChild(ctx, (yyval.node), (yyvsp[-1].node)); }
+#line 1607 "obj/parser.c"
+    break;
+
+  case 51: /* LValue: IDENT  */
+#line 228 "src/parser.y"
+                                            { (yyval.node) = makeNodeWithValue(ctx, span_to_ident(ctx, (yyvsp[0].span)), Ident); }
+#line 1613 "obj/parser.c"
+    break;
+
+  case 52: /* LValue: IDENT '[' Exp ']'  */
+#line 229 "src/parser.y"
+                                            { (yyval.node) = makeNodeWithValue(ctx, span_to_ident(ctx, (yyvsp[-3].span)), Ident); 
+                                              addChild(ctx, (yyval.node), (yyvsp[-1].node)); }
+#line 1620 "obj/parser.c"
+    break;
+
+  case 53: /* Arguments: ListExp  */
+#line 233 "src/parser.y"
+                                            { (yyval.node) = makeNode(ctx, ListExp); 
+                                              addChild(ctx, (yyval.node), (yyvsp[0].node)); }
+#line 1627 "obj/parser.c"
+    break;
+
+  case 54: /* Arguments: %empty  */
+#line 235 "src/parser.y"
+                                            { (yyval.node) = makeNode(ctx, NoParametres); }
+#line 1633 "obj/parser.c"
+    break;
+
+  case 55: /* ListExp: ListExp ',' Exp  */
+#line 238 "src/parser.y"
+                                            { (yyval.node) = (yyvsp[-2].node);
+                                              addSibling(ctx, (yyval.node), (yyvsp[0].node)); }
+#line 1640 "obj/parser.c"
+    break;
+
+  case 56: /* ListExp: Exp  */
+#line 240 "src/parser.y"
+                                            { (yyval.node) = (yyvsp[0].node); }
+#line 1646 "obj/parser.c"
+    break;
+
+
+#line 1650 "obj/parser.c"
+
+      default: break;
+    }
+  /* User semantic actions sometimes alter yychar, and that requires
+     that yytoken be updated with the new translation.  We take the
+     approach of translating immediately before every use of yytoken.
+     One alternative is translating here after every semantic action,
+     but that translation would be missed if the semantic action invokes
+     YYABORT, YYACCEPT, or YYERROR immediately after altering yychar or
+     if it invokes YYBACKUP.  In the case of YYABORT or YYACCEPT, an
+     incorrect destructor might then be invoked immediately.  In the
+     case of YYERROR or YYBACKUP, subsequent parser actions might lead
+     to an incorrect destructor call or verbose syntax error message
+     before the lookahead is translated.  */
+  YY_SYMBOL_PRINT ("-> $$ =", YY_CAST (yysymbol_kind_t, yyr1[yyn]), &yyval, &yyloc);
+
+  YYPOPSTACK (yylen);
+  yylen = 0;
+
+  *++yyvsp = yyval;
+
+  /* Now 'shift' the result of the reduction.  Determine what state
+     that goes to, based on the state we popped back to and the rule
+     number reduced by.  */
+  {
+    const int yylhs = yyr1[yyn] - YYNTOKENS;
+    const int yyi = yypgoto[yylhs] + *yyssp;
+    yystate = (0 <= yyi && yyi <= YYLAST && yycheck[yyi] == *yyssp
+               ? yytable[yyi]
+               : yydefgoto[yylhs]);
+  }
+
+  goto yynewstate;
+
+
+/*--------------------------------------.
+| yyerrlab -- here on detecting error.  |
+`--------------------------------------*/
+yyerrlab:
+  /* Make sure we have latest lookahead translation.  See comments at
+     user semantic actions for why this is necessary.  */
+  yytoken = yychar == YYEMPTY ? YYSYMBOL_YYEMPTY : YYTRANSLATE (yychar);
+  /* If not already recovering from an error, report this error.  */
+  if (!yyerrstatus)
+    {
+      ++yynerrs;
+      yyerror (scanner, ctx, tree, YY_("syntax error"));
+    }
+
+  if (yyerrstatus == 3)
+    {
+      /* If just tried and failed to reuse lookahead token after an
+         error, discard it.  */
+
+      if (yychar <= YYEOF)
+        {
+          /* Return failure if at end of input.  */
+          if (yychar == YYEOF)
+            YYABORT;
+        }
+      else
+        {
+          yydestruct ("Error: discarding",
+                      yytoken, &yylval, scanner, ctx, tree);
+          yychar = YYEMPTY;
+        }
+    }
+
+  /* Else will try to reuse lookahead token after shifting the error
+     token.  */
+  goto yyerrlab1;
+
+
+/*---------------------------------------------------.
+| yyerrorlab -- error raised explicitly by YYERROR.  |
+`---------------------------------------------------*/
+yyerrorlab:
+  /* Pacify compilers when the user code never invokes YYERROR and the
+     label yyerrorlab therefore never appears in user code.  */
+  if (0)
+    YYERROR;
+  ++yynerrs;
+
+  /* Do not reclaim the symbols of the rule whose action triggered
+     this YYERROR.  */
+  YYPOPSTACK (yylen);
+  yylen = 0;
+  YY_STACK_PRINT (yyss, yyssp);
+  yystate = *yyssp;
+  goto yyerrlab1;
+
+
+/*-------------------------------------------------------------.
+| yyerrlab1 -- common code for both syntax error and YYERROR.  |
+`-------------------------------------------------------------*/
+yyerrlab1:
+  yyerrstatus = 3;      /* Each real token shifted decrements this.  */
+
+  /* Pop stack until we find a state that shifts the error token.  */
+  for (;;)
+    {
+      yyn = yypact[yystate];
+      if (!yypact_value_is_default (yyn))
+        {
+          yyn += YYSYMBOL_YYerror;
+          if (0 <= yyn && yyn <= YYLAST && yycheck[yyn] == YYSYMBOL_YYerror)
+            {
+              yyn = yytable[yyn];
+              if (0 < yyn)
+                break;
+            }
+        }
+
+      /* Pop the current state because it cannot handle the error token.  */
+      if (yyssp == yyss)
+        YYABORT;
+
+
+      yydestruct ("Error: popping",
+                  YY_ACCESSING_SYMBOL (yystate), yyvsp, scanner, ctx, tree);
+      YYPOPSTACK (1);
+      yystate = *yyssp;
+      YY_STACK_PRINT (yyss, yyssp);
+    }
+
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  *++yyvsp = yylval;
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
+
+
+  /* Shift the error token.  */
+  YY_SYMBOL_PRINT ("Shifting", YY_ACCESSING_SYMBOL (yyn), yyvsp, yylsp);
+
+  yystate = yyn;
+  goto yynewstate;
+
+
+/*-------------------------------------.
+| yyacceptlab -- YYACCEPT comes here.  |
+`-------------------------------------*/
+yyacceptlab:
+  yyresult = 0;
+  goto yyreturnlab;
+
+
+/*-----------------------------------.
+| yyabortlab -- YYABORT comes here.  |
+`-----------------------------------*/
+yyabortlab:
+  yyresult = 1;
+  goto yyreturnlab;
+
+
+/*-----------------------------------------------------------.
+| yyexhaustedlab -- YYNOMEM (memory exhaustion) comes here.  |
+`-----------------------------------------------------------*/
+yyexhaustedlab:
+  yyerror (scanner, ctx, tree, YY_("memory exhausted"));
+  yyresult = 2;
+  goto yyreturnlab;
+
+
+/*----------------------------------------------------------.
+| yyreturnlab -- parsing is finished, clean up and return.  |
+`----------------------------------------------------------*/
+yyreturnlab:
+  if (yychar != YYEMPTY)
+    {
+      /* Make sure we have latest lookahead translation.  See comments at
+         user semantic actions for why this is necessary.  */
+      yytoken = YYTRANSLATE (yychar);
+      yydestruct ("Cleanup: discarding lookahead",
+                  yytoken, &yylval, scanner, ctx, tree);
+    }
+  /* Do not reclaim the symbols of the rule whose action triggered
+     this YYABORT or YYACCEPT.  */
+  YYPOPSTACK (yylen);
+  YY_STACK_PRINT (yyss, yyssp);
+  while (yyssp != yyss)
+    {
+      yydestruct ("Cleanup: popping",
+                  YY_ACCESSING_SYMBOL (+*yyssp), yyvsp, scanner, ctx, tree);
+      YYPOPSTACK (1);
+    }
+#ifndef yyoverflow
+  if (yyss != yyssa)
+    YYSTACK_FREE (yyss);
+#endif
+
+  return yyresult;
+}
+
+#line 242 "src/parser.y"
+
+
+static Value make_ident(Context* ctx, const char* text, size_t len) {
+    if (len >= IDENT_LEN) {
+        // the parser stops at the next token, so the process can go on
+        yyerror(NULL, ctx, NULL, "identifier too long");
+        ctx->parse_error = true;
+        len = IDENT_LEN - 1;
+    }
+    Value v;
+    if ((v.ident = intern(ctx, text, len)) == -1) {
+        printf("Run out of memory\n");
+        exit(3);
+    }
+    return v;
+}
+
+Value to_ident(Context* ctx, const char* val) {
+    return make_ident(ctx, val, strlen(val));
+}
+
+Value span_to_ident(Context* ctx, Span span) {
+    return make_ident(ctx, ctx->source + span.offset, span.len);
+}
+
+Value to_int(int n) {
+    return (Value){.num = n};
+}
+
+static node_t add_function(Context* ctx, node_t list, node_t head) {
+    node_t node = makeNode(ctx, DeclFonct);
+    addChild(ctx, node, head);
+    if (ctx->stream) {
+        stream_function(ctx, node);
+        return NO_NODE;
+    }
+    if (list != NO_NODE) {
+        addChild(ctx, list, node);
+    }
+    return node;
+}
+
+/**
+ * @brief Read the next token with the scanner chosen by the context
+ */
+static int yylex(YYSTYPE* lval, void* scanner, Context* ctx) {
+    // an error already reported by an action
+    if (ctx->parse_error) {
+        return YYerror;
+    }
+    return ctx->fast_lexer ? fast_lex(lval, scanner): flex_lex(lval, scanner);
+}
+
+/**
+ * @brief Print error with the line and column where the error was triggered
+ */
+void yyerror(void* scanner, Context* ctx, node_t* tree, char* msg) {
+    fprintf(ctx->err, "%s at %d:%d\n", msg, ctx->lineno, ctx->prevcolno);
+}
+
+/**
+ * @brief Create the scanner chosen by the context
+ */
+static int open_scanner(Context* ctx, Source* source, void** scanner) {
+    return ctx->fast_lexer ? init_fast_scanner(ctx, source, scanner)
+                           : init_scanner(ctx, source, scanner);
+}
+
+/**
+ * @brief Free the scanner chosen by the context
+ */
+static void close_scanner(Context* ctx, void* scanner) {
+    if (ctx->fast_lexer) {
+        free_fast_scanner(scanner);
+    } else {
+        free_scanner(scanner);
+    }
+}
+
+int parse_source(Context* ctx, Source* source, node_t* tree) {
+    void* scanner;
+    if (!open_scanner(ctx, source, &scanner)) {
+        return 2;
+    }
+    // a streamed tree only holds the globals and a function at a time
+    if (!init_tree(&ctx->tree, ctx->stream ? 0: source->len)) {
+        printf("Run out of memory\n");
+        exit(3);
+    }
+    int res = yyparse(scanner, ctx, tree);
+    close_scanner(ctx, scanner);
+    return res;
+}
+
+int print_tokens(Context* ctx, Source* source) {
+    void* scanner;
+    if (!open_scanner(ctx, source, &scanner)) {
+        return 0;
+    }
+    YYSTYPE lval;
+    int token;
+    while ((token = yylex(&lval, scanner, ctx))) {
+        printf("%d:%d:%d\t%d", ctx->lineno, ctx->colno, ctx->prevcolno, token);
+        switch (token) {
+            case NUM:
+                printf("\t%d", lval.num);
+                break;
+            case TYPE: case VOID: case AND: case OR: case EQ: case ORDER:
+            case ADDSUB: case DIVSTAR: case IDENT: case CHARACTER:
+                printf("\t%.*s", (int)lval.span.len, ctx->source + lval.span.offset);
+                break;
+            default:
+                break;
+        }
+        putchar('\n');
+    }
+    printf("%d:%d:%d\tEOF\n", ctx->lineno, ctx->colno, ctx->prevcolno);
+    close_scanner(ctx, scanner);
+    // the parser scans the source again from its start
+    ctx->lineno = 1;
+    ctx->colno = ctx->prevcolno = 0;
+    return 1;
+}
@@ -0,0 +1,96 @@
+#!/bin/bash
+
+# Compile generated inputs of growing size, and check that compilation time
+# grows linearly with the number of instructions, of functions, of branches
+# and with the depth of expressions and of branches, also from the IR
+
+TPCC=$(realpath ./bin/tpcc)
+DIR=$(mktemp -d)
+RES=0
+
+MAX_RATIO=20    # 10 for a linear growth, 100 for a quadratic one
+
+gen_instructions() {
+    awk -v n=$1 'BEGIN {
+        print "int main(void) {\n    int a;\n    a = 0;"
+        for (i = 0; i < n; i++) print "    a = a + " i % 7 ";"
+        print "    return a;\n}"
+    }'
+}
+
+gen_functions() {
+    awk -v n=$1 'BEGIN {
+        # each function calls the previous one, so all are reached from main
+        print "int f" n "(int x) {\n    return x;\n}"
+        for (i = n - 1; i >= 0; i--) print "int f" i "(int x) {\n    return f" i + 1 "(x) + " i ";\n}"
+        print "int main(void) {\n    return f0(1);\n}"
+    }'
+}
+
+gen_nested() {
+    awk -v n=$1 'BEGIN {
+        printf "int main(void) {\n    return "
+        for (i = 0; i < n; i++) printf "-("
+        printf "1"
+        for (i = 0; i < n; i++) printf ")"
+        print ";\n}"
+    }'
+}
+
+gen_branches() {
+    awk -v n=$1 'BEGIN {
+        print "int main(void) {\n    int a;\n    a = getint();"
+        for (i = 0; i < n; i++) print "    if (a > " i ") {\n        a = a + 1;\n    }"
+        print "    return a;\n}"
+    }'
+}
+
+gen_nested_branches() {
+    awk -v n=$1 'BEGIN {
+        print "int main(void) {\n    int a;\n    a = getint();"
+        for (i = 0; i < n; i++) print "    if (a > " i ") {"
+        print "    a = a + 1;"
+        for (i = 0; i < n; i++) print "    }"
+        print "    return a;\n}"
+    }'
+}
+
+# options given to tpcc
+OPTIONS=
+
+run() {
+    echo "Starting benchmark on $1${OPTIONS:+ ($OPTIONS)}"
+    local prev=0
+    for n in ${@:2}; do
+        gen_$1 $n > $DIR/$1_$n.tpc
+        local start=$(date +%s%N)
+        (cd $DIR && $TPCC $OPTIONS $1_$n.tpc > /dev/null 2> /dev/null)
+        local acc=$?
+        local time=$((($(date +%s%N) - $start)/1000000))
+        echo "$n $1 : ${time}ms"
+        if [ $acc -ne 0 ]; then
+            echo "Benchmark failed on $n $1 : exit code $acc"
+            RES=1
+        elif [ $prev -gt 0 ] && [ $time -gt $(($prev*$MAX_RATIO)) ]; then
+            echo "Benchmark failed on $n $1 : growth is not linear"
+            RES=1
+        fi
+        # ignore too short times to compute the growth
+        prev=$(($time > 10 ? $time: 10))
+    done
+    echo
+}
+
+run instructions 10000 100000 1000000
+run functions 10000 100000
+run nested 1000 10000
+run branches 10000 100000
+run nested_branches 1000 10000 100000
+
+OPTIONS=--codegen=ir
+run instructions 10000 100000 1000000
+run branches 10000 100000
+run nested_branches 1000 10000 100000
+
+rm -rf $DIR
+exit $RES
@@ -0,0 +1,48 @@
+#!/bin/bash
+
+# Compile the executable test programs with nasm and ld, and with tpcc alone,
+# and check that both executables, and the programs run in memory by tpcc,
+# from the tree and from the IR, give the same outputs and exit codes
+
+TPCC=$(realpath ./bin/tpcc)
+DIR=$(mktemp -d)
+INPUTS=("5" "27" "-7" "0" "abc")
+RES=0
+NBFILES=0
+
+# outputs and exit codes of an executable on every input
+run() {
+    for input in "${INPUTS[@]}"; do
+        echo "$input" | timeout 5 $1
+        echo "exit code $?"
+    done
+}
+
+for file in test/exec/*.tpc; do
+    path=$(realpath $file)
+    name=$(basename $file .tpc)
+    (cd $DIR && $TPCC $path > /dev/null 2>&1 \
+     && nasm -f elf64 -o $name.o $name.asm \
+     && gcc -o nasm_$name $name.o -nostartfiles -no-pie)
+    (cd $DIR && $TPCC --format=exe $path > /dev/null 2>&1)
+    if [ ! -x $DIR/nasm_$name ] || [ ! -x $DIR/$name ]; then
+        echo "Cannot build file $file"
+    elif ! cmp -s <(run $DIR/nasm_$name) <(run $DIR/$name); then
+        echo "Executables differ on file $file"
+        diff <(run $DIR/nasm_$name) <(run $DIR/$name) | head -5
+    elif ! cmp -s <(run $DIR/nasm_$name) <(run "$TPCC --run $path" 2> /dev/null); then
+        echo "Run in memory differs on file $file"
+        diff <(run $DIR/nasm_$name) <(run "$TPCC --run $path" 2> /dev/null) | head -5
+    elif ! cmp -s <(run $DIR/nasm_$name) <(run "$TPCC --run --codegen=ir $path" 2> /dev/null); then
+        echo "Code generated from the IR differs on file $file"
+        diff <(run $DIR/nasm_$name) <(run "$TPCC --run --codegen=ir $path" 2> /dev/null) | head -5
+    else
+        RES=$(($RES + 1))
+    fi
+    NBFILES=$(($NBFILES + 1))
+done
+
+rm -rf $DIR
+
+echo "Same executions : $RES/$NBFILES"
+[ $RES -eq $NBFILES ]
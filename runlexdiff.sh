@@ -0,0 +1,30 @@
+#!/bin/bash
+
+# Scan every test source with the flex lexer and with the fast one, and
+# check that both give the same tokens at the same positions
+
+TPCC=$(realpath ./bin/tpcc)
+DIR=$(mktemp -d)
+RES=0
+NBFILES=0
+
+for file in $(find test* -name "*.tpc" | sort); do
+    path=$(realpath $file)
+    (cd $DIR && $TPCC --tokens --lexer=flex $path > flex.out 2> flex.err)
+    flex_acc=$?
+    (cd $DIR && $TPCC --tokens --lexer=fast $path > fast.out 2> fast.err)
+    fast_acc=$?
+    if [ $flex_acc -ne $fast_acc ] || ! cmp -s $DIR/flex.out $DIR/fast.out \
+       || ! cmp -s $DIR/flex.err $DIR/fast.err; then
+        echo "Lexers differ on file $file"
+        diff $DIR/flex.out $DIR/fast.out | head -5
+    else
+        RES=$(($RES + 1))
+    fi
+    NBFILES=$(($NBFILES + 1))
+done
+
+rm -rf $DIR
+
+echo "Same tokens : $RES/$NBFILES"
+[ $RES -eq $NBFILES ]
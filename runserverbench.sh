@@ -0,0 +1,49 @@
+#!/bin/bash
+
+# Compile the test files many times, once by starting a process per file and
+# once through a compile server, and print the rate of compilations and their
+# latencies for both
+
+TPCC=$(realpath ./bin/tpcc)
+DIR=$(mktemp -d)
+SOCK=$DIR/tpcc.sock
+FILES=$(realpath test/good/*.tpc)
+REPEAT=20       # times each file is compiled
+JOBS=2          # compilations at the same time through the server
+
+# latencies in microseconds on the standard input, elapsed time in argument
+summary() {
+    sort -n | awk -v elapsed=$1 '{ l[NR] = $1 } END {
+        printf "%-20s%d\n", "requests", NR
+        printf "%-20s%.0f\n", "requests/s", NR * 1000000 / elapsed
+        printf "%-20s%d\n", "p50 latency (us)", l[int(NR / 2) + 1]
+        printf "%-20s%d\n", "p99 latency (us)", l[int((NR - 1) * 99 / 100) + 1]
+        printf "%-20s%d\n", "max latency (us)", l[NR]
+    }'
+}
+
+echo "Starting benchmark with a process per file"
+start=${EPOCHREALTIME/[.,]/}
+for i in $(seq $REPEAT); do
+    for f in $FILES; do
+        s=${EPOCHREALTIME/[.,]/}
+        (cd $DIR && $TPCC $f > /dev/null 2> /dev/null)
+        echo $((${EPOCHREALTIME/[.,]/} - s))
+    done
+done > $DIR/latencies
+summary $((${EPOCHREALTIME/[.,]/} - start)) < $DIR/latencies
+echo
+
+echo "Starting benchmark through a server"
+$TPCC --server $SOCK -j $JOBS &
+SERVER=$!
+for i in $(seq 50); do
+    [ -S $SOCK ] && break
+    sleep 0.1
+done
+$TPCC --client $SOCK --repeat $REPEAT -j $JOBS $FILES
+RES=$?
+
+kill $SERVER
+rm -rf $DIR
+exit $RES
@@ -25,12 +25,56 @@ run() {
     echo 
 }
 
+# a streamed compilation reports the diagnostics of the whole tree, in the
+# same order, and exits with the same code
+run_stream() {
+    echo "Starting tests on $1/$2 with --stream"
+
+    for file in $1/$2/* ; do
+        echo "Test $file"
+        local whole=$(./bin/tpcc $file 2>&1 > /dev/null; echo $?)
+        local streamed=$(./bin/tpcc --stream $file 2>&1 > /dev/null; echo $?)
+        if [ "$whole" != "$streamed" ]; then
+            echo "Test failed on file $file with --stream"
+        else
+            RES=$(($RES + 1))
+        fi
+        NBFILES=$(($NBFILES + 1))
+    done
+    echo
+}
+
+# several files of the same name in a batch: only the first one is compiled,
+# the others fail without overwriting its file
+run_batch() {
+    echo "Starting tests on batch"
+
+    local dir=$(mktemp -d)
+    local root=$PWD
+    local files=(test/exec/fibo.tpc test-nico/good/fibo.tpc test/exec/seq.tpc)
+    echo "Test ${files[@]}"
+    (cd $dir && $root/bin/tpcc -j 2 ${files[@]/#/$root/} 2> err > /dev/null)
+    ACC=$?
+    ./bin/tpcc ${files[0]} 2> /dev/null > /dev/null
+    if [ $ACC -ne 3 ] || ! cmp -s fibo.asm $dir/fibo.asm || [ ! -f $dir/seq.asm ] \
+       || ! grep -q "'$root/${files[1]}' is not compiled" $dir/err; then
+        echo "Test failed on batch ${files[@]}"
+    else
+        RES=$(($RES + 1))
+    fi
+    NBFILES=$(($NBFILES + 1))
+    rm -rf $dir
+    echo
+}
+
 
 for src in ${sources[@]}; do
     for i in "${!folders[@]}"; do
         run $src ${folders[$i]} ${rvalues[$i]}
+        run_stream $src ${folders[$i]}
     done
 done
+run_batch
 
 rm *.asm
 
@@ -0,0 +1,79 @@
+#include "arena.h"
+
+#include <stdlib.h>
+
+/**
+ * @brief Allocate a chunk able to hold at least size bytes
+ * 
+ * @param size number of bytes needed
+ * @return allocated chunk
+ *         NULL if fail due to memory error
+ */
+static Chunk* new_chunk(size_t size) {
+    if (size < ARENA_CHUNK_SIZE) {
+        size = ARENA_CHUNK_SIZE;
+    }
+    Chunk* chunk = malloc(sizeof(Chunk) + size);
+    if (!chunk) {
+        return NULL;
+    }
+    chunk->next = NULL;
+    chunk->size = size;
+    chunk->used = 0;
+    return chunk;
+}
+
+void init_arena(Arena* arena) {
+    *arena = (Arena){.first     = NULL,
+                     .current   = NULL,
+                     .bytes     = 0,
+                     .nb_chunks = 0};
+}
+
+void* arena_alloc(Arena* arena, size_t size) {
+    // keep every allocation aligned for any type
+    size_t align = _Alignof(max_align_t);
+    size = (size + align - 1) / align * align;
+
+    Chunk* chunk = arena->current;
+    // move to the next chunks kept by a reset, or allocate a new one
+    while (!chunk || chunk->used + size > chunk->size) {
+        Chunk* next = chunk ? chunk->next: arena->first;
+        if (next) {
+            next->used = 0;
+        } else {
+            if (!(next = new_chunk(size))) {
+                return NULL;
+            }
+            if (chunk) {
+                chunk->next = next;
+            } else {
+                arena->first = next;
+            }
+            arena->nb_chunks++;
+        }
+        chunk = arena->current = next;
+    }
+
+    void* ptr = (char*)chunk->data + chunk->used;
+    chunk->used += size;
+    arena->bytes += size;
+    return ptr;
+}
+
+void reset_arena(Arena* arena) {
+    arena->current = arena->first;
+    if (arena->first) {
+        arena->first->used = 0;
+    }
+    arena->bytes = 0;
+}
+
+void free_arena(Arena* arena) {
+    Chunk* next;
+    for (Chunk* chunk = arena->first; chunk; chunk = next) {
+        next = chunk->next;
+        free(chunk);
+    }
+    init_arena(arena);
+}
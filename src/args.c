@@ -1,6 +1,8 @@
 #include <getopt.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "args.h"
 
@@ -10,12 +12,27 @@
  * @return
  */
 static Args init_args(void) {
-    return (Args){.help    = false,
-                  .tree    = false,
-                  .err     = false,
-                  .symbols = false,
-                  .source  = NULL,
-                  .name    = NULL};
+    return (Args){.help       = false,
+                  .tree       = false,
+                  .err        = false,
+                  .symbols    = false,
+                  .stats      = false,
+                  .tokens     = false,
+                  .fast_lexer = false,
+                  .stream     = false,
+                  .cache_stats = false,
+                  .comments   = COMMENTS_NONE,
+                  .format     = FORMAT_NASM,
+                  .codegen    = CODEGEN_WALK,
+                  .dump_ir    = false,
+                  .perf_map   = false,
+                  .cache_dir  = NULL,
+                  .server     = NULL,
+                  .client     = NULL,
+                  .repeat     = 0,
+                  .jobs       = 1,
+                  .nb_files   = 0,
+                  .files      = NULL};
 }
 
 Args parse_args(int argc, char* argv[]) {
@@ -28,9 +45,25 @@ Args parse_args(int argc, char* argv[]) {
         {"help",    no_argument,       0, 'h'},
         {"tree",    no_argument,       0, 't'},
         {"symtabs", no_argument,       0, 's'},
+        {"jobs",    required_argument, 0, 'j'},
+        {"stats",   no_argument,       0, 'S'},
+        {"tokens",  no_argument,       0, 'T'},
+        {"lexer",   required_argument, 0, 'L'},
+        {"stream",  no_argument,       0, 'F'},
+        {"cache-dir",   required_argument, 0, 'C'},
+        {"cache-stats", no_argument,       0, 'K'},
+        {"server",  required_argument, 0, 'V'},
+        {"client",  required_argument, 0, 'c'},
+        {"repeat",  required_argument, 0, 'R'},
+        {"asm-comments", required_argument, 0, 'A'},
+        {"format",  required_argument, 0, 'f'},
+        {"run",     no_argument,       0, 'r'},
+        {"perf-map", no_argument,      0, 'P'},
+        {"codegen", required_argument, 0, 'G'},
+        {"dump-ir", no_argument,       0, 'I'},
         {0,         0,                 0, 0}
     };
-    while ((opt = getopt_long(argc, argv, "htso:", long_options, &opt_index)) != -1) {
+    while ((opt = getopt_long(argc, argv, "htsj:o:", long_options, &opt_index)) != -1) {
         switch (opt) {
             case 't':
                 args.tree = true;
@@ -41,6 +74,94 @@ Args parse_args(int argc, char* argv[]) {
             case 's':
                 args.symbols = true;
                 break;
+            case 'S':
+                args.stats = true;
+                break;
+            case 'T':
+                args.tokens = true;
+                break;
+            case 'F':
+                args.stream = true;
+                break;
+            case 'C':
+                args.cache_dir = optarg;
+                break;
+            case 'K':
+                args.cache_stats = true;
+                break;
+            case 'V':
+                args.server = optarg;
+                break;
+            case 'c':
+                args.client = optarg;
+                break;
+            case 'R':
+                args.repeat = atoi(optarg);
+                if (args.repeat < 1) {
+                    fprintf(stderr, "Invalid number of requests : %s\n", optarg);
+                    args.err = true;
+                }
+                break;
+            case 'L':
+                if (!strcmp(optarg, "fast")) {
+                    args.fast_lexer = true;
+                } else if (!strcmp(optarg, "flex")) {
+                    args.fast_lexer = false;
+                } else {
+                    fprintf(stderr, "Unknown lexer : %s\n", optarg);
+                    args.err = true;
+                }
+                break;
+            case 'A':
+                if (!strcmp(optarg, "none")) {
+                    args.comments = COMMENTS_NONE;
+                } else if (!strcmp(optarg, "brief")) {
+                    args.comments = COMMENTS_BRIEF;
+                } else if (!strcmp(optarg, "full")) {
+                    args.comments = COMMENTS_FULL;
+                } else {
+                    fprintf(stderr, "Unknown level of comments : %s\n", optarg);
+                    args.err = true;
+                }
+                break;
+            case 'f':
+                if (!strcmp(optarg, "asm")) {
+                    args.format = FORMAT_NASM;
+                } else if (!strcmp(optarg, "obj")) {
+                    args.format = FORMAT_OBJECT;
+                } else if (!strcmp(optarg, "exe")) {
+                    args.format = FORMAT_EXECUTABLE;
+                } else {
+                    fprintf(stderr, "Unknown format : %s\n", optarg);
+                    args.err = true;
+                }
+                break;
+            case 'r':
+                args.format = FORMAT_RUN;
+                break;
+            case 'G':
+                if (!strcmp(optarg, "walk")) {
+                    args.codegen = CODEGEN_WALK;
+                } else if (!strcmp(optarg, "ir")) {
+                    args.codegen = CODEGEN_IR;
+                } else {
+                    fprintf(stderr, "Unknown code generator : %s\n", optarg);
+                    args.err = true;
+                }
+                break;
+            case 'I':
+                args.dump_ir = true;
+                break;
+            case 'P':
+                args.perf_map = true;
+                break;
+            case 'j':
+                args.jobs = atoi(optarg);
+                if (args.jobs < 1) {
+                    fprintf(stderr, "Invalid number of jobs : %s\n", optarg);
+                    args.err = true;
+                }
+                break;
             case '?':
                 fprintf(stderr, "Unknown option : %c\n", optopt);
                 args.err = true;
@@ -48,16 +169,28 @@ Args parse_args(int argc, char* argv[]) {
                 break;
         }
     }
-    // check if a path is given
-    if (optind < argc) {
-        char* path = argv[optind];
-        args.name = path;
-        args.source = fopen(path, "r");
-        if (!(args.source)) {
-            fprintf(stderr, "Cannot open file '%s'\n", path);
-            args.err = true;
-        }
+    // keep given paths, they are opened when compiled
+    args.files = argv + optind;
+    args.nb_files = argc - optind;
+    if (args.nb_files > 1 && (args.tree || args.symbols || args.tokens || args.dump_ir)) {
+        fprintf(stderr, "Cannot print tokens, trees, symbols or IR of several files\n");
+        args.err = true;
+    }
+    if (args.client && (args.tree || args.symbols || args.tokens || args.dump_ir)) {
+        fprintf(stderr, "Cannot print tokens, trees, symbols or IR through a server\n");
+        args.err = true;
+    }
+    if (args.format == FORMAT_RUN && (args.nb_files > 1 || args.client)) {
+        fprintf(stderr, "Can only run a single file, without a server\n");
+        args.err = true;
+    }
+    if (args.perf_map && args.format != FORMAT_RUN) {
+        fprintf(stderr, "Can only write the perf map of a program run\n");
+        args.err = true;
+    }
+    if (args.repeat && !args.client) {
+        fprintf(stderr, "Requests can only be repeated to a server\n");
+        args.err = true;
     }
     return args;
 }
-
@@ -0,0 +1,1412 @@
+#include "assemble.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "errors.h"
+
+#define DEFAULT_TEXT (1 << 16)
+#define DEFAULT_SYMBOLS 64
+#define DEFAULT_FIXUPS 64
+#define MAX_INSTR_LEN 16        // instructions are up to 15 bytes long
+#define MAX_OPERANDS 3
+
+typedef enum {                  // kinds of operands
+    OPERAND_REG,                // register
+    OPERAND_IMM,                // immediate value or address of a label
+    OPERAND_MEM,                // memory at an address
+} OperandKind;
+
+typedef struct {                // operand of an instruction
+    OperandKind kind;           // kind of the operand
+    int size;                   // size in bytes, 0 if not given
+    int reg;                    // register, or base register of the
+                                // address, -1 if none
+    int index;                  // index register of the address, -1 if none
+    int scale;                  // scale of the index
+    int symbol;                 // label of the immediate or of the
+                                // address, -1 if none
+    long value;                 // immediate value or displacement
+} Operand;
+
+typedef struct {                // state of an assembly
+    Context* ctx;               // compilation context
+    Object* obj;                // assembled program
+    SectionId section;          // section being assembled
+    int parent;                 // last label not starting with a dot
+    int line;                   // line being assembled
+    const char* start;          // start of the line being assembled
+    const char* end;            // end of the line being assembled
+    bool failed;                // if an error was reported
+} Assembler;
+
+typedef struct Mnemonic Mnemonic;
+
+typedef void (*Encoder)(Assembler* as, const Mnemonic* mnemonic,
+                        const Operand* ops, int nb_ops);
+
+struct Mnemonic {               // instruction known by the assembler
+    const char* name;           // name of the instruction
+    int len;                    // length of the name
+    Encoder encode;             // writes the instruction
+    unsigned int opcode;        // opcode, from its first byte to its last
+    int ext;                    // opcode extension or condition code
+};
+
+typedef struct {                // register known by the assembler
+    const char* name;           // name of the register
+    int len;                    // length of the name
+    int reg;                    // number of the register
+    int size;                   // size in bytes
+} Register;
+
+typedef struct {                // condition of jumps, sets and moves
+    const char* name;           // suffix of the instruction
+    int len;                    // length of the suffix
+    int code;                   // condition code
+} Condition;
+
+#define REG(name, reg, size) {name, sizeof(name) - 1, reg, size}
+
+// registers, the most used first
+static const Register registers[] = {
+    REG("rax", 0, 8), REG("rcx", 1, 8), REG("rbp", 5, 8), REG("rsp", 4, 8),
+    REG("rdi", 7, 8), REG("rdx", 2, 8), REG("rsi", 6, 8), REG("rbx", 3, 8),
+    REG("r8", 8, 8), REG("r9", 9, 8), REG("r10", 10, 8), REG("r11", 11, 8),
+    REG("r12", 12, 8), REG("r13", 13, 8), REG("r14", 14, 8), REG("r15", 15, 8),
+    REG("eax", 0, 4), REG("ecx", 1, 4), REG("edx", 2, 4), REG("ebx", 3, 4),
+    REG("esp", 4, 4), REG("ebp", 5, 4), REG("esi", 6, 4), REG("edi", 7, 4),
+    REG("r8d", 8, 4), REG("r9d", 9, 4), REG("r10d", 10, 4), REG("r11d", 11, 4),
+    REG("r12d", 12, 4), REG("r13d", 13, 4), REG("r14d", 14, 4), REG("r15d", 15, 4),
+    REG("al", 0, 1), REG("cl", 1, 1), REG("dl", 2, 1), REG("bl", 3, 1),
+    REG("spl", 4, 1), REG("bpl", 5, 1), REG("sil", 6, 1), REG("dil", 7, 1),
+    REG("r8b", 8, 1), REG("r9b", 9, 1), REG("r10b", 10, 1), REG("r11b", 11, 1),
+    REG("r12b", 12, 1), REG("r13b", 13, 1), REG("r14b", 14, 1), REG("r15b", 15, 1),
+    {NULL, 0, 0, 0}
+};
+
+#define COND(name, code) {name, sizeof(name) - 1, code}
+
+static const Condition conditions[] = {
+    COND("e", 4), COND("ne", 5), COND("l", 12), COND("ge", 13), COND("le", 14),
+    COND("g", 15), COND("z", 4), COND("nz", 5), COND("nge", 12), COND("nl", 13),
+    COND("ng", 14), COND("nle", 15), COND("o", 0), COND("no", 1), COND("b", 2),
+    COND("c", 2), COND("nae", 2), COND("nb", 3), COND("nc", 3), COND("ae", 3),
+    COND("be", 6), COND("na", 6), COND("a", 7), COND("nbe", 7), COND("s", 8),
+    COND("ns", 9), COND("p", 10), COND("pe", 10), COND("np", 11), COND("po", 11),
+    {NULL, 0, 0}
+};
+
+/**
+ * @brief Write an instruction of a single opcode, without operand
+ */
+static void encode_fixed(Assembler* as, const Mnemonic* mnemonic,
+                         const Operand* ops, int nb_ops);
+
+/**
+ * @brief Write an arithmetic or logic instruction of two operands, whose
+ *        extension is the row of the instruction in the opcode map
+ */
+static void encode_alu(Assembler* as, const Mnemonic* mnemonic,
+                       const Operand* ops, int nb_ops);
+
+/**
+ * @brief Write an instruction of a single register or memory operand,
+ *        whose extension is given in the ModRM byte
+ */
+static void encode_unary(Assembler* as, const Mnemonic* mnemonic,
+                         const Operand* ops, int nb_ops);
+
+/**
+ * @brief Write a shift of a register or memory by an immediate or `cl`
+ */
+static void encode_shift(Assembler* as, const Mnemonic* mnemonic,
+                         const Operand* ops, int nb_ops);
+
+/**
+ * @brief Write a `test`
+ */
+static void encode_test(Assembler* as, const Mnemonic* mnemonic,
+                        const Operand* ops, int nb_ops);
+
+/**
+ * @brief Write a `mov`, in its shortest form for immediates
+ */
+static void encode_mov(Assembler* as, const Mnemonic* mnemonic,
+                       const Operand* ops, int nb_ops);
+
+/**
+ * @brief Write a `movzx` of a byte
+ */
+static void encode_movzx(Assembler* as, const Mnemonic* mnemonic,
+                         const Operand* ops, int nb_ops);
+
+/**
+ * @brief Write a `lea`
+ */
+static void encode_lea(Assembler* as, const Mnemonic* mnemonic,
+                       const Operand* ops, int nb_ops);
+
+/**
+ * @brief Write a `push`
+ */
+static void encode_push(Assembler* as, const Mnemonic* mnemonic,
+                        const Operand* ops, int nb_ops);
+
+/**
+ * @brief Write a `pop`
+ */
+static void encode_pop(Assembler* as, const Mnemonic* mnemonic,
+                       const Operand* ops, int nb_ops);
+
+/**
+ * @brief Write an `imul` of one, two or three operands
+ */
+static void encode_imul(Assembler* as, const Mnemonic* mnemonic,
+                        const Operand* ops, int nb_ops);
+
+/**
+ * @brief Write a `call` or a `jmp`, to a label or to an address in a
+ *        register or in memory
+ */
+static void encode_branch(Assembler* as, const Mnemonic* mnemonic,
+                          const Operand* ops, int nb_ops);
+
+/**
+ * @brief Write a conditional jump to a label
+ */
+static void encode_jcc(Assembler* as, const Mnemonic* mnemonic,
+                       const Operand* ops, int nb_ops);
+
+/**
+ * @brief Write a `set` of a byte on a condition
+ */
+static void encode_setcc(Assembler* as, const Mnemonic* mnemonic,
+                         const Operand* ops, int nb_ops);
+
+/**
+ * @brief Write a `cmov` on a condition
+ */
+static void encode_cmovcc(Assembler* as, const Mnemonic* mnemonic,
+                          const Operand* ops, int nb_ops);
+
+#define MNEMONIC(name, encode, opcode, ext) \
+    {name, sizeof(name) - 1, encode, opcode, ext}
+
+// instructions, the most used first
+static const Mnemonic mnemonics[] = {
+    MNEMONIC("push",    encode_push,   0,      0),
+    MNEMONIC("pop",     encode_pop,    0,      0),
+    MNEMONIC("mov",     encode_mov,    0,      0),
+    MNEMONIC("sub",     encode_alu,    0,      5),
+    MNEMONIC("add",     encode_alu,    0,      0),
+    MNEMONIC("cmp",     encode_alu,    0,      7),
+    MNEMONIC("jmp",     encode_branch, 0xE9,   4),
+    MNEMONIC("call",    encode_branch, 0xE8,   2),
+    MNEMONIC("ret",     encode_fixed,  0xC3,   0),
+    MNEMONIC("imul",    encode_imul,   0,      0),
+    MNEMONIC("syscall", encode_fixed,  0x0F05, 0),
+    MNEMONIC("neg",     encode_unary,  0xF7,   3),
+    MNEMONIC("idiv",    encode_unary,  0xF7,   7),
+    MNEMONIC("cqo",     encode_fixed,  0x4899, 0),
+    MNEMONIC("inc",     encode_unary,  0xFF,   0),
+    MNEMONIC("dec",     encode_unary,  0xFF,   1),
+    MNEMONIC("test",    encode_test,   0,      0),
+    MNEMONIC("movzx",   encode_movzx,  0,      0),
+    MNEMONIC("lea",     encode_lea,    0,      0),
+    MNEMONIC("and",     encode_alu,    0,      4),
+    MNEMONIC("or",      encode_alu,    0,      1),
+    MNEMONIC("xor",     encode_alu,    0,      6),
+    MNEMONIC("adc",     encode_alu,    0,      2),
+    MNEMONIC("sbb",     encode_alu,    0,      3),
+    MNEMONIC("not",     encode_unary,  0xF7,   2),
+    MNEMONIC("mul",     encode_unary,  0xF7,   4),
+    MNEMONIC("div",     encode_unary,  0xF7,   6),
+    MNEMONIC("shl",     encode_shift,  0,      4),
+    MNEMONIC("sal",     encode_shift,  0,      4),
+    MNEMONIC("shr",     encode_shift,  0,      5),
+    MNEMONIC("sar",     encode_shift,  0,      7),
+    MNEMONIC("leave",   encode_fixed,  0xC9,   0),
+    MNEMONIC("nop",     encode_fixed,  0x90,   0),
+    {NULL, 0, NULL, 0, 0}
+};
+
+// instructions whose name is followed by a condition
+static const Mnemonic conditional[] = {
+    MNEMONIC("j",       encode_jcc,    0,      0),
+    MNEMONIC("set",     encode_setcc,  0,      0),
+    MNEMONIC("cmov",    encode_cmovcc, 0,      0),
+    {NULL, 0, NULL, 0, 0}
+};
+
+/**
+ * @brief Report an error on the line being assembled, once
+ *
+ * @param as assembler
+ * @param message description of the error, followed by the line
+ */
+static void fail(Assembler* as, const char* message);
+
+/**
+ * @brief Hash the name of a label with FNV-1a, along with its parent
+ *
+ * @param name name of the label
+ * @param len length of the name
+ * @param parent label a local label belongs to, else -1
+ * @return hash
+ */
+static unsigned int hash_symbol(const char* name, int len, int parent);
+
+/**
+ * @brief Double the capacity of the labels, keeping the buckets at most half
+ *        filled
+ *
+ * @param obj assembled program
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+static int grow_symbols(Object* obj);
+
+/**
+ * @brief Get a label by its name, added as undefined if unknown yet. Names
+ *        starting with a dot belong to the last label not starting with one
+ *
+ * @param as assembler
+ * @param name name of the label
+ * @param len length of the name
+ * @return index of the label
+ *         -1 if fail due to memory error
+ */
+static int get_symbol(Assembler* as, const char* name, int len);
+
+/**
+ * @brief Define a label at the current offset of the current section
+ *
+ * @param as assembler
+ * @param name name of the label
+ * @param len length of the name
+ */
+static void define_symbol(Assembler* as, const char* name, int len);
+
+/**
+ * @brief Keep an address to write once the label is placed
+ *
+ * @param as assembler
+ * @param kind how the address is written
+ * @param symbol label addressed
+ * @param addend added to the address of the label
+ */
+static void add_fixup(Assembler* as, FixupKind kind, int symbol, long addend);
+
+/**
+ * @brief Make room for an instruction at the end of the code
+ *
+ * @param as assembler
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+static int reserve_text(Assembler* as);
+
+/**
+ * @brief Write a byte of code, once room is made
+ *
+ * @param obj assembled program
+ * @param byte byte to write
+ */
+static void put_byte(Object* obj, int byte);
+
+/**
+ * @brief Write the lowest 32 bits of a value
+ *
+ * @param obj assembled program
+ * @param value value to write
+ */
+static void put_int32(Object* obj, long value);
+
+/**
+ * @brief Write an opcode of one to three bytes
+ *
+ * @param obj assembled program
+ * @param opcode opcode, from its first byte to its last
+ */
+static void put_opcode(Object* obj, unsigned int opcode);
+
+/**
+ * @brief Write an instruction whose operands are given by a ModRM byte,
+ *        after its REX prefix if needed
+ *
+ * @param as assembler
+ * @param size size of the operation, 8 for 64 bits operations
+ * @param opcode opcode, from its first byte to its last
+ * @param reg register or opcode extension in the ModRM byte
+ * @param rm register or memory operand in the ModRM byte
+ */
+static void put_modrm(Assembler* as, int size, unsigned int opcode, int reg,
+                      const Operand* rm);
+
+/**
+ * @brief Write a 32 bits immediate, or the address of its label
+ *
+ * @param as assembler
+ * @param imm immediate operand
+ */
+static void put_imm32(Assembler* as, const Operand* imm);
+
+/**
+ * @brief Write a jump to a label, in two bytes if the label is defined
+ *        close enough before it
+ *
+ * @param as assembler
+ * @param short_opcode opcode of the jump of a byte, -1 if none
+ * @param near_opcode opcode of the jump of 32 bits
+ * @param target immediate operand giving the label
+ */
+static void put_branch(Assembler* as, int short_opcode, unsigned int near_opcode,
+                       const Operand* target);
+
+/**
+ * @brief Get the size of the operands of an instruction, checking that the
+ *        sized ones are of the same size
+ *
+ * @param as assembler
+ * @param ops operands
+ * @param nb_ops number of operands
+ * @return size in bytes
+ *         0 if none is sized or if they differ
+ */
+static int operation_size(Assembler* as, const Operand* ops, int nb_ops);
+
+/**
+ * @brief Get the register named by a word
+ *
+ * @param name word
+ * @param len length of the word
+ * @return register
+ *         NULL if the word is not a register
+ */
+static const Register* find_register(const char* name, int len);
+
+/**
+ * @brief Get the instruction named by a word
+ *
+ * @param name word
+ * @param len length of the word
+ * @param cond set to the condition of a conditional instruction
+ * @return instruction
+ *         NULL if the word is not an instruction
+ */
+static const Mnemonic* find_mnemonic(const char* name, int len, int* cond);
+
+/**
+ * @brief Read a number, a quoted string of characters, a register or a label
+ *        and add it to an operand, as the terms of its address if in memory
+ *
+ * @param as assembler
+ * @param cur current position in the line, moved after the term
+ * @param op operand
+ * @param negative if the term is subtracted
+ * @return 1 if success
+ *         0 if the term is invalid
+ */
+static int parse_term(Assembler* as, const char** cur, Operand* op,
+                      bool negative);
+
+/**
+ * @brief Read an operand
+ *
+ * @param as assembler
+ * @param cur current position in the line, moved after the operand
+ * @param op operand to fill
+ * @return 1 if success
+ *         0 if the operand is invalid
+ */
+static int parse_operand(Assembler* as, const char** cur, Operand* op);
+
+/**
+ * @brief Read a directive or an instruction, with the labels before it, and
+ *        write its code
+ *
+ * @param as assembler
+ */
+static void parse_line(Assembler* as);
+
+/**
+ * @brief Write the jumps within the code, and check that every label used
+ *        or declared global is defined
+ *
+ * @param as assembler
+ */
+static void link_text(Assembler* as);
+
+/**
+ * @brief Check if a character can be part of a word
+ *
+ * @param c character
+ * @return true if so
+ */
+static inline bool is_word_char(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+           || (c >= '0' && c <= '9') || c == '_' || c == '.' || c == '$'
+           || c == '?' || c == '@';
+}
+
+/**
+ * @brief Skip the blanks of a line
+ *
+ * @param cur current position in the line
+ * @param end end of the line
+ * @return first character after the blanks
+ */
+static inline const char* skip_blanks(const char* cur, const char* end) {
+    while (cur < end && (*cur == ' ' || *cur == '\t' || *cur == '\r')) {
+        cur++;
+    }
+    return cur;
+}
+
+/**
+ * @brief Skip a word
+ *
+ * @param cur current position in the line
+ * @param end end of the line
+ * @return first character after the word
+ */
+static inline const char* skip_word(const char* cur, const char* end) {
+    while (cur < end && is_word_char(*cur)) {
+        cur++;
+    }
+    return cur;
+}
+
+static void fail(Assembler* as, const char* message) {
+    if (as->failed) {
+        return;
+    }
+    char text[ERROR_LEN];
+    const char* start = skip_blanks(as->start, as->end);
+    const char* end = as->end;
+    while (end > start && (end[-1] == '\r' || end[-1] == ' ')) {
+        end--;
+    }
+    snprintf(text, ERROR_LEN, "%s: '%.*s'", message,
+             (int)(end - start < 80 ? end - start: 80), start);
+    assembly_error(as->ctx, as->line, text);
+    as->failed = true;
+}
+
+static unsigned int hash_symbol(const char* name, int len, int parent) {
+    unsigned int hash = 2166136261u ^ (unsigned int)parent;
+    for (int i = 0; i < len; i++) {
+        hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static int grow_symbols(Object* obj) {
+    int max_symbols = obj->max_symbols ? obj->max_symbols*2: DEFAULT_SYMBOLS;
+    int nb_buckets = max_symbols*2;
+
+    AsmSymbol* symbols = realloc(obj->symbols, sizeof(AsmSymbol)*max_symbols);
+    if (!symbols) {
+        return 0;
+    }
+    obj->symbols = symbols;
+    int* buckets = malloc(sizeof(int)*nb_buckets);
+    if (!buckets) {
+        return 0;
+    }
+
+    // put back known labels in the new buckets
+    memset(buckets, -1, sizeof(int)*nb_buckets);
+    for (int id = 0; id < obj->nb_symbols; id++) {
+        const AsmSymbol* sym = &obj->symbols[id];
+        unsigned int i = hash_symbol(sym->name, sym->len, sym->parent)
+                         & (nb_buckets - 1);
+        while (buckets[i] != -1) {
+            i = (i + 1) & (nb_buckets - 1);
+        }
+        buckets[i] = id;
+    }
+    free(obj->buckets);
+    obj->buckets = buckets;
+    obj->nb_buckets = nb_buckets;
+    obj->max_symbols = max_symbols;
+    return 1;
+}
+
+static int get_symbol(Assembler* as, const char* name, int len) {
+    Object* obj = as->obj;
+    int parent = name[0] == '.' ? as->parent: -1;
+    if (obj->nb_symbols == obj->max_symbols && !grow_symbols(obj)) {
+        memory_error(as->ctx);
+        as->failed = true;
+        return -1;
+    }
+    unsigned int i = hash_symbol(name, len, parent) & (obj->nb_buckets - 1);
+    for (; obj->buckets[i] != -1; i = (i + 1) & (obj->nb_buckets - 1)) {
+        const AsmSymbol* sym = &obj->symbols[obj->buckets[i]];
+        if (sym->len == len && sym->parent == parent
+            && !memcmp(sym->name, name, len)) {
+            return obj->buckets[i];
+        }
+    }
+    obj->buckets[i] = obj->nb_symbols;
+    obj->symbols[obj->nb_symbols] = (AsmSymbol){.name    = name,
+                                                .len     = len,
+                                                .parent  = parent,
+                                                .global  = false,
+                                                .section = SECTION_NONE,
+                                                .offset  = 0};
+    return obj->nb_symbols++;
+}
+
+static void define_symbol(Assembler* as, const char* name, int len) {
+    int id = get_symbol(as, name, len);
+    if (id < 0) {
+        return;
+    }
+    AsmSymbol* sym = &as->obj->symbols[id];
+    if (sym->section != SECTION_NONE) {
+        fail(as, "label defined twice");
+        return;
+    }
+    if (as->section == SECTION_NONE) {
+        fail(as, "label outside of a section");
+        return;
+    }
+    sym->section = as->section;
+    sym->offset = as->section == SECTION_TEXT ? as->obj->text_len
+                                              : as->obj->bss_len;
+    // next local labels belong to this one
+    if (name[0] != '.') {
+        as->parent = id;
+    }
+}
+
+static void add_fixup(Assembler* as, FixupKind kind, int symbol, long addend) {
+    Object* obj = as->obj;
+    if (obj->nb_fixups == obj->max_fixups) {
+        int max_fixups = obj->max_fixups ? obj->max_fixups*2: DEFAULT_FIXUPS;
+        Fixup* fixups = realloc(obj->fixups, sizeof(Fixup)*max_fixups);
+        if (!fixups) {
+            memory_error(as->ctx);
+            as->failed = true;
+            return;
+        }
+        obj->fixups = fixups;
+        obj->max_fixups = max_fixups;
+    }
+    obj->fixups[obj->nb_fixups++] = (Fixup){.kind   = kind,
+                                            .offset = obj->text_len,
+                                            .symbol = symbol,
+                                            .addend = addend,
+                                            .line   = as->line};
+}
+
+static int reserve_text(Assembler* as) {
+    Object* obj = as->obj;
+    if (obj->text_len + MAX_INSTR_LEN <= obj->text_max) {
+        return 1;
+    }
+    size_t text_max = obj->text_max ? obj->text_max*2: DEFAULT_TEXT;
+    unsigned char* text = realloc(obj->text, text_max);
+    if (!text) {
+        memory_error(as->ctx);
+        as->failed = true;
+        return 0;
+    }
+    obj->text = text;
+    obj->text_max = text_max;
+    return 1;
+}
+
+static void put_byte(Object* obj, int byte) {
+    obj->text[obj->text_len++] = byte;
+}
+
+static void put_int32(Object* obj, long value) {
+    uint32_t bits = value;
+    memcpy(obj->text + obj->text_len, &bits, 4);
+    obj->text_len += 4;
+}
+
+static void put_opcode(Object* obj, unsigned int opcode) {
+    if (opcode > 0xFFFF) {
+        put_byte(obj, opcode >> 16);
+    }
+    if (opcode > 0xFF) {
+        put_byte(obj, (opcode >> 8) & 0xFF);
+    }
+    put_byte(obj, opcode & 0xFF);
+}
+
+static void put_modrm(Assembler* as, int size, unsigned int opcode, int reg,
+                      const Operand* rm) {
+    Object* obj = as->obj;
+    int rex = (size == 8 ? 8: 0) | (reg & 8 ? 4: 0);
+    bool byte_reg = false;
+    if (rm->kind == OPERAND_REG) {
+        rex |= rm->reg & 8 ? 1: 0;
+        // spl, bpl, sil and dil are only reached with a prefix
+        byte_reg = rm->size == 1 && rm->reg >= 4 && rm->reg < 8;
+    } else {
+        rex |= (rm->index >= 0 && rm->index & 8 ? 2: 0)
+               | (rm->reg >= 0 && rm->reg & 8 ? 1: 0);
+    }
+    if (rex || byte_reg) {
+        put_byte(obj, 0x40 | rex);
+    }
+    put_opcode(obj, opcode);
+
+    if (rm->kind == OPERAND_REG) {
+        put_byte(obj, 0xC0 | (reg & 7) << 3 | (rm->reg & 7));
+        return;
+    }
+    int scale = rm->scale == 8 ? 3: rm->scale == 4 ? 2: rm->scale == 2 ? 1: 0;
+    int index = rm->index >= 0 ? rm->index & 7: 4;
+    int disp_len;
+    if (rm->reg < 0) {
+        // absolute address, through a SIB byte without base
+        put_byte(obj, (reg & 7) << 3 | 4);
+        put_byte(obj, scale << 6 | index << 3 | 5);
+        disp_len = 4;
+    } else {
+        int mod;
+        if (rm->symbol < 0 && !rm->value && (rm->reg & 7) != 5) {
+            mod = 0;
+            disp_len = 0;
+        } else if (rm->symbol < 0 && rm->value >= -128 && rm->value <= 127) {
+            mod = 1;
+            disp_len = 1;
+        } else {
+            mod = 2;
+            disp_len = 4;
+        }
+        if (rm->index >= 0 || (rm->reg & 7) == 4) {
+            put_byte(obj, mod << 6 | (reg & 7) << 3 | 4);
+            put_byte(obj, scale << 6 | index << 3 | (rm->reg & 7));
+        } else {
+            put_byte(obj, mod << 6 | (reg & 7) << 3 | (rm->reg & 7));
+        }
+    }
+    if (disp_len == 1) {
+        put_byte(obj, rm->value & 0xFF);
+    } else if (disp_len == 4) {
+        if (rm->symbol >= 0) {
+            add_fixup(as, FIXUP_ABS32S, rm->symbol, rm->value);
+        }
+        put_int32(obj, rm->symbol >= 0 ? 0: rm->value);
+    }
+}
+
+static void put_imm32(Assembler* as, const Operand* imm) {
+    if (imm->symbol >= 0) {
+        add_fixup(as, FIXUP_ABS32S, imm->symbol, imm->value);
+        put_int32(as->obj, 0);
+    } else {
+        put_int32(as->obj, imm->value);
+    }
+}
+
+static void put_branch(Assembler* as, int short_opcode, unsigned int near_opcode,
+                       const Operand* target) {
+    Object* obj = as->obj;
+    if (target->kind != OPERAND_IMM || target->symbol < 0) {
+        fail(as, "invalid jump target");
+        return;
+    }
+    const AsmSymbol* sym = &obj->symbols[target->symbol];
+    // labels before the jump are known, the next ones are fixed at the end
+    if (short_opcode >= 0 && sym->section == SECTION_TEXT) {
+        long rel = sym->offset + target->value - (obj->text_len + 2);
+        if (rel >= -128 && rel <= 127) {
+            put_byte(obj, short_opcode);
+            put_byte(obj, rel & 0xFF);
+            return;
+        }
+    }
+    put_opcode(obj, near_opcode);
+    add_fixup(as, FIXUP_REL32, target->symbol, target->value - 4);
+    put_int32(obj, 0);
+}
+
+static int operation_size(Assembler* as, const Operand* ops, int nb_ops) {
+    int size = 0;
+    for (int i = 0; i < nb_ops; i++) {
+        if (ops[i].size && size && ops[i].size != size) {
+            fail(as, "operands of different sizes");
+            return 0;
+        }
+        if (ops[i].size) {
+            size = ops[i].size;
+        }
+    }
+    return size;
+}
+
+/**
+ * @brief Check that an operand is a register or in memory
+ *
+ * @param op operand
+ * @return true if so
+ */
+static inline bool is_rm(const Operand* op) {
+    return op->kind == OPERAND_REG || op->kind == OPERAND_MEM;
+}
+
+/**
+ * @brief Check that an immediate fits in a signed byte
+ *
+ * @param op immediate operand
+ * @return true if so
+ */
+static inline bool fits_byte(const Operand* op) {
+    return op->symbol < 0 && op->value >= -128 && op->value <= 127;
+}
+
+static void encode_fixed(Assembler* as, const Mnemonic* mnemonic,
+                         const Operand* ops, int nb_ops) {
+    if (nb_ops) {
+        fail(as, "unexpected operand");
+        return;
+    }
+    put_opcode(as->obj, mnemonic->opcode);
+}
+
+static void encode_alu(Assembler* as, const Mnemonic* mnemonic,
+                       const Operand* ops, int nb_ops) {
+    int size = operation_size(as, ops, nb_ops);
+    if (nb_ops != 2 || (size != 4 && size != 8)) {
+        fail(as, "invalid operands");
+        return;
+    }
+    int row = mnemonic->ext << 3;
+    if (is_rm(&ops[0]) && ops[1].kind == OPERAND_REG) {
+        put_modrm(as, size, row | 0x01, ops[1].reg, &ops[0]);
+    } else if (ops[0].kind == OPERAND_REG && ops[1].kind == OPERAND_MEM) {
+        put_modrm(as, size, row | 0x03, ops[0].reg, &ops[1]);
+    } else if (is_rm(&ops[0]) && ops[1].kind == OPERAND_IMM) {
+        if (fits_byte(&ops[1])) {
+            put_modrm(as, size, 0x83, mnemonic->ext, &ops[0]);
+            put_byte(as->obj, ops[1].value & 0xFF);
+        } else {
+            put_modrm(as, size, 0x81, mnemonic->ext, &ops[0]);
+            put_imm32(as, &ops[1]);
+        }
+    } else {
+        fail(as, "invalid operands");
+    }
+}
+
+static void encode_unary(Assembler* as, const Mnemonic* mnemonic,
+                         const Operand* ops, int nb_ops) {
+    int size = operation_size(as, ops, nb_ops);
+    if (nb_ops != 1 || !is_rm(&ops[0]) || (size != 4 && size != 8)) {
+        fail(as, "invalid operands");
+        return;
+    }
+    put_modrm(as, size, mnemonic->opcode, mnemonic->ext, &ops[0]);
+}
+
+static void encode_shift(Assembler* as, const Mnemonic* mnemonic,
+                         const Operand* ops, int nb_ops) {
+    if (nb_ops != 2 || !is_rm(&ops[0])
+        || (ops[0].size != 4 && ops[0].size != 8)) {
+        fail(as, "invalid operands");
+        return;
+    }
+    if (ops[1].kind == OPERAND_IMM && ops[1].symbol < 0) {
+        if (ops[1].value == 1) {
+            put_modrm(as, ops[0].size, 0xD1, mnemonic->ext, &ops[0]);
+        } else {
+            put_modrm(as, ops[0].size, 0xC1, mnemonic->ext, &ops[0]);
+            put_byte(as->obj, ops[1].value & 0xFF);
+        }
+    } else if (ops[1].kind == OPERAND_REG && ops[1].reg == 1 && ops[1].size == 1) {
+        put_modrm(as, ops[0].size, 0xD3, mnemonic->ext, &ops[0]);
+    } else {
+        fail(as, "invalid operands");
+    }
+}
+
+static void encode_test(Assembler* as, const Mnemonic* mnemonic,
+                        const Operand* ops, int nb_ops) {
+    int size = operation_size(as, ops, nb_ops);
+    if (nb_ops != 2 || !is_rm(&ops[0]) || (size != 4 && size != 8)) {
+        fail(as, "invalid operands");
+    } else if (ops[1].kind == OPERAND_REG) {
+        put_modrm(as, size, 0x85, ops[1].reg, &ops[0]);
+    } else if (ops[1].kind == OPERAND_IMM) {
+        put_modrm(as, size, 0xF7, 0, &ops[0]);
+        put_imm32(as, &ops[1]);
+    } else {
+        fail(as, "invalid operands");
+    }
+}
+
+static void encode_mov(Assembler* as, const Mnemonic* mnemonic,
+                       const Operand* ops, int nb_ops) {
+    Object* obj = as->obj;
+    int size = operation_size(as, ops, nb_ops);
+    if (nb_ops != 2 || (size != 4 && size != 8)) {
+        fail(as, "invalid operands");
+    } else if (is_rm(&ops[0]) && ops[1].kind == OPERAND_REG) {
+        put_modrm(as, size, 0x89, ops[1].reg, &ops[0]);
+    } else if (ops[0].kind == OPERAND_REG && ops[1].kind == OPERAND_MEM) {
+        put_modrm(as, size, 0x8B, ops[0].reg, &ops[1]);
+    } else if (ops[0].kind == OPERAND_REG && ops[1].kind == OPERAND_IMM) {
+        int reg = ops[0].reg;
+        long value = ops[1].value;
+        if (ops[1].symbol >= 0 && size == 8) {
+            // addresses of labels are written on 64 bits
+            put_byte(obj, 0x48 | (reg & 8 ? 1: 0));
+            put_byte(obj, 0xB8 | (reg & 7));
+            add_fixup(as, FIXUP_ABS64, ops[1].symbol, value);
+            memset(obj->text + obj->text_len, 0, 8);
+            obj->text_len += 8;
+        } else if (size == 4 || ops[1].symbol >= 0
+                   || (value >= 0 && value <= 0xFFFFFFFFL)) {
+            // a 32 bits move clears the high bits of the register
+            if (reg & 8) {
+                put_byte(obj, 0x41);
+            }
+            put_byte(obj, 0xB8 | (reg & 7));
+            put_imm32(as, &ops[1]);
+        } else if (value >= INT32_MIN && value <= INT32_MAX) {
+            put_modrm(as, 8, 0xC7, 0, &ops[0]);
+            put_int32(obj, value);
+        } else {
+            put_byte(obj, 0x48 | (reg & 8 ? 1: 0));
+            put_byte(obj, 0xB8 | (reg & 7));
+            memcpy(obj->text + obj->text_len, &value, 8);
+            obj->text_len += 8;
+        }
+    } else if (ops[0].kind == OPERAND_MEM && ops[1].kind == OPERAND_IMM) {
+        put_modrm(as, size, 0xC7, 0, &ops[0]);
+        put_imm32(as, &ops[1]);
+    } else {
+        fail(as, "invalid operands");
+    }
+}
+
+static void encode_movzx(Assembler* as, const Mnemonic* mnemonic,
+                         const Operand* ops, int nb_ops) {
+    if (nb_ops != 2 || ops[0].kind != OPERAND_REG || !is_rm(&ops[1])
+        || ops[1].size != 1 || (ops[0].size != 4 && ops[0].size != 8)) {
+        fail(as, "invalid operands");
+        return;
+    }
+    put_modrm(as, ops[0].size, 0x0FB6, ops[0].reg, &ops[1]);
+}
+
+static void encode_lea(Assembler* as, const Mnemonic* mnemonic,
+                       const Operand* ops, int nb_ops) {
+    if (nb_ops != 2 || ops[0].kind != OPERAND_REG || ops[1].kind != OPERAND_MEM
+        || (ops[0].size != 4 && ops[0].size != 8)) {
+        fail(as, "invalid operands");
+        return;
+    }
+    put_modrm(as, ops[0].size, 0x8D, ops[0].reg, &ops[1]);
+}
+
+static void encode_push(Assembler* as, const Mnemonic* mnemonic,
+                        const Operand* ops, int nb_ops) {
+    Object* obj = as->obj;
+    if (nb_ops != 1 || (ops[0].size && ops[0].size != 8)) {
+        fail(as, "invalid operands");
+    } else if (ops[0].kind == OPERAND_REG) {
+        if (ops[0].reg & 8) {
+            put_byte(obj, 0x41);
+        }
+        put_byte(obj, 0x50 | (ops[0].reg & 7));
+    } else if (ops[0].kind == OPERAND_MEM) {
+        // pushes are of 64 bits without prefix
+        put_modrm(as, 4, 0xFF, 6, &ops[0]);
+    } else if (fits_byte(&ops[0])) {
+        put_byte(obj, 0x6A);
+        put_byte(obj, ops[0].value & 0xFF);
+    } else {
+        put_byte(obj, 0x68);
+        put_imm32(as, &ops[0]);
+    }
+}
+
+static void encode_pop(Assembler* as, const Mnemonic* mnemonic,
+                       const Operand* ops, int nb_ops) {
+    if (nb_ops != 1 || (ops[0].size && ops[0].size != 8)) {
+        fail(as, "invalid operands");
+    } else if (ops[0].kind == OPERAND_REG) {
+        if (ops[0].reg & 8) {
+            put_byte(as->obj, 0x41);
+        }
+        put_byte(as->obj, 0x58 | (ops[0].reg & 7));
+    } else if (ops[0].kind == OPERAND_MEM) {
+        put_modrm(as, 4, 0x8F, 0, &ops[0]);
+    } else {
+        fail(as, "invalid operands");
+    }
+}
+
+static void encode_imul(Assembler* as, const Mnemonic* mnemonic,
+                        const Operand* ops, int nb_ops) {
+    int size = operation_size(as, ops, nb_ops);
+    if (size != 4 && size != 8) {
+        fail(as, "invalid operands");
+    } else if (nb_ops == 1 && is_rm(&ops[0])) {
+        put_modrm(as, size, 0xF7, 5, &ops[0]);
+    } else if (nb_ops == 2 && ops[0].kind == OPERAND_REG && is_rm(&ops[1])) {
+        put_modrm(as, size, 0x0FAF, ops[0].reg, &ops[1]);
+    } else if (ops[0].kind == OPERAND_REG && ops[nb_ops - 1].kind == OPERAND_IMM
+               && (nb_ops == 2 || (nb_ops == 3 && is_rm(&ops[1])))) {
+        // the two operands form multiplies the register by itself
+        const Operand* imm = &ops[nb_ops - 1];
+        const Operand* rm = nb_ops == 3 ? &ops[1]: &ops[0];
+        if (fits_byte(imm)) {
+            put_modrm(as, size, 0x6B, ops[0].reg, rm);
+            put_byte(as->obj, imm->value & 0xFF);
+        } else {
+            put_modrm(as, size, 0x69, ops[0].reg, rm);
+            put_imm32(as, imm);
+        }
+    } else {
+        fail(as, "invalid operands");
+    }
+}
+
+static void encode_branch(Assembler* as, const Mnemonic* mnemonic,
+                          const Operand* ops, int nb_ops) {
+    if (nb_ops != 1) {
+        fail(as, "invalid operands");
+    } else if (is_rm(&ops[0])) {
+        put_modrm(as, 4, 0xFF, mnemonic->ext, &ops[0]);
+    } else {
+        // calls are always written on 32 bits, as nasm does
+        put_branch(as, mnemonic->opcode == 0xE9 ? 0xEB: -1, mnemonic->opcode,
+                   &ops[0]);
+    }
+}
+
+static void encode_jcc(Assembler* as, const Mnemonic* mnemonic,
+                       const Operand* ops, int nb_ops) {
+    if (nb_ops != 1) {
+        fail(as, "invalid operands");
+        return;
+    }
+    put_branch(as, 0x70 | mnemonic->ext, 0x0F80 | mnemonic->ext, &ops[0]);
+}
+
+static void encode_setcc(Assembler* as, const Mnemonic* mnemonic,
+                         const Operand* ops, int nb_ops) {
+    if (nb_ops != 1 || !is_rm(&ops[0]) || ops[0].size != 1) {
+        fail(as, "invalid operands");
+        return;
+    }
+    put_modrm(as, 1, 0x0F90 | mnemonic->ext, 0, &ops[0]);
+}
+
+static void encode_cmovcc(Assembler* as, const Mnemonic* mnemonic,
+                          const Operand* ops, int nb_ops) {
+    int size = operation_size(as, ops, nb_ops);
+    if (nb_ops != 2 || ops[0].kind != OPERAND_REG || !is_rm(&ops[1])
+        || (size != 4 && size != 8)) {
+        fail(as, "invalid operands");
+        return;
+    }
+    put_modrm(as, size, 0x0F40 | mnemonic->ext, ops[0].reg, &ops[1]);
+}
+
+static const Register* find_register(const char* name, int len) {
+    if (len > 4) {
+        return NULL;
+    }
+    for (const Register* reg = registers; reg->name; reg++) {
+        if (reg->len == len && reg->name[0] == name[0]
+            && !memcmp(reg->name, name, len)) {
+            return reg;
+        }
+    }
+    return NULL;
+}
+
+static const Mnemonic* find_mnemonic(const char* name, int len, int* cond) {
+    for (const Mnemonic* m = mnemonics; m->name; m++) {
+        if (m->len == len && m->name[0] == name[0]
+            && !memcmp(m->name, name, len)) {
+            return m;
+        }
+    }
+    // jumps, sets and moves are named after their condition
+    for (const Mnemonic* m = conditional; m->name; m++) {
+        if (len <= m->len || memcmp(m->name, name, m->len)) {
+            continue;
+        }
+        for (const Condition* c = conditions; c->name; c++) {
+            if (c->len == len - m->len
+                && !memcmp(c->name, name + m->len, c->len)) {
+                *cond = c->code;
+                return m;
+            }
+        }
+    }
+    return NULL;
+}
+
+static int parse_term(Assembler* as, const char** cur, Operand* op,
+                      bool negative) {
+    const char* end = as->end;
+    const char* start = *cur;
+    long value = 0;
+    if (start < end && *start >= '0' && *start <= '9') {
+        // numbers are decimal, unless written in hexadecimal with 0x
+        const char* p = start;
+        if (end - p > 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+            for (p += 2; p < end && is_word_char(*p); p++) {
+                int digit = *p >= 'a' ? *p - 'a' + 10
+                          : *p >= 'A' ? *p - 'A' + 10: *p - '0';
+                if (digit < 0 || digit > 15) {
+                    return 0;
+                }
+                value = value*16 + digit;
+            }
+        } else {
+            for (; p < end && *p >= '0' && *p <= '9'; p++) {
+                value = value*10 + (*p - '0');
+            }
+            if (p < end && is_word_char(*p)) {
+                return 0;
+            }
+        }
+        *cur = p;
+    } else if (start < end && (*start == '\'' || *start == '"')) {
+        // characters of a string are its bytes, the first one the lowest
+        const char* close = memchr(start + 1, *start, end - start - 1);
+        if (!close || close - start - 1 > 8) {
+            return 0;
+        }
+        for (const char* p = close - 1; p > start; p--) {
+            value = value << 8 | (unsigned char)*p;
+        }
+        *cur = close + 1;
+    } else if (start < end && is_word_char(*start)) {
+        const char* after = skip_word(start, end);
+        *cur = after;
+        const Register* reg = find_register(start, after - start);
+        if (reg) {
+            // registers are only added in addresses
+            if (op->kind != OPERAND_MEM || negative || reg->size != 8) {
+                return 0;
+            }
+            const char* p = skip_blanks(after, end);
+            int scale = 1;
+            if (p < end && *p == '*') {
+                p = skip_blanks(p + 1, end);
+                scale = p < end ? *p - '0': 0;
+                *cur = p + 1;
+            }
+            if (scale != 1 && scale != 2 && scale != 4 && scale != 8) {
+                return 0;
+            }
+            if (op->reg < 0 && scale == 1) {
+                op->reg = reg->reg;
+            } else if (op->index < 0 && reg->reg != 4) {
+                op->index = reg->reg;
+                op->scale = scale;
+            } else {
+                return 0;
+            }
+            return 1;
+        }
+        if (negative || op->symbol >= 0) {
+            return 0;
+        }
+        op->symbol = get_symbol(as, start, after - start);
+        return op->symbol >= 0;
+    } else {
+        return 0;
+    }
+    op->value += negative ? -value: value;
+    return 1;
+}
+
+static int parse_operand(Assembler* as, const char** cur, Operand* op) {
+    const char* end = as->end;
+    *op = (Operand){.kind   = OPERAND_IMM,
+                    .size   = 0,
+                    .reg    = -1,
+                    .index  = -1,
+                    .scale  = 1,
+                    .symbol = -1,
+                    .value  = 0};
+    const char* p = skip_blanks(*cur, end);
+    const char* after = skip_word(p, end);
+    int len = after - p;
+    // size of the operand
+    if ((len == 4 && !memcmp(p, "byte", 4)) || (len == 4 && !memcmp(p, "word", 4))
+        || (len == 5 && !memcmp(p, "dword", 5)) || (len == 5 && !memcmp(p, "qword", 5))) {
+        op->size = p[0] == 'b' ? 1: p[0] == 'w' ? 2: p[0] == 'd' ? 4: 8;
+        p = skip_blanks(after, end);
+        after = skip_word(p, end);
+        len = after - p;
+    }
+    const Register* reg;
+    if (len && (reg = find_register(p, len))) {
+        if (op->size && op->size != reg->size) {
+            return 0;
+        }
+        op->kind = OPERAND_REG;
+        op->reg = reg->reg;
+        op->size = reg->size;
+        *cur = after;
+        return 1;
+    }
+    bool memory = p < end && *p == '[';
+    if (memory) {
+        op->kind = OPERAND_MEM;
+        p++;
+    }
+    // sum of terms
+    bool negative = false;
+    for (;;) {
+        p = skip_blanks(p, end);
+        if (p < end && (*p == '-' || *p == '+')) {
+            negative = *p == '-';
+            p = skip_blanks(p + 1, end);
+        }
+        if (!parse_term(as, &p, op, negative)) {
+            return 0;
+        }
+        p = skip_blanks(p, end);
+        if (p >= end || (*p != '+' && *p != '-')) {
+            break;
+        }
+    }
+    if (memory) {
+        if (p >= end || *p != ']') {
+            return 0;
+        }
+        p++;
+    }
+    *cur = p;
+    return 1;
+}
+
+static void parse_line(Assembler* as) {
+    const char* end = as->end;
+    const char* cur = skip_blanks(as->start, end);
+    if (cur == end || *cur == ';') {
+        return;
+    }
+    const char* word = cur;
+    cur = skip_word(cur, end);
+    // labels before the instruction
+    if (cur < end && *cur == ':') {
+        define_symbol(as, word, cur - word);
+        cur = skip_blanks(cur + 1, end);
+        if (cur == end || *cur == ';') {
+            return;
+        }
+        word = cur;
+        cur = skip_word(cur, end);
+    }
+    int len = cur - word;
+    if (!len) {
+        fail(as, "invalid line");
+        return;
+    }
+
+    if (len == 6 && !memcmp(word, "global", 6)) {
+        // labels exported, separated by commas
+        do {
+            const char* name = skip_blanks(cur, end);
+            cur = skip_word(name, end);
+            int id = cur > name ? get_symbol(as, name, cur - name): -1;
+            if (id < 0) {
+                fail(as, "invalid global label");
+                return;
+            }
+            as->obj->symbols[id].global = true;
+            cur = skip_blanks(cur, end);
+        } while (cur < end && *cur++ == ',');
+        return;
+    }
+    if (len == 7 && !memcmp(word, "section", 7)) {
+        const char* name = skip_blanks(cur, end);
+        cur = skip_word(name, end);
+        if (cur - name == 5 && !memcmp(name, ".text", 5)) {
+            as->section = SECTION_TEXT;
+        } else if (cur - name == 4 && !memcmp(name, ".bss", 4)) {
+            as->section = SECTION_BSS;
+        } else {
+            fail(as, "unknown section");
+        }
+        return;
+    }
+    if (len == 4 && !memcmp(word, "res", 3)) {
+        // zeroed data of bytes, words, double or quad words
+        int size = word[3] == 'b' ? 1: word[3] == 'w' ? 2
+                 : word[3] == 'd' ? 4: word[3] == 'q' ? 8: 0;
+        Operand count;
+        if (!size || as->section != SECTION_BSS || !parse_operand(as, &cur, &count)
+            || count.kind != OPERAND_IMM || count.symbol >= 0 || count.value < 0) {
+            fail(as, "invalid reservation");
+            return;
+        }
+        as->obj->bss_len += count.value*size;
+        return;
+    }
+
+    int cond = 0;
+    const Mnemonic* mnemonic = find_mnemonic(word, len, &cond);
+    if (!mnemonic) {
+        fail(as, "unknown instruction");
+        return;
+    }
+    if (as->section != SECTION_TEXT) {
+        fail(as, "instruction outside of the code");
+        return;
+    }
+    Operand ops[MAX_OPERANDS];
+    int nb_ops = 0;
+    cur = skip_blanks(cur, end);
+    while (cur < end && *cur != ';') {
+        if (nb_ops == MAX_OPERANDS || !parse_operand(as, &cur, &ops[nb_ops++])) {
+            fail(as, "invalid operand");
+            return;
+        }
+        cur = skip_blanks(cur, end);
+        if (cur < end && *cur == ',') {
+            cur = skip_blanks(cur + 1, end);
+        } else if (cur < end && *cur != ';') {
+            fail(as, "invalid operand");
+            return;
+        }
+    }
+    if (!as->failed && reserve_text(as)) {
+        Mnemonic conditioned = *mnemonic;
+        conditioned.ext |= cond;
+        mnemonic->encode(as, &conditioned, ops, nb_ops);
+    }
+}
+
+static void link_text(Assembler* as) {
+    Object* obj = as->obj;
+    for (int i = 0; i < obj->nb_symbols; i++) {
+        if (obj->symbols[i].global && obj->symbols[i].section == SECTION_NONE) {
+            char text[ERROR_LEN];
+            snprintf(text, ERROR_LEN, "undefined global label '%.*s'",
+                     obj->symbols[i].len, obj->symbols[i].name);
+            assembly_error(as->ctx, 0, text);
+            as->failed = true;
+            return;
+        }
+    }
+    // jumps within the code are written, other addresses are kept
+    int kept = 0;
+    for (int i = 0; i < obj->nb_fixups; i++) {
+        const Fixup* fixup = &obj->fixups[i];
+        const AsmSymbol* sym = &obj->symbols[fixup->symbol];
+        if (sym->section == SECTION_NONE) {
+            char text[ERROR_LEN];
+            snprintf(text, ERROR_LEN, "undefined label '%.*s'", sym->len,
+                     sym->name);
+            assembly_error(as->ctx, fixup->line, text);
+            as->failed = true;
+            return;
+        }
+        if (fixup->kind == FIXUP_REL32 && sym->section == SECTION_TEXT) {
+            uint32_t rel = sym->offset + fixup->addend - fixup->offset;
+            memcpy(obj->text + fixup->offset, &rel, 4);
+        } else {
+            obj->fixups[kept++] = *fixup;
+        }
+    }
+    obj->nb_fixups = kept;
+}
+
+int assemble(Context* ctx, Object* obj, const char* nasm, size_t len) {
+    *obj = (Object){.text        = NULL,
+                    .text_len    = 0,
+                    .text_max    = 0,
+                    .bss_len     = 0,
+                    .nb_symbols  = 0,
+                    .max_symbols = 0,
+                    .symbols     = NULL,
+                    .nb_buckets  = 0,
+                    .buckets     = NULL,
+                    .nb_fixups   = 0,
+                    .max_fixups  = 0,
+                    .fixups      = NULL};
+    Assembler as = {.ctx     = ctx,
+                    .obj     = obj,
+                    .section = SECTION_NONE,
+                    .parent  = -1,
+                    .line    = 0,
+                    .failed  = false};
+    const char* end = nasm + len;
+    const char* cur = nasm;
+    while (cur < end && !as.failed) {
+        const char* eol = memchr(cur, '\n', end - cur);
+        as.start = cur;
+        as.end = eol ? eol: end;
+        as.line++;
+        parse_line(&as);
+        cur = eol ? eol + 1: end;
+    }
+    if (!as.failed) {
+        link_text(&as);
+    }
+    return !as.failed;
+}
+
+int find_symbol(const Object* obj, const char* name) {
+    int len = strlen(name);
+    if (!obj->nb_buckets) {
+        return -1;
+    }
+    unsigned int i = hash_symbol(name, len, -1) & (obj->nb_buckets - 1);
+    for (; obj->buckets[i] != -1; i = (i + 1) & (obj->nb_buckets - 1)) {
+        const AsmSymbol* sym = &obj->symbols[obj->buckets[i]];
+        if (sym->len == len && sym->parent == -1 && !memcmp(sym->name, name, len)) {
+            return sym->section != SECTION_NONE ? obj->buckets[i]: -1;
+        }
+    }
+    return -1;
+}
+
+int place_object(Context* ctx, Object* obj, uint64_t text_address,
+                 uint64_t bss_address) {
+    for (int i = 0; i < obj->nb_fixups; i++) {
+        const Fixup* fixup = &obj->fixups[i];
+        const AsmSymbol* sym = &obj->symbols[fixup->symbol];
+        uint64_t address = sym->section == SECTION_TEXT ? text_address
+                                                        : bss_address;
+        int64_t value = address + sym->offset + fixup->addend;
+        if (fixup->kind == FIXUP_REL32) {
+            value -= text_address + fixup->offset;
+        }
+        unsigned char* field = obj->text + fixup->offset;
+        if (fixup->kind == FIXUP_ABS64) {
+            memcpy(field, &value, 8);
+        } else if (value >= INT32_MIN && value <= INT32_MAX) {
+            int32_t value32 = value;
+            memcpy(field, &value32, 4);
+        } else {
+            assembly_error(ctx, fixup->line, "address out of range");
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void free_object(Object* obj) {
+    free(obj->text);
+    free(obj->symbols);
+    free(obj->buckets);
+    free(obj->fixups);
+    obj->text = NULL;
+    obj->symbols = NULL;
+    obj->buckets = NULL;
+    obj->fixups = NULL;
+}
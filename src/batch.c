@@ -0,0 +1,407 @@
+#include "batch.h"
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "binary.h"
+#include "errors.h"
+#include "jit.h"
+#include "source.h"
+#include "tpcc.h"
+
+typedef struct {                // compilation of a single file
+    bool done;                  // if the compilation is over
+    int shared;                 // earlier job written to the same file,
+                                // -1 if none, else the job is not compiled
+    int res;                    // result of the compilation
+    char* name;                 // path of the source file
+    char* diagnostics;          // diagnostics printed while compiling
+    size_t diagnostics_len;     // length of diagnostics
+    Context ctx;                // compilation context
+} Job;
+
+typedef struct {                // files shared between workers
+    int nb_jobs;                // number of jobs
+    atomic_int next;            // next job to compile
+    pthread_mutex_t lock;       // lock on jobs state
+    pthread_cond_t done;        // signaled when a job is over
+    const Context* options;     // context copied by each job
+    Job* jobs;                  // jobs array
+} JobQueue;
+
+typedef struct {                // file written by a source file
+    char* name;                 // name of the written file
+    int file;                   // index of the source file
+} Output;
+
+/**
+ * @brief Write the generated nasm in the current directory, as nasm or
+ *        assembled in the format of the context, or run it in memory
+ * 
+ * @param ctx compilation context
+ * @param name source file path, NULL for standard input
+ * @param nasm generated nasm
+ * @param len length of the nasm
+ * @return 1 in case of success
+ *         else 0
+ */
+static int write_output(Context* ctx, const char* name, const char* nasm,
+                        size_t len);
+
+/**
+ * @brief Compile a loaded source function by function, straight into the
+ *        nasm file of the current directory, removed if the compilation fails.
+ *        The nasm is kept in memory if it is assembled
+ * 
+ * @param ctx compilation context
+ * @param name source file path, NULL for standard input
+ * @param src loaded source
+ * @return 0 if success
+ *         SYNTAX_ERROR, SEMANTIC_ERROR or OTHER_ERROR else
+ */
+static int stream_output(Context* ctx, const char* name, Source* src);
+
+/**
+ * @brief Compare two outputs by the name of their written file, then by the
+ *        order of their source files
+ * 
+ * @param a
+ * @param b
+ * @return comparison as expected by qsort
+ */
+static int compare_outputs(const void* a, const void* b);
+
+/**
+ * @brief Compile a job, with its diagnostics kept in memory
+ * 
+ * @param job job to compile
+ * @param options context giving the options of the compilation
+ * @param arena arena of the worker, reused from a job to the next
+ */
+static void run_job(Job* job, const Context* options, Arena* arena);
+
+/**
+ * @brief Worker taking jobs from the queue until it is empty
+ * 
+ * @param queue shared job queue
+ * @return NULL
+ */
+static void* worker(void* queue);
+
+/**
+ * @brief Print the diagnostics and the rapport of a finished job
+ * 
+ * @param queue job queue of the job
+ * @param job job to print
+ */
+static void print_job(JobQueue* queue, Job* job);
+
+int output_name(const char* name, OutputFormat format, char* filename,
+                size_t size) {
+    const char* ext = format == FORMAT_NASM ? ".asm"
+                    : format == FORMAT_OBJECT ? ".o": "";
+    int written;
+    if (!name) {
+        written = snprintf(filename, size, "_anonymous%s", ext);
+    } else {
+        // remove path prefix and extension to only keep the filename
+        const char* base = strrchr(name, '/');
+        base = base ? base + 1: name;
+        int len = strlen(base) - 4;
+        written = snprintf(filename, size, "%.*s%s", len > 0 ? len: 0, base, ext);
+    }
+    return written >= 0 && (size_t)written < size;
+}
+
+static int compare_outputs(const void* a, const void* b) {
+    const Output* x = a;
+    const Output* y = b;
+    int cmp = strcmp(x->name, y->name);
+    return cmp ? cmp: x->file - y->file;
+}
+
+int shared_outputs(OutputFormat format, char* files[], int nb_files,
+                   int* shared) {
+    for (int i = 0; i < nb_files; i++) {
+        shared[i] = -1;
+    }
+    if (format == FORMAT_RUN || nb_files < 2) {
+        return 1;
+    }
+    Output* outputs = calloc(nb_files, sizeof(Output));
+    if (!outputs) {
+        fprintf(stderr, "error while allocating memory\n");
+        return 0;
+    }
+    int res = 1;
+    char filename[PATH_MAX];
+    for (int i = 0; i < nb_files && res; i++) {
+        // a name too long is reported by the compilation of its file
+        output_name(files[i], format, filename, PATH_MAX);
+        outputs[i] = (Output){.name = strdup(filename), .file = i};
+        if (!outputs[i].name) {
+            fprintf(stderr, "error while allocating memory\n");
+            res = 0;
+        }
+    }
+    if (res) {
+        // files written by the same name are next to each other once sorted,
+        // the earliest first
+        qsort(outputs, nb_files, sizeof(Output), compare_outputs);
+        for (int i = 1, first = 0; i < nb_files; i++) {
+            if (strcmp(outputs[first].name, outputs[i].name)) {
+                first = i;
+            } else {
+                shared[outputs[i].file] = outputs[first].file;
+            }
+        }
+    }
+    for (int i = 0; i < nb_files; i++) {
+        free(outputs[i].name);
+    }
+    free(outputs);
+    return res;
+}
+
+void shared_output_error(OutputFormat format, const char* name,
+                         const char* earlier) {
+    char filename[PATH_MAX];
+    output_name(name, format, filename, PATH_MAX);
+    fprintf(stderr, "File '%s' is not compiled: '%s' is already written by "
+                    "'%s'\n", name, filename, earlier);
+}
+
+static int write_output(Context* ctx, const char* name, const char* nasm,
+                        size_t len) {
+    if (ctx->format == FORMAT_RUN) {
+        return run_program(ctx, nasm, len);
+    }
+    char filename[PATH_MAX];
+    if (!output_name(name, ctx->format, filename, PATH_MAX)) {
+        fprintf(ctx->err, "File name too long '%s'\n", name);
+        return 0;
+    }
+    if (ctx->format != FORMAT_NASM) {
+        return write_binary(ctx, filename, nasm, len);
+    }
+
+    FILE* out = fopen(filename, "w");
+    if (!out) {
+        return 0;
+    }
+    fwrite(nasm, 1, len, out);
+    fclose(out);
+    return 1;
+}
+
+static int stream_output(Context* ctx, const char* name, Source* src) {
+    char filename[PATH_MAX];
+    if (!output_name(name, ctx->format, filename, PATH_MAX)) {
+        fprintf(ctx->err, "File name too long '%s'\n", name);
+        return OTHER_ERROR;
+    }
+
+    char* nasm = NULL;
+    size_t len;
+    FILE* out = ctx->format == FORMAT_NASM ? fopen(filename, "w")
+                                           : open_memstream(&nasm, &len);
+    if (!out && ctx->format != FORMAT_NASM) {
+        memory_error(ctx);
+        return OTHER_ERROR;
+    } else if (!out) {
+        fprintf(ctx->err, "Cannot open file '%s'\n", filename);
+        return OTHER_ERROR;
+    }
+    int res = tpcc_compile_stream(ctx, src, out);
+    fclose(out);
+    if (ctx->format != FORMAT_NASM) {
+        if (!res && !write_output(ctx, name, nasm, len)) {
+            res = OTHER_ERROR;
+        }
+        free(nasm);
+    } else if (res) {
+        // functions written before the error do not make a program
+        remove(filename);
+    }
+    return res;
+}
+
+int compile_file(Context* ctx, const char* name) {
+    // load input
+    FILE* source = stdin;
+    if (name && !(source = fopen(name, "r"))) {
+        fprintf(ctx->err, "Cannot open file '%s'\n", name);
+        return OTHER_ERROR;
+    }
+    Source src;
+    int loaded = load_source(&src, source);
+    if (name) {
+        fclose(source);
+    }
+    if (!loaded) {
+        memory_error(ctx);
+        return OTHER_ERROR;
+    }
+
+    if (ctx->stream_functions) {
+        int res = stream_output(ctx, name, &src);
+        free_source(&src);
+        return res;
+    }
+    char* nasm;
+    int res = tpcc_compile_source(ctx, &src, &nasm);
+    free_source(&src);
+
+    if (nasm) {
+        // a program which cannot be assembled fails the compilation
+        if (!write_output(ctx, name, nasm, strlen(nasm))
+            && ctx->format != FORMAT_NASM) {
+            res = OTHER_ERROR;
+        }
+        free(nasm);
+    }
+    return res;
+}
+
+static void run_job(Job* job, const Context* options, Arena* arena) {
+    if (job->shared != -1) {
+        job->res = OTHER_ERROR;
+        return;
+    }
+    job->ctx = *options;
+    job->ctx.filename = job->name;
+    job->ctx.arena = arena;
+    // files are already compiled at the same time
+    job->ctx.jobs = 1;
+    job->ctx.err = open_memstream(&job->diagnostics, &job->diagnostics_len);
+    if (!job->ctx.err) {
+        // diagnostics cannot be delayed, print them directly
+        job->ctx.err = stderr;
+    }
+    job->res = compile_file(&job->ctx, job->name);
+    if (job->ctx.err != stderr) {
+        fclose(job->ctx.err);
+    }
+}
+
+static void* worker(void* queue) {
+    JobQueue* q = queue;
+    int index;
+    Arena arena;
+    init_arena(&arena);
+
+    // each worker takes the next job as soon as it is free, so a worker
+    // stuck on a large file does not delay the others
+    while ((index = atomic_fetch_add(&q->next, 1)) < q->nb_jobs) {
+        run_job(&q->jobs[index], q->options, &arena);
+
+        pthread_mutex_lock(&q->lock);
+        q->jobs[index].done = true;
+        pthread_cond_broadcast(&q->done);
+        pthread_mutex_unlock(&q->lock);
+    }
+    free_arena(&arena);
+    return NULL;
+}
+
+static void print_job(JobQueue* queue, Job* job) {
+    if (job->shared != -1) {
+        shared_output_error(queue->options->format, job->name,
+                            queue->jobs[job->shared].name);
+        return;
+    }
+    if (job->diagnostics) {
+        fputs(job->diagnostics, stderr);
+        free(job->diagnostics);
+    }
+    // syntax errors are reported by the parser itself
+    if (job->res != SYNTAX_ERROR && job->res != OTHER_ERROR) {
+        printf("%s:\n", job->name);
+        print_rapport(&job->ctx);
+    }
+    bool stats = job->ctx.print_stats || job->ctx.print_cache_stats;
+    if (stats && job->res != OTHER_ERROR) {
+        if (job->res == SYNTAX_ERROR) {
+            printf("%s:\n", job->name);
+        }
+        if (job->ctx.print_stats) {
+            print_stats(&job->ctx);
+        }
+        if (job->ctx.print_cache_stats) {
+            print_cache_stats(&job->ctx);
+        }
+    }
+}
+
+int compile_batch(const Context* options, char* files[], int nb_files,
+                  int jobs) {
+    JobQueue queue = {.nb_jobs = nb_files,
+                      .options = options,
+                      .jobs = calloc(nb_files, sizeof(Job))};
+    int* shared = malloc(sizeof(int)*nb_files);
+    // jobs writing the same file would overwrite each other, so only the
+    // earliest of them is compiled
+    if (!queue.jobs || !shared) {
+        fprintf(stderr, "error while allocating memory\n");
+        free(queue.jobs);
+        free(shared);
+        return OTHER_ERROR;
+    }
+    if (!shared_outputs(options->format, files, nb_files, shared)) {
+        free(queue.jobs);
+        free(shared);
+        return OTHER_ERROR;
+    }
+    atomic_init(&queue.next, 0);
+    pthread_mutex_init(&queue.lock, NULL);
+    pthread_cond_init(&queue.done, NULL);
+    for (int i = 0; i < nb_files; i++) {
+        queue.jobs[i].name = files[i];
+        queue.jobs[i].shared = shared[i];
+    }
+    free(shared);
+
+    if (jobs > nb_files) {
+        jobs = nb_files;
+    }
+    pthread_t* workers = malloc(sizeof(pthread_t)*jobs);
+    int nb_workers = 0;
+    for (; workers && nb_workers < jobs; nb_workers++) {
+        if (pthread_create(&workers[nb_workers], NULL, worker, &queue)) {
+            break;
+        }
+    }
+    if (!nb_workers) {
+        // no thread could be started, compile in the current one
+        worker(&queue);
+    }
+
+    // print results in the order of the files, as soon as they are known
+    int res = 0;
+    for (int i = 0; i < nb_files; i++) {
+        pthread_mutex_lock(&queue.lock);
+        while (!queue.jobs[i].done) {
+            pthread_cond_wait(&queue.done, &queue.lock);
+        }
+        pthread_mutex_unlock(&queue.lock);
+
+        print_job(&queue, &queue.jobs[i]);
+        if (queue.jobs[i].res > res) {
+            res = queue.jobs[i].res;
+        }
+    }
+
+    for (int i = 0; i < nb_workers; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    free(workers);
+    free(queue.jobs);
+    pthread_mutex_destroy(&queue.lock);
+    pthread_cond_destroy(&queue.done);
+    return res;
+}
@@ -0,0 +1,341 @@
+#include "binary.h"
+
+#include <elf.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "assemble.h"
+#include "errors.h"
+
+#define BASE_ADDRESS 0x400000   // address of the executable, as ld places it
+#define PAGE_SIZE 0x1000
+#define TEXT_ALIGN 16
+
+// names of the sections, each one at the offset given below
+static const char section_names[] = "\0.text\0.bss\0.rela.text\0.symtab"
+                                    "\0.strtab\0.shstrtab\0.note.GNU-stack";
+
+enum {                          // offsets of the names of the sections
+    NAME_TEXT = 1,
+    NAME_BSS = 7,
+    NAME_RELA = 12,
+    NAME_SYMTAB = 23,
+    NAME_STRTAB = 31,
+    NAME_SHSTRTAB = 39,
+    NAME_NOTE = 49,
+};
+
+enum {                          // sections of the written files
+    SEC_NULL,
+    SEC_TEXT,
+    SEC_BSS,
+    SEC_SYMTAB,
+    SEC_STRTAB,
+    SEC_SHSTRTAB,
+    SEC_RELA,                   // objects only
+    SEC_NOTE,                   // objects only, for a stack not executable
+    NB_SECTIONS,
+};
+
+typedef struct {                // symbols of the written file
+    int nb_symbols;             // number of symbols
+    int first_global;           // index of the first global symbol
+    Elf64_Sym* symbols;         // symbols, locals first
+    size_t names_len;           // length of the names of the symbols
+    char* names;                // names of the symbols
+} SymbolTable;
+
+/**
+ * @brief Fill the symbols of the labels, except the local ones, at their
+ *        address in the executable or at their offset in the object
+ *
+ * @param obj assembled program
+ * @param table table to fill
+ * @param addresses address of each section, 0 in an object
+ * @param object if an object is written, whose relocations need the symbols
+ *               of the sections
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+static int fill_symbols(const Object* obj, SymbolTable* table,
+                        const Elf64_Addr* addresses, bool object);
+
+/**
+ * @brief Get the relocations of the addresses of labels in the code of an
+ *        object, relative to the symbols of the sections
+ *
+ * @param obj assembled program
+ * @return allocated relocations, as many as fixups
+ *         NULL if fail due to memory error
+ */
+static Elf64_Rela* relocations(const Object* obj);
+
+/**
+ * @brief Write zeros up to an alignment
+ *
+ * @param file written file
+ * @param offset offset in the file, moved to the alignment
+ * @param align alignment
+ */
+static void pad(FILE* file, size_t* offset, size_t align);
+
+/**
+ * @brief Write data in a file
+ *
+ * @param file written file
+ * @param offset offset in the file, moved after the data
+ * @param data data to write
+ * @param len length of the data
+ */
+static void put(FILE* file, size_t* offset, const void* data, size_t len);
+
+/**
+ * @brief Write an assembled program in an ELF64 file
+ *
+ * @param ctx compilation context
+ * @param obj assembled program, whose addresses are written in an executable
+ * @param file written file
+ * @return 1 if success
+ *         0 if fail
+ */
+static int write_elf(Context* ctx, Object* obj, FILE* file);
+
+/**
+ * @brief Round a value up to an alignment
+ *
+ * @param value value to round
+ * @param align alignment, a power of 2
+ * @return rounded value
+ */
+static inline size_t align_up(size_t value, size_t align) {
+    return (value + align - 1) & ~(align - 1);
+}
+
+static int fill_symbols(const Object* obj, SymbolTable* table,
+                        const Elf64_Addr* addresses, bool object) {
+    table->symbols = malloc(sizeof(Elf64_Sym)*(obj->nb_symbols + 3));
+    table->names_len = 1;
+    for (int i = 0; i < obj->nb_symbols; i++) {
+        table->names_len += obj->symbols[i].len + 1;
+    }
+    table->names = malloc(table->names_len);
+    if (!table->symbols || !table->names) {
+        return 0;
+    }
+    table->names[0] = '\0';
+    table->names_len = 1;
+    table->symbols[0] = (Elf64_Sym){0};
+    table->nb_symbols = 1;
+    if (object) {
+        // relocations address the labels from the start of their section
+        for (int sec = SEC_TEXT; sec <= SEC_BSS; sec++) {
+            table->symbols[table->nb_symbols++] = (Elf64_Sym){
+                .st_info = ELF64_ST_INFO(STB_LOCAL, STT_SECTION),
+                .st_shndx = sec};
+        }
+    }
+    // labels local to the file first, then the global ones
+    for (int global = 0; global < 2; global++) {
+        if (global) {
+            table->first_global = table->nb_symbols;
+        }
+        for (int i = 0; i < obj->nb_symbols; i++) {
+            const AsmSymbol* sym = &obj->symbols[i];
+            if (sym->global != global || sym->parent >= 0 || sym->name[0] == '.') {
+                continue;
+            }
+            int sec = sym->section == SECTION_TEXT ? SEC_TEXT: SEC_BSS;
+            table->symbols[table->nb_symbols++] = (Elf64_Sym){
+                .st_name = table->names_len,
+                .st_info = ELF64_ST_INFO(global ? STB_GLOBAL: STB_LOCAL, STT_NOTYPE),
+                .st_shndx = sec,
+                .st_value = addresses[sec] + sym->offset};
+            memcpy(table->names + table->names_len, sym->name, sym->len);
+            table->names_len += sym->len;
+            table->names[table->names_len++] = '\0';
+        }
+    }
+    return 1;
+}
+
+static Elf64_Rela* relocations(const Object* obj) {
+    Elf64_Rela* rela = malloc(sizeof(Elf64_Rela)*(obj->nb_fixups + 1));
+    if (!rela) {
+        return NULL;
+    }
+    for (int i = 0; i < obj->nb_fixups; i++) {
+        const Fixup* fixup = &obj->fixups[i];
+        const AsmSymbol* sym = &obj->symbols[fixup->symbol];
+        int type = fixup->kind == FIXUP_REL32 ? R_X86_64_PC32
+                 : fixup->kind == FIXUP_ABS32S ? R_X86_64_32S: R_X86_64_64;
+        // symbols of the sections follow the null one
+        int sec = sym->section == SECTION_TEXT ? SEC_TEXT: SEC_BSS;
+        rela[i] = (Elf64_Rela){.r_offset = fixup->offset,
+                               .r_info = ELF64_R_INFO(sec, type),
+                               .r_addend = sym->offset + fixup->addend};
+    }
+    return rela;
+}
+
+static void pad(FILE* file, size_t* offset, size_t align) {
+    static const char zeros[PAGE_SIZE];
+    size_t aligned = align_up(*offset, align);
+    fwrite(zeros, 1, aligned - *offset, file);
+    *offset = aligned;
+}
+
+static void put(FILE* file, size_t* offset, const void* data, size_t len) {
+    if (len) {
+        fwrite(data, 1, len, file);
+        *offset += len;
+    }
+}
+
+static int write_elf(Context* ctx, Object* obj, FILE* file) {
+    bool object = ctx->format == FORMAT_OBJECT;
+    int nb_sections = object ? NB_SECTIONS: SEC_RELA;
+    int nb_segments = object ? 0: obj->bss_len ? 3: 2;
+
+    // the code follows the headers, the zeroed data starts on the next page
+    size_t text_offset = align_up(sizeof(Elf64_Ehdr)
+                                  + nb_segments*sizeof(Elf64_Phdr), TEXT_ALIGN);
+    Elf64_Addr addresses[NB_SECTIONS] = {0};
+    if (!object) {
+        addresses[SEC_TEXT] = BASE_ADDRESS + text_offset;
+        addresses[SEC_BSS] = align_up(addresses[SEC_TEXT] + obj->text_len,
+                                      PAGE_SIZE);
+    }
+    int entry = find_symbol(obj, "_start");
+    if (!object && (entry < 0 || obj->symbols[entry].section != SECTION_TEXT)) {
+        assembly_error(ctx, 0, "no '_start' label to start the executable at");
+        return 0;
+    }
+
+    SymbolTable table = {.symbols = NULL, .names = NULL};
+    Elf64_Rela* rela = NULL;
+    if (!fill_symbols(obj, &table, addresses, object)
+        || (object && !(rela = relocations(obj)))) {
+        memory_error(ctx);
+        free(table.symbols);
+        free(table.names);
+        return 0;
+    }
+    if (!object && !place_object(ctx, obj, addresses[SEC_TEXT],
+                                 addresses[SEC_BSS])) {
+        free(table.symbols);
+        free(table.names);
+        return 0;
+    }
+
+    // sections after the code
+    size_t symtab_offset = align_up(text_offset + obj->text_len, 8);
+    size_t symtab_len = sizeof(Elf64_Sym)*table.nb_symbols;
+    size_t strtab_offset = symtab_offset + symtab_len;
+    size_t rela_offset = align_up(strtab_offset + table.names_len, 8);
+    size_t rela_len = object ? sizeof(Elf64_Rela)*obj->nb_fixups: 0;
+    size_t shstrtab_offset = rela_offset + rela_len;
+    size_t sh_offset = align_up(shstrtab_offset + sizeof(section_names), 8);
+
+    Elf64_Ehdr header = {
+        .e_ident = {ELFMAG0, ELFMAG1, ELFMAG2, ELFMAG3, ELFCLASS64, ELFDATA2LSB,
+                    EV_CURRENT, ELFOSABI_SYSV},
+        .e_type = object ? ET_REL: ET_EXEC,
+        .e_machine = EM_X86_64,
+        .e_version = EV_CURRENT,
+        .e_entry = object ? 0: addresses[SEC_TEXT] + obj->symbols[entry].offset,
+        .e_phoff = nb_segments ? sizeof(Elf64_Ehdr): 0,
+        .e_shoff = sh_offset,
+        .e_ehsize = sizeof(Elf64_Ehdr),
+        .e_phentsize = nb_segments ? sizeof(Elf64_Phdr): 0,
+        .e_phnum = nb_segments,
+        .e_shentsize = sizeof(Elf64_Shdr),
+        .e_shnum = nb_sections,
+        .e_shstrndx = SEC_SHSTRTAB};
+    Elf64_Phdr segments[3] = {
+        {.p_type = PT_LOAD, .p_flags = PF_R | PF_X, .p_offset = 0,
+         .p_vaddr = BASE_ADDRESS, .p_paddr = BASE_ADDRESS,
+         .p_filesz = text_offset + obj->text_len,
+         .p_memsz = text_offset + obj->text_len, .p_align = PAGE_SIZE},
+        {.p_type = PT_GNU_STACK, .p_flags = PF_R | PF_W, .p_align = 16},
+        // zeroed data is not in the file
+        {.p_type = PT_LOAD, .p_flags = PF_R | PF_W, .p_offset = 0,
+         .p_vaddr = addresses[SEC_BSS], .p_paddr = addresses[SEC_BSS],
+         .p_filesz = 0, .p_memsz = obj->bss_len, .p_align = PAGE_SIZE}};
+    Elf64_Shdr sections[NB_SECTIONS] = {
+        [SEC_TEXT] = {.sh_name = NAME_TEXT, .sh_type = SHT_PROGBITS,
+                      .sh_flags = SHF_ALLOC | SHF_EXECINSTR,
+                      .sh_addr = addresses[SEC_TEXT], .sh_offset = text_offset,
+                      .sh_size = obj->text_len, .sh_addralign = TEXT_ALIGN},
+        [SEC_BSS] = {.sh_name = NAME_BSS, .sh_type = SHT_NOBITS,
+                     .sh_flags = SHF_ALLOC | SHF_WRITE,
+                     .sh_addr = addresses[SEC_BSS], .sh_offset = text_offset,
+                     .sh_size = obj->bss_len, .sh_addralign = 8},
+        [SEC_SYMTAB] = {.sh_name = NAME_SYMTAB, .sh_type = SHT_SYMTAB,
+                        .sh_offset = symtab_offset, .sh_size = symtab_len,
+                        .sh_link = SEC_STRTAB, .sh_info = table.first_global,
+                        .sh_addralign = 8, .sh_entsize = sizeof(Elf64_Sym)},
+        [SEC_STRTAB] = {.sh_name = NAME_STRTAB, .sh_type = SHT_STRTAB,
+                        .sh_offset = strtab_offset, .sh_size = table.names_len,
+                        .sh_addralign = 1},
+        [SEC_SHSTRTAB] = {.sh_name = NAME_SHSTRTAB, .sh_type = SHT_STRTAB,
+                          .sh_offset = shstrtab_offset,
+                          .sh_size = sizeof(section_names), .sh_addralign = 1},
+        [SEC_RELA] = {.sh_name = NAME_RELA, .sh_type = SHT_RELA,
+                      .sh_flags = SHF_INFO_LINK, .sh_offset = rela_offset,
+                      .sh_size = rela_len, .sh_link = SEC_SYMTAB,
+                      .sh_info = SEC_TEXT, .sh_addralign = 8,
+                      .sh_entsize = sizeof(Elf64_Rela)},
+        [SEC_NOTE] = {.sh_name = NAME_NOTE, .sh_type = SHT_PROGBITS,
+                      .sh_offset = sh_offset, .sh_addralign = 1}};
+
+    size_t offset = 0;
+    put(file, &offset, &header, sizeof(header));
+    put(file, &offset, segments, nb_segments*sizeof(Elf64_Phdr));
+    pad(file, &offset, TEXT_ALIGN);
+    put(file, &offset, obj->text, obj->text_len);
+    pad(file, &offset, 8);
+    put(file, &offset, table.symbols, symtab_len);
+    put(file, &offset, table.names, table.names_len);
+    pad(file, &offset, 8);
+    put(file, &offset, rela, rela_len);
+    put(file, &offset, section_names, sizeof(section_names));
+    pad(file, &offset, 8);
+    put(file, &offset, sections, nb_sections*sizeof(Elf64_Shdr));
+
+    free(table.symbols);
+    free(table.names);
+    free(rela);
+    return 1;
+}
+
+int write_binary(Context* ctx, const char* filename, const char* nasm,
+                 size_t len) {
+    Object obj;
+    if (!assemble(ctx, &obj, nasm, len)) {
+        free_object(&obj);
+        return 0;
+    }
+    // executables are written with the same rights as the ones of ld
+    bool object = ctx->format == FORMAT_OBJECT;
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, object ? 0666: 0777);
+    FILE* file = fd >= 0 ? fdopen(fd, "w"): NULL;
+    if (!file) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        fprintf(ctx->err, "Cannot open file '%s'\n", filename);
+        free_object(&obj);
+        return 0;
+    }
+    int res = write_elf(ctx, &obj, file);
+    if (fclose(file) || !res) {
+        remove(filename);
+        res = 0;
+    }
+    free_object(&obj);
+    return res;
+}
@@ -0,0 +1,424 @@
+#include "cache.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "walk.h"
+
+// changed each time the generated nasm changes, so older entries are missed
+#define CACHE_VERSION "tpcc-cache-10"
+
+#define FNV_OFFSET 14695981039346656037ull
+#define FNV_PRIME 1099511628211ull
+
+typedef struct {                // pass computing the key of a function
+    uint64_t hash;              // hash of the nodes visited so far
+    const Scope* scope;         // symbols seen by the function
+} Key;
+
+/**
+ * @brief Add bytes to a FNV-1a hash
+ *
+ * @param hash hash to update
+ * @param data bytes to add
+ * @param len number of bytes
+ * @return updated hash
+ */
+static uint64_t hash_bytes(uint64_t hash, const void* data, size_t len);
+
+/**
+ * @brief Add a name to a hash, with its terminator so that two names in a
+ *        row cannot be taken for others
+ *
+ * @param hash hash to update
+ * @param name name to add
+ * @return updated hash
+ */
+static uint64_t hash_name(uint64_t hash, const char* name);
+
+/**
+ * @brief Check if a label keeps an identifier as value
+ *
+ * @param label label of a node
+ * @return true if the value of the node is an identifier
+ */
+static bool has_name(label_t label);
+
+/**
+ * @brief Add to the key what a name refers to out of the function: the
+ *        global variable and the function of this name, if any
+ *
+ * @param ctx compilation context
+ * @param key key of the function
+ * @param ident name used by the function
+ */
+static void hash_symbol(Context* ctx, Key* key, ident_t ident);
+
+/**
+ * @brief Add a node to the key, then its children, then the end of the
+ *        node. Visit of the walk computing the key of a function
+ *
+ * @param walk walk whose pass is the key
+ * @param frame frame of the node
+ * @return 1
+ */
+static int hash_node(Walk* walk, Frame* frame);
+
+/**
+ * @brief Build the path of the pack of the compiled source
+ *
+ * @param ctx compilation context
+ * @param path set to the path
+ * @return 1 if the path fits in PATH_MAX
+ *         else 0
+ */
+static int pack_path(const Context* ctx, char* path);
+
+/**
+ * @brief Read the pack of the compiled source, if any
+ *
+ * @param ctx compilation context
+ * @param cache cache to load the pack in
+ * @return 1 if success, even if there is no pack
+ *         0 if fail due to memory error
+ */
+static int load_pack(Context* ctx, Cache* cache);
+
+/**
+ * @brief Insert a function of the loaded pack in the table of the cache
+ *
+ * @param cache cache, with room for the function
+ * @param entry function to insert
+ */
+static void insert_entry(Cache* cache, CacheEntry entry);
+
+/**
+ * @brief Find a function of the loaded pack
+ *
+ * @param cache
+ * @param key key of the function
+ * @return function, or NULL if not in the pack
+ */
+static CacheEntry* find_entry_by_key(Cache* cache, uint64_t key);
+
+/**
+ * @brief Write a function in a pack
+ *
+ * @param out pack target
+ * @param key key of the function
+ * @param nasm nasm of the function
+ * @param len length of the nasm
+ */
+static void write_entry(FILE* out, uint64_t key, const char* nasm, size_t len);
+
+/**
+ * @brief Replace the pack of the compiled source, so that other
+ *        compilations only ever see a complete pack
+ *
+ * @param ctx compilation context
+ * @param cache cache to write
+ * @param complete if the functions which were not used are dropped
+ */
+static void store_pack(Context* ctx, Cache* cache, bool complete);
+
+/**
+ * @brief Append the functions written by the compilation to the pack of the
+ *        compiled source. A reader seeing a partly appended function drops it
+ *
+ * @param ctx compilation context
+ * @param cache cache to write
+ */
+static void append_pack(Context* ctx, Cache* cache);
+
+static uint64_t hash_bytes(uint64_t hash, const void* data, size_t len) {
+    const unsigned char* bytes = data;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+static uint64_t hash_name(uint64_t hash, const char* name) {
+    return hash_bytes(hash, name, strlen(name) + 1);
+}
+
+static bool has_name(label_t label) {
+    switch (label) {
+        case Type: case Void: case Eq: case Negation: case Order:
+        case AddSub: case DivStar: case Character: case Ident:
+        case Assignation:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void hash_symbol(Context* ctx, Key* key, ident_t ident) {
+    const Scope* scope = key->scope;
+    const Entry* entry = get_entry(scope->globals, ident);
+    if (entry) {
+        key->hash = hash_bytes(key->hash, &entry->address, sizeof(entry->address));
+        key->hash = hash_bytes(key->hash, &entry->size, sizeof(entry->size));
+        key->hash = hash_bytes(key->hash, &entry->type, sizeof(entry->type));
+    }
+    const Function* fun = get_function(scope->collection, ident);
+    if (fun) {
+        key->hash = hash_bytes(key->hash, &fun->r_type, sizeof(fun->r_type));
+        key->hash = hash_bytes(key->hash, &fun->parameters.cur_len,
+                               sizeof(fun->parameters.cur_len));
+        for (int i = 0; i < fun->parameters.cur_len; i++) {
+            const Entry* param = &fun->parameters.array[i];
+            key->hash = hash_bytes(key->hash, &param->type, sizeof(param->type));
+        }
+    }
+}
+
+static int hash_node(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    Key* key = walk->pass;
+    if (frame->step) {
+        key->hash = hash_bytes(key->hash, ")", 1); // end of the children
+        return 1;
+    }
+    unsigned char header[2] = {NODE_LABEL(ctx, frame->node), NODE_TYPE(ctx, frame->node)};
+    key->hash = hash_bytes(key->hash, header, sizeof(header));
+
+    Value val = NODE_VAL(ctx, frame->node);
+    if (NODE_LABEL(ctx, frame->node) == Num) {
+        key->hash = hash_bytes(key->hash, &val.num, sizeof(val.num));
+    } else if (has_name(NODE_LABEL(ctx, frame->node))) {
+        const char* name = ident_name(ctx, val.ident);
+        key->hash = hash_name(key->hash, name);
+        if (NODE_LABEL(ctx, frame->node) == Ident) {
+            hash_symbol(ctx, key, val.ident);
+        }
+    }
+    visit_list(walk, FIRSTCHILD(ctx, frame->node));
+    return 1;
+}
+
+uint64_t function_key(Context* ctx, const Scope* scope, node_t node) {
+    Key pass = {.hash = hash_name(FNV_OFFSET, CACHE_VERSION), .scope = scope};
+    // the comments are part of the cached nasm
+    pass.hash = hash_bytes(pass.hash, &ctx->comments, sizeof(ctx->comments));
+    // and so is the way it is generated
+    pass.hash = hash_bytes(pass.hash, &ctx->codegen, sizeof(ctx->codegen));
+    Walk walk;
+    init_walk(&walk, ctx, hash_node, &pass);
+    // the header and the body of the function, not the functions after it
+    walk_tree(&walk, FIRSTCHILD(ctx, node));
+    free_walk(&walk);
+    // 0 marks the empty buckets of the cache
+    return pass.hash ? pass.hash: 1;
+}
+
+static int pack_path(const Context* ctx, char* path) {
+    // sources are told apart by their path
+    uint64_t hash = hash_name(FNV_OFFSET, ctx->filename);
+    int len = snprintf(path, PATH_MAX, "%s/%016llx.pack", ctx->cache_dir,
+                       (unsigned long long)hash);
+    return len > 0 && len < PATH_MAX;
+}
+
+static void insert_entry(Cache* cache, CacheEntry entry) {
+    int i = entry.key & (cache->nb_buckets - 1);
+    while (cache->entries[i].key) {
+        i = (i + 1) & (cache->nb_buckets - 1);
+    }
+    cache->entries[i] = entry;
+    cache->nb_entries++;
+}
+
+static CacheEntry* find_entry_by_key(Cache* cache, uint64_t key) {
+    if (!cache->nb_buckets) {
+        return NULL;
+    }
+    int i = key & (cache->nb_buckets - 1);
+    for (; cache->entries[i].key; i = (i + 1) & (cache->nb_buckets - 1)) {
+        if (cache->entries[i].key == key) {
+            return &cache->entries[i];
+        }
+    }
+    return NULL;
+}
+
+static int load_pack(Context* ctx, Cache* cache) {
+    char path[PATH_MAX];
+    FILE* file;
+    if (!pack_path(ctx, path) || !(file = fopen(path, "r"))) {
+        return 1;
+    }
+    // mapped as a source, so it is followed by null bytes
+    int loaded = load_source(&cache->pack, file);
+    fclose(file);
+    if (!loaded) {
+        return 0;
+    }
+
+    // a function takes at least a header line, so the table never fills
+    int max_entries = 0;
+    const char* line = cache->pack.text;
+    const char* end = cache->pack.text + cache->pack.len;
+    for (; (line = memchr(line, '\n', end - line)); line++) {
+        max_entries++;
+    }
+    for (cache->nb_buckets = 16; cache->nb_buckets < 2 * max_entries;) {
+        cache->nb_buckets *= 2;
+    }
+    if (!(cache->entries = calloc(cache->nb_buckets, sizeof(CacheEntry)))) {
+        return 0;
+    }
+    // each function is a header line followed by its nasm, a damaged pack
+    // is read up to its first damaged function
+    size_t offset = 0;
+    while (offset < cache->pack.len) {
+        CacheEntry entry = {0};
+        char* cur = cache->pack.text + offset;
+        if (strncmp(cur, "; function ", 11)) {
+            break;
+        }
+        entry.key = strtoull(cur + 11, &cur, 16);
+        entry.len = strtoull(cur, &cur, 10);
+        if (!entry.key || *cur != '\n'
+            || entry.len > cache->pack.len - (cur + 1 - cache->pack.text)) {
+            break;
+        }
+        entry.offset = cur + 1 - cache->pack.text;
+        insert_entry(cache, entry);
+        offset = entry.offset + entry.len;
+    }
+    return 1;
+}
+
+int open_cache(Context* ctx) {
+    Cache* cache = calloc(1, sizeof(Cache));
+    if (!cache) {
+        return 0;
+    }
+    pthread_mutex_init(&cache->lock, NULL);
+    cache->added_out = open_memstream(&cache->added, &cache->added_len);
+    if (!cache->added_out || !load_pack(ctx, cache)) {
+        ctx->cache = cache;
+        close_cache(ctx, false);
+        return 0;
+    }
+    ctx->cache = cache;
+    return 1;
+}
+
+static void write_entry(FILE* out, uint64_t key, const char* nasm, size_t len) {
+    fprintf(out, "; function %016llx %zu\n", (unsigned long long)key, len);
+    fwrite(nasm, 1, len, out);
+}
+
+static void store_pack(Context* ctx, Cache* cache, bool complete) {
+    char path[PATH_MAX], tmp[PATH_MAX];
+    if (!pack_path(ctx, path)
+        || snprintf(tmp, PATH_MAX, "%s/.tmpXXXXXX", ctx->cache_dir) >= PATH_MAX) {
+        return;
+    }
+    int fd = mkstemp(tmp);
+    if (fd == -1 && errno == ENOENT && !mkdir(ctx->cache_dir, 0755)) {
+        // the failed attempt may have filled the template
+        snprintf(tmp, PATH_MAX, "%s/.tmpXXXXXX", ctx->cache_dir);
+        fd = mkstemp(tmp);
+    }
+    if (fd == -1) {
+        return;
+    }
+    FILE* file = fdopen(fd, "w");
+    if (!file) {
+        close(fd);
+        unlink(tmp);
+        return;
+    }
+    for (int i = 0; i < cache->nb_buckets; i++) {
+        const CacheEntry* entry = &cache->entries[i];
+        if (entry->key && (entry->used || !complete)) {
+            write_entry(file, entry->key, cache->pack.text + entry->offset,
+                        entry->len);
+        }
+    }
+    fwrite(cache->added, 1, cache->added_len, file);
+    long written = ftell(file);
+    if (fclose(file) || rename(tmp, path)) {
+        unlink(tmp);
+        return;
+    }
+    ctx->stats.cache_written_bytes += written;
+}
+
+static void append_pack(Context* ctx, Cache* cache) {
+    char path[PATH_MAX];
+    if (!pack_path(ctx, path)) {
+        return;
+    }
+    FILE* file = fopen(path, "a");
+    if (!file && errno == ENOENT && !mkdir(ctx->cache_dir, 0755)) {
+        file = fopen(path, "a");
+    }
+    if (!file) {
+        return;
+    }
+    size_t written = fwrite(cache->added, 1, cache->added_len, file);
+    if (!fclose(file)) {
+        ctx->stats.cache_written_bytes += written;
+    }
+}
+
+void close_cache(Context* ctx, bool complete) {
+    Cache* cache = ctx->cache;
+    if (!cache) {
+        return;
+    }
+    if (cache->added_out) {
+        fclose(cache->added_out);
+        // the pack is rewritten once most of it is left by the edits
+        size_t unused = 0;
+        for (int i = 0; i < cache->nb_buckets; i++) {
+            if (cache->entries[i].key && !cache->entries[i].used) {
+                unused += cache->entries[i].len;
+            }
+        }
+        if (complete && unused > cache->pack.len / 2) {
+            store_pack(ctx, cache, complete);
+        } else if (cache->added_len) {
+            append_pack(ctx, cache);
+        }
+    }
+    pthread_mutex_destroy(&cache->lock);
+    free(cache->added);
+    free(cache->entries);
+    free_source(&cache->pack);
+    free(cache);
+    ctx->cache = NULL;
+}
+
+const char* cached_function(Context* ctx, uint64_t key, size_t* len) {
+    Cache* cache = ctx->cache;
+    CacheEntry* entry = find_entry_by_key(cache, key);
+    if (!entry) {
+        return NULL;
+    }
+    // functions of a source may be generated by several threads
+    pthread_mutex_lock(&cache->lock);
+    entry->used = true;
+    pthread_mutex_unlock(&cache->lock);
+    *len = entry->len;
+    ctx->stats.cache_read_bytes += entry->len;
+    return cache->pack.text + entry->offset;
+}
+
+void cache_function(Context* ctx, uint64_t key, const char* nasm, size_t len) {
+    Cache* cache = ctx->cache;
+    pthread_mutex_lock(&cache->lock);
+    write_entry(cache->added_out, key, nasm, len);
+    pthread_mutex_unlock(&cache->lock);
+}
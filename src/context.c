@@ -0,0 +1,61 @@
+#include "context.h"
+
+#include "peephole.h"
+
+void init_context(Context* ctx, const char* filename) {
+    *ctx = (Context){.filename      = filename,
+                     .source        = NULL,
+                     .error_count   = {0},
+                     .lineno        = 1,
+                     .colno         = 0,
+                     .prevcolno     = 0,
+                     .label         = 0,
+                     .jobs          = 1,
+                     .parse_error   = false,
+                     .print_tree    = false,
+                     .print_symbols = false,
+                     .print_stats   = false,
+                     .print_tokens  = false,
+                     .fast_lexer    = false,
+                     .stream_functions = false,
+                     .print_cache_stats = false,
+                     .comments      = COMMENTS_NONE,
+                     .format        = FORMAT_NASM,
+                     .codegen       = CODEGEN_WALK,
+                     .dump_ir       = false,
+                     .perf_map      = false,
+                     .status        = 0,
+                     .cache_dir     = NULL,
+                     .cache         = NULL,
+                     .arena         = NULL,
+                     .idents        = {0},
+                     .tree          = {0},
+                     .stream        = NULL,
+                     .stats         = {0},
+                     .out           = NULL,
+                     .emit          = NULL,
+                     .err           = stderr};
+}
+
+void print_stats(const Context* ctx) {
+    printf("Statistics:\n"
+           "-----------\n");
+    printf("%-20s%zu\n", "arena bytes", ctx->stats.arena_bytes);
+    printf("%-20s%zu\n", "arena chunks", ctx->stats.arena_chunks);
+    printf("%-20s%zu\n", "tree nodes", ctx->stats.tree_nodes);
+    printf("%-20s%zu\n", "tree bytes", ctx->stats.tree_bytes);
+    printf("Peephole rules:\n"
+           "---------------\n");
+    for (int i = 0; i < NB_PEEPHOLE_RULES; i++) {
+        printf("%-20s%zu\n", peephole_rule_name(i), ctx->stats.peephole_rules[i]);
+    }
+}
+
+void print_cache_stats(const Context* ctx) {
+    printf("Cache:\n"
+           "------\n");
+    printf("%-20s%zu\n", "hits", ctx->stats.cache_hits);
+    printf("%-20s%zu\n", "misses", ctx->stats.cache_misses);
+    printf("%-20s%zu\n", "bytes read", ctx->stats.cache_read_bytes);
+    printf("%-20s%zu\n", "bytes written", ctx->stats.cache_written_bytes);
+}
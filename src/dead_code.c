@@ -0,0 +1,393 @@
+#include "dead_code.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "simplify.h"
+#include "walk.h"
+
+typedef struct {                // pass removing the dead code of a function
+    const Function* fun;        // function, with its parameters and locals
+    bool* read;                 // if each parameter, then each local, is read
+    Walk effects;               // walk looking for side effects
+} DeadCode;
+
+typedef struct {                // pass following the calls from main
+    const FunctionCollection* collection;
+    bool* reached;              // if each function of the collection is reached
+    int* pending;               // functions reached, whose calls are not
+    int nb_pending;             // followed yet
+} Reach;
+
+/**
+ * @brief Check if a node is a call
+ *
+ * @param ctx compilation context
+ * @param node
+ * @return true if the node is an identifier followed by its arguments
+ */
+static bool is_call(Context* ctx, node_t node);
+
+/**
+ * @brief Get the index of a scalar parameter or local in the variables
+ *        of a function, the parameters first
+ *
+ * @param fun function
+ * @param ident name of the variable
+ * @return index of the variable
+ *         -1 if it is an array, a global or not a variable
+ */
+static int var_index(const Function* fun, ident_t ident);
+
+/**
+ * @brief Visit of the walk marking the variables read by the instructions
+ *        of a function. The variable an assignation writes is not read
+ *
+ * @param walk walk with the 'DeadCode' of the function
+ * @param frame
+ * @return 1
+ */
+static int find_reads(Walk* walk, Frame* frame);
+
+/**
+ * @brief Check if an instruction always ends with a return. Its blocs are
+ *        already pruned
+ *
+ * @param ctx compilation context
+ * @param node instruction
+ * @return true if the instructions after it are never run
+ */
+static bool ends(Context* ctx, node_t node);
+
+/**
+ * @brief Remove the empty instructions of a bloc, and those after an
+ *        instruction ending with a return. The instructions of a nested
+ *        bloc, such as the branch taken by an `if` on a constant, take its
+ *        place
+ *
+ * @param ctx compilation context
+ * @param bloc node with the 'SuiteInstr' label
+ */
+static void prune_bloc(Context* ctx, node_t bloc);
+
+/**
+ * @brief Remove an assignation of a variable which is never read. If its
+ *        value is a call, the call is kept as an instruction
+ *
+ * @param dead
+ * @param node node with the 'Assignation' label
+ */
+static void remove_dead_store(DeadCode* dead, node_t node);
+
+/**
+ * @brief Visit of the walk removing the dead code of the instructions,
+ *        each one after those it holds
+ *
+ * @param walk walk with the 'DeadCode' of the function
+ * @param frame
+ * @return 1
+ */
+static int remove_dead_code(Walk* walk, Frame* frame);
+
+/**
+ * @brief Visit of the walk marking the functions called by a function
+ *
+ * @param walk walk with the 'Reach' of the program
+ * @param frame
+ * @return 1
+ */
+static int find_calls(Walk* walk, Frame* frame);
+
+/**
+ * @brief Remove the functions which are not reached by calls from main,
+ *        and mark as used the reached ones
+ *
+ * @param ctx compilation context
+ * @param collection functions of the program
+ * @param functions node with the 'DeclFoncts' label
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+static int remove_unreached(Context* ctx, FunctionCollection* collection,
+                            node_t functions);
+
+static bool is_call(Context* ctx, node_t node) {
+    node_t first = FIRSTCHILD(ctx, node);
+    return NODE_LABEL(ctx, node) == Ident && first
+           && (NODE_LABEL(ctx, first) == ListExp
+               || NODE_LABEL(ctx, first) == NoParametres);
+}
+
+static int var_index(const Function* fun, ident_t ident) {
+    const Entry* entry = get_entry(&fun->parameters, ident);
+    if (entry) {
+        return is_array(entry->type) ? -1: entry - fun->parameters.array;
+    }
+    entry = get_entry(&fun->locals, ident);
+    if (entry) {
+        return is_array(entry->type)
+               ? -1: fun->parameters.cur_len + (entry - fun->locals.array);
+    }
+    return -1;
+}
+
+static int find_reads(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    DeadCode* dead = walk->pass;
+    node_t node = frame->node;
+    if (NODE_LABEL(ctx, node) == Assignation) {
+        // only the index of the variable and the value are read
+        if (frame->step == 0) {
+            visit_list(walk, FIRSTCHILD(ctx, FIRSTCHILD(ctx, node)));
+        } else if (frame->step == 1) {
+            visit_node(walk, SECONDCHILD(ctx, node));
+        }
+        return 1;
+    }
+    if (frame->step == 0) {
+        if (NODE_LABEL(ctx, node) == Ident && !is_call(ctx, node)) {
+            int var = var_index(dead->fun, NODE_VAL(ctx, node).ident);
+            if (var != -1) {
+                dead->read[var] = true;
+            }
+        }
+        visit_list(walk, FIRSTCHILD(ctx, node));
+    }
+    return 1;
+}
+
+static bool ends(Context* ctx, node_t node) {
+    while (true) {
+        switch (NODE_LABEL(ctx, node)) {
+            case Return:
+                return true;
+            case SuiteInstr:
+                if (!FIRSTCHILD(ctx, node)) {
+                    return false;
+                }
+                // the last instruction of a pruned bloc is cached
+                node = ctx->tree.last_siblings[FIRSTCHILD(ctx, node)];
+                break;
+            case If:
+                // both branches must end
+                if (NODE_LABEL(ctx, THIRDCHILD(ctx, node)) != Else
+                    || !ends(ctx, SECONDCHILD(ctx, node))) {
+                    return false;
+                }
+                node = FIRSTCHILD(ctx, THIRDCHILD(ctx, node));
+                break;
+            default:
+                return false;
+        }
+    }
+}
+
+static void prune_bloc(Context* ctx, node_t bloc) {
+    node_t first = NO_NODE;
+    node_t last = NO_NODE;
+    node_t next;
+    for (node_t node = FIRSTCHILD(ctx, bloc); node; node = next) {
+        next = NEXTSIBLING(ctx, node);
+        if (NODE_LABEL(ctx, node) == SuiteInstr && FIRSTCHILD(ctx, node)) {
+            // already pruned, so it holds no bloc itself
+            node_t tail = FIRSTCHILD(ctx, node);
+            while (NEXTSIBLING(ctx, tail)) {
+                tail = NEXTSIBLING(ctx, tail);
+            }
+            NEXTSIBLING(ctx, tail) = next;
+            next = FIRSTCHILD(ctx, node);
+            continue;
+        }
+        if (NODE_LABEL(ctx, node) == EmptyInstr || NODE_LABEL(ctx, node) == SuiteInstr) {
+            continue;
+        }
+        if (last) {
+            NEXTSIBLING(ctx, last) = node;
+        } else {
+            first = node;
+        }
+        last = node;
+        if (ends(ctx, node)) {
+            break;
+        }
+    }
+    if (last) {
+        NEXTSIBLING(ctx, last) = NO_NODE;
+        ctx->tree.last_siblings[first] = last;
+    }
+    FIRSTCHILD(ctx, bloc) = first;
+}
+
+static void remove_dead_store(DeadCode* dead, node_t node) {
+    Context* ctx = dead->effects.ctx;
+    node_t lvalue = FIRSTCHILD(ctx, node);
+    node_t value = SECONDCHILD(ctx, node);
+    int var = var_index(dead->fun, NODE_VAL(ctx, lvalue).ident);
+    if (var == -1 || dead->read[var]) {
+        return;
+    }
+    if (!has_side_effect(&dead->effects, value)) {
+        NODE_LABEL(ctx, node) = EmptyInstr;
+        FIRSTCHILD(ctx, node) = NO_NODE;
+    } else if (is_call(ctx, value)) {
+        replaceNode(ctx, node, value);
+    }
+}
+
+static int remove_dead_code(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    DeadCode* dead = walk->pass;
+    node_t node = frame->node;
+    node_t cond = FIRSTCHILD(ctx, node);
+    switch (NODE_LABEL(ctx, node)) {
+        case SuiteInstr:
+            if (frame->step == 0) {
+                visit_list(walk, FIRSTCHILD(ctx, node));
+            } else {
+                prune_bloc(ctx, node);
+            }
+            break;
+        case Else:
+            if (frame->step == 0) {
+                visit_node(walk, FIRSTCHILD(ctx, node));
+            }
+            break;
+        case If:
+            if (frame->step == 0) {
+                // the instruction, then the else
+                visit_list(walk, SECONDCHILD(ctx, node));
+            } else if (NODE_LABEL(ctx, cond) == Num) {
+                node_t taken = NODE_VAL(ctx, cond).num ? SECONDCHILD(ctx, node)
+                                                       : THIRDCHILD(ctx, node);
+                if (NODE_LABEL(ctx, taken) == Else) {
+                    taken = FIRSTCHILD(ctx, taken);
+                }
+                replaceNode(ctx, node, taken);
+            }
+            break;
+        case While:
+            if (frame->step == 0) {
+                visit_node(walk, SECONDCHILD(ctx, node));
+            } else if (NODE_LABEL(ctx, cond) == Num && !NODE_VAL(ctx, cond).num) {
+                NODE_LABEL(ctx, node) = EmptyInstr;
+                FIRSTCHILD(ctx, node) = NO_NODE;
+            }
+            break;
+        case Assignation: remove_dead_store(dead, node); break;
+        default: break;
+    }
+    return 1;
+}
+
+static int find_calls(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    Reach* reach = walk->pass;
+    node_t node = frame->node;
+    if (frame->step == 0) {
+        if (is_call(ctx, node)) {
+            int index = is_in_collection(reach->collection, NODE_VAL(ctx, node).ident);
+            if (index != -1 && !reach->reached[index]) {
+                reach->reached[index] = true;
+                reach->pending[reach->nb_pending++] = index;
+            }
+        }
+        visit_list(walk, FIRSTCHILD(ctx, node));
+    }
+    return 1;
+}
+
+static int remove_unreached(Context* ctx, FunctionCollection* collection,
+                            node_t functions) {
+    int nb_functions = collection->cur_len;
+    Reach reach = {.collection = collection,
+                   .reached = calloc(nb_functions, sizeof(bool)),
+                   .pending = malloc(nb_functions * sizeof(int))};
+    node_t* nodes = calloc(nb_functions, sizeof(node_t));
+    if (!reach.reached || !reach.pending || !nodes) {
+        free(reach.reached);
+        free(reach.pending);
+        free(nodes);
+        return 0;
+    }
+    for (node_t node = FIRSTCHILD(ctx, functions); node; node = NEXTSIBLING(ctx, node)) {
+        node_t name = SECONDCHILD(ctx, FIRSTCHILD(ctx, node));
+        nodes[is_in_collection(collection, NODE_VAL(ctx, name).ident)] = node;
+    }
+
+    // follow the calls of each function reached, from main
+    Walk walk;
+    init_walk(&walk, ctx, find_calls, &reach);
+    int start = is_in_collection(collection, intern(ctx, "main", 4));
+    reach.reached[start] = true;
+    reach.pending[reach.nb_pending++] = start;
+    while (reach.nb_pending) {
+        node_t node = nodes[reach.pending[--reach.nb_pending]];
+        if (node) { // builtins have no node
+            walk_tree(&walk, SECONDCHILD(ctx, node));
+        }
+    }
+    free_walk(&walk);
+
+    // unlink the other ones from the functions of the program
+    node_t first = NO_NODE;
+    node_t last = NO_NODE;
+    for (node_t node = FIRSTCHILD(ctx, functions); node; node = NEXTSIBLING(ctx, node)) {
+        node_t name = SECONDCHILD(ctx, FIRSTCHILD(ctx, node));
+        if (!reach.reached[is_in_collection(collection, NODE_VAL(ctx, name).ident)]) {
+            continue;
+        }
+        if (last) {
+            NEXTSIBLING(ctx, last) = node;
+        } else {
+            first = node;
+        }
+        last = node;
+    }
+    NEXTSIBLING(ctx, last) = NO_NODE;
+    ctx->tree.last_siblings[first] = last;
+    FIRSTCHILD(ctx, functions) = first;
+
+    // only the builtins reached are written
+    for (int i = 0; i < nb_functions; i++) {
+        collection->funcs[i].is_used = reach.reached[i];
+    }
+    free(reach.reached);
+    free(reach.pending);
+    free(nodes);
+    return 1;
+}
+
+int eliminate_dead_code(Context* ctx, const Function* fun, node_t node) {
+    int nb_vars = fun->parameters.cur_len + fun->locals.cur_len;
+    DeadCode dead = {.fun = fun, .read = calloc(nb_vars ? nb_vars: 1, sizeof(bool))};
+    if (!dead.read) {
+        return 0;
+    }
+    // the instructions of the function, after its header and its locals
+    node_t bloc = SECONDCHILD(ctx, SECONDCHILD(ctx, node));
+    Walk walk;
+    init_walk(&walk, ctx, find_reads, &dead);
+    walk_tree(&walk, bloc);
+    free_walk(&walk);
+
+    init_effects(&dead.effects, ctx);
+    init_walk(&walk, ctx, remove_dead_code, &dead);
+    walk_tree(&walk, bloc);
+    free_walk(&walk);
+    free_walk(&dead.effects);
+    free(dead.read);
+    return 1;
+}
+
+int eliminate_dead_tree(Context* ctx, FunctionCollection* collection,
+                        node_t tree) {
+    node_t functions = SECONDCHILD(ctx, tree);
+    for (node_t node = FIRSTCHILD(ctx, functions); node; node = NEXTSIBLING(ctx, node)) {
+        node_t name = SECONDCHILD(ctx, FIRSTCHILD(ctx, node));
+        const Function* fun = get_function(collection, NODE_VAL(ctx, name).ident);
+        if (!eliminate_dead_code(ctx, fun, node)) {
+            return 0;
+        }
+    }
+    return remove_unreached(ctx, collection, functions);
+}
@@ -0,0 +1,94 @@
+#include "emit.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+void open_emitter(Context* ctx, EmitBuffer* buffer) {
+    buffer->len = 0;
+    ctx->emit = buffer;
+}
+
+void flush_emitter(Context* ctx) {
+    if (ctx->emit && ctx->emit->len) {
+        fwrite(ctx->emit->data, 1, ctx->emit->len, ctx->out);
+        ctx->emit->len = 0;
+    }
+}
+
+void close_emitter(Context* ctx) {
+    flush_emitter(ctx);
+    ctx->emit = NULL;
+}
+
+void emit(Context* ctx, const char* text) {
+    emit_bytes(ctx, text, strlen(text));
+}
+
+void emit_unbuffered(Context* ctx, const char* data, size_t len) {
+    flush_emitter(ctx);
+    if (ctx->emit && len <= EMIT_BUFFER_SIZE) {
+        memcpy(ctx->emit->data, data, len);
+        ctx->emit->len = len;
+        return;
+    }
+    // nasm larger than the buffer, as cached functions, is not copied
+    fwrite(data, 1, len, ctx->out);
+}
+
+void emit_int(Context* ctx, long value) {
+    char digits[24];
+    char* cur = digits + sizeof(digits);
+    unsigned long abs = value < 0 ? -(unsigned long)value: (unsigned long)value;
+    // digits are written from the last one
+    do {
+        *--cur = '0' + abs % 10;
+        abs /= 10;
+    } while (abs);
+    if (value < 0) {
+        *--cur = '-';
+    }
+    emit_bytes(ctx, cur, digits + sizeof(digits) - cur);
+}
+
+void emit_label(Context* ctx, const char* fun, int label) {
+    emit_bytes(ctx, ".L", 2);
+    emit(ctx, fun);
+    emit_bytes(ctx, "_", 1);
+    emit_int(ctx, label);
+}
+
+void emit_comment(Context* ctx, CommentLevel level, const char* format, ...) {
+    if (ctx->comments < level) {
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    emit_bytes(ctx, "\n\t; ", 4);
+    const char* cur = format;
+    const char* hole;
+    while ((hole = strchr(cur, '%')) && hole[1]) {
+        emit_bytes(ctx, cur, hole - cur);
+        switch (hole[1]) {
+            case 's': emit(ctx, va_arg(args, const char*)); break;
+            case 'd': emit_int(ctx, va_arg(args, int)); break;
+            case 'c': {
+                char c = va_arg(args, int);
+                emit_bytes(ctx, &c, 1);
+                break;
+            }
+            default: emit_bytes(ctx, hole + 1, 1); // as in '%%'
+        }
+        cur = hole + 2;
+    }
+    emit(ctx, cur);
+    emit_bytes(ctx, "\n", 1);
+    va_end(args);
+}
+
+void emit_note(Context* ctx, const char* text) {
+    if (ctx->comments == COMMENTS_FULL) {
+        emit_bytes(ctx, "\t; ", 3);
+        emit(ctx, text);
+    }
+}
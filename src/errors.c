@@ -6,9 +6,6 @@
 
 #include "types.h"
 
-bool init = false;
-char filename[64];
-
 static char* types[] = {
     [WARNING] = PURPLE "warning" RESET,
     [NOTE]    = CYAN "note" RESET,
@@ -16,12 +13,6 @@ static char* types[] = {
     NULL
 };
 
-static int error_count[] = {
-    [WARNING] = 0,
-    [NOTE]    = 0,
-    [ERROR]   = 0
-};
-
 static const char* type_convert[] = {
     [T_NONE]           = "none",
     [T_CHAR]           = "char",
@@ -33,31 +24,26 @@ static const char* type_convert[] = {
     [T_FUNCTION]       = "function",
 };
 
-void init_error(const char* source) {
-    init = true;
-    strcpy(filename, source);
-}
-
-static void print_error(Error *error) {
+static void print_error(Context* ctx, Error *error) {
     if (error->has_line) {
-        fprintf(stderr, "%s:%d:%d %s: %s\n",
-                init ? filename: "", error->line, error->col, 
+        fprintf(ctx->err, "%s:%d:%d %s: %s\n",
+                ctx->filename ? ctx->filename: "", error->line, error->col, 
                 types[error->type], error->message);
     } else {
-        fprintf(stderr, "%s: %s: %s\n",
-                init ? filename: "", types[error->type], error->message);
+        fprintf(ctx->err, "%s: %s: %s\n",
+                ctx->filename ? ctx->filename: "", types[error->type], error->message);
     }
-    error_count[error->type]++;
+    ctx->error_count[error->type]++;
 }
 
-void memory_error(void) {
+void memory_error(Context* ctx) {
     Error error = (Error){.type = ERROR,
                           .has_line = false,
                           .message = "error while allocating memory"};
-    print_error(&error);
+    print_error(ctx, &error);
 }
 
-void already_declared_error(const char* symbol, int line, int col,
+void already_declared_error(Context* ctx, const char* symbol, int line, int col,
                             int last_line) {
     Error err = (Error){.type = ERROR,
                         .line = line,
@@ -68,11 +54,12 @@ void already_declared_error(const char* symbol, int line, int col,
              "symbol '%s' already declared at line %d",
              symbol, last_line);
     
-    print_error(&err);
+    print_error(ctx, &err);
 }
 
-void wrong_rtype_error(ErrorType type, const char* symbol, t_type current_type,
-                       t_type expected_type, int line, int col) {
+void wrong_rtype_error(Context* ctx, ErrorType type, const char* symbol,
+                       t_type current_type, t_type expected_type, int line,
+                       int col) {
     Error err = (Error){.type = type,
                         .line = line,
                         .col  = col,
@@ -81,11 +68,11 @@ void wrong_rtype_error(ErrorType type, const char* symbol, t_type current_type,
              "'%s' return type must be '%s' instead of '%s'",
              symbol, type_convert[expected_type], type_convert[current_type]);
     
-    print_error(&err);
+    print_error(ctx, &err);
 }
 
-void use_of_undeclare_symbol(ErrorType type, const char* symbol, int line,
-                             int col) {
+void use_of_undeclare_symbol(Context* ctx, ErrorType type, const char* symbol,
+                             int line, int col) {
     Error err = (Error){.type = type,
                         .line = line,
                         .col = col,
@@ -93,10 +80,10 @@ void use_of_undeclare_symbol(ErrorType type, const char* symbol, int line,
                         };
     snprintf(err.message, ERROR_LEN,
              "uses of undeclared symbol: '%s'", symbol);
-    print_error(&err);
+    print_error(ctx, &err);
 }
 
-void unused_symbol(const char* symbol, int line, int col) {
+void unused_symbol(Context* ctx, const char* symbol, int line, int col) {
     Error err = (Error){.type = NOTE,
                         .line = line,
                         .col = col,
@@ -104,11 +91,11 @@ void unused_symbol(const char* symbol, int line, int col) {
                         };
     snprintf(err.message, ERROR_LEN,
              "unused symbol: '%s'", symbol);
-    print_error(&err);
+    print_error(ctx, &err);
 }
 
-void unused_symbol_in_function(const char* function, const char* symbol,
-                               int line, int col) {
+void unused_symbol_in_function(Context* ctx, const char* function,
+                               const char* symbol, int line, int col) {
     Error err = (Error){.type = NOTE,
                         .line = line,
                         .col = col,
@@ -117,11 +104,12 @@ void unused_symbol_in_function(const char* function, const char* symbol,
     snprintf(err.message, ERROR_LEN,
              "unused symbol: '%s' in function '%s'",
              symbol, function);
-    print_error(&err);
+    print_error(ctx, &err);
 }
 
-void assignation_error(ErrorType type, const char* symbol, t_type dest_type,
-                       t_type source_type, int line, int col) {
+void assignation_error(Context* ctx, ErrorType type, const char* symbol,
+                       t_type dest_type, t_type source_type, int line,
+                       int col) {
     Error err = (Error){.type = type,
                         .line = line,
                         .col = col,
@@ -130,11 +118,11 @@ void assignation_error(ErrorType type, const char* symbol, t_type dest_type,
     snprintf(err.message, ERROR_LEN,
              "trying to assign to '%s' of type '%s' a value of type '%s'",
              symbol, type_convert[dest_type], type_convert[source_type]);
-    print_error(&err);
+    print_error(ctx, &err);
 }
 
-void redefinition_of_builtin_functions(const char* function, int line,
-                                       int col) {
+void redefinition_of_builtin_functions(Context* ctx, const char* function,
+                                       int line, int col) {
     Error err = (Error){.type = ERROR,
                         .line = line,
                         .col = col,
@@ -142,11 +130,11 @@ void redefinition_of_builtin_functions(const char* function, int line,
                         };
     snprintf(err.message, ERROR_LEN,
              "trying to redefine builtin function '%s'", function);
-    print_error(&err);
+    print_error(ctx, &err);
 }
 
-void incorrect_array_access(const char* name, t_type access_type, int line,
-                            int col) {
+void incorrect_array_access(Context* ctx, const char* name, t_type access_type,
+                            int line, int col) {
     Error err = (Error){.type = ERROR,
                         .line = line,
                         .col = col,
@@ -155,11 +143,11 @@ void incorrect_array_access(const char* name, t_type access_type, int line,
     snprintf(err.message, ERROR_LEN,
              "trying to access array '%s' with an expression of type '%s'",
              name, type_convert[access_type]);
-    print_error(&err);
+    print_error(ctx, &err);
 }
 
-void invalid_operation(const char* operation, t_type type, int line,
-                       int col) {
+void invalid_operation(Context* ctx, const char* operation, t_type type,
+                       int line, int col) {
     Error err = (Error){.type = ERROR,
                         .line = line,
                         .col = col,
@@ -168,10 +156,10 @@ void invalid_operation(const char* operation, t_type type, int line,
     snprintf(err.message, ERROR_LEN,
              "invalid operation '%s' on type '%s'",
              operation, type_convert[type]);
-    print_error(&err);
+    print_error(ctx, &err);
 }
 
-void invalid_condition(t_type type, int line, int col) {
+void invalid_condition(Context* ctx, t_type type, int line, int col) {
     Error err = (Error){.type = ERROR,
                         .line = line,
                         .col = col,
@@ -180,10 +168,11 @@ void invalid_condition(t_type type, int line, int col) {
     snprintf(err.message, ERROR_LEN,
              "invalid type for condition: expected 'int', got '%s'",
              type_convert[type]);
-    print_error(&err);
+    print_error(ctx, &err);
 }
 
-void incorrect_function_call(const char* function, int line, int col) {
+void incorrect_function_call(Context* ctx, const char* function, int line,
+                             int col) {
     Error err = (Error){.type = ERROR,
                         .line = line,
                         .col = col,
@@ -191,10 +180,10 @@ void incorrect_function_call(const char* function, int line, int col) {
                         };
     snprintf(err.message, ERROR_LEN,
              "incorrect function '%s' call", function);
-    print_error(&err);
+    print_error(ctx, &err);
 }
 
-void invalid_parameter_type(ErrorType type, const char* function,
+void invalid_parameter_type(Context* ctx, ErrorType type, const char* function,
                             const char* param_name, t_type expected,
                             t_type current, int line, int col) {
     Error err = (Error){.type = type,
@@ -206,10 +195,10 @@ void invalid_parameter_type(ErrorType type, const char* function,
              "incorrect parameter '%s' type while trying to call '%s': "
              "expected type '%s', got '%s'",
              param_name, function, type_convert[expected], type_convert[current]);
-    print_error(&err);
+    print_error(ctx, &err);
 }
 
-void incorrect_symbol_use(const char* symbol, t_type sym_type,
+void incorrect_symbol_use(Context* ctx, const char* symbol, t_type sym_type,
                           t_type expected_type, int line, int col) {
     Error err = (Error){.type = ERROR,
                         .line = line,
@@ -219,42 +208,66 @@ void incorrect_symbol_use(const char* symbol, t_type sym_type,
     snprintf(err.message, ERROR_LEN,
              "entry %s of type %s is not typed %s",
              symbol, type_convert[sym_type], type_convert[expected_type]);
-    print_error(&err);
+    print_error(ctx, &err);
 }
 
-void incorrect_array_decl(const char* symbol, int line, int col) {
+void incorrect_array_decl(Context* ctx, const char* symbol, int line, int col) {
     Error err = (Error){.type = ERROR,
                         .line = line,
                         .col = col,
                         .has_line = true
                         };
     snprintf(err.message, ERROR_LEN, "array '%s' size cannot be 0", symbol);
-    print_error(&err);
+    print_error(ctx, &err);
+}
+
+void division_by_zero(Context* ctx, const char* operation, int line, int col) {
+    Error err = (Error){.type = WARNING,
+                        .line = line,
+                        .col = col,
+                        .has_line = true
+                        };
+    snprintf(err.message, ERROR_LEN,
+             "%s by zero in operation '%s', which traps when run",
+             operation[0] == '/' ? "division": "modulo", operation);
+    print_error(ctx, &err);
+}
+
+void assembly_error(Context* ctx, int line, const char* message) {
+    Error err = (Error){.type = ERROR, .has_line = false};
+    if (line) {
+        snprintf(err.message, ERROR_LEN, "cannot assemble line %d of the nasm, %s",
+                 line, message);
+    } else {
+        snprintf(err.message, ERROR_LEN, "cannot assemble the nasm, %s", message);
+    }
+    print_error(ctx, &err);
 }
 
-void error(ErrorType type, const char* message) {
+void error(Context* ctx, ErrorType type, const char* message) {
     Error err = (Error){.type = type, .has_line = false};
     strcpy(err.message, message);
-    print_error(&err);
+    print_error(ctx, &err);
 }
 
-void line_error(ErrorType type, const char* message, int line, int col) {
+void line_error(Context* ctx, ErrorType type, const char* message, int line,
+                int col) {
     Error err = (Error){.type = type,
                         .line = line,
                         .col = col,
                         .has_line = true};
     strcpy(err.message, message);
-    print_error(&err);
+    print_error(ctx, &err);
 }
 
-bool fatal_error(void) {
-    return error_count[ERROR];
+bool fatal_error(Context* ctx) {
+    return ctx->error_count[ERROR];
 }
 
-void print_rapport(void) {
+void print_rapport(Context* ctx) {
     printf("Execution rapport:\n"
            "------------------\n");
     for (int i = 0; types[i]; i++) {
-        printf("%-20s%d\n", types[i], error_count[i]);
+        printf("%-20s%d\n", types[i], ctx->error_count[i]);
     }
 }
@@ -0,0 +1,401 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "context.h"
+#include "lexer.h"
+#include "tokens.h"
+
+#define KEYWORD_HASH(first, len) (((first) + (len)) & 31)
+
+typedef struct {                // state of a hand-written scanner
+    Context* ctx;               // context holding the cursor position
+    const char* text;           // scanned source
+    size_t len;                 // length of the source
+    size_t pos;                 // offset of the next character
+} FastScanner;
+
+typedef struct {                // keyword, at its hash in the keywords table
+    const char* name;
+    size_t len;
+    int token;
+    bool has_span;              // if the token value is its span
+} Keyword;
+
+// first character plus length give a different hash to each keyword
+static const Keyword keywords[32] = {
+    [KEYWORD_HASH('i', 2)] = {"if",     2, IF,     false},
+    [KEYWORD_HASH('e', 4)] = {"else",   4, ELSE,   false},
+    [KEYWORD_HASH('w', 5)] = {"while",  5, WHILE,  false},
+    [KEYWORD_HASH('r', 6)] = {"return", 6, RETURN, false},
+    [KEYWORD_HASH('i', 3)] = {"int",    3, TYPE,   true},
+    [KEYWORD_HASH('c', 4)] = {"char",   4, TYPE,   true},
+    [KEYWORD_HASH('v', 4)] = {"void",   4, VOID,   true}
+};
+
+#if defined(__AVX2__)
+#define BLOCK 32                // bytes compared at once
+typedef __m256i Block;
+#define load_block(p) _mm256_loadu_si256((const __m256i*)(p))
+#define mask_eq(b, c) (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(b, _mm256_set1_epi8(c)))
+#define mask_range(b, lo, hi) (uint32_t)_mm256_movemask_epi8(_mm256_and_si256( \
+            _mm256_cmpgt_epi8(b, _mm256_set1_epi8((lo) - 1)),                 \
+            _mm256_cmpgt_epi8(_mm256_set1_epi8((hi) + 1), b)))
+#define lower_block(b) _mm256_or_si256(b, _mm256_set1_epi8(0x20))
+#define FULL_MASK 0xffffffffu
+#elif defined(__SSE2__)
+#define BLOCK 16
+typedef __m128i Block;
+#define load_block(p) _mm_loadu_si128((const __m128i*)(p))
+#define mask_eq(b, c) (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(b, _mm_set1_epi8(c)))
+#define mask_range(b, lo, hi) (uint32_t)_mm_movemask_epi8(_mm_and_si128( \
+            _mm_cmpgt_epi8(b, _mm_set1_epi8((lo) - 1)),                  \
+            _mm_cmpgt_epi8(_mm_set1_epi8((hi) + 1), b)))
+#define lower_block(b) _mm_or_si128(b, _mm_set1_epi8(0x20))
+#define FULL_MASK 0xffffu
+#endif
+
+/**
+ * @brief Tell if a character is a separator, as the flex lexer defines it
+ */
+static bool is_blank(char c);
+
+/**
+ * @brief Tell if a character can be part of an identifier
+ */
+static bool is_ident_char(char c);
+
+/**
+ * @brief Count the newlines of a part of the source
+ *
+ * @param text source
+ * @param start offset of the first character
+ * @param end offset after the last character
+ * @param last set to the offset of the last newline, if any
+ * @return number of newlines
+ */
+static size_t count_lines(const char* text, size_t start, size_t end, size_t* last);
+
+/**
+ * @brief Find the first occurence of a character
+ *
+ * @param text source
+ * @param start offset where the search starts
+ * @param len length of the source
+ * @param c searched character
+ * @return offset of the character, or len if not found
+ */
+static size_t find_char(const char* text, size_t start, size_t len, char c);
+
+/**
+ * @brief Find the end of a multi-line comment
+ *
+ * @param text source
+ * @param start offset where the search starts
+ * @param len length of the source
+ * @return offset of the closing "*" "/", or len if the comment is not closed
+ */
+static size_t find_comment_end(const char* text, size_t start, size_t len);
+
+/**
+ * @brief Find the end of an identifier, or of a keyword
+ *
+ * @param text source
+ * @param start offset of its second character
+ * @param len length of the source
+ * @return offset of the first character after it
+ */
+static size_t find_ident_end(const char* text, size_t start, size_t len);
+
+/**
+ * @brief Skip the separators at the position of a scanner, and move the
+ *        cursor as the flex lexer does one separator at a time
+ *
+ * @param s scanner
+ */
+static void skip_blanks(FastScanner* s);
+
+/**
+ * @brief Skip a multi-line comment at the position of a scanner, and move
+ *        the cursor as the flex lexer does one character at a time
+ *
+ * @param s scanner
+ */
+static void skip_comment(FastScanner* s);
+
+/**
+ * @brief Move the cursor over a token and return it
+ *
+ * @param s scanner
+ * @param lval token value, set to the span of the token if has_span
+ * @param token token to return
+ * @param len length of the token
+ * @param has_span if the token value is its span
+ * @return token
+ */
+static int make_token(FastScanner* s, YYSTYPE* lval, int token, size_t len,
+                      bool has_span);
+
+static bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static bool is_ident_char(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+           || (c >= '0' && c <= '9') || c == '_';
+}
+
+static size_t count_lines(const char* text, size_t start, size_t end, size_t* last) {
+    size_t nb_lines = 0, p = start;
+#ifdef BLOCK
+    for (; p + BLOCK <= end; p += BLOCK) {
+        uint32_t newlines = mask_eq(load_block(text + p), '\n');
+        if (newlines) {
+            nb_lines += __builtin_popcount(newlines);
+            *last = p + 31 - __builtin_clz(newlines);
+        }
+    }
+#endif
+    for (; p < end; p++) {
+        if (text[p] == '\n') {
+            nb_lines++;
+            *last = p;
+        }
+    }
+    return nb_lines;
+}
+
+static size_t find_char(const char* text, size_t start, size_t len, char c) {
+    size_t p = start;
+#ifdef BLOCK
+    for (; p + BLOCK <= len; p += BLOCK) {
+        uint32_t found = mask_eq(load_block(text + p), c);
+        if (found) {
+            return p + __builtin_ctz(found);
+        }
+    }
+#endif
+    while (p < len && text[p] != c) {
+        p++;
+    }
+    return p;
+}
+
+static size_t find_comment_end(const char* text, size_t start, size_t len) {
+    size_t p = start;
+#ifdef BLOCK
+    // a star followed by a slash, the slashes being loaded one byte later
+    for (; p + 1 + BLOCK <= len; p += BLOCK) {
+        uint32_t found = mask_eq(load_block(text + p), '*')
+                         & mask_eq(load_block(text + p + 1), '/');
+        if (found) {
+            return p + __builtin_ctz(found);
+        }
+    }
+#endif
+    for (; p + 1 < len; p++) {
+        if (text[p] == '*' && text[p + 1] == '/') {
+            return p;
+        }
+    }
+    return len;
+}
+
+static size_t find_ident_end(const char* text, size_t start, size_t len) {
+    size_t p = start;
+#ifdef BLOCK
+    for (; p + BLOCK <= len; p += BLOCK) {
+        Block b = load_block(text + p);
+        uint32_t ident = mask_range(lower_block(b), 'a', 'z')
+                         | mask_range(b, '0', '9') | mask_eq(b, '_');
+        if (ident != FULL_MASK) {
+            return p + __builtin_ctz(~ident);
+        }
+    }
+#endif
+    while (p < len && is_ident_char(text[p])) {
+        p++;
+    }
+    return p;
+}
+
+static void skip_blanks(FastScanner* s) {
+    Context* ctx = s->ctx;
+    size_t start = s->pos, end = start;
+#ifdef BLOCK
+    for (; end + BLOCK <= s->len; end += BLOCK) {
+        Block b = load_block(s->text + end);
+        uint32_t blanks = mask_eq(b, ' ') | mask_eq(b, '\t')
+                          | mask_eq(b, '\r') | mask_eq(b, '\n');
+        if (blanks != FULL_MASK) {
+            end += __builtin_ctz(~blanks);
+            goto found;
+        }
+    }
+#endif
+    while (end < s->len && is_blank(s->text[end])) {
+        end++;
+    }
+found:
+    if (end == start) {
+        return;
+    }
+    // all separators but the last one only move the line and column
+    size_t last;
+    size_t nb_lines = count_lines(s->text, start, end - 1, &last);
+    if (nb_lines) {
+        ctx->lineno += nb_lines;
+        ctx->colno = end - 1 - last - 1;
+    } else {
+        ctx->colno += end - 1 - start;
+    }
+    ctx->prevcolno = ctx->colno;
+    if (s->text[end - 1] == '\n') {
+        ctx->colno = 0;
+        ctx->lineno++;
+    } else {
+        ctx->colno++;
+    }
+    s->pos = end;
+}
+
+static void skip_comment(FastScanner* s) {
+    Context* ctx = s->ctx;
+    size_t start = s->pos + 2;
+    ctx->prevcolno = ctx->colno;
+    ctx->colno += 2;
+
+    size_t end = find_comment_end(s->text, start, s->len);
+    // characters move both columns, newlines only reset the current one
+    size_t last;
+    size_t nb_lines = count_lines(s->text, start, end, &last);
+    ctx->prevcolno += end - start - nb_lines;
+    if (nb_lines) {
+        ctx->lineno += nb_lines;
+        ctx->colno = end - last - 1;
+    } else {
+        ctx->colno += end - start;
+    }
+    if (end == s->len) {
+        s->pos = end;
+        return;
+    }
+    ctx->prevcolno = ctx->colno;
+    ctx->colno += 2;
+    s->pos = end + 2;
+}
+
+static int make_token(FastScanner* s, YYSTYPE* lval, int token, size_t len,
+                      bool has_span) {
+    if (has_span) {
+        lval->span = (Span){.offset = s->pos, .len = len};
+    }
+    s->ctx->prevcolno = s->ctx->colno;
+    s->ctx->colno += len;
+    s->pos += len;
+    return token;
+}
+
+int fast_lex(YYSTYPE* lval, void* scanner) {
+    FastScanner* s = scanner;
+    const char* text = s->text;
+    size_t p;
+    for (;;) {
+        skip_blanks(s);
+        p = s->pos;
+        if (p >= s->len) {
+            return 0;
+        }
+        if (text[p] != '/' || p + 1 >= s->len) {
+            break;
+        }
+        if (text[p + 1] == '*') {
+            skip_comment(s);
+        } else if (text[p + 1] == '/') {
+            s->pos = find_char(text, p + 2, s->len, '\n');
+            s->ctx->prevcolno = s->ctx->colno;
+            s->ctx->colno = 0;
+        } else {
+            break;
+        }
+    }
+
+    char c = text[p];
+    char next = p + 1 < s->len ? text[p + 1]: '\0';
+    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_') {
+        size_t len = find_ident_end(text, p + 1, s->len) - p;
+        const Keyword* k = &keywords[KEYWORD_HASH((unsigned char)c, len)];
+        if (k->name && k->len == len && !memcmp(k->name, text + p, len)) {
+            return make_token(s, lval, k->token, len, k->has_span);
+        }
+        return make_token(s, lval, IDENT, len, true);
+    }
+    if (c >= '1' && c <= '9') {
+        size_t end = p + 1;
+        while (end < s->len && text[end] >= '0' && text[end] <= '9') {
+            end++;
+        }
+        // digits are followed by another character or the padding
+        lval->num = atoi(text + p);
+        return make_token(s, lval, NUM, end - p, false);
+    }
+    switch (c) {
+        case '0':
+            lval->num = 0;
+            return make_token(s, lval, NUM, 1, false);
+        case '&':
+            if (next == '&') return make_token(s, lval, AND, 2, true);
+            break;
+        case '|':
+            if (next == '|') return make_token(s, lval, OR, 2, true);
+            break;
+        case '=': case '!':
+            if (next == '=') return make_token(s, lval, EQ, 2, true);
+            break;
+        case '<': case '>':
+            return make_token(s, lval, ORDER, next == '=' ? 2: 1, true);
+        case '+': case '-':
+            return make_token(s, lval, ADDSUB, 1, true);
+        case '*': case '/': case '%':
+            return make_token(s, lval, DIVSTAR, 1, true);
+        case ';': case ',': case '(': case ')':
+        case '{': case '}': case '[': case ']':
+            return make_token(s, lval, c, 1, false);
+        case '\'':
+            if (p + 2 < s->len && next != '\\' && text[p + 2] == '\'') {
+                return make_token(s, lval, CHARACTER, 3, true);
+            }
+            if (p + 3 < s->len && next == '\\' && text[p + 3] == '\''
+                && text[p + 2] && strchr("0ntr'\\", text[p + 2])) {
+                return make_token(s, lval, CHARACTER, 4, true);
+            }
+            break;
+        default:
+            break;
+    }
+    // any other character is its own token, as a char like in flex
+    return make_token(s, lval, c, 1, false);
+}
+
+int init_fast_scanner(Context* ctx, Source* source, void** scanner) {
+    FastScanner* s = malloc(sizeof(FastScanner));
+    if (!s) {
+        return 0;
+    }
+    ctx->source = source->text;
+    *s = (FastScanner){.ctx = ctx, .text = source->text, .len = source->len,
+                       .pos = 0};
+    *scanner = s;
+    return 1;
+}
+
+void free_fast_scanner(void* scanner) {
+    free(scanner);
+}
@@ -0,0 +1,752 @@
+#include "gen_ir.h"
+
+#include <string.h>
+
+#include "emit.h"
+
+typedef struct {                // nasm of a function written from its IR
+    Context* ctx;
+    const IrFunction* ir;
+    const RegAlloc* alloc;      // location of each register
+    const char* name;           // name of the function, prefix of its labels
+    int saves;                  // offset of the registers saved for the
+                                // caller, below the parameters and locals
+    int slots;                  // offset of the slots of spilled values,
+                                // below the saved registers
+} IrGen;
+
+// registers for arguments, according to AMD64 conventions
+static const char* param_registers[] = {
+    "rdi", "rsi", "rdx", "rcx", "r8", "r9", NULL
+};
+
+// registers given to the values, by their MachineReg
+static const char* machine_registers[] = {
+    [REG_R12] = "r12", [REG_R13] = "r13", [REG_R14] = "r14",
+    [REG_R15] = "r15", [REG_RBX] = "rbx", [REG_R10] = "r10",
+    [REG_R11] = "r11"
+};
+
+static const char* instr_names[] = {
+    [IR_ADD] = "\tadd \t",        [IR_SUB] = "\tsub \t",
+    [IR_MUL] = "\timul\t",        [IR_EQ] = "\tsete\tal\n",
+    [IR_NE] = "\tsetne\tal\n",  [IR_LT] = "\tsetl\tal\n",
+    [IR_LE] = "\tsetle\tal\n",  [IR_GT] = "\tsetg\tal\n",
+    [IR_GE] = "\tsetge\tal\n",  [IR_NOT] = "\tsete\tal\n",
+    [IR_BOOL] = "\tsetne\tal\n"
+};
+
+/**
+ * @brief Give the register of the processor holding a register of the
+ *        function
+ *
+ * @param gen function written
+ * @param reg register of the function
+ * @return name of the register of the processor
+ *         NULL if the register is spilled to the frame
+ */
+static const char* machine_register(IrGen* gen, vreg_t reg);
+
+/**
+ * @brief Tell if two registers of the function are at the same location
+ *
+ * @param gen function written
+ * @param reg first register
+ * @param other second register
+ * @return true if they share their register of the processor or slot
+ */
+static bool same_location(IrGen* gen, vreg_t reg, vreg_t other);
+
+/**
+ * @brief Write the location of a register, as in `r12` or
+ *        `qword [rbp - 8]` for a spilled one
+ *
+ * @param gen function written
+ * @param reg register
+ */
+static void write_location(IrGen* gen, vreg_t reg);
+
+/**
+ * @brief Write an instruction reading a register of the function, as in
+ *        `push r12`
+ *
+ * @param gen function written
+ * @param instr instruction and its destination, as in `\tmov \trax, `
+ * @param reg source register
+ */
+static void write_from_location(IrGen* gen, const char* instr, vreg_t reg);
+
+/**
+ * @brief Write the move of a register of the function to a register of the
+ *        processor, unless it is already there
+ *
+ * @param gen function written
+ * @param target register of the processor
+ * @param reg source register
+ */
+static void write_load(IrGen* gen, const char* target, vreg_t reg);
+
+/**
+ * @brief Write the move of a register of the processor to the location of
+ *        a register of the function
+ *
+ * @param gen function written
+ * @param reg destination register
+ * @param source register of the processor
+ */
+static void write_to_location(IrGen* gen, vreg_t reg, const char* source);
+
+/**
+ * @brief Write the copy of a register of the function to another one,
+ *        through rax if both are spilled
+ *
+ * @param gen function written
+ * @param dst destination register
+ * @param src source register
+ */
+static void write_copy(IrGen* gen, vreg_t dst, vreg_t src);
+
+/**
+ * @brief Write the test of a register of the function against 0, or
+ *        against another register
+ *
+ * @param gen function written
+ * @param a tested register
+ * @param b register compared to, NO_VREG to compare to 0
+ */
+static void write_compare(IrGen* gen, vreg_t a, vreg_t b);
+
+/**
+ * @brief Write an address relative to rbp, as in `[rbp - 8]`
+ *
+ * @param ctx compilation context
+ * @param offset offset from rbp
+ */
+static void write_frame(Context* ctx, int offset);
+
+/**
+ * @brief Write the instructions computing the address of a variable or
+ *        of an element in rcx and rdx, before its memory is accessed
+ *
+ * @param gen function written
+ * @param var variable accessed
+ * @param index register of the index of the element, NO_VREG for a scalar
+ */
+static void write_address(IrGen* gen, const IrVar* var, vreg_t index);
+
+/**
+ * @brief Write the memory of a variable or of an element, as in
+ *        `qword [globals + rcx*8 + 16]`, once its address is computed
+ *
+ * @param gen function written
+ * @param var variable accessed
+ * @param index register of the index of the element, NO_VREG for a scalar
+ */
+static void write_memory(IrGen* gen, const IrVar* var, vreg_t index);
+
+/**
+ * @brief Write the nasm of a function call, the first six arguments in
+ *        their registers and the other ones on the stack
+ *
+ * @param gen function written
+ * @param instr instruction of the call
+ */
+static void write_call(IrGen* gen, const IrInstr* instr);
+
+/**
+ * @brief Write the nasm of an arithmetic instruction, in the register of
+ *        its destination when it has one
+ *
+ * @param gen function written
+ * @param instr instruction to write
+ */
+static void write_arithmetic(IrGen* gen, const IrInstr* instr);
+
+/**
+ * @brief Write the nasm of an instruction other than a terminator
+ *
+ * @param gen function written
+ * @param instr instruction to write
+ */
+static void write_ir_instr(IrGen* gen, const IrInstr* instr);
+
+/**
+ * @brief Give the index of the operands of the phis of a block coming from
+ *        one of its predecessors
+ *
+ * @param ir IR of the function
+ * @param from predecessor
+ * @param to block with the phis
+ * @return index of the operands of the edge
+ */
+static int phi_operand(const IrFunction* ir, int from, int to);
+
+/**
+ * @brief Tell if the phis of a block are copied by an edge of its own,
+ *        between a branch and the block. No code is needed when each phi
+ *        is at the location of its operand
+ *
+ * @param gen function written
+ * @param from block ended by the edge
+ * @param to block jumped to
+ * @return true if the edge needs its own code
+ */
+static bool split_edge(IrGen* gen, int from, int to);
+
+/**
+ * @brief Write the copies of the values of the phis of a block, for an
+ *        edge coming from one of its predecessors. The copies are made at
+ *        once, as a phi may be at the location read by another one
+ *
+ * @param gen function written
+ * @param from predecessor
+ * @param to block with the phis
+ */
+static void write_phi_copies(IrGen* gen, int from, int to);
+
+/**
+ * @brief Write a jump to a block or to the code of an edge
+ *
+ * @param gen function written
+ * @param jump jump instruction, with the tab before its operand
+ * @param label label of the block or of the edge
+ */
+static void write_ir_jump(IrGen* gen, const char* jump, int label);
+
+/**
+ * @brief Write the moves between the registers kept for the caller and
+ *        their slots in the frame
+ *
+ * @param gen function written
+ * @param save if the registers are saved, else restored
+ */
+static void write_saves(IrGen* gen, bool save);
+
+/**
+ * @brief Write the terminator of a block, after the copies of the phis of
+ *        its successor for a jump. Jumps to the next block are not written
+ *
+ * @param gen function written
+ * @param block index of the block
+ * @param nb_split number of split edges before the block, updated
+ */
+static void write_terminator(IrGen* gen, int block, int* nb_split);
+
+/**
+ * @brief Write the declaration of a function, stack operations for its
+ *        parameters, memory for its locals and spilled values, and the
+ *        saves of the registers kept for the caller
+ *
+ * @param gen function written
+ */
+static void write_prologue(IrGen* gen);
+
+
+static const char* machine_register(IrGen* gen, vreg_t reg) {
+    int loc = gen->alloc->locs[reg];
+    return loc >= 0 && loc < NB_REGS ? machine_registers[loc]: NULL;
+}
+
+static bool same_location(IrGen* gen, vreg_t reg, vreg_t other) {
+    return reg != NO_VREG && other != NO_VREG
+           && gen->alloc->locs[reg] == gen->alloc->locs[other];
+}
+
+static void write_location(IrGen* gen, vreg_t reg) {
+    const char* name = machine_register(gen, reg);
+    if (name) {
+        emit(gen->ctx, name);
+        return;
+    }
+    EMIT(gen->ctx, "qword [rbp - ");
+    emit_int(gen->ctx, gen->slots + 8 * (gen->alloc->locs[reg] - NB_REGS + 1));
+    EMIT(gen->ctx, "]");
+}
+
+static void write_from_location(IrGen* gen, const char* instr, vreg_t reg) {
+    emit(gen->ctx, instr);
+    write_location(gen, reg);
+    EMIT(gen->ctx, "\n");
+}
+
+static void write_load(IrGen* gen, const char* target, vreg_t reg) {
+    const char* name = machine_register(gen, reg);
+    if (name && !strcmp(name, target)) {
+        return;
+    }
+    EMIT(gen->ctx, "\tmov \t");
+    emit(gen->ctx, target);
+    EMIT(gen->ctx, ", ");
+    write_location(gen, reg);
+    EMIT(gen->ctx, "\n");
+}
+
+static void write_to_location(IrGen* gen, vreg_t reg, const char* source) {
+    EMIT(gen->ctx, "\tmov \t");
+    write_location(gen, reg);
+    EMIT(gen->ctx, ", ");
+    emit(gen->ctx, source);
+    EMIT(gen->ctx, "\n");
+}
+
+static void write_copy(IrGen* gen, vreg_t dst, vreg_t src) {
+    const char* name = machine_register(gen, dst);
+    if (same_location(gen, dst, src)) {
+        return;
+    }
+    if (name) {
+        write_load(gen, name, src);
+    } else if ((name = machine_register(gen, src))) {
+        write_to_location(gen, dst, name);
+    } else {
+        write_load(gen, "rax", src);
+        write_to_location(gen, dst, "rax");
+    }
+}
+
+static void write_compare(IrGen* gen, vreg_t a, vreg_t b) {
+    Context* ctx = gen->ctx;
+    const char* name = machine_register(gen, a);
+    if (b == NO_VREG) {
+        if (name) {
+            EMIT(ctx, "\ttest\t");
+            emit(ctx, name);
+            EMIT(ctx, ", ");
+            emit(ctx, name);
+            EMIT(ctx, "\n");
+        } else {
+            EMIT(ctx, "\tcmp \t");
+            write_location(gen, a);
+            EMIT(ctx, ", 0\n");
+        }
+        return;
+    }
+    if (!name) {
+        write_load(gen, "rax", a);
+        name = "rax";
+    }
+    EMIT(ctx, "\tcmp \t");
+    emit(ctx, name);
+    EMIT(ctx, ", ");
+    write_location(gen, b);
+    EMIT(ctx, "\n");
+}
+
+static void write_frame(Context* ctx, int offset) {
+    EMIT(ctx, "[rbp ");
+    emit(ctx, offset < 0 ? "- ": "+ ");
+    emit_int(ctx, offset < 0 ? -offset: offset);
+    EMIT(ctx, "]");
+}
+
+static void write_address(IrGen* gen, const IrVar* var, vreg_t index) {
+    Context* ctx = gen->ctx;
+    if (index != NO_VREG) {
+        write_load(gen, "rcx", index);
+        // elements of locals and parameters go down from the first one
+        if (!var->global) {
+            EMIT(ctx, "\tneg \trcx\n");
+        }
+    }
+    if (var->indirect) {
+        EMIT(ctx, "\tmov \trdx, qword ");
+        write_frame(ctx, var->offset);
+        EMIT(ctx, "\n");
+    }
+}
+
+static void write_memory(IrGen* gen, const IrVar* var, vreg_t index) {
+    Context* ctx = gen->ctx;
+    EMIT(ctx, "qword [");
+    if (var->indirect) {
+        EMIT(ctx, "rdx + rcx*8]");
+        return;
+    }
+    emit(ctx, var->global ? "globals": "rbp");
+    if (index != NO_VREG) {
+        EMIT(ctx, " + rcx*8");
+    }
+    emit(ctx, var->offset < 0 ? " - ": " + ");
+    emit_int(ctx, var->offset < 0 ? -var->offset: var->offset);
+    EMIT(ctx, "]");
+}
+
+static void write_call(IrGen* gen, const IrInstr* instr) {
+    Context* ctx = gen->ctx;
+    const vreg_t* args = &gen->ir->operands[instr->first_operand];
+    emit_comment(ctx, COMMENTS_BRIEF, "call of the function");
+    for (int i = instr->nb_operands - 1; i >= 6; i--) {
+        write_from_location(gen, "\tpush\t", args[i]);
+    }
+    for (int i = 0; i < instr->nb_operands && param_registers[i]; i++) {
+        write_load(gen, param_registers[i], args[i]);
+    }
+    EMIT(ctx, "\tcall\t");
+    emit(ctx, ident_name(ctx, instr->callee));
+    EMIT(ctx, "\n");
+    if (instr->nb_operands > 6) {
+        EMIT(ctx, "\tadd \trsp, ");
+        emit_int(ctx, (instr->nb_operands - 6) * 8);
+        EMIT(ctx, "\n");
+    }
+    if (instr->dst != NO_VREG) {
+        write_to_location(gen, instr->dst, "rax");
+    }
+}
+
+static void write_arithmetic(IrGen* gen, const IrInstr* instr) {
+    Context* ctx = gen->ctx;
+    vreg_t a = instr->a;
+    vreg_t b = instr->b;
+    if (instr->op != IR_SUB && same_location(gen, instr->dst, b)) {
+        a = instr->b;
+        b = instr->a;
+    }
+    // the destination cannot be written before b is read
+    const char* target = machine_register(gen, instr->dst);
+    if (!target || (same_location(gen, instr->dst, b)
+                    && !same_location(gen, instr->dst, a))) {
+        target = "rax";
+    }
+    write_load(gen, target, a);
+    emit(ctx, instr_names[instr->op]);
+    emit(ctx, target);
+    EMIT(ctx, ", ");
+    write_location(gen, b);
+    EMIT(ctx, "\n");
+    if (!strcmp(target, "rax")) {
+        write_to_location(gen, instr->dst, "rax");
+    }
+}
+
+static void write_ir_instr(IrGen* gen, const IrInstr* instr) {
+    Context* ctx = gen->ctx;
+    const IrVar* var = instr->var >= 0 ? &gen->ir->vars[instr->var]: NULL;
+    const char* target = machine_register(gen, instr->dst);
+    if (!target) {
+        target = "rax";
+    }
+    switch (instr->op) {
+        case IR_CONST:
+            if (!machine_register(gen, instr->dst) && instr->imm != (int)instr->imm) {
+                EMIT(ctx, "\tmov \trax, ");
+                emit_int(ctx, instr->imm);
+                EMIT(ctx, "\n");
+                break;
+            }
+            EMIT(ctx, "\tmov \t");
+            write_location(gen, instr->dst);
+            EMIT(ctx, ", ");
+            emit_int(ctx, instr->imm);
+            EMIT(ctx, "\n");
+            return;
+        case IR_PARAM:
+            EMIT(ctx, "\tmov \t");
+            emit(ctx, target);
+            EMIT(ctx, ", qword ");
+            write_frame(ctx, var->offset);
+            EMIT(ctx, "\n");
+            break;
+        case IR_NEG:
+            write_load(gen, target, instr->a);
+            EMIT(ctx, "\tneg \t");
+            emit(ctx, target);
+            EMIT(ctx, "\n");
+            break;
+        case IR_ADD:
+        case IR_SUB:
+        case IR_MUL:
+            write_arithmetic(gen, instr);
+            return;
+        case IR_DIV:
+        case IR_MOD:
+            write_load(gen, "rax", instr->a);
+            EMIT(ctx, "\tcqo \n");
+            write_from_location(gen, "\tidiv\t", instr->b);
+            write_to_location(gen, instr->dst, instr->op == IR_MOD ? "rdx": "rax");
+            return;
+        case IR_EQ:
+        case IR_NE:
+        case IR_LT:
+        case IR_LE:
+        case IR_GT:
+        case IR_GE:
+        case IR_NOT:
+        case IR_BOOL:
+            write_compare(gen, instr->a, instr->b);
+            emit(ctx, instr_names[instr->op]);
+            EMIT(ctx, "\tmovzx\teax, al\n");
+            write_to_location(gen, instr->dst, "rax");
+            return;
+        case IR_LOAD:
+            write_address(gen, var, instr->a);
+            EMIT(ctx, "\tmov \t");
+            emit(ctx, target);
+            EMIT(ctx, ", ");
+            write_memory(gen, var, instr->a);
+            EMIT(ctx, "\n");
+            break;
+        case IR_STORE: {
+            const char* value = machine_register(gen, instr->a);
+            if (!value) {
+                write_load(gen, "rax", instr->a);
+                value = "rax";
+            }
+            write_address(gen, var, instr->b);
+            EMIT(ctx, "\tmov \t");
+            write_memory(gen, var, instr->b);
+            EMIT(ctx, ", ");
+            emit(ctx, value);
+            EMIT(ctx, "\n");
+            return;
+        }
+        case IR_ADDR:
+            if (var->indirect) {
+                EMIT(ctx, "\tmov \t");
+                emit(ctx, target);
+                EMIT(ctx, ", qword ");
+                write_frame(ctx, var->offset);
+            } else if (var->global) {
+                EMIT(ctx, "\tlea \t");
+                emit(ctx, target);
+                EMIT(ctx, ", [globals + ");
+                emit_int(ctx, var->offset);
+                EMIT(ctx, "]");
+            } else {
+                EMIT(ctx, "\tlea \t");
+                emit(ctx, target);
+                EMIT(ctx, ", ");
+                write_frame(ctx, var->offset);
+            }
+            EMIT(ctx, "\n");
+            break;
+        case IR_CALL:
+            write_call(gen, instr);
+            return;
+        default:
+            return;
+    }
+    if (!machine_register(gen, instr->dst)) {
+        write_to_location(gen, instr->dst, "rax");
+    }
+}
+
+static int phi_operand(const IrFunction* ir, int from, int to) {
+    const IrBlock* block = &ir->blocks[to];
+    int pred = 0;
+    while (block->preds[pred] != from) {
+        pred++;
+    }
+    return pred;
+}
+
+static bool split_edge(IrGen* gen, int from, int to) {
+    const IrFunction* ir = gen->ir;
+    const IrBlock* block = &ir->blocks[to];
+    if (ir->blocks[from].nb_succs != 2) {
+        return false;
+    }
+    int pred = phi_operand(ir, from, to);
+    for (int i = 0; i < block->nb_instrs && block->instrs[i].op == IR_PHI; i++) {
+        const IrInstr* phi = &block->instrs[i];
+        if (!same_location(gen, phi->dst, ir->operands[phi->first_operand + pred])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void write_phi_copies(IrGen* gen, int from, int to) {
+    const IrFunction* ir = gen->ir;
+    const IrBlock* block = &ir->blocks[to];
+    int pred = phi_operand(ir, from, to);
+    int nb_phis = 0;
+    int nb_copies = 0;
+    bool overlap = false;
+    for (; nb_phis < block->nb_instrs && block->instrs[nb_phis].op == IR_PHI; nb_phis++) {
+        const IrInstr* phi = &block->instrs[nb_phis];
+        if (same_location(gen, phi->dst, ir->operands[phi->first_operand + pred])) {
+            continue;
+        }
+        nb_copies++;
+        // a phi at the location read by another one is only written once
+        // all are read
+        for (int i = 0; i < block->nb_instrs && block->instrs[i].op == IR_PHI; i++) {
+            const IrInstr* other = &block->instrs[i];
+            overlap |= i != nb_phis
+                       && same_location(gen, phi->dst,
+                                        ir->operands[other->first_operand + pred]);
+        }
+    }
+    if (!nb_copies) {
+        return;
+    }
+    emit_comment(gen->ctx, COMMENTS_FULL, "values of the phis of block %d", to);
+    for (int i = 0; i < nb_phis; i++) {
+        const IrInstr* phi = &block->instrs[i];
+        vreg_t value = ir->operands[phi->first_operand + pred];
+        if (same_location(gen, phi->dst, value)) {
+            continue;
+        }
+        if (overlap) {
+            write_from_location(gen, "\tpush\t", value);
+        } else {
+            write_copy(gen, phi->dst, value);
+        }
+    }
+    for (int i = nb_phis - 1; overlap && i >= 0; i--) {
+        const IrInstr* phi = &block->instrs[i];
+        if (!same_location(gen, phi->dst, ir->operands[phi->first_operand + pred])) {
+            write_from_location(gen, "\tpop \t", phi->dst);
+        }
+    }
+}
+
+static void write_ir_jump(IrGen* gen, const char* jump, int label) {
+    emit(gen->ctx, jump);
+    emit_label(gen->ctx, gen->name, label);
+    EMIT(gen->ctx, "\n");
+}
+
+static void write_terminator(IrGen* gen, int block, int* nb_split) {
+    Context* ctx = gen->ctx;
+    const IrFunction* ir = gen->ir;
+    const IrBlock* b = &ir->blocks[block];
+    const IrInstr* instr = &b->instrs[b->nb_instrs - 1];
+    switch (instr->op) {
+        case IR_JUMP:
+            write_phi_copies(gen, block, b->succs[0]);
+            if (b->succs[0] != block + 1) {
+                write_ir_jump(gen, "\tjmp \t", b->succs[0]);
+            }
+            return;
+        case IR_BRANCH: {
+            // edges copying phis have their own label, after the blocks
+            int labels[2];
+            for (int i = 0; i < 2; i++) {
+                labels[i] = split_edge(gen, block, b->succs[i])
+                            ? ir->nb_blocks + (*nb_split)++: b->succs[i];
+            }
+            write_compare(gen, instr->a, NO_VREG);
+            if (labels[1] == block + 1) {
+                write_ir_jump(gen, "\tjne \t", labels[0]);
+            } else if (labels[0] == block + 1) {
+                write_ir_jump(gen, "\tje  \t", labels[1]);
+            } else {
+                write_ir_jump(gen, "\tjne \t", labels[0]);
+                write_ir_jump(gen, "\tjmp \t", labels[1]);
+            }
+            return;
+        }
+        default:
+            if (instr->a != NO_VREG) {
+                write_load(gen, "rax", instr->a);
+            }
+            write_saves(gen, false);
+            EMIT(ctx, "\tmov \trsp, rbp\n"
+                      "\tpop \trbp\n"
+                      "\tret\n");
+    }
+}
+
+static void write_saves(IrGen* gen, bool save) {
+    Context* ctx = gen->ctx;
+    int offset = gen->saves;
+    if (save) {
+        emit_comment(ctx, COMMENTS_FULL, "save the registers kept for the caller");
+    }
+    for (int reg = 0; reg < NB_KEPT_REGS; reg++) {
+        if (!(gen->alloc->used & 1U << reg)) {
+            continue;
+        }
+        offset += 8;
+        EMIT(ctx, "\tmov \t");
+        if (!save) {
+            emit(ctx, machine_registers[reg]);
+            EMIT(ctx, ", ");
+        }
+        EMIT(ctx, "qword ");
+        write_frame(ctx, -offset);
+        if (save) {
+            EMIT(ctx, ", ");
+            emit(ctx, machine_registers[reg]);
+        }
+        EMIT(ctx, "\n");
+    }
+}
+
+static void write_prologue(IrGen* gen) {
+    Context* ctx = gen->ctx;
+    const Function* fun = gen->ir->fun;
+    EMIT(ctx, "\n");
+    if (ctx->comments >= COMMENTS_BRIEF) {
+        EMIT(ctx, "; function ");
+        emit(ctx, gen->name);
+        EMIT(ctx, "\n");
+    }
+    emit(ctx, gen->name);
+    EMIT(ctx, ":\n"
+              "\tpush\trbp\n"
+              "\tmov \trbp, rsp\n");
+    emit_comment(ctx, COMMENTS_FULL, "push parameters on the stack");
+    for (int i = 0; i < fun->parameters.cur_len && param_registers[i]; i++) {
+        EMIT(ctx, "\tpush\t");
+        emit(ctx, param_registers[i]);
+        EMIT(ctx, "\n");
+    }
+    emit_comment(ctx, COMMENTS_FULL, "allocate memory for local variables, "
+                 "saved and spilled registers");
+    EMIT(ctx, "\tsub \trsp, ");
+    emit_int(ctx, fun->locals.total_bytes + gen->slots - gen->saves
+                  + 8 * gen->alloc->nb_slots);
+    EMIT(ctx, "\n");
+    if (gen->alloc->used & ((1U << NB_KEPT_REGS) - 1)) {
+        write_saves(gen, true);
+    }
+}
+
+void write_ir_function(Context* ctx, const IrFunction* ir,
+                       const RegAlloc* alloc) {
+    const Function* fun = ir->fun;
+    IrGen gen = {.ctx = ctx,
+                 .ir = ir,
+                 .alloc = alloc,
+                 .name = ident_name(ctx, fun->name),
+                 .saves = fun->parameters.offset + fun->locals.total_bytes};
+    gen.slots = gen.saves;
+    for (int reg = 0; reg < NB_KEPT_REGS; reg++) {
+        gen.slots += alloc->used & 1U << reg ? 8: 0;
+    }
+    write_prologue(&gen);
+
+    int nb_split = 0;
+    for (int b = 0; b < ir->nb_blocks; b++) {
+        const IrBlock* block = &ir->blocks[b];
+        if (b) {
+            EMIT(ctx, "\t");
+            emit_label(ctx, gen.name, b);
+            EMIT(ctx, ":\n");
+        }
+        emit_comment(ctx, COMMENTS_FULL, "block %d", b);
+        for (int i = 0; i < block->nb_instrs - 1; i++) {
+            write_ir_instr(&gen, &block->instrs[i]);
+        }
+        write_terminator(&gen, b, &nb_split);
+    }
+
+    // edges copying phis, numbered as they are jumped to
+    nb_split = 0;
+    for (int b = 0; b < ir->nb_blocks; b++) {
+        const IrBlock* block = &ir->blocks[b];
+        for (int i = 0; block->nb_succs == 2 && i < 2; i++) {
+            if (!split_edge(&gen, b, block->succs[i])) {
+                continue;
+            }
+            EMIT(ctx, "\t");
+            emit_label(ctx, gen.name, ir->nb_blocks + nb_split++);
+            EMIT(ctx, ":\n");
+            write_phi_copies(&gen, b, block->succs[i]);
+            write_ir_jump(&gen, "\tjmp \t", block->succs[i]);
+        }
+    }
+}
@@ -1,26 +1,62 @@
 #include "gen_nasm.h"
 
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 
+#include "builtins.h"
+#include "cache.h"
+#include "emit.h"
+#include "gen_ir.h"
+#include "ir.h"
+#include "peephole.h"
+#include "regalloc.h"
+#include "simplify.h"
+#include "walk.h"
+
 typedef struct  {
     char* symbol;
     char* instr;
+    char* inverse;          // jump taken when the comparison is false
+    char* set;              // setting al to the result of the comparison
 } comp_op;
 
-#define BUFFER_SIZE 512
-#define DEFAULT_PATH ""
-
-// nasm target
-static FILE* out;
-
-// builtin source file path 
-static const char* buitlin_fcts[] = {
-    "./builtin/getchar.asm", "./builtin/getint.asm",
-    "./builtin/putchar.asm", "./builtin/putint.asm",
-    NULL
-};
+typedef enum {              // how a node is written, in frame->data[2]
+    AS_VALUE,               // its value on top of the stack
+    JUMP_IF_FALSE,          // a jump to the label in frame->data[0] when it
+    JUMP_IF_TRUE            // is 0, or when it is not
+} Use;
+
+typedef struct {            // function written by a walk over its tree
+    const Scope* scope;     // symbols seen by the function
+    bool cached;            // if the value on top of the stack is kept in
+                            // rax instead of being pushed
+    bool jumping;           // if the next node visited is a condition,
+    int jump_label;         // jumping to this label
+    bool jump_if_true;      // when true, else when false
+    Walk effects;           // looking for side effects and array accesses
+                            // in right members of logical operators
+} TreeGen;
+
+#define TASKS_PER_JOB 8     // tasks of each thread, to balance large functions
+#define NO_LABEL -1         // logical operator evaluating both its members
+
+typedef struct {            // functions of a file generated by several threads
+    const Context* ctx;     // context of the file, copied by each thread
+    const Table* globals;   // global variables
+    const FunctionCollection* collection;
+    node_t* functions;      // head nodes of the functions, in order
+    int nb_functions;       // number of functions
+    int nb_tasks;           // number of tasks, consecutive functions each
+    atomic_int next;        // next task to generate
+    char** nasm;            // nasm of each task, NULL if not generated
+    size_t* lens;           // length of the nasm of each task
+    pthread_mutex_t lock;   // lock on stats
+    Stats stats;            // cache and peephole statistics of the threads
+} Codegen;
 
 // registers for arguments, according to AMD64 conventions
 static const char* param_registers[] = {
@@ -28,978 +64,1741 @@ static const char* param_registers[] = {
 };
 
 static const comp_op operators[] = {
-    {.symbol = "==", .instr = "je"},
-    {.symbol = "!=", .instr = "jne"},
-    {.symbol = "<",  .instr = "jl"},
-    {.symbol = "<=", .instr = "jle"},
-    {.symbol = ">",  .instr = "jg"},
-    {.symbol = ">=", .instr = "jge"},
-    {NULL,           NULL}
+    {.symbol = "==", .instr = "je",  .inverse = "jne", .set = "\tsete\tal\n"},
+    {.symbol = "!=", .instr = "jne", .inverse = "je",  .set = "\tsetne\tal\n"},
+    {.symbol = "<",  .instr = "jl",  .inverse = "jge", .set = "\tsetl\tal\n"},
+    {.symbol = "<=", .instr = "jle", .inverse = "jg",  .set = "\tsetle\tal\n"},
+    {.symbol = ">",  .instr = "jg",  .inverse = "jle", .set = "\tsetg\tal\n"},
+    {.symbol = ">=", .instr = "jge", .inverse = "jl",  .set = "\tsetge\tal\n"},
+    {NULL,           NULL,           NULL,             NULL}
 };
 
 /**
- * @brief Remove path prefix to only keep the filename
+ * @brief Write a builtin function, after the builtins it calls, unless it
+ *        is already written
  * 
- * @param path path prefix to substitute
- * @return modified path
+ * @param ctx compilation context
+ * @param index index of the builtin in `embedded_builtins`
+ * @param written builtins already written, a bit by index
  */
-static char* sub_path(char* path);
+static void write_builtin(Context* ctx, int index, unsigned* written);
 
 /**
- * @brief Create the output file
+ * @brief Write the builtin functions called by the program, with the
+ *        builtins they call. Unused builtins are not written
  * 
- * @param output filename
- * @return 1 in case of success
- *         else 0
+ * @param ctx compilation context
+ * @param coll collection of function, whose builtins are marked if used
  */
-static int create_file(char* output);
+static void write_buitlins(Context* ctx, const FunctionCollection* coll);
 
 /**
- * @brief Copy `file` content to the output
+ * @brief Write to output the nasm header
  * 
- * @param file file to copy
+ * @param ctx compilation context
+ * @param globals_size size of globals variables in bytes
  */
-static void write_builtin(FILE* file);
+static void write_init(Context* ctx, int globals_size);
 
 /**
- * @brief Copy builtin functions in the output files
+ * @brief Write syscall to exit the programm
  * 
- * @return 1 in case of success
- *         else 0
+ * @param ctx compilation context
  */
-static int write_buitlins(void);
+static void write_exit(Context* ctx);
 
 /**
- * @brief Write to output the nasm header
- *        If no buitlin functions are used, they'll not be copied in target
+ * @brief Push the value kept in rax on top of the stack, before rax is
+ *        written by the next value
  * 
- * @param coll collection of function
- * @param globals_size size of globals variables in bytes
+ * @param walk walk writing the instructions of a function
  */
-static void write_init(const FunctionCollection* coll, int globals_size);
+static void flush_top(Walk* walk);
 
 /**
- * @brief Write syscall to exit the programm
+ * @brief Pop the value on top of the stack to a register, from rax if it is
+ *        kept there
  * 
+ * @param walk walk writing the instructions of a function
+ * @param reg register receiving the value
  */
-static void write_exit(void);
+static void pop_top(Walk* walk, const char* reg);
+
+/**
+ * @brief Keep the value written in rax as the top of the stack, pushed only
+ *        when another value is written
+ * 
+ * @param walk walk writing the instructions of a function
+ */
+static void keep_top(Walk* walk);
+
+/**
+ * @brief Tell if the node visited by a walk is an instruction, whose value
+ *        is not used, rather than part of an expression
+ * 
+ * @param walk walk writing the instructions of a function
+ * @return true for an instruction
+ */
+static bool is_instruction(Walk* walk);
 
 /**
  * @brief Write nasm code instructions to handle nodes with 'AddSub' label
  *       and 'DivStar' label only if its a multiplication 
  * 
- * @param globals global's table
- * @param collection collection of functions
- * @param fun current function where the operation is computed
- * @param tree head node with the 'AddSub' or 'DivStar' label
+ * @param walk walk writing the instructions of a function
+ * @param frame frame of the node with the 'AddSub' or 'DivStar' label
  */
-static void write_add_sub_mul(const Table* globals, const FunctionCollection* collection,
-                              const Function* fun, const Node* tree);
+static void write_add_sub_mul(Walk* walk, Frame* frame);
 
 /**
  * @brief Write nasm code instructions to handle nodes with the 'DivStar' label
  *        in operations are division and modulo
  * 
- * @param globals global's table
- * @param collection collection of function
- * @param fun current function where the operation is computed
- * @param tree head node with the 'DivStar' label
+ * @param walk walk writing the instructions of a function
+ * @param frame frame of the node with the 'DivStar' label
  */
-static void write_div_mod(const Table* globals, const FunctionCollection* collection,
-                          const Function* fun, const Node* tree);
+static void write_div_mod(Walk* walk, Frame* frame);
 
 /**
  * @brief Write nasm code for arithemtic operation where nodes labels are either
  *        'AddSub' or 'DivStar'
  * 
- * @param globals global's table
- * @param collection collection of function
- * @param fun current function where the arithmetic is performed
- * @param tree head node with the 'AddSub' or 'DivStar' label
+ * @param walk walk writing the instructions of a function
+ * @param frame frame of the node with the 'AddSub' or 'DivStar' label
  */
-static void write_arithmetic(const Table* globals, const FunctionCollection* collection,
-                             const Function* fun, const Node* tree);
+static void write_arithmetic(Walk* walk, Frame* frame);
 
 /**
  * @brief Write nasm code to set rbp and rsp to their correct values when
  *        exiting a function
  * 
+ * @param ctx compilation context
  */
-static void write_function_exit(void);
+static void write_function_exit(Context* ctx);
 
 /**
  * @brief Write nasm code to handle function returns
  * 
- * @param globals global's table
- * @param collection collection of function
- * @param fun current function where the return is computed
- * @param tree head node with the 'Return' label
+ * @param walk walk writing the instructions of a function
+ * @param frame frame of the node with the 'Return' label
  */
-static void write_return(const Table* globals, const FunctionCollection* collection,
-                         const Function* fun, const Node* tree);
+static void write_return(Walk* walk, Frame* frame);
 
 /**
  * @brief Write nasm code to handle function declaration, stack operations for
  *        parameters and memory allocation for locals
  * 
+ * @param ctx compilation context
  * @param fun function to write declaration
  */
-static void write_function(Function* fun);
+static void write_function(Context* ctx, const Function* fun);
 
 /**
  * @brief Write assignation between an identifer and a value
  * 
- * @param globals global's table
- * @param collection collection of functions
- * @param fun current function where the assignation is computed
- * @param tree head node with the 'Assignation' label
+ * @param walk walk writing the instructions of a function
+ * @param frame frame of the node with the 'Assignation' label
  */
-static void write_assign(const Table* globals, const FunctionCollection* collection,
-                         const Function* fun, const Node* tree);
+static void write_assign(Walk* walk, Frame* frame);
 
 /**
- * @brief Write parameters assignation when calling a function. This function
- *        uses the AMD64 code conventions on parameters use
+ * @brief Write nasm code to handle function call. Parameters are written
+ *        first, from the last one, and moved to their registers according
+ *        to AMD64 code conventions
  * 
- * @param globals global's table
- * @param collection collection of functions
- * @param fun current function where the call is computed
- * @param tree first parameter node
+ * @param walk walk writing the instructions of a function
+ * @param frame frame of the node with the 'Ident' label, the name of the function
  */
-static void write_parameters(const Table* globals, const FunctionCollection* collection,
-                             const Function* fun, const Node* tree);
+static void write_function_call(Walk* walk, Frame* frame);
 
 /**
- * @brief Write nasm code to handle function call
+ * @brief Write the start of an instruction loading a memory in rax, or
+ *        storing the value on top of the stack in it
  * 
- * @param globals global's table
- * @param collection collection of function
- * @param fun current function where the call is computed
- * @param tree head node with the 'Ident' label, the name of the function
+ * @param walk walk writing the instructions of a function
+ * @param store if the memory is written, else read
+ */
+static void begin_memory(Walk* walk, bool store);
+
+/**
+ * @brief Write the end of an instruction accessing a memory, after the
+ *        memory. A loaded value is kept in rax
+ * 
+ * @param walk walk writing the instructions of a function
+ * @param store if the memory is written, else read
+ */
+static void end_memory(Walk* walk, bool store);
+
+/**
+ * @brief Write an instruction loading a memory in rax, or storing the value
+ *        on top of the stack in it, as in `mov rax, qword [rax]`
+ * 
+ * @param walk walk writing the instructions of a function
+ * @param store if the memory is written, else read
+ * @param memory memory accessed
+ */
+static void write_memory(Walk* walk, bool store, const char* memory);
+
+/**
+ * @brief Write an instruction accessing the memory at an offset, as in
+ *        `mov rax, qword [rbp - <offset>]`
+ * 
+ * @param walk walk writing the instructions of a function
+ * @param store if the memory is written, else read
+ * @param memory memory before the offset, as in `qword [rbp - `
+ * @param offset offset of the memory
+ */
+static void write_access(Walk* walk, bool store, const char* memory, long offset);
+
+/**
+ * @brief Write the computation of an address, ended by its offset
+ * 
+ * @param ctx compilation context
+ * @param base instructions before the offset, as in `\tsub \trax, `
+ * @param offset offset of the address
  */
-static void write_function_call(const Table* globals, const FunctionCollection* collection,
-                                const Function* fun, const Node* tree);
+static void write_address(Context* ctx, const char* base, long offset);
 
 /**
- * @brief Write nasm code to access to local variables
+ * @brief Write nasm code to access to local variables. The index of an
+ *        element is on top of the stack, and a stored value below it
  * 
+ * @param walk walk writing the instructions of a function
  * @param fun function where the user access the local
  * @param entry entry the user is accessing
- * @param instr instruction to compute (between 'push' and 'pop')
+ * @param store if the value on top of the stack is stored, else the value
+ *              of the local is loaded in rax
  * @param address if we tried to access a local address (like arrays given to a
  *                function call)
  */
-static void local_access(const Function* fun, const Entry* entry, 
-                         const char* instr, bool address);
+static void local_access(Walk* walk, const Function* fun, const Entry* entry,
+                         bool store, bool address);
 
 /**
- * @brief Write nasm code to access to parameters
+ * @brief Write nasm code to access to parameters. The index of an element
+ *        is on top of the stack, and a stored value below it
  * 
+ * @param walk walk writing the instructions of a function
  * @param fun function where the user access the parameter
  * @param entry entry the user is accessing
- * @param instr instruction to compute (between 'push' and 'pop')
+ * @param store if the value on top of the stack is stored, else the value
+ *              of the parameter is loaded in rax
  * @param address if we tried to access a parameter address (like arrays given
  *                to a function call)
  */
-static void param_access(const Function* fun, const Entry* entry,
-                         const char* instr, bool address);
+static void param_access(Walk* walk, const Function* fun, const Entry* entry,
+                         bool store, bool address);
 
 /**
- * @brief Write nasm code to access to global variables
+ * @brief Write nasm code to access to global variables. The index of an
+ *        element is on top of the stack, and a stored value below it
  * 
+ * @param walk walk writing the instructions of a function
  * @param entry entry the user is accessing
- * @param instr instruction to compute (between 'push' and 'pop')
+ * @param store if the value on top of the stack is stored, else the value
+ *              of the global is loaded in rax
  * @param address if we tried to access a global address (like arrays given to a
  *                function call)
  */
-static void global_access(const Entry* entry, const char* instr, bool address);
+static void global_access(Walk* walk, const Entry* entry, bool store,
+                          bool address);
 
 /**
- * @brief Write nasm code to get variables values on top of the stack
+ * @brief Write the start of the access to a variable: the index of an
+ *        element is popped to rcx, or the value kept in rax is pushed before
+ *        a load
  * 
- * @param globals global's table
- * @param collection collection of funtion
- * @param fun current function where the variable is used
- * @param tree head node with the 'Ident' label
+ * @param walk walk writing the instructions of a function
+ * @param entry entry the user is accessing
+ * @param store if the variable is written
+ * @param address if the address of an array is loaded
+ */
+static void start_access(Walk* walk, const Entry* entry, bool store, bool address);
+
+/**
+ * @brief Write nasm code to get variables values on top of the stack, kept
+ *        in rax
+ * 
+ * @param walk walk writing the instructions of a function
+ * @param frame frame of the node with the 'Ident' label
  */
-static void write_load_ident(const Table* globals, const FunctionCollection* collection,
-                             const Function* fun, const Node* tree);
+static void write_load_ident(Walk* walk, Frame* frame);
 
 /**
- * @brief Get the nasm instruction for the given comparaison symbol
+ * @brief Get the nasm instructions for the given comparaison symbol
  * 
  * @param symbol 
- * @return
+ * @return its jumps and its 'set' instruction
  */
-static char* get_comp_instr(const char* symbol);
+static const comp_op* get_comp_op(const char* symbol);
 
 /**
- * @brief Give a number of an unsued label
+ * @brief Give a number of an unsued label. Labels are numbered from 0 in
+ *        each function, whose name is part of their names
  * 
+ * @param ctx compilation context
  * @return
  */
-static int next_free_label(void);
+static int next_free_label(Context* ctx);
+
+/**
+ * @brief Get the name of the function written by a walk, which prefixes
+ *        its labels as in `.L<function>_<number>`
+ * 
+ * @param walk walk writing the instructions of a function
+ * @return name of the function
+ */
+static const char* label_function(Walk* walk);
+
+/**
+ * @brief Write a jump to a label of the function
+ * 
+ * @param ctx compilation context
+ * @param jump jump instruction, with the tab before its operand
+ * @param fun name of the function
+ * @param label number of the label
+ */
+static void write_jump(Context* ctx, const char* jump, const char* fun, int label);
+
+/**
+ * @brief Write the definition of a label of the function
+ * 
+ * @param ctx compilation context
+ * @param fun name of the function
+ * @param label number of the label
+ */
+static void write_label(Context* ctx, const char* fun, int label);
+
+/**
+ * @brief Write the members of a comparaison, then the `cmp` setting the
+ *        flags. A constant right member is compared directly
+ * 
+ * @param walk walk writing the instructions of a function
+ * @param frame frame of the node with either the 'Order' or the 'Eq' label
+ * @return 1 once the flags are set
+ *         0 while a member remains to be written
+ */
+static int write_cmp(Walk* walk, Frame* frame);
 
 /**
  * @brief Write nasm code to handle comparaisons
  * 
- * @param globals global's table
- * @param collection collection of function
- * @param fun function where the comparaison is computed
- * @param tree head node with either the 'Order' or the 'Eq' label
+ * @param walk walk writing the instructions of a function
+ * @param frame frame of the node with either the 'Order' or the 'Eq' label
+ */
+static void write_comp(Walk* walk, Frame* frame);
+
+/**
+ * @brief Check if a condition is written as jumps, rather than as a value
+ *        compared to 0
+ * 
+ * @param ctx compilation context
+ * @param node condition
+ * @return true for comparaisons, logical operators and numbers
+ */
+static bool is_jumping(Context* ctx, node_t node);
+
+/**
+ * @brief Visit a condition, which jumps to a label when it is true, or when
+ *        it is false, and goes on after its code otherwise
+ * 
+ * @param walk walk writing the instructions of a function
+ * @param node condition
+ * @param label label to jump to
+ * @param if_true if the jump is taken when the condition is true
  */
-static void write_comp(const Table* globals, const FunctionCollection* collection,
-                       const Function* fun, const Node* tree);
+static void visit_condition(Walk* walk, node_t node, int label, bool if_true);
+
+/**
+ * @brief End a visited condition: a condition written as a value is
+ *        tested, then jumps as `visit_condition` asked
+ * 
+ * @param walk walk writing the instructions of a function
+ * @param node condition
+ * @param label label to jump to
+ * @param if_true if the jump is taken when the condition is true
+ */
+static void end_condition(Walk* walk, node_t node, int label, bool if_true);
+
+/**
+ * @brief Write a condition as jumps, without its value. `&&` and `||` jump
+ *        over their right member as soon as the left one decides
+ * 
+ * @param walk walk writing the instructions of a function
+ * @param frame frame of the condition, with its label and its 'Use'
+ */
+static void write_jumps(Walk* walk, Frame* frame);
 
 /**
  * @brief Write the boolean transformation from a non-null variable to '1'
  *        or keep 0 if not
  * 
+ * @param walk walk writing the instructions of a function
+ */
+static void write_bool_transform(Walk* walk);
+
+/**
+ * @brief Check if an expression is always 0 or 1
+ * 
+ * @param ctx compilation context
+ * @param node expression
+ * @return true for comparaisons and logical operators
+ */
+static bool is_boolean(Context* ctx, node_t node);
+
+/**
+ * @brief Write nasm code to handle an 'and' (&&) or an 'or' (||) whose right
+ *        member has no side effect and reads no array element: both members
+ *        are evaluated, then
+ *        combined without any jump
+ * 
+ * @param walk walk writing the instructions of a function
+ * @param frame frame of the node with the 'And' or the 'Or' label
  */
-static void write_bool_transform(void);
+static void write_strict_logic(Walk* walk, Frame* frame);
 
 /**
  * @brief Write nasm code to handle 'and' (&&) lazy evaluation
  * 
- * @param globals global's table
- * @param collection collection of fucntion
- * @param fun function where the 'and' is computed
- * @param tree head node with the 'And' label
+ * @param walk walk writing the instructions of a function
+ * @param frame frame of the node with the 'And' label
  */
-static void write_and(const Table* globals, const FunctionCollection* collection,
-                       const Function* fun, const Node* tree);
+static void write_and(Walk* walk, Frame* frame);
 
 /**
  * @brief Write nasm code to handle 'or' (||) lazy evaluation
  * 
- * @param globals global's table
- * @param collection collection of fucntion
- * @param fun function where the 'or' is computed
- * @param tree head node with the 'Or' label
+ * @param walk walk writing the instructions of a function
+ * @param frame frame of the node with the 'Or' label
  */
-static void write_or(const Table* globals, const FunctionCollection* collection,
-                       const Function* fun, const Node* tree);
+static void write_or(Walk* walk, Frame* frame);
 
 /**
  * @brief Write nasm code to handle negation
  * 
- * @param globals global's table
- * @param collection collection of fucntion
- * @param fun function where the 'negation' is computed
- * @param tree head node with the 'Negation' label
+ * @param walk walk writing the instructions of a function
+ * @param frame frame of the node with the 'Negation' label
  */
-static void write_neg(const Table* globals, const FunctionCollection* collection,
-                      const Function* fun, const Node* tree);
+static void write_neg(Walk* walk, Frame* frame);
 
 /**
  * @brief Write nasm code to handle 'if' and 'else' statements
  * 
- * @param globals global's table
- * @param collection collection of function
- * @param fun function where the 'if' is computed
- * @param tree head node with the 'If' label
+ * @param walk walk writing the instructions of a function
+ * @param frame frame of the node with the 'If' label
  */
-static void write_if(const Table* globals, const FunctionCollection* collection,
-                     const Function* fun, const Node* tree);
+static void write_if(Walk* walk, Frame* frame);
 
 /**
  * @brief Write nasm code to handle the 'while' statement
  * 
- * @param globals global's table
- * @param collection collection of function
- * @param fun function where the 'while' is computed
- * @param tree head node with the 'While' label
+ * @param walk walk writing the instructions of a function
+ * @param frame frame of the node with the 'While' label
  */
-static void write_while(const Table* globals, const FunctionCollection* collection,
-                        const Function* fun, const Node* tree);
+static void write_while(Walk* walk, Frame* frame);
 
 /**
- * @brief Push on stack the number store in tree
+ * @brief Push on stack the number store in tree, kept in rax
  * 
+ * @param walk walk writing the instructions of a function
  * @param tree 
  */
-static void write_num(const Node* tree);
+static void write_num(Walk* walk, node_t tree);
 
 /**
- * @brief Push on stack the charactre stored in tree. In case of special
- *        caracters, push their numerical equivalent
+ * @brief Write nasm code for each instruction of a function. Visit of the
+ *        walk over the instructions of a function
  * 
- * @param tree 
+ * @param walk walk writing the instructions, with the 'Scope' of the
+ *             function
+ * @param frame frame of the node to write
+ * @return 1
  */
-static void write_character(const Node* tree);
+static int write_tree(Walk* walk, Frame* frame);
 
 /**
- * @brief Write nasm code for each instruction of a function
+ * @brief Get the first instruction of a bloc of instructions
  * 
- * @param globals global's table
- * @param collection collection of function
- * @param fun function where the instructions are performed
- * @param tree node to write
+ * @param ctx compilation context
+ * @param tree bloc, or first instruction
+ * @return first instruction to write
  */
-static void write_tree(const Table* globals, const FunctionCollection* collection,
-                       const Function* fun, const Node* tree);
+static node_t instructions_head(Context* ctx, node_t tree);
 
 /**
- * @brief Write bloc of instruction
+ * @brief Write a function from its IR. If the IR cannot be built, or is
+ *        not well formed, the function is written from the tree
  * 
- * @param globals global's table
- * @param collection collection of function
- * @param fun function where the instructions are performed
- * @param tree node to write
+ * @param ctx compilation context
+ * @param scope symbols seen by the function, with the function itself
+ * @param node head node of the function (the 'DeclFonct' label)
+ * @return 1 if the function is written
+ *         0 else
+ */
+static int write_function_ir(Context* ctx, const Scope* scope, node_t node);
+
+/**
+ * @brief Print the IR of a function on the standard output
+ * 
+ * @param ctx compilation context
+ * @param scope symbols seen by the function, with the function itself
+ * @param node head node of the function (the 'DeclFonct' label)
+ */
+static void dump_function_ir(Context* ctx, const Scope* scope, node_t node);
+
+/**
+ * @brief Generate the declaration of a function and its code
+ * 
+ * @param ctx compilation context
+ * @param scope symbols seen by the function, with the function itself
+ * @param node head node of the function (the 'DeclFonct' label)
+ */
+static void generate_function_code(Context* ctx, const Scope* scope, node_t node);
+
+/**
+ * @brief Write the declaration of a function and its code, rewritten by the
+ *        peephole optimizer
+ * 
+ * @param ctx compilation context
+ * @param scope symbols seen by the function, with the function itself
+ * @param node head node of the function (the 'DeclFonct' label)
+ */
+static void write_function_code(Context* ctx, const Scope* scope, node_t node);
+
+/**
+ * @brief Write a function from the cache directory, or generate it and
+ *        store it there if it is not cached yet
+ * 
+ * @param ctx compilation context
+ * @param scope symbols seen by the function, with the function itself
+ * @param node head node of the function (the 'DeclFonct' label)
+ * @return 1 if the function is written
+ *         0 if the cache cannot be used, so nothing is written
+ */
+static int write_cached_function(Context* ctx, const Scope* scope, node_t node);
+
+/**
+ * @brief Write a function, from the cache directory if it is used
+ * 
+ * @param ctx compilation context
+ * @param globals symbols table
+ * @param collection array of functions, with the functions it calls
+ * @param node head node of the function (the 'DeclFonct' label)
+ */
+static void write_function_node(Context* ctx, const Table* globals,
+                                const FunctionCollection* collection, node_t node);
+
+/**
+ * @brief Write the functions of a task, consecutive functions of a file
+ * 
+ * @param gen functions of the file
+ * @param ctx compilation context, whose output is the nasm of the task
+ * @param task index of the task
+ */
+static void write_task(Codegen* gen, Context* ctx, int task);
+
+/**
+ * @brief Thread taking the tasks of a file until all are taken, each one
+ *        generated in its own buffer with a copy of the context
+ * 
+ * @param gen functions of the file
+ * @return NULL
  */
-static void write_instructions(const Table* globals, const FunctionCollection* collection,
-                               const Function* fun, const Node* tree);
+static void* write_tasks(void* gen);
+
+/**
+ * @brief Generate the functions of a file on several threads, then write
+ *        them in the order of the file, so the nasm does not depend on the
+ *        threads
+ * 
+ * @param ctx compilation context
+ * @param gen functions of the file, split in tasks
+ * @param jobs number of threads
+ */
+static void write_functions_parallel(Context* ctx, Codegen* gen, int jobs);
 
 /**
  * @brief Write all function declarations and their code
  * 
+ * @param ctx compilation context
  * @param globals global's table
  * @param collection collection of function
  * @param tree head of the programm, node with the 'Prog' label 
  */
-static void write_functions(const Table* globals, const FunctionCollection* collection, const Node* tree);
+static void write_functions(Context* ctx, const Table* globals,
+                            const FunctionCollection* collection, node_t tree);
 
-static char* sub_path(char* path) {
-    int len = strlen(path), i;
-    for (i = len - 1; i > -1; i--) {
-        if (path[i] == '/') {
-            return path + i + 1;
+static void write_builtin(Context* ctx, int index, unsigned* written) {
+    const EmbeddedBuiltin* builtin = &embedded_builtins[index];
+    if (*written & (1u << index)) {
+        return;
+    }
+    *written |= 1u << index;
+    for (int i = 0; builtin->calls[i]; i++) {
+        for (int j = 0; embedded_builtins[j].name; j++) {
+            if (!strcmp(embedded_builtins[j].name, builtin->calls[i])) {
+                write_builtin(ctx, j, written);
+            }
         }
     }
-    return path;
+    EMIT(ctx, "\n");
+    emit(ctx, builtin->nasm);
 }
 
-static int create_file(char* output) {
-    if (!output) {
-        output = "_anonymous";
-    } else {
-        output = sub_path(output);
-        output[strlen(output) - 4] = '\0';
+static void write_buitlins(Context* ctx, const FunctionCollection* coll) {
+    unsigned written = 0;
+    for (int i = 0; embedded_builtins[i].name; i++) {
+        const char* name = embedded_builtins[i].name;
+        // the names of the builtins are interned with the collection
+        Function* fun = get_function(coll, intern(ctx, name, strlen(name)));
+        if (fun && fun->is_used) {
+            write_builtin(ctx, i, &written);
+        }
     }
-    char filename[64];
-    snprintf(filename, 64, DEFAULT_PATH"%s.asm", output);
+}
 
-    // set the global variable 'out' to the file's output
-    out = fopen(filename, "w");
-    return out != NULL;
+static void write_init(Context* ctx, int globals_size) {
+    EMIT(ctx, "global _start\n"
+              "section .bss\n"
+              "\tglobals: resb ");
+    emit_int(ctx, globals_size);
+    EMIT(ctx, "\n"
+              "\nsection .text\n");
+
+    EMIT(ctx, "\n_start:\n"
+              "\tcall\tmain\n");
+    write_exit(ctx);
 }
 
-static void write_builtin(FILE* file) {
-    char buffer[BUFFER_SIZE];
-    while (fgets(buffer, BUFFER_SIZE, file)) {
-        fputs(buffer, out);
-    }
-    fputc('\n', out);
+static void write_exit(Context* ctx) {
+    EMIT(ctx, "\tmov \trdi, rax\n"
+              "\tmov \trax, 60\n"
+              "\tsyscall\n");
 }
 
-static int write_buitlins(void) {
-    FILE* bfile; 
-    for (int i = 0; buitlin_fcts[i]; i++) {
-        bfile = fopen(buitlin_fcts[i], "r");
-        if (!bfile) {
-            return 0;
-        }
-        write_builtin(bfile);
-        fclose(bfile);
+static void flush_top(Walk* walk) {
+    TreeGen* gen = walk->pass;
+    if (gen->cached) {
+        EMIT(walk->ctx, "\tpush\trax\n");
+        gen->cached = false;
     }
-    return 1;
 }
 
-static void write_init(const FunctionCollection* coll, int globals_size) {
-    fprintf(out, "global _start\n"
-                 "section .bss\n"
-                 "\tglobals: resb %d\n"
-                 "\nsection .text\n", globals_size);
-
-    write_buitlins();
-
-    fprintf(out, "\n_start:\n"
-                 "\tcall\tmain\n");
-    write_exit();
+static void pop_top(Walk* walk, const char* reg) {
+    TreeGen* gen = walk->pass;
+    if (!gen->cached) {
+        EMIT(walk->ctx, "\tpop \t");
+        emit(walk->ctx, reg);
+        EMIT(walk->ctx, "\n");
+    } else if (strcmp(reg, "rax")) {
+        EMIT(walk->ctx, "\tmov \t");
+        emit(walk->ctx, reg);
+        EMIT(walk->ctx, ", rax\n");
+    }
+    gen->cached = false;
 }
 
-static void write_exit(void) {
-    fprintf(out, "\tmov \trdi, rax\n"
-                 "\tmov \trax, 60\n"
-                 "\tsyscall\n");
+static void keep_top(Walk* walk) {
+    ((TreeGen*)walk->pass)->cached = true;
 }
 
+static bool is_instruction(Walk* walk) {
+    // instructions are in lists, but for the one of an 'if'
+    const Frame* parent = &walk->frames[walk->depth - 2];
+    return parent->list
+           || (NODE_LABEL(walk->ctx, parent->node) == If
+               && FIRSTCHILD(walk->ctx, parent->node) != walk->frames[walk->depth - 1].node);
+}
 
-static void write_add_sub_mul(const Table* globals, const FunctionCollection* collection,
-                              const Function* fun, const Node* tree) {
+static void write_add_sub_mul(Walk* walk, Frame* frame) {
     static const char* sym_op[] = {
-        ['-'] = "sub ",
-        ['+'] = "add ",
-        ['*'] = "imul"
+        ['-'] = "\tsub \trax, rcx\n",
+        ['+'] = "\tadd \trax, rcx\n",
+        ['*'] = "\timul\trax, rcx\n"
     };
 
-    write_tree(globals, collection, fun, FIRSTCHILD(tree));
+    Context* ctx = walk->ctx;
+    node_t tree = frame->node;
+    char op = ident_name(ctx, NODE_VAL(ctx, tree).ident)[0];
+    if (frame->step == 0) {
+        visit_node(walk, FIRSTCHILD(ctx, tree));
+        return;
+    }
 
-    if (!SECONDCHILD(tree)) { // unary plus and minus
-        if (tree->val.ident[0] == '-') {
-            fprintf(out, "\n\t; unary negation\n"
-                         "\tpop \trax\n"
-                         "\tneg \trax\n"
-                         "\tpush\trax\n");
+    if (!SECONDCHILD(ctx, tree)) { // unary plus and minus
+        if (op == '-') {
+            emit_comment(ctx, COMMENTS_FULL, "unary negation");
+            pop_top(walk, "rax");
+            EMIT(ctx, "\tneg \trax\n");
+            keep_top(walk);
         }
+    } else if (frame->step == 1) {
+        visit_node(walk, SECONDCHILD(ctx, tree));
     } else {
-        write_tree(globals, collection, fun, SECONDCHILD(tree));
-        fprintf(out, "\n\t; binary operator (%c)\n"
-                     "\tpop \trcx\n"
-                     "\tpop \trax\n"
-                     "\t%s\trax, rcx\n"
-                     "\tpush\trax\n",
-                     tree->val.ident[0],
-                     sym_op[(int)tree->val.ident[0]]);
-    }
-
-}
-
-static void write_div_mod(const Table* globals, const FunctionCollection* collection,
-                          const Function* fun, const Node* tree) {
-    write_tree(globals, collection, fun, FIRSTCHILD(tree));
-    write_tree(globals, collection, fun, SECONDCHILD(tree));
-    if(tree->val.ident[0] == '/') {
-        fprintf(out, "\n\t; division operator\n"
-                     "\tpop \trcx\t; dividend\n"
-                     "\tpop \trax\n"
-                     "\tcqo \t; initialise quotient\n"
-                     "\tidiv\trcx\n"
-                     "\tpush\trax\n");
-    } else if(tree->val.ident[0] == '%') {
-        fprintf(out, "\n\t; modulo operator\n"
-                     "\tpop \trcx\t; dividend\n"
-                     "\tpop \trax\n"
-                     "\tcqo \t; initialise quotient\n"
-                     "\tidiv\trcx\n"
-                     "\tpush\trdx\n");
-    }
-}
-
-static void write_arithmetic(const Table* globals, const FunctionCollection* collection,
-                             const Function* fun, const Node* tree) {
-    if (tree->val.ident[0] == '/' || tree->val.ident[0] == '%') {
-        write_div_mod(globals, collection, fun, tree);
+        emit_comment(ctx, COMMENTS_FULL, "binary operator (%c)", op);
+        pop_top(walk, "rcx");
+        pop_top(walk, "rax");
+        emit(ctx, sym_op[(int)op]);
+        keep_top(walk);
+    }
+
+}
+
+static void write_div_mod(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    node_t tree = frame->node;
+    if (frame->step < 2) {
+        visit_node(walk, frame->step ? SECONDCHILD(ctx, tree) : FIRSTCHILD(ctx, tree));
+        return;
+    }
+    char op = ident_name(ctx, NODE_VAL(ctx, tree).ident)[0];
+    if (op != '/' && op != '%') {
+        return;
+    }
+    emit_comment(ctx, COMMENTS_FULL, op == '/' ? "division operator": "modulo operator");
+    pop_top(walk, "rcx");
+    pop_top(walk, "rax");
+    EMIT(ctx, "\tcqo ");
+    emit_note(ctx, "initialise quotient");
+    EMIT(ctx, "\n"
+              "\tidiv\trcx\n");
+    if (op == '%') {
+        EMIT(ctx, "\tmov \trax, rdx\n");
+    }
+    keep_top(walk);
+}
+
+static void write_arithmetic(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    char op = ident_name(ctx, NODE_VAL(ctx, frame->node).ident)[0];
+    if (op == '/' || op == '%') {
+        write_div_mod(walk, frame);
     } else {
-        write_add_sub_mul(globals, collection, fun, tree);
+        write_add_sub_mul(walk, frame);
     }
 }
 
-static void write_function_exit(void) {
-    fprintf(out, "\n\t; stack alignement before exiting the function\n"
-                 "\tmov \trsp, rbp\n"
-                 "\tpop \trbp\n"
-                 "\tret\n");
+static void write_function_exit(Context* ctx) {
+    emit_comment(ctx, COMMENTS_FULL, "stack alignement before exiting the function");
+    EMIT(ctx, "\tmov \trsp, rbp\n"
+              "\tpop \trbp\n"
+              "\tret\n");
 }
 
-static void write_return(const Table* globals, const FunctionCollection* collection,
-                         const Function* fun, const Node* tree) {
+static void write_return(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    const Function* fun = ((const TreeGen*)walk->pass)->scope->fun;
     if (fun->r_type != T_VOID) {
-        write_tree(globals, collection, fun, FIRSTCHILD(tree));
-        fprintf(out, "\n\t; return value loading\n" 
-                     "\tpop \trax\n");
+        if (frame->step == 0) {
+            visit_node(walk, FIRSTCHILD(ctx, frame->node));
+            return;
+        }
+        emit_comment(ctx, COMMENTS_FULL, "return value loading");
+        pop_top(walk, "rax");
     }
-    write_function_exit();
+    write_function_exit(ctx);
 }
 
-static void write_function(Function* fun) {
-    fprintf(out, "\n; function %s\n"
-                 "%s:\n"
-                 "\t; save stack return address\n"
-                 "\tpush\trbp\n"
-                 "\tmov \trbp, rsp\n",
-                 fun->name, fun->name);
-    
-    fprintf(out, "\n\t; push parameters on the stack\n");
+static void write_function(Context* ctx, const Function* fun) {
+    const char* name = ident_name(ctx, fun->name);
+    EMIT(ctx, "\n");
+    if (ctx->comments >= COMMENTS_BRIEF) {
+        EMIT(ctx, "; function ");
+        emit(ctx, name);
+        EMIT(ctx, "\n");
+    }
+    emit(ctx, name);
+    EMIT(ctx, ":\n");
+    if (ctx->comments == COMMENTS_FULL) {
+        EMIT(ctx, "\t; save stack return address\n");
+    }
+    EMIT(ctx, "\tpush\trbp\n"
+              "\tmov \trbp, rsp\n");
+
+    emit_comment(ctx, COMMENTS_FULL, "push parameters on the stack");
 
     for (int i = 0; i < fun->parameters.cur_len && param_registers[i]; i++) {
-        fprintf(out, "\tpush\t%s\n", param_registers[i]);
+        EMIT(ctx, "\tpush\t");
+        emit(ctx, param_registers[i]);
+        EMIT(ctx, "\n");
     }
 
-    fprintf(out, "\n\t; allocate memory for local variables\n"
-                 "\tsub \trsp, %d\n\n"
-                 "\t; function's body\n",
-                 fun->locals.total_bytes);
+    emit_comment(ctx, COMMENTS_FULL, "allocate memory for local variables");
+    EMIT(ctx, "\tsub \trsp, ");
+    emit_int(ctx, fun->locals.total_bytes);
+    EMIT(ctx, "\n");
+    emit_comment(ctx, COMMENTS_FULL, "function's body");
 
 }
 
-static void write_assign(const Table* globals, const FunctionCollection* collection,
-                         const Function* fun, const Node* tree) {
-    
-    write_tree(globals, collection, fun, SECONDCHILD(tree));
-    
+static void write_assign(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    const Scope* scope = ((const TreeGen*)walk->pass)->scope;
+    const Function* fun = scope->fun;
+    node_t tree = frame->node;
+
+    if (frame->step == 0) {
+        visit_node(walk, SECONDCHILD(ctx, tree));
+        return;
+    }
+
+    // the index of an array is written before the access
     Entry* entry;
-    if ((entry = get_entry(&fun->locals, FIRSTCHILD(tree)->val.ident))) {
-        if (is_array(entry->type)) {
-            write_tree(globals, collection, fun, FIRSTCHILD(FIRSTCHILD(tree)));
+    if ((entry = get_entry(&fun->locals, NODE_VAL(ctx, FIRSTCHILD(ctx, tree)).ident))) {
+        if (is_array(entry->type) && frame->step == 1) {
+            visit_node(walk, FIRSTCHILD(ctx, FIRSTCHILD(ctx, tree)));
+            return;
         }
-        local_access(fun, entry, "pop ", false);
-    } else if ((entry = get_entry(&fun->parameters, FIRSTCHILD(tree)->val.ident))) {
-        if (is_array(entry->type)) {
-            write_tree(globals, collection, fun, FIRSTCHILD(FIRSTCHILD(tree)));
+        local_access(walk, fun, entry, true, false);
+    } else if ((entry = get_entry(&fun->parameters, NODE_VAL(ctx, FIRSTCHILD(ctx, tree)).ident))) {
+        if (is_array(entry->type) && frame->step == 1) {
+            visit_node(walk, FIRSTCHILD(ctx, FIRSTCHILD(ctx, tree)));
+            return;
         }
-        param_access(fun, entry, "pop ", false);
-    } else if ((entry = get_entry(globals, FIRSTCHILD(tree)->val.ident))) {
-        if (is_array(entry->type)) {
-            write_tree(globals, collection, fun, FIRSTCHILD(FIRSTCHILD(tree)));
+        param_access(walk, fun, entry, true, false);
+    } else if ((entry = get_entry(scope->globals, NODE_VAL(ctx, FIRSTCHILD(ctx, tree)).ident))) {
+        if (is_array(entry->type) && frame->step == 1) {
+            visit_node(walk, FIRSTCHILD(ctx, FIRSTCHILD(ctx, tree)));
+            return;
         }
-        global_access(entry, "pop ", false);
+        global_access(walk, entry, true, false);
     }
 
 }
 
-static void write_parameters(const Table* globals, const FunctionCollection* collection,
-                             const Function* fun, const Node* tree) {
-    // We want to treat the first parameter at the very last
-    // So parameters are handled in reverse order
+static void write_function_call(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    node_t tree = frame->node;
+    Function* to_call = get_function(((const TreeGen*)walk->pass)->scope->collection,
+                                     NODE_VAL(ctx, tree).ident);
 
-    if (!tree) return;
-    write_parameters(globals, collection, fun, tree->nextSibling);
-    write_tree(globals, collection, fun, tree);
-}
+    // the call changes rax
+    if (frame->step == 0) {
+        flush_top(walk);
+    }
+    if (NODE_LABEL(ctx, FIRSTCHILD(ctx, tree)) == ListExp) {
+        if (frame->step == 0) {
+            // We want to treat the first parameter at the very last
+            // So parameters are handled in reverse order
+            visit_reversed_list(walk, FIRSTCHILD(ctx, FIRSTCHILD(ctx, tree)));
+            return;
+        }
+        emit_comment(ctx, COMMENTS_FULL, "move the first six parameters from the "
+                     "stack to their register according to AMD64 conventions");
 
-static void write_function_call(const Table* globals, const FunctionCollection* collection,
-                                const Function* fun, const Node* tree) {
-    Function* to_call = get_function(collection, tree->val.ident);
-    
-    if (FIRSTCHILD(tree)->label == ListExp) {
-        write_parameters(globals, collection, fun, FIRSTCHILD(FIRSTCHILD(tree)));
-        fprintf(out, "\n\t; move the first six parameters from the stack to "
-                     "their register according to AMD64 conventions\n");
-        
         for (int i = 0; i < to_call->parameters.cur_len && i < 6; i++) {
-            fprintf(out, "\tpop \t%s\n", param_registers[i]);
+            pop_top(walk, param_registers[i]);
         }
     }
-    fprintf(out, "\n\t; call of the function\n"
-                 "\tcall\t%s\n",
-                 tree->val.ident);
+    emit_comment(ctx, COMMENTS_BRIEF, "call of the function");
+    EMIT(ctx, "\tcall\t");
+    emit(ctx, ident_name(ctx, NODE_VAL(ctx, tree).ident));
+    EMIT(ctx, "\n");
 
     if (to_call->parameters.cur_len > 6) {
-        fprintf(out, "\n\t; remove parameters that have stayed in the stack\n"
-                     "\tadd \trsp, %d\n",
-                     (to_call->parameters.cur_len - 6)*8);
+        emit_comment(ctx, COMMENTS_FULL, "remove parameters that have stayed in the stack");
+        EMIT(ctx, "\tadd \trsp, ");
+        emit_int(ctx, (to_call->parameters.cur_len - 6)*8);
+        EMIT(ctx, "\n");
     }
 
-    if (to_call->r_type != T_VOID) {
-        fprintf(out, "\n\t; pushing the return value\n"
-                     "\tpush\trax\n");
+    // the value of a call used as an instruction is dropped
+    if (to_call->r_type != T_VOID && !is_instruction(walk)) {
+        emit_comment(ctx, COMMENTS_FULL, "pushing the return value");
+        keep_top(walk);
     }
 }
 
-static void local_access(const Function* fun, const Entry* entry, 
-                         const char* instr, bool address) {
+static void begin_memory(Walk* walk, bool store) {
+    // a stored value is in rax, or still on the stack below an index
+    bool cached = ((const TreeGen*)walk->pass)->cached;
+    emit(walk->ctx, !store ? "\tmov \trax, ": cached ? "\tmov \t": "\tpop \t");
+}
+
+static void end_memory(Walk* walk, bool store) {
+    TreeGen* gen = walk->pass;
+    emit(walk->ctx, store && gen->cached ? ", rax\n": "\n");
+    gen->cached = !store;
+}
+
+static void write_memory(Walk* walk, bool store, const char* memory) {
+    begin_memory(walk, store);
+    emit(walk->ctx, memory);
+    end_memory(walk, store);
+}
+
+static void write_access(Walk* walk, bool store, const char* memory, long offset) {
+    begin_memory(walk, store);
+    emit(walk->ctx, memory);
+    emit_int(walk->ctx, offset);
+    EMIT(walk->ctx, "]");
+    end_memory(walk, store);
+}
+
+static void write_address(Context* ctx, const char* base, long offset) {
+    emit(ctx, base);
+    emit_int(ctx, offset);
+    EMIT(ctx, "\n");
+}
+
+static void start_access(Walk* walk, const Entry* entry, bool store, bool address) {
+    if (is_array(entry->type) && !address) {
+        pop_top(walk, "rcx");
+        EMIT(walk->ctx, "\timul\trcx, 8\n");
+    } else if (!store) {
+        flush_top(walk);
+    }
+}
+
+static void local_access(Walk* walk, const Function* fun, const Entry* entry,
+                         bool store, bool address) {
+    Context* ctx = walk->ctx;
+    emit_comment(ctx, COMMENTS_FULL, "accessing to '%s' in locals",
+                 ident_name(ctx, entry->name));
+    int offset = fun->parameters.offset + entry->address;
+    start_access(walk, entry, store, address);
     if (is_array(entry->type)) {
+        write_address(ctx, "\tmov \trax, rbp\n"
+                           "\tsub \trax, ", offset);
         if (address) {
-            fprintf(out, "\n\t; accessing to '%s' in locals\n"
-                        "\tmov \trax, rbp\n"
-                        "\tsub \trax, %d\n"
-                        "\t%s\trax\n",
-                        entry->name, fun->parameters.offset + entry->address, instr);
+            keep_top(walk);
             return;
         }
-        fprintf(out, "\n\t; accessing to '%s' in locals\n"
-                     "\tpop \trcx\n"
-                     "\timul\trcx, 8\n"
-                     "\tmov \trax, rbp\n"
-                     "\tsub \trax, %d\n"
-                     "\tsub \trax, rcx\n"
-                     "\t%s\tqword [rax]\n",
-                     entry->name, fun->parameters.offset + entry->address, instr);
+        EMIT(ctx, "\tsub \trax, rcx\n");
+        write_memory(walk, store, "qword [rax]");
     } else {
-        fprintf(out, "\n\t; accessing to '%s' in locals\n"
-                     "\t%s\tqword [rbp - %d]\n",
-                     entry->name, instr, fun->parameters.offset + entry->address);
-
+        write_access(walk, store, "qword [rbp - ", offset);
     }
 }
 
-static void param_access(const Function* fun, const Entry* entry,
-                         const char* instr, bool address) {
+static void param_access(Walk* walk, const Function* fun, const Entry* entry,
+                         bool store, bool address) {
+    Context* ctx = walk->ctx;
     int index = is_in_table(&fun->parameters, entry->name);
+    const char* name = ident_name(ctx, entry->name);
+    if (address) {
+        emit_comment(ctx, COMMENTS_FULL, "accessing address of '%s' in parameters", name);
+    } else {
+        emit_comment(ctx, COMMENTS_FULL, "accessing to '%s' in parameters", name);
+    }
+    start_access(walk, entry, store, address);
     if (index < 6) {
         if (is_array(entry->type)) {
+            write_address(ctx, "\tmov \trax, rbp\n"
+                               "\tsub \trax, ", entry->address);
             if (address) {
-                fprintf(out, "\n\t; accessing address of '%s' in parameters\n"
-                             "\tmov \trax, rbp\n"
-                             "\tsub \trax, %d\n"
-                             "\t%s\tqword [rax]\n",
-                             entry->name, entry->address, instr);
+                write_memory(walk, false, "qword [rax]");
                 return;
             }
-            fprintf(out, "\n\t; accessing to '%s' in parameters\n"
-                         "\tpop \trcx\n"
-                         "\timul\trcx, 8\n"
-                         "\tmov \trax, rbp\n"
-                         "\tsub \trax, %d\n"
-                         "\tmov \trdx, qword [rax]\n"
-                         "\tsub \trdx, rcx\n"
-                         "\t%s\tqword [rdx]\n",
-                         entry->name, entry->address, instr);
+            EMIT(ctx, "\tmov \trdx, qword [rax]\n"
+                      "\tsub \trdx, rcx\n");
+            write_memory(walk, store, "qword [rdx]");
         } else {
-            fprintf(out, "\n\t; accessing to '%s' in parameters\n"
-                         "\t%s\tqword [rbp - %d]\n",
-                         entry->name, instr, entry->address);
+            write_access(walk, store, "qword [rbp - ", entry->address);
         }
     } else {
         if (is_array(entry->type)) {
             if (address) {
-                fprintf(out, "\n\t; accessing address of '%s' in parameters\n"
-                             "\tmov \trax, rbp\n"
-                             "\tadd \trax, %d\n"
-                             "\t%s\tqword [rax]\n",
-                             entry->name, entry->address, instr);
+                write_address(ctx, "\tmov \trax, rbp\n"
+                                   "\tadd \trax, ", entry->address);
+                write_memory(walk, false, "qword [rax]");
                 return;
             }
-            fprintf(out, "\n\t; accessing to '%s' in parameters\n"
-                         "\tpop \trcx\n"
-                         "\timul\trcx, 8\n"
-                         "\tmov \trax, rbp\n"
-                         "\tsub \trax, %d\n"
-                         "\tadd \trax, rcx\n"
-                         "\t%s\tqword [rax]\n",
-                         entry->name, entry->address, instr);
+            write_address(ctx, "\tmov \trax, rbp\n"
+                               "\tsub \trax, ", entry->address);
+            EMIT(ctx, "\tadd \trax, rcx\n");
+            write_memory(walk, store, "qword [rax]");
         } else {
-            fprintf(out, "\n\t; accessing to '%s' in parameters\n"
-                        "\t%s\tqword [rbp + %d]\n",
-                        entry->name, instr, entry->address);
+            write_access(walk, store, "qword [rbp + ", entry->address);
         }
     }
 }
 
-static void global_access(const Entry* entry, const char* instr, bool address) {
+static void global_access(Walk* walk, const Entry* entry, bool store,
+                          bool address) {
+    Context* ctx = walk->ctx;
+    const char* name = ident_name(ctx, entry->name);
     if (is_array(entry->type)) {
         if (address) {
-            fprintf(out, "\n\t; accessing  address of '%s' in globals\n"
-                         "\tmov \trcx, globals\n"
-                         "\tadd \trcx, %d\n"
-                         "\t%s\trcx\n",
-                         entry->name, entry->address, instr);
+            emit_comment(ctx, COMMENTS_FULL, "accessing  address of '%s' in globals", name);
+            start_access(walk, entry, store, address);
+            write_address(ctx, "\tmov \trax, globals\n"
+                               "\tadd \trax, ", entry->address);
+            keep_top(walk);
             return;
         }
-        fprintf(out, "\n\t; accessing to '%s' in globals\n"
-                     "\tpop \trcx\n"
-                     "\timul\trcx, 8\n"
-                     "\tmov \trax, globals\n"
-                     "\tadd \trax, %d\n"
-                     "\tadd \trax, rcx\n"
-                     "\t%s\tqword [rax]\n",
-                     entry->name, entry->address, instr);
+        emit_comment(ctx, COMMENTS_FULL, "accessing to '%s' in globals", name);
+        start_access(walk, entry, store, address);
+        write_address(ctx, "\tmov \trax, globals\n"
+                           "\tadd \trax, ", entry->address);
+        EMIT(ctx, "\tadd \trax, rcx\n");
+        write_memory(walk, store, "qword [rax]");
     } else {
-        fprintf(out, "\n\t; accessing to '%s' in globals\n"
-                     "\tmov \trcx, globals\n"
-                     "\t%s\tqword [rcx + %d]\n",
-                     entry->name, instr, entry->address);
+        emit_comment(ctx, COMMENTS_FULL, "accessing to '%s' in globals", name);
+        start_access(walk, entry, store, address);
+        EMIT(ctx, "\tmov \trcx, globals\n");
+        write_access(walk, store, "qword [rcx + ", entry->address);
     }
 }
 
-static void write_load_ident(const Table* globals, const FunctionCollection* collection,
-                             const Function* fun, const Node* tree) {
-    write_tree(globals, collection, fun, FIRSTCHILD(tree));
+static void write_load_ident(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    const Scope* scope = ((const TreeGen*)walk->pass)->scope;
+    const Function* fun = scope->fun;
+    node_t tree = frame->node;
+    ident_t ident = NODE_VAL(ctx, tree).ident;
+
+    // the index of an array is written before the access, while a function
+    // call writes its own parameters
+    if (frame->step == 0 && (get_entry(&fun->locals, ident)
+                             || get_entry(&fun->parameters, ident)
+                             || get_entry(scope->globals, ident))) {
+        visit_node(walk, FIRSTCHILD(ctx, tree));
+        return;
+    }
     Entry* entry;
-    if ((entry = get_entry(&fun->locals, tree->val.ident))) {
-        local_access(fun, entry, "push", !FIRSTCHILD(tree));
-    } else if ((entry = get_entry(&fun->parameters, tree->val.ident))) {
-        param_access(fun, entry, "push", !FIRSTCHILD(tree));
-    } else if ((entry = get_entry(globals, tree->val.ident))) {
-        global_access(entry, "push", !FIRSTCHILD(tree));
+    if ((entry = get_entry(&fun->locals, ident))) {
+        local_access(walk, fun, entry, false, !FIRSTCHILD(ctx, tree));
+    } else if ((entry = get_entry(&fun->parameters, ident))) {
+        param_access(walk, fun, entry, false, !FIRSTCHILD(ctx, tree));
+    } else if ((entry = get_entry(scope->globals, ident))) {
+        global_access(walk, entry, false, !FIRSTCHILD(ctx, tree));
     } else {
-        write_function_call(globals, collection, fun, tree);
+        write_function_call(walk, frame);
     }
 }
 
-static char* get_comp_instr(const char* symbol) {
+static const comp_op* get_comp_op(const char* symbol) {
     for (int i = 0; operators[i].symbol; i++) {
         if (!strcmp(operators[i].symbol, symbol)) {
-            return operators[i].instr;
+            return &operators[i];
         }
     }
     return NULL;
 }
 
-static int next_free_label(void) {
-    static int label = 0;
-    return label++;
-}
-
-static void write_comp(const Table* globals, const FunctionCollection* collection,
-                       const Function* fun, const Node* tree) {
-    write_tree(globals, collection, fun, FIRSTCHILD(tree));
-    write_tree(globals, collection, fun, SECONDCHILD(tree));
-
-    fprintf(out, "\n\t; loading values to compare them\n"
-                 "\tpop \trcx\n"
-                 "\tpop \trax\n");
-    
-    int nlabel = next_free_label();
-    int ncontinue = next_free_label();
-
-    fprintf(out, "\n\t; comparaison (%s)\n"
-                 "\tcmp \trax, rcx\n"
-                 "\t%s \tlabel%d\n"
-                 "\tpush\t0\n"
-                 "\tjmp \tcontinue%d\n"
-                 "\tlabel%d:\n"
-                 "\tpush\t1\n"
-                 "\tcontinue%d:\n",
-                 tree->val.ident, get_comp_instr(tree->val.ident), nlabel,
-                 ncontinue, nlabel, ncontinue);
-}
-
-static void write_bool_transform(void) {
-    int nlabel = next_free_label();
-    int ncontinue = next_free_label();
-
-    fprintf(out, "\n\t; transform output to correct format\n"
-                 "\tpop \trax\n"
-                 "\tcmp \trax, 0\n"
-                 "\tjne \t label%d\n"
-                 "\tpush\t0\n"
-                 "\tjmp \tcontinue%d\n"
-                 "\tlabel%d:\n"
-                 "\tpush\t1\n"
-                 "\tcontinue%d:\n",
-                 nlabel, ncontinue, nlabel, ncontinue);
-}
-
-static void write_and(const Table* globals, const FunctionCollection* collection,
-                       const Function* fun, const Node* tree) {
-    int nlabel = next_free_label();
-    int ncontinue = next_free_label();
-
-    fprintf(out, "\n\t; begin evaluation of an 'and' (&&)\n"
-                 "\n\t; evaluation of the left member\n");
-
-    write_tree(globals, collection, fun, FIRSTCHILD(tree));
-
-    fprintf(out, "\n\t; lazy evaluation of the 'and' (&&)\n"
-                 "\tpop \trax\n"
-                 "\tcmp \trax, 0\n"
-                 "\tjne \tlabel%d\t; left member is a non-zero value: we can "
-                    "evaluate the right member\n"
-                 "\tpush\t0\n"
-                 "\tjmp \tcontinue%d\t; left member is zero: there is no need "
-                    "to evaluate the right member since we already know the "
-                    "expression is false\n"
-                 "\tlabel%d:\n",
-                 nlabel, ncontinue, nlabel);
-
-    write_tree(globals, collection, fun, SECONDCHILD(tree));
-
-    fprintf(out, "\tcontinue%d:\n", ncontinue);
-    write_bool_transform();
-}
-
-static void write_or(const Table* globals, const FunctionCollection* collection,
-                     const Function* fun, const Node* tree) {
-    int nlabel = next_free_label();
-    int ncontinue = next_free_label();
-
-    fprintf(out, "\n\t; begin evaluation of an 'or' (||)\n"
-                 "\n\t; evaluation of the left member\n");
-
-    // write condition
-    write_tree(globals, collection, fun, FIRSTCHILD(tree));
-
-    // transform non-boolean values to boolean
-    write_bool_transform();
-
-    // evaluate condition
-    fprintf(out, "\n\t; evaluation du 'or' (||)\n"
-                 "\tpop \trax\n"
-                 "\tcmp \trax, 1\n"
-                 "\tjne \tlabel%d\t; left member is a zero: we need to "
-                    "evaluate the right member\n"
-                 "\tpush\t1\n"
-                 "\tjmp \tcontinue%d\t; left member is a non-zero value: there "
-                    "is no need to evaluate the right member since we know "
-                    "the condition is already true\n"
-                 "\tlabel%d:\n",
-                 nlabel, ncontinue, nlabel);
-    
-    // write the left part of the expression
-    write_tree(globals, collection, fun, SECONDCHILD(tree));
-
-    fprintf(out, "\tcontinue%d:\n", ncontinue);
-    write_bool_transform();
-}
-
-static void write_neg(const Table* globals, const FunctionCollection* collection,
-                      const Function* fun, const Node* tree) {
-    int ncontinue = next_free_label();
-    int nlabel = next_free_label();
-
-    fprintf(out, "\n\t; begin evaluating a 'not' (!)\n"
-                 "\t; label%d -> if 0 we push a 1\n"
-                 "\t; continue%d -> otherwise\n",
-                 nlabel, ncontinue);
-
-    write_tree(globals, collection, fun, FIRSTCHILD(tree));
-
-    fprintf(out, "\n\t; evaluation of the 'not' (!)\n"
-                 "\tpop \trax\n"
-                 "\tcmp \trax, 0\n"
-                 "\tje  \tlabel%d\n"
-                 "\tpush\t0\n"
-                 "\tjmp \tcontinue%d\n"
-                 "\tlabel%d:\n"
-                 "\tpush\t1\n"
-                 "\tcontinue%d:\n",
-                 nlabel, ncontinue, nlabel, ncontinue);
-}
-
-static void write_if(const Table* globals, const FunctionCollection* collection,
-                     const Function* fun, const Node* tree) {
-    int ncontinue = next_free_label();
-    int nelse = next_free_label();
-
-    fprintf(out, "\n\t; begin evaluation of an 'if'\n"
-                 "\t; continue%d -> code after the condition\n"
-                 "\t; else%d -> code of else\n", 
-                 ncontinue, nelse);
-    
-    // evaluate condition
-    write_tree(globals, collection, fun, FIRSTCHILD(tree));
-
-    fprintf(out, "\n\t; evaluation of the 'if' condition\n"
-                 "\tpop \trax\n"
-                 "\tcmp \trax, 0\n"
-                 "\tje  \telse%d\n",
-                 nelse);
-    
-    // instruction inside the if
-    write_tree(globals, collection, fun, SECONDCHILD(tree));
-    
-    fprintf(out, "\tjmp \tcontinue%d\n"
-                 "\telse%d:\n", ncontinue, nelse);
-
-    // instruction inside the else
-    write_instructions(globals, collection, fun, THIRDCHILD(tree));
-
-    fprintf(out, "\tcontinue%d:\n", ncontinue);
-}
-
-static void write_while(const Table* globals, const FunctionCollection* collection,
-                        const Function* fun, const Node* tree) {
-    int ncontinue = next_free_label();
-    int nhead = next_free_label();
-
-    fprintf(out, "\n\t; begin evaluating a 'while'\n"
-                 "\t; continue%d -> code after the 'while'\n"
-                 "\t; head%d -> head of loop\n"
-                 "\thead%d:\n",
-                 ncontinue, nhead, nhead);
-
-    // evaluate condition
-    write_tree(globals, collection, fun, FIRSTCHILD(tree));
-
-    fprintf(out, "\n\t; evaluation of the 'while' condition\n"
-                 "\tpop \trax\n"
-                 "\tcmp \trax, 0\n"
-                 "\tje  \tcontinue%d\t;\n",
-                 ncontinue);
-    
-    // write while code
-    write_instructions(globals, collection, fun, SECONDCHILD(tree));
-
-    fprintf(out, "\tjmp \thead%d\n"
-                 "\tcontinue%d:\n",
-                 nhead, ncontinue);
-}
-
-static void write_num(const Node* tree) {
-    fprintf(out, "\n\t; pushing integer\n"
-                 "\tpush\t%d\n",
-                 tree->val.num);
-}
-
-static void write_character(const Node* tree) {
-    int sym = -1;
-    if (!strcmp(tree->val.ident, "'\\n'")) {
-        sym = '\n';
-    } else if (!strcmp(tree->val.ident, "'\\t'")) {
-        sym = '\t';
-    } else if (!strcmp(tree->val.ident, "'\\r'")) {
-        sym = '\r';
-    } else if (!strcmp(tree->val.ident, "'\\''")) {
-        sym = '\'';
-    } else if (!strcmp(tree->val.ident, "'\\0'")) {
-        sym = '\0';
-    }
-
-    if (sym == -1) {
-        fprintf(out, "\n\t; pushing character\n"
-                     "\tpush\t%s\n",
-                     tree->val.ident);
+static int next_free_label(Context* ctx) {
+    return ctx->label++;
+}
+
+static const char* label_function(Walk* walk) {
+    const Scope* scope = ((const TreeGen*)walk->pass)->scope;
+    return ident_name(walk->ctx, scope->fun->name);
+}
+
+static void write_jump(Context* ctx, const char* jump, const char* fun, int label) {
+    emit(ctx, jump);
+    emit_label(ctx, fun, label);
+    EMIT(ctx, "\n");
+}
+
+static void write_label(Context* ctx, const char* fun, int label) {
+    EMIT(ctx, "\t");
+    emit_label(ctx, fun, label);
+    EMIT(ctx, ":\n");
+}
+
+static int write_cmp(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    node_t tree = frame->node;
+    node_t right = SECONDCHILD(ctx, tree);
+    if (frame->step == 0) {
+        visit_node(walk, FIRSTCHILD(ctx, tree));
+        return 0;
+    }
+    if (frame->step == 1 && NODE_LABEL(ctx, right) != Num) {
+        visit_node(walk, right);
+        return 0;
+    }
+
+    emit_comment(ctx, COMMENTS_FULL, "loading values to compare them");
+    if (NODE_LABEL(ctx, right) != Num) {
+        pop_top(walk, "rcx");
+    }
+    pop_top(walk, "rax");
+
+    emit_comment(ctx, COMMENTS_FULL, "comparaison (%s)",
+                 ident_name(ctx, NODE_VAL(ctx, tree).ident));
+    EMIT(ctx, "\tcmp \trax, ");
+    if (NODE_LABEL(ctx, right) == Num) {
+        emit_int(ctx, NODE_VAL(ctx, right).num);
     } else {
-        fprintf(out, "\n\t; pushing character\n"
-                     "\tpush\t%d\n",
-                     sym);
+        EMIT(ctx, "rcx");
+    }
+    EMIT(ctx, "\n");
+    return 1;
+}
+
+static void write_comp(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    node_t tree = frame->node;
+    if (!write_cmp(walk, frame)) {
+        return;
+    }
+
+    // the flags give the value without a jump
+    emit(ctx, get_comp_op(ident_name(ctx, NODE_VAL(ctx, tree).ident))->set);
+    EMIT(ctx, "\tmovzx\teax, al\n");
+    keep_top(walk);
+}
+
+static void write_bool_transform(Walk* walk) {
+    Context* ctx = walk->ctx;
+    emit_comment(ctx, COMMENTS_FULL, "transform output to correct format");
+    pop_top(walk, "rax");
+    EMIT(ctx, "\ttest\trax, rax\n"
+              "\tsetne\tal\n"
+              "\tmovzx\teax, al\n");
+    keep_top(walk);
+}
+
+static bool is_boolean(Context* ctx, node_t node) {
+    switch (NODE_LABEL(ctx, node)) {
+        case Eq: case Order: case And: case Or: case Negation:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void write_strict_logic(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    node_t tree = frame->node;
+    node_t left = FIRSTCHILD(ctx, tree);
+    node_t right = SECONDCHILD(ctx, tree);
+    bool is_and = NODE_LABEL(ctx, tree) == And;
+
+    switch (frame->step) {
+        case 0:
+            emit_comment(ctx, COMMENTS_BRIEF, "begin evaluation of an '%s' "
+                         "without jumps", is_and ? "and (&&)": "or (||)");
+            visit_node(walk, left);
+            return;
+        case 1:
+            if (is_and && !is_boolean(ctx, left)) {
+                write_bool_transform(walk);
+            }
+            visit_node(walk, right);
+            return;
+        default:
+            if (is_and && !is_boolean(ctx, right)) {
+                write_bool_transform(walk);
+            }
+            emit_comment(ctx, COMMENTS_FULL, "combination of both members");
+            pop_top(walk, "rcx");
+            pop_top(walk, "rax");
+            if (is_and) {
+                EMIT(ctx, "\tand \trax, rcx\n");
+            } else {
+                EMIT(ctx, "\tor  \trax, rcx\n");
+            }
+            keep_top(walk);
+            if (!is_and && !(is_boolean(ctx, left) && is_boolean(ctx, right))) {
+                write_bool_transform(walk);
+            }
+    }
+}
+
+static void write_and(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    TreeGen* gen = walk->pass;
+    node_t tree = frame->node;
+    const char* fun = label_function(walk);
+    // labels are kept in the frame between the steps
+    int* nfalse = &frame->data[0];
+    int* ncontinue = &frame->data[1];
+
+    if (frame->step == 0) {
+        // the right member is skipped only when evaluating it for nothing
+        // could be seen, or could trap
+        if (!has_side_effect(&gen->effects, SECONDCHILD(ctx, tree))) {
+            *nfalse = NO_LABEL;
+        } else {
+            *nfalse = next_free_label(ctx);
+            *ncontinue = next_free_label(ctx);
+        }
+    }
+    if (*nfalse == NO_LABEL) {
+        write_strict_logic(walk, frame);
+        return;
+    }
+
+    switch (frame->step) {
+        case 0:
+            emit_comment(ctx, COMMENTS_BRIEF, "begin evaluation of an 'and' (&&)");
+            emit_comment(ctx, COMMENTS_FULL, "evaluation of the left member");
+            // both ends share the state of the stack
+            flush_top(walk);
+
+            // a zero left member is the value of the expression
+            visit_condition(walk, FIRSTCHILD(ctx, tree), *nfalse, false);
+            return;
+        case 1:
+            end_condition(walk, FIRSTCHILD(ctx, tree), *nfalse, false);
+            visit_node(walk, SECONDCHILD(ctx, tree));
+            return;
+        default:
+            if (!is_boolean(ctx, SECONDCHILD(ctx, tree))) {
+                write_bool_transform(walk);
+            }
+            pop_top(walk, "rax");
+            write_jump(ctx, "\tjmp \t", fun, *ncontinue);
+            write_label(ctx, fun, *nfalse);
+            EMIT(ctx, "\tmov \trax, 0\n");
+            write_label(ctx, fun, *ncontinue);
+            keep_top(walk);
+    }
+}
+
+static void write_or(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    TreeGen* gen = walk->pass;
+    node_t tree = frame->node;
+    const char* fun = label_function(walk);
+    int* ntrue = &frame->data[0];
+    int* ncontinue = &frame->data[1];
+
+    if (frame->step == 0) {
+        if (!has_side_effect(&gen->effects, SECONDCHILD(ctx, tree))) {
+            *ntrue = NO_LABEL;
+        } else {
+            *ntrue = next_free_label(ctx);
+            *ncontinue = next_free_label(ctx);
+        }
+    }
+    if (*ntrue == NO_LABEL) {
+        write_strict_logic(walk, frame);
+        return;
+    }
+
+    switch (frame->step) {
+        case 0:
+            emit_comment(ctx, COMMENTS_BRIEF, "begin evaluation of an 'or' (||)");
+            emit_comment(ctx, COMMENTS_FULL, "evaluation of the left member");
+            // both ends share the state of the stack
+            flush_top(walk);
+
+            // a non-zero left member makes the expression true
+            visit_condition(walk, FIRSTCHILD(ctx, tree), *ntrue, true);
+            return;
+        case 1:
+            end_condition(walk, FIRSTCHILD(ctx, tree), *ntrue, true);
+            visit_node(walk, SECONDCHILD(ctx, tree));
+            return;
+        default:
+            if (!is_boolean(ctx, SECONDCHILD(ctx, tree))) {
+                write_bool_transform(walk);
+            }
+            pop_top(walk, "rax");
+            write_jump(ctx, "\tjmp \t", fun, *ncontinue);
+            write_label(ctx, fun, *ntrue);
+            EMIT(ctx, "\tmov \trax, 1\n");
+            write_label(ctx, fun, *ncontinue);
+            keep_top(walk);
+    }
+}
+
+static void write_neg(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    if (frame->step == 0) {
+        emit_comment(ctx, COMMENTS_BRIEF, "begin evaluating a 'not' (!)");
+        visit_node(walk, FIRSTCHILD(ctx, frame->node));
+        return;
+    }
+
+    emit_comment(ctx, COMMENTS_FULL, "evaluation of the 'not' (!)");
+    pop_top(walk, "rax");
+    EMIT(ctx, "\ttest\trax, rax\n"
+              "\tsete\tal\n"
+              "\tmovzx\teax, al\n");
+    keep_top(walk);
+}
+
+static bool is_jumping(Context* ctx, node_t node) {
+    switch (NODE_LABEL(ctx, node)) {
+        case Eq: case Order: case And: case Or: case Negation: case Num:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void visit_condition(Walk* walk, node_t node, int label, bool if_true) {
+    TreeGen* gen = walk->pass;
+    if (is_jumping(walk->ctx, node)) {
+        // taken by the first step of the node
+        gen->jumping = true;
+        gen->jump_label = label;
+        gen->jump_if_true = if_true;
+    }
+    visit_node(walk, node);
+}
+
+static void end_condition(Walk* walk, node_t node, int label, bool if_true) {
+    Context* ctx = walk->ctx;
+    if (is_jumping(ctx, node)) {
+        return;
     }
+    pop_top(walk, "rax");
+    EMIT(ctx, "\ttest\trax, rax\n");
+    write_jump(ctx, if_true ? "\tjne \t": "\tje  \t", label_function(walk), label);
+}
 
+static void write_jumps(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    node_t tree = frame->node;
+    node_t left = FIRSTCHILD(ctx, tree);
+    const char* fun = label_function(walk);
+    int label = frame->data[0];
+    int* nskip = &frame->data[1];
+    bool if_true = frame->data[2] == JUMP_IF_TRUE;
+
+    // a true left member decides a '||', a false one an '&&'
+    bool decides = NODE_LABEL(ctx, tree) == Or;
+    int left_label = if_true == decides ? label: *nskip;
+    switch (NODE_LABEL(ctx, tree)) {
+        case Num:
+            if ((NODE_VAL(ctx, tree).num != 0) == if_true) {
+                write_jump(ctx, "\tjmp \t", fun, label);
+            }
+            break;
+        case Negation:
+            if (frame->step == 0) {
+                visit_condition(walk, left, label, !if_true);
+            } else {
+                end_condition(walk, left, label, !if_true);
+            }
+            break;
+        case Eq:
+        case Order:
+            if (write_cmp(walk, frame)) {
+                const comp_op* op = get_comp_op(ident_name(ctx, NODE_VAL(ctx, tree).ident));
+                EMIT(ctx, "\t");
+                emit(ctx, if_true ? op->instr: op->inverse);
+                write_jump(ctx, " \t", fun, label);
+            }
+            break;
+        case And:
+        case Or:
+            switch (frame->step) {
+                case 0:
+                    // the left member jumps over the right one when it
+                    // decides the opposite of the jump
+                    if (if_true != decides) {
+                        left_label = *nskip = next_free_label(ctx);
+                    }
+                    emit_comment(ctx, COMMENTS_BRIEF, "condition with an '%s'",
+                                 decides ? "or (||)": "and (&&)");
+                    visit_condition(walk, left, left_label, decides);
+                    return;
+                case 1:
+                    end_condition(walk, left, left_label, decides);
+                    visit_condition(walk, SECONDCHILD(ctx, tree), label, if_true);
+                    return;
+                default:
+                    end_condition(walk, SECONDCHILD(ctx, tree), label, if_true);
+                    if (if_true != decides) {
+                        write_label(ctx, fun, *nskip);
+                    }
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static void write_if(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    node_t tree = frame->node;
+    const char* fun = label_function(walk);
+    int* ncontinue = &frame->data[0];
+    int* nelse = &frame->data[1];
+
+    switch (frame->step) {
+        case 0:
+            *ncontinue = next_free_label(ctx);
+            *nelse = next_free_label(ctx);
+
+            emit_comment(ctx, COMMENTS_BRIEF, "begin evaluation of an 'if'\n"
+                         "\t; .L%s_%d -> code after the condition\n"
+                         "\t; .L%s_%d -> code of else",
+                         fun, *ncontinue, fun, *nelse);
+
+            // the condition jumps to the else when false
+            visit_condition(walk, FIRSTCHILD(ctx, tree), *nelse, false);
+            return;
+        case 1:
+            emit_comment(ctx, COMMENTS_FULL, "evaluation of the 'if' condition");
+            end_condition(walk, FIRSTCHILD(ctx, tree), *nelse, false);
+
+            // instruction inside the if
+            visit_node(walk, SECONDCHILD(ctx, tree));
+            return;
+        case 2:
+            write_jump(ctx, "\tjmp \t", fun, *ncontinue);
+            write_label(ctx, fun, *nelse);
+
+            // instruction inside the else
+            visit_list(walk, instructions_head(ctx, THIRDCHILD(ctx, tree)));
+            return;
+        default:
+            write_label(ctx, fun, *ncontinue);
+    }
 }
 
-static void write_tree(const Table* globals, const FunctionCollection* collection,
-                       const Function* fun, const Node* tree) {
-    if (!tree) return;
-    
-    switch (tree->label) {
-        case SuiteInstr: write_instructions(globals, collection, fun, FIRSTCHILD(tree)); return;
-        case Assignation: write_assign(globals, collection, fun, tree); return;
-        case Ident: write_load_ident(globals, collection, fun, tree); return;
-        case Num: write_num(tree); return;
-        case Character: write_character(tree); return;
+static void write_while(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    node_t tree = frame->node;
+    const char* fun = label_function(walk);
+    int* ncondition = &frame->data[0];
+    int* nbody = &frame->data[1];
+
+    switch (frame->step) {
+        case 0:
+            *ncondition = next_free_label(ctx);
+            *nbody = next_free_label(ctx);
+
+            emit_comment(ctx, COMMENTS_BRIEF, "begin evaluating a 'while'\n"
+                         "\t; .L%s_%d -> condition of the loop\n"
+                         "\t; .L%s_%d -> body of the loop",
+                         fun, *ncondition, fun, *nbody);
+            // the condition is written after the body, so that each turn
+            // takes a single jump
+            write_jump(ctx, "\tjmp \t", fun, *ncondition);
+            write_label(ctx, fun, *nbody);
+
+            // write while code
+            visit_list(walk, instructions_head(ctx, SECONDCHILD(ctx, tree)));
+            return;
+        case 1:
+            write_label(ctx, fun, *ncondition);
+            visit_condition(walk, FIRSTCHILD(ctx, tree), *nbody, true);
+            return;
+        default:
+            emit_comment(ctx, COMMENTS_FULL, "evaluation of the 'while' condition");
+            end_condition(walk, FIRSTCHILD(ctx, tree), *nbody, true);
+    }
+}
+
+static void write_num(Walk* walk, node_t tree) {
+    Context* ctx = walk->ctx;
+    flush_top(walk);
+    emit_comment(ctx, COMMENTS_FULL, "pushing integer");
+    EMIT(ctx, "\tmov \trax, ");
+    emit_int(ctx, NODE_VAL(ctx, tree).num);
+    EMIT(ctx, "\n");
+    keep_top(walk);
+}
+
+static int write_tree(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    TreeGen* gen = walk->pass;
+    node_t tree = frame->node;
+    if (gen->jumping) {
+        // first step of a condition visited by its 'if', 'while' or
+        // logical operator
+        gen->jumping = false;
+        frame->data[0] = gen->jump_label;
+        frame->data[2] = gen->jump_if_true ? JUMP_IF_TRUE: JUMP_IF_FALSE;
+    }
+    if (frame->data[2] != AS_VALUE) {
+        write_jumps(walk, frame);
+        return 1;
+    }
+    switch (NODE_LABEL(ctx, tree)) {
+        case SuiteInstr:
+            // a nested bloc is visited as one of the instructions
+            if (frame->step == 0) {
+                visit_list(walk, FIRSTCHILD(ctx, tree));
+            }
+            break;
+        case Else:
+            if (frame->step == 0) {
+                visit_list(walk, instructions_head(ctx, FIRSTCHILD(ctx, tree)));
+            }
+            break;
+        case Assignation: write_assign(walk, frame); break;
+        case Ident: write_load_ident(walk, frame); break;
+        case Num: write_num(walk, tree); break;
         case DivStar:
-        case AddSub: write_arithmetic(globals, collection, fun, tree); return;
-        case Return: write_return(globals, collection, fun, tree); return;
+        case AddSub: write_arithmetic(walk, frame); break;
+        case Return: write_return(walk, frame); break;
         case Order:
-        case Eq: write_comp(globals, collection, fun, tree); return;
-        case And: write_and(globals, collection, fun, tree); return;
-        case Or: write_or(globals, collection, fun, tree); return;
-        case Negation: write_neg(globals, collection, fun, tree); return;
-        case If: write_if(globals, collection, fun, tree); return;
-        case Else: write_instructions(globals, collection, fun, FIRSTCHILD(tree)); return;
-        case While: write_while(globals, collection, fun, tree); return;
-        default: return;
+        case Eq: write_comp(walk, frame); break;
+        case And: write_and(walk, frame); break;
+        case Or: write_or(walk, frame); break;
+        case Negation: write_neg(walk, frame); break;
+        case If: write_if(walk, frame); break;
+        case While: write_while(walk, frame); break;
+        default: break;
     }
+    return 1;
 }
 
-static void write_instructions(const Table* globals, const FunctionCollection* collection,
-                               const Function* fun, const Node* tree) {
-    if (!tree) return;
-    if (tree->label == SuiteInstr) {
-        tree = FIRSTCHILD(tree);
+static node_t instructions_head(Context* ctx, node_t tree) {
+    if (tree && NODE_LABEL(ctx, tree) == SuiteInstr) {
+        return FIRSTCHILD(ctx, tree);
     }
+    return tree;
+}
 
-    for (; tree;) {
-        write_tree(globals, collection, fun, tree);
-        tree = tree->nextSibling;
+static void write_task(Codegen* gen, Context* ctx, int task) {
+    int first = (long)gen->nb_functions * task / gen->nb_tasks;
+    int last = (long)gen->nb_functions * (task + 1) / gen->nb_tasks;
+    for (int i = first; i < last; i++) {
+        write_function_node(ctx, gen->globals, gen->collection, gen->functions[i]);
     }
 }
 
-static void write_functions(const Table* globals, const FunctionCollection* collection, const Node* tree) {
-    Node* decl_fonct_node = FIRSTCHILD(SECONDCHILD(tree)), *head_instr;
-    Function* fun;
+static void* write_tasks(void* gen) {
+    Codegen* g = gen;
+    // nodes, names and symbols are only read, the output and labels are
+    // those of the thread
+    Context ctx = *g->ctx;
+    ctx.stats = (Stats){0};
+    EmitBuffer buffer;
+    open_emitter(&ctx, &buffer);
+    int task;
+    while ((task = atomic_fetch_add(&g->next, 1)) < g->nb_tasks) {
+        if (!(ctx.out = open_memstream(&g->nasm[task], &g->lens[task]))) {
+            g->nasm[task] = NULL; // written once the threads are over
+            continue;
+        }
+        write_task(g, &ctx, task);
+        flush_emitter(&ctx);
+        fclose(ctx.out);
+    }
+    pthread_mutex_lock(&g->lock);
+    g->stats.cache_hits += ctx.stats.cache_hits;
+    g->stats.cache_misses += ctx.stats.cache_misses;
+    g->stats.cache_read_bytes += ctx.stats.cache_read_bytes;
+    for (int i = 0; i < NB_PEEPHOLE_RULES; i++) {
+        g->stats.peephole_rules[i] += ctx.stats.peephole_rules[i];
+    }
+    pthread_mutex_unlock(&g->lock);
+    return NULL;
+}
 
-    for (; decl_fonct_node != NULL;) {
-        fun = get_function(collection,
-                           SECONDCHILD(FIRSTCHILD(decl_fonct_node))->val.ident);
-        
-        head_instr = FIRSTCHILD(SECONDCHILD(SECONDCHILD(decl_fonct_node)));
-        write_function(fun);
+static void write_functions_parallel(Context* ctx, Codegen* gen, int jobs) {
+    // the current thread is one of the jobs
+    pthread_t* threads = malloc((jobs - 1) * sizeof(pthread_t));
+    int nb_threads = 0;
+    for (; threads && nb_threads < jobs - 1; nb_threads++) {
+        if (pthread_create(&threads[nb_threads], NULL, write_tasks, gen)) {
+            break;
+        }
+    }
+    write_tasks(gen);
+    for (int i = 0; i < nb_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+    for (int task = 0; task < gen->nb_tasks; task++) {
+        if (!gen->nasm[task]) {
+            write_task(gen, ctx, task);
+        } else {
+            emit_bytes(ctx, gen->nasm[task], gen->lens[task]);
+            free(gen->nasm[task]);
+        }
+    }
+    ctx->stats.cache_hits += gen->stats.cache_hits;
+    ctx->stats.cache_misses += gen->stats.cache_misses;
+    ctx->stats.cache_read_bytes += gen->stats.cache_read_bytes;
+    for (int i = 0; i < NB_PEEPHOLE_RULES; i++) {
+        ctx->stats.peephole_rules[i] += gen->stats.peephole_rules[i];
+    }
+}
+
+static void write_functions(Context* ctx, const Table* globals,
+                            const FunctionCollection* collection, node_t tree) {
+    node_t first = FIRSTCHILD(ctx, SECONDCHILD(ctx, tree));
+    Codegen gen = {.ctx = ctx, .globals = globals, .collection = collection};
+    for (node_t node = first; node != NO_NODE; node = NEXTSIBLING(ctx, node)) {
+        gen.nb_functions++;
+    }
+    gen.nb_tasks = ctx->jobs * TASKS_PER_JOB;
+    if (gen.nb_tasks > gen.nb_functions) {
+        gen.nb_tasks = gen.nb_functions;
+    }
+
+    // the cache is opened before the threads share it
+    // the IR is printed in the order of the functions
+    if (ctx->jobs > 1 && gen.nb_functions > 1 && !ctx->dump_ir
+        && (!ctx->cache_dir || ctx->cache || open_cache(ctx))
+        && (gen.functions = malloc(gen.nb_functions * sizeof(node_t)))
+        && (gen.nasm = calloc(gen.nb_tasks, sizeof(char*)))
+        && (gen.lens = calloc(gen.nb_tasks, sizeof(size_t)))) {
+        int i = 0;
+        for (node_t node = first; node != NO_NODE; node = NEXTSIBLING(ctx, node)) {
+            gen.functions[i++] = node;
+        }
+        atomic_init(&gen.next, 0);
+        pthread_mutex_init(&gen.lock, NULL);
+        write_functions_parallel(ctx, &gen, ctx->jobs);
+        pthread_mutex_destroy(&gen.lock);
+    } else {
+        for (node_t node = first; node != NO_NODE; node = NEXTSIBLING(ctx, node)) {
+            write_function_node(ctx, globals, collection, node);
+        }
+    }
+    free(gen.functions);
+    free(gen.nasm);
+    free(gen.lens);
+}
+
+void gen_nasm(Context* ctx, FILE* out, const Table* globals,
+              const FunctionCollection* collection, node_t tree) {
+    EmitBuffer buffer;
+    ctx->out = out;
+    open_emitter(ctx, &buffer);
+    write_init(ctx, globals->total_bytes);
+    write_functions(ctx, globals, collection, tree);
+    write_buitlins(ctx, collection);
+    close_emitter(ctx);
+}
+
+void gen_nasm_init(Context* ctx, FILE* out, const Table* globals,
+                   const FunctionCollection* collection) {
+    EmitBuffer buffer;
+    ctx->out = out;
+    open_emitter(ctx, &buffer);
+    write_init(ctx, globals->total_bytes);
+    close_emitter(ctx);
+}
+
+void gen_nasm_end(Context* ctx, const FunctionCollection* collection) {
+    EmitBuffer buffer;
+    open_emitter(ctx, &buffer);
+    write_buitlins(ctx, collection);
+    close_emitter(ctx);
+}
+
+static int write_function_ir(Context* ctx, const Scope* scope, node_t node) {
+    IrFunction ir;
+    char why[128];
+    int res = build_ir(ctx, scope, node, &ir);
+    if (res && !(res = verify_ir(&ir, why, sizeof(why)))) {
+        fprintf(ctx->err, "invalid IR of '%s': %s\n",
+                ident_name(ctx, scope->fun->name), why);
+    }
+    RegAlloc alloc = {0};
+    // a function whose registers cannot be allocated is generated from its
+    // tree
+    if (res && (res = allocate_registers(&ir, &alloc))) {
+        write_ir_function(ctx, &ir, &alloc);
+    }
+    free_regalloc(&alloc);
+    free_ir(&ir);
+    return res;
+}
+
+static void dump_function_ir(Context* ctx, const Scope* scope, node_t node) {
+    IrFunction ir;
+    if (build_ir(ctx, scope, node, &ir)) {
+        print_ir(ctx, &ir);
+    }
+    free_ir(&ir);
+}
 
-        write_instructions(globals, collection, fun, head_instr);
-        write_function_exit();
-        
-        decl_fonct_node = decl_fonct_node->nextSibling;
+static void generate_function_code(Context* ctx, const Scope* scope, node_t node) {
+    if (ctx->codegen == CODEGEN_IR && write_function_ir(ctx, scope, node)) {
+        return;
+    }
+    node_t head_instr = FIRSTCHILD(ctx, SECONDCHILD(ctx, SECONDCHILD(ctx, node)));
+    Walk walk;
+    TreeGen gen = {.scope = scope, .cached = false};
+
+    init_walk(&walk, ctx, write_tree, &gen);
+    init_traps(&gen.effects, ctx);
+    ctx->label = 0;
+    write_function(ctx, scope->fun);
+
+    walk_tree(&walk, instructions_head(ctx, head_instr));
+    if (!strcmp(ident_name(ctx, scope->fun->name), "main")) {
+        // main ending without a return exits with 0
+        EMIT(ctx, "\tmov \trax, 0\n");
     }
+    write_function_exit(ctx);
+    free_walk(&walk);
+    free_walk(&gen.effects);
 }
 
-void gen_nasm(char* output, const Table* globals, const FunctionCollection* collection, const Node* tree) {
-    if (!create_file(output)) {
+static void write_function_code(Context* ctx, const Scope* scope, node_t node) {
+    // the function is generated apart, then rewritten
+    FILE* out = ctx->out;
+    char* nasm;
+    size_t len;
+    flush_emitter(ctx);
+    ctx->out = open_memstream(&nasm, &len);
+    if (!ctx->out) {
+        ctx->out = out;
+        generate_function_code(ctx, scope, node);
         return;
     }
-    write_init(collection, globals->total_bytes);
-    write_functions(globals, collection, tree);
-    fclose(out);
+    generate_function_code(ctx, scope, node);
+    flush_emitter(ctx);
+    fclose(ctx->out);
+    ctx->out = out;
+
+    if (!write_peephole(ctx, nasm, len)) {
+        emit_bytes(ctx, nasm, len);
+    }
+    free(nasm);
+}
+
+static int write_cached_function(Context* ctx, const Scope* scope, node_t node) {
+    if (!ctx->cache && !open_cache(ctx)) {
+        return 0;
+    }
+    // labels are named after the function, so its nasm is written as cached
+    uint64_t key = function_key(ctx, scope, node);
+    size_t len;
+    const char* cached = cached_function(ctx, key, &len);
+    if (cached) {
+        ctx->stats.cache_hits++;
+        emit_bytes(ctx, cached, len);
+        return 1;
+    }
+
+    // generate the function apart to keep a copy of it
+    FILE* out = ctx->out;
+    char* nasm;
+    flush_emitter(ctx);
+    ctx->out = open_memstream(&nasm, &len);
+    if (!ctx->out) {
+        ctx->out = out;
+        return 0;
+    }
+    write_function_code(ctx, scope, node);
+    flush_emitter(ctx);
+    fclose(ctx->out);
+    ctx->out = out;
+
+    ctx->stats.cache_misses++;
+    cache_function(ctx, key, nasm, len);
+    emit_bytes(ctx, nasm, len);
+    free(nasm);
+    return 1;
+}
+
+static void write_function_node(Context* ctx, const Table* globals,
+                                const FunctionCollection* collection, node_t node) {
+    Function* fun = get_function(collection,
+                                 NODE_VAL(ctx, SECONDCHILD(ctx, FIRSTCHILD(ctx, node))).ident);
+    Scope scope = {.globals = globals, .collection = collection, .fun = fun};
+
+    if (ctx->dump_ir) {
+        dump_function_ir(ctx, &scope, node);
+    }
+    if (!ctx->cache_dir || !write_cached_function(ctx, &scope, node)) {
+        write_function_code(ctx, &scope, node);
+    }
+}
+
+void gen_nasm_function(Context* ctx, const Table* globals,
+                       const FunctionCollection* collection, node_t node) {
+    EmitBuffer buffer;
+    open_emitter(ctx, &buffer);
+    write_function_node(ctx, globals, collection, node);
+    close_emitter(ctx);
 }
@@ -0,0 +1,126 @@
+#include "intern.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "context.h"
+
+#define DEFAULT_IDENTS 64
+
+/**
+ * @brief Hash an identifier with FNV-1a
+ * 
+ * @param str identifier
+ * @param len length of the identifier
+ * @return hash
+ */
+static unsigned int hash_ident(const char* str, size_t len) {
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (unsigned char)str[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief Double the capacity of a table, keeping its buckets at most half
+ *        filled
+ * 
+ * @param table table to grow
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+static int grow_table(InternTable* table) {
+    int max_idents = table->max_idents ? table->max_idents*2: DEFAULT_IDENTS;
+    int nb_buckets = max_idents*2;
+
+    const char** names = realloc(table->names, sizeof(char*)*max_idents);
+    if (!names) {
+        return 0;
+    }
+    table->names = names;
+    unsigned int* hashes = realloc(table->hashes,
+                                   sizeof(unsigned int)*max_idents);
+    if (!hashes) {
+        return 0;
+    }
+    table->hashes = hashes;
+    ident_t* buckets = malloc(sizeof(ident_t)*nb_buckets);
+    if (!buckets) {
+        return 0;
+    }
+
+    // put back known identifiers in the new buckets
+    memset(buckets, -1, sizeof(ident_t)*nb_buckets);
+    for (ident_t id = 0; id < table->nb_idents; id++) {
+        unsigned int i = table->hashes[id] & (nb_buckets - 1);
+        while (buckets[i] != -1) {
+            i = (i + 1) & (nb_buckets - 1);
+        }
+        buckets[i] = id;
+    }
+    free(table->buckets);
+    table->buckets = buckets;
+    table->nb_buckets = nb_buckets;
+    table->max_idents = max_idents;
+    return 1;
+}
+
+void init_intern_table(InternTable* table) {
+    *table = (InternTable){.nb_idents  = 0,
+                           .max_idents = 0,
+                           .nb_buckets = 0,
+                           .names      = NULL,
+                           .hashes     = NULL,
+                           .buckets    = NULL};
+}
+
+ident_t intern(Context* ctx, const char* str, size_t len) {
+    InternTable* table = &ctx->idents;
+    unsigned int hash = hash_ident(str, len);
+
+    // look for the identifier
+    if (table->nb_buckets) {
+        unsigned int i = hash & (table->nb_buckets - 1);
+        for (ident_t id; (id = table->buckets[i]) != -1;
+             i = (i + 1) & (table->nb_buckets - 1)) {
+            if (table->hashes[id] == hash && !strncmp(table->names[id], str, len)
+                && !table->names[id][len]) {
+                return id;
+            }
+        }
+    }
+
+    // unknown identifier, copy its name in the arena
+    if (table->nb_idents == table->max_idents && !grow_table(table)) {
+        return -1;
+    }
+    char* name = arena_alloc(ctx->arena, len + 1);
+    if (!name) {
+        return -1;
+    }
+    memcpy(name, str, len);
+    name[len] = '\0';
+
+    ident_t id = table->nb_idents++;
+    table->names[id] = name;
+    table->hashes[id] = hash;
+    unsigned int i = hash & (table->nb_buckets - 1);
+    while (table->buckets[i] != -1) {
+        i = (i + 1) & (table->nb_buckets - 1);
+    }
+    table->buckets[i] = id;
+    return id;
+}
+
+const char* ident_name(const Context* ctx, ident_t id) {
+    return ctx->idents.names[id];
+}
+
+void free_intern_table(InternTable* table) {
+    free(table->names);
+    free(table->hashes);
+    free(table->buckets);
+    init_intern_table(table);
+}
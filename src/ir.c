@@ -0,0 +1,1331 @@
+#include "ir.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "errors.h"
+#include "ssa.h"
+#include "walk.h"
+
+#define INIT_LENGTH 8
+
+typedef struct {                // lowering of the tree of a function
+    Context* ctx;
+    IrFunction* ir;             // IR being built
+    const Scope* scope;         // symbols seen by the function
+    int block;                  // block the instructions are added to
+    vreg_t* values;             // values of the expressions lowered, kept as
+    int nb_values;              // the nasm of the tree keeps them on the
+    int max_values;             // stack
+    int* layout;                // blocks in the order they are started
+    int nb_layout;
+    int max_layout;
+    bool failed;                // if it ran out of memory
+} Lowering;
+
+typedef struct {
+    const char* symbol;
+    IrOp op;
+} CompOp;
+
+static const CompOp comparisons[] = {
+    {"==", IR_EQ}, {"!=", IR_NE}, {"<", IR_LT},
+    {"<=", IR_LE}, {">", IR_GT},  {">=", IR_GE},
+    {NULL, IR_NOP}
+};
+
+static const char* op_names[] = {
+    [IR_NOP] = "nop",   [IR_CONST] = "const", [IR_PARAM] = "param",
+    [IR_NEG] = "neg",   [IR_ADD] = "add",     [IR_SUB] = "sub",
+    [IR_MUL] = "mul",   [IR_DIV] = "div",     [IR_MOD] = "mod",
+    [IR_EQ] = "eq",     [IR_NE] = "ne",       [IR_LT] = "lt",
+    [IR_LE] = "le",     [IR_GT] = "gt",       [IR_GE] = "ge",
+    [IR_NOT] = "not",   [IR_BOOL] = "bool",   [IR_LOAD] = "load",
+    [IR_STORE] = "store", [IR_ADDR] = "addr", [IR_CALL] = "call",
+    [IR_PHI] = "phi",   [IR_JUMP] = "jump",   [IR_BRANCH] = "branch",
+    [IR_RET] = "ret"
+};
+
+/**
+ * @brief Grow an array by doubling its capacity, if it is full
+ *
+ * @param ctx compilation context
+ * @param array array to grow, NULL if not allocated yet
+ * @param max_len capacity of the array, updated once grown
+ * @param len number of elements in the array
+ * @param size size of an element
+ * @return the array, moved if grown
+ *         NULL if fail due to memory error
+ */
+static void* grow(Context* ctx, void* array, int* max_len, int len, size_t size);
+
+/**
+ * @brief Add an empty block to the function
+ *
+ * @param low lowering of the function
+ * @return index of the block, -1 if fail due to memory error
+ */
+static int add_block(Lowering* low);
+
+/**
+ * @brief Make a block the one the instructions are added to
+ *
+ * @param low lowering of the function
+ * @param block block to start
+ */
+static void start_block(Lowering* low, int block);
+
+/**
+ * @brief Tell if the current block already ends with its terminator
+ *
+ * @param low lowering of the function
+ * @return true if the code lowered now cannot be reached
+ */
+static bool block_ended(const Lowering* low);
+
+/**
+ * @brief Add an instruction at the end of the current block. The code after
+ *        a terminator goes to a new block, which nothing jumps to
+ *
+ * @param low lowering of the function
+ * @param op operation of the instruction
+ * @return instruction, valid until the next one is added
+ *         NULL if fail due to memory error
+ */
+static IrInstr* add_instr(Lowering* low, IrOp op);
+
+/**
+ * @brief Add an instruction defining a new register
+ *
+ * @param low lowering of the function
+ * @param op operation of the instruction
+ * @param a first operand
+ * @param b second operand
+ * @return defined register, NO_VREG if fail due to memory error
+ */
+static vreg_t add_value(Lowering* low, IrOp op, vreg_t a, vreg_t b);
+
+/**
+ * @brief Add a constant
+ *
+ * @param low lowering of the function
+ * @param imm value of the constant
+ * @return defined register, NO_VREG if fail due to memory error
+ */
+static vreg_t add_const(Lowering* low, long imm);
+
+/**
+ * @brief Add an instruction using a variable
+ *
+ * @param low lowering of the function
+ * @param op IR_LOAD, IR_STORE, IR_ADDR or IR_PARAM
+ * @param var variable
+ * @param a first operand
+ * @param b second operand
+ * @return defined register for loads, addresses and parameters
+ *         NO_VREG for stores, or if fail due to memory error
+ */
+static vreg_t add_access(Lowering* low, IrOp op, int var, vreg_t a, vreg_t b);
+
+/**
+ * @brief Add an edge between two blocks
+ *
+ * @param low lowering of the function
+ * @param from block ended by a jump or a branch
+ * @param to block jumped to
+ */
+static void add_edge(Lowering* low, int from, int to);
+
+/**
+ * @brief End the current block by a jump, unless it cannot be reached
+ *
+ * @param low lowering of the function
+ * @param target block jumped to
+ */
+static void add_jump(Lowering* low, int target);
+
+/**
+ * @brief End the current block by a branch, unless it cannot be reached
+ *
+ * @param low lowering of the function
+ * @param cond register tested
+ * @param if_true block jumped to if cond is not 0
+ * @param if_false block jumped to if cond is 0
+ */
+static void add_branch(Lowering* low, vreg_t cond, int if_true, int if_false);
+
+/**
+ * @brief End the current block by a return, unless it cannot be reached
+ *
+ * @param low lowering of the function
+ * @param value returned register, NO_VREG to return nothing
+ */
+static void add_ret(Lowering* low, vreg_t value);
+
+/**
+ * @brief Push the value of an expression
+ *
+ * @param low lowering of the function
+ * @param value register holding the value
+ */
+static void push_value(Lowering* low, vreg_t value);
+
+/**
+ * @brief Pop the value of the last expression lowered
+ *
+ * @param low lowering of the function
+ * @return register holding the value, NO_VREG if none
+ */
+static vreg_t pop_value(Lowering* low);
+
+/**
+ * @brief Add a variable to the function
+ *
+ * @param low lowering of the function
+ * @param var variable to add
+ * @return index of the variable, -1 if fail due to memory error
+ */
+static int add_var(Lowering* low, IrVar var);
+
+/**
+ * @brief Add the parameters and locals of the function, and set the
+ *        promoted ones at the start of the entry block: the parameters to
+ *        their value and the locals to 0
+ *
+ * @param low lowering of the function
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+static int declare_vars(Lowering* low);
+
+/**
+ * @brief Find the variable named by an identifier, searched in locals,
+ *        parameters then globals as in the nasm of the tree. Globals are
+ *        added once used
+ *
+ * @param low lowering of the function
+ * @param ident identifier
+ * @return index of the variable, -1 if the identifier names a function or
+ *         if fail due to memory error
+ */
+static int find_var(Lowering* low, ident_t ident);
+
+/**
+ * @brief Lower an assignation, its value before the index of an array
+ *
+ * @param walk walk lowering the function
+ * @param frame frame of the node with the 'Assignation' label
+ */
+static void lower_assign(Walk* walk, Frame* frame);
+
+/**
+ * @brief Lower a function call, its arguments from the last one
+ *
+ * @param walk walk lowering the function
+ * @param frame frame of the node with the 'Ident' label, the name of the
+ *              function
+ */
+static void lower_call(Walk* walk, Frame* frame);
+
+/**
+ * @brief Lower the value of an identifier, a variable, an element of an
+ *        array, the address of an array or a function call
+ *
+ * @param walk walk lowering the function
+ * @param frame frame of the node with the 'Ident' label
+ */
+static void lower_ident(Walk* walk, Frame* frame);
+
+/**
+ * @brief Lower an operation of the 'AddSub' or 'DivStar' label
+ *
+ * @param walk walk lowering the function
+ * @param frame frame of the node
+ */
+static void lower_arithmetic(Walk* walk, Frame* frame);
+
+/**
+ * @brief Lower a comparison of the 'Order' or 'Eq' label
+ *
+ * @param walk walk lowering the function
+ * @param frame frame of the node
+ */
+static void lower_comp(Walk* walk, Frame* frame);
+
+/**
+ * @brief Lower the lazy evaluation of an 'and' (&&) or an 'or' (||). The
+ *        result is kept in a temporary variable, set before the right
+ *        member is evaluated and once it is
+ *
+ * @param walk walk lowering the function
+ * @param frame frame of the node with the 'And' or 'Or' label
+ */
+static void lower_logic(Walk* walk, Frame* frame);
+
+/**
+ * @brief Lower a negation
+ *
+ * @param walk walk lowering the function
+ * @param frame frame of the node with the 'Negation' label
+ */
+static void lower_not(Walk* walk, Frame* frame);
+
+/**
+ * @brief Lower a return, with a value only in a function returning one
+ *
+ * @param walk walk lowering the function
+ * @param frame frame of the node with the 'Return' label
+ */
+static void lower_return(Walk* walk, Frame* frame);
+
+/**
+ * @brief Lower an 'if' statement and its optional 'else'
+ *
+ * @param walk walk lowering the function
+ * @param frame frame of the node with the 'If' label
+ */
+static void lower_if(Walk* walk, Frame* frame);
+
+/**
+ * @brief Lower a 'while' statement
+ *
+ * @param walk walk lowering the function
+ * @param frame frame of the node with the 'While' label
+ */
+static void lower_while(Walk* walk, Frame* frame);
+
+/**
+ * @brief Lower each instruction of a function. Visit of the walk over the
+ *        instructions of a function
+ *
+ * @param walk walk lowering the instructions, with the 'Lowering'
+ * @param frame frame of the node to lower
+ * @return 0 if it ran out of memory, 1 otherwise
+ */
+static int lower_tree(Walk* walk, Frame* frame);
+
+/**
+ * @brief Get the first instruction of a bloc of instructions
+ *
+ * @param ctx compilation context
+ * @param tree bloc, or first instruction
+ * @return first instruction to lower
+ */
+static node_t instructions_head(Context* ctx, node_t tree);
+
+/**
+ * @brief Number the blocks of a function in the order of a depth-first walk
+ *        of its dominator tree, once entered and once left, so that a block
+ *        dominates the blocks numbered within its own numbers
+ *
+ * @param ir IR of the function, whose blocks are all reached
+ * @param order set to the number of each block once entered and once left
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+static int number_dominators(const IrFunction* ir, int* order);
+
+/**
+ * @brief Tell if a block dominates another one
+ *
+ * @param order numbers of the blocks in the dominator tree
+ * @param dom dominating block
+ * @param block dominated block
+ * @return true if each path from the entry to block goes through dom
+ */
+static bool dominates(const int* order, int dom, int block);
+
+/**
+ * @brief Check the operands of an instruction, which need their register
+ *        and a variable for memory accesses
+ *
+ * @param ir IR of the function
+ * @param instr instruction to check
+ * @return true if the instruction has the operands of its operation
+ */
+static bool has_operands(const IrFunction* ir, const IrInstr* instr);
+
+/**
+ * @brief Check that a register is defined before a use, in a block
+ *        dominating it
+ *
+ * @param ir IR of the function
+ * @param order numbers of the blocks in the dominator tree
+ * @param defs block and index defining each register, -1 if not defined
+ * @param reg used register
+ * @param block block of the use
+ * @param index index of the use in its block, or the end of the block for
+ *              the operands of phis
+ * @return true if the definition dominates the use
+ */
+static bool defined_before(const IrFunction* ir, const int* order,
+                           const int* defs, vreg_t reg, int block, int index);
+
+/**
+ * @brief Check the control flow of a function: each block ends with its
+ *        single terminator, with the successors of its operation and with
+ *        its phis first, and the predecessors match the successors
+ *
+ * @param ir IR to check
+ * @param why set to the first broken rule, if any
+ * @param size size of why
+ * @return 1 if the control flow is well formed
+ *         0 else
+ */
+static int verify_blocks(const IrFunction* ir, char* why, size_t size);
+
+/**
+ * @brief Check the registers of a function: each one is defined once,
+ *        before its uses
+ *
+ * @param ir IR to check, whose control flow is well formed
+ * @param why set to the first broken rule, if any
+ * @param size size of why
+ * @return 1 if the registers are well formed
+ *         0 else
+ */
+static int verify_registers(const IrFunction* ir, char* why, size_t size);
+
+/**
+ * @brief Print a variable accessed by an instruction
+ *
+ * @param ctx compilation context
+ * @param ir IR of the function
+ * @param var index of the variable
+ */
+static void print_var(Context* ctx, const IrFunction* ir, int var);
+
+/**
+ * @brief Print an instruction
+ *
+ * @param ctx compilation context
+ * @param ir IR of the function
+ * @param instr instruction to print
+ */
+static void print_instr(Context* ctx, const IrFunction* ir, const IrInstr* instr);
+
+
+static void* grow(Context* ctx, void* array, int* max_len, int len, size_t size) {
+    if (array && len < *max_len) {
+        return array;
+    }
+    int next_len = *max_len ? *max_len * 2: INIT_LENGTH;
+    void* temp = realloc(array, next_len * size);
+    if (!temp) {
+        memory_error(ctx);
+        return NULL;
+    }
+    *max_len = next_len;
+    return temp;
+}
+
+static int add_block(Lowering* low) {
+    IrFunction* ir = low->ir;
+    IrBlock* blocks = grow(low->ctx, ir->blocks, &ir->max_blocks,
+                           ir->nb_blocks, sizeof(IrBlock));
+    if (!blocks) {
+        low->failed = true;
+        return -1;
+    }
+    ir->blocks = blocks;
+    blocks[ir->nb_blocks] = (IrBlock){.idom = -1};
+    return ir->nb_blocks++;
+}
+
+static void start_block(Lowering* low, int block) {
+    int* layout = grow(low->ctx, low->layout, &low->max_layout, low->nb_layout,
+                       sizeof(int));
+    if (!layout) {
+        low->failed = true;
+        return;
+    }
+    low->layout = layout;
+    layout[low->nb_layout++] = block;
+    low->block = block;
+}
+
+static bool block_ended(const Lowering* low) {
+    const IrBlock* block = &low->ir->blocks[low->block];
+    return block->nb_instrs && is_terminator(block->instrs[block->nb_instrs - 1].op);
+}
+
+static IrInstr* add_instr(Lowering* low, IrOp op) {
+    if (low->failed) {
+        return NULL;
+    }
+    if (block_ended(low)) {
+        int block = add_block(low);
+        if (block == -1) {
+            return NULL;
+        }
+        start_block(low, block);
+    }
+    IrBlock* block = &low->ir->blocks[low->block];
+    IrInstr* instrs = grow(low->ctx, block->instrs, &block->max_instrs,
+                           block->nb_instrs, sizeof(IrInstr));
+    if (!instrs) {
+        low->failed = true;
+        return NULL;
+    }
+    block->instrs = instrs;
+    IrInstr* instr = &instrs[block->nb_instrs++];
+    *instr = (IrInstr){.op = op, .var = -1};
+    return instr;
+}
+
+static vreg_t add_value(Lowering* low, IrOp op, vreg_t a, vreg_t b) {
+    IrInstr* instr = add_instr(low, op);
+    if (!instr) {
+        return NO_VREG;
+    }
+    instr->a = a;
+    instr->b = b;
+    instr->dst = low->ir->nb_vregs++;
+    return instr->dst;
+}
+
+static vreg_t add_const(Lowering* low, long imm) {
+    IrInstr* instr = add_instr(low, IR_CONST);
+    if (!instr) {
+        return NO_VREG;
+    }
+    instr->imm = imm;
+    instr->dst = low->ir->nb_vregs++;
+    return instr->dst;
+}
+
+static vreg_t add_access(Lowering* low, IrOp op, int var, vreg_t a, vreg_t b) {
+    IrInstr* instr = add_instr(low, op);
+    if (!instr) {
+        return NO_VREG;
+    }
+    instr->var = var;
+    instr->a = a;
+    instr->b = b;
+    if (op != IR_STORE) {
+        instr->dst = low->ir->nb_vregs++;
+    }
+    return instr->dst;
+}
+
+static void add_edge(Lowering* low, int from, int to) {
+    IrBlock* src = &low->ir->blocks[from];
+    IrBlock* dst = &low->ir->blocks[to];
+    int* preds = grow(low->ctx, dst->preds, &dst->max_preds, dst->nb_preds,
+                      sizeof(int));
+    if (!preds) {
+        low->failed = true;
+        return;
+    }
+    dst->preds = preds;
+    preds[dst->nb_preds++] = from;
+    src->succs[src->nb_succs++] = to;
+}
+
+static void add_jump(Lowering* low, int target) {
+    if (block_ended(low) || !add_instr(low, IR_JUMP)) {
+        return;
+    }
+    add_edge(low, low->block, target);
+}
+
+static void add_branch(Lowering* low, vreg_t cond, int if_true, int if_false) {
+    IrInstr* instr;
+    if (block_ended(low) || !(instr = add_instr(low, IR_BRANCH))) {
+        return;
+    }
+    instr->a = cond;
+    add_edge(low, low->block, if_true);
+    add_edge(low, low->block, if_false);
+}
+
+static void add_ret(Lowering* low, vreg_t value) {
+    IrInstr* instr;
+    if (block_ended(low) || !(instr = add_instr(low, IR_RET))) {
+        return;
+    }
+    instr->a = value;
+}
+
+static void push_value(Lowering* low, vreg_t value) {
+    vreg_t* values = grow(low->ctx, low->values, &low->max_values,
+                          low->nb_values, sizeof(vreg_t));
+    if (!values) {
+        low->failed = true;
+        return;
+    }
+    low->values = values;
+    values[low->nb_values++] = value;
+}
+
+static vreg_t pop_value(Lowering* low) {
+    return low->nb_values ? low->values[--low->nb_values]: NO_VREG;
+}
+
+static int add_var(Lowering* low, IrVar var) {
+    IrFunction* ir = low->ir;
+    IrVar* vars = grow(low->ctx, ir->vars, &ir->max_vars, ir->nb_vars,
+                       sizeof(IrVar));
+    if (!vars) {
+        low->failed = true;
+        return -1;
+    }
+    ir->vars = vars;
+    vars[ir->nb_vars] = var;
+    return ir->nb_vars++;
+}
+
+static int declare_vars(Lowering* low) {
+    const Function* fun = low->scope->fun;
+    // parameters first, so that a variable is found from its index in its
+    // table
+    for (int i = 0; i < fun->parameters.cur_len; i++) {
+        const Entry* entry = &fun->parameters.array[i];
+        bool array = is_array(entry->type);
+        // the first parameters are pushed below rbp, the other ones are
+        // above the return address; arrays are given by their address
+        int var = add_var(low, (IrVar){.name = entry->name,
+                                       .array = array,
+                                       .promoted = !array,
+                                       .indirect = array,
+                                       .offset = i < 6 ? -entry->address: entry->address,
+                                       .entry = entry});
+        if (var != -1 && !array) {
+            add_access(low, IR_STORE, var, add_access(low, IR_PARAM, var, NO_VREG, NO_VREG),
+                       NO_VREG);
+        }
+    }
+    for (int i = 0; i < fun->locals.cur_len; i++) {
+        const Entry* entry = &fun->locals.array[i];
+        bool array = is_array(entry->type);
+        int var = add_var(low, (IrVar){.name = entry->name,
+                                       .array = array,
+                                       .promoted = !array,
+                                       .offset = -(fun->parameters.offset + entry->address),
+                                       .entry = entry});
+        if (var != -1 && !array) {
+            add_access(low, IR_STORE, var, add_const(low, 0), NO_VREG);
+        }
+    }
+    return !low->failed;
+}
+
+static int find_var(Lowering* low, ident_t ident) {
+    const Function* fun = low->scope->fun;
+    const Entry* entry;
+    if ((entry = get_entry(&fun->locals, ident))) {
+        return fun->parameters.cur_len + (entry - fun->locals.array);
+    }
+    int index = is_in_table(&fun->parameters, ident);
+    if (index != -1) {
+        return index;
+    }
+    if (!(entry = get_entry(low->scope->globals, ident))) {
+        return -1;
+    }
+    for (int i = fun->parameters.cur_len + fun->locals.cur_len; i < low->ir->nb_vars; i++) {
+        if (low->ir->vars[i].entry == entry) {
+            return i;
+        }
+    }
+    return add_var(low, (IrVar){.name = entry->name,
+                                .array = is_array(entry->type),
+                                .global = true,
+                                .offset = entry->address,
+                                .entry = entry});
+}
+
+static void lower_assign(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    Lowering* low = walk->pass;
+    node_t lvalue = FIRSTCHILD(ctx, frame->node);
+    node_t index = FIRSTCHILD(ctx, lvalue);
+
+    if (frame->step == 0) {
+        visit_node(walk, SECONDCHILD(ctx, frame->node));
+        return;
+    }
+    // the index of an array is lowered after the value
+    if (frame->step == 1 && index) {
+        visit_node(walk, index);
+        return;
+    }
+    vreg_t element = index ? pop_value(low): NO_VREG;
+    vreg_t value = pop_value(low);
+    int var = find_var(low, NODE_VAL(ctx, lvalue).ident);
+    if (var != -1) {
+        add_access(low, IR_STORE, var, value, element);
+    }
+}
+
+static void lower_call(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    Lowering* low = walk->pass;
+    node_t tree = frame->node;
+    const Function* to_call = get_function(low->scope->collection,
+                                           NODE_VAL(ctx, tree).ident);
+    node_t args = FIRSTCHILD(ctx, tree);
+    int nb_args = 0;
+
+    if (NODE_LABEL(ctx, args) == ListExp) {
+        if (frame->step == 0) {
+            // the first argument is lowered last, as in the nasm of the tree
+            visit_reversed_list(walk, FIRSTCHILD(ctx, args));
+            return;
+        }
+        for (node_t arg = FIRSTCHILD(ctx, args); arg; arg = NEXTSIBLING(ctx, arg)) {
+            nb_args++;
+        }
+    }
+    int first = add_operands(ctx, low->ir, nb_args);
+    if (first == -1) {
+        low->failed = true;
+        return;
+    }
+    for (int i = 0; i < nb_args; i++) {
+        low->ir->operands[first + i] = pop_value(low);
+    }
+    IrInstr* instr = add_instr(low, IR_CALL);
+    if (!instr) {
+        return;
+    }
+    instr->callee = NODE_VAL(ctx, tree).ident;
+    instr->first_operand = first;
+    instr->nb_operands = nb_args;
+    if (to_call->r_type != T_VOID) {
+        instr->dst = low->ir->nb_vregs++;
+        push_value(low, instr->dst);
+    }
+}
+
+static void lower_ident(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    Lowering* low = walk->pass;
+    node_t index = FIRSTCHILD(ctx, frame->node);
+    int var = find_var(low, NODE_VAL(ctx, frame->node).ident);
+
+    if (var == -1) {
+        if (!low->failed) {
+            lower_call(walk, frame);
+        }
+        return;
+    }
+    if (frame->step == 0 && index) {
+        visit_node(walk, index);
+        return;
+    }
+    if (low->ir->vars[var].array && !index) {
+        push_value(low, add_access(low, IR_ADDR, var, NO_VREG, NO_VREG));
+    } else {
+        vreg_t element = index ? pop_value(low): NO_VREG;
+        push_value(low, add_access(low, IR_LOAD, var, element, NO_VREG));
+    }
+}
+
+static void lower_arithmetic(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    Lowering* low = walk->pass;
+    node_t tree = frame->node;
+    char op = ident_name(ctx, NODE_VAL(ctx, tree).ident)[0];
+
+    if (frame->step == 0) {
+        visit_node(walk, FIRSTCHILD(ctx, tree));
+        return;
+    }
+    if (!SECONDCHILD(ctx, tree)) { // unary plus and minus
+        if (op == '-') {
+            push_value(low, add_value(low, IR_NEG, pop_value(low), NO_VREG));
+        }
+        return;
+    }
+    if (frame->step == 1) {
+        visit_node(walk, SECONDCHILD(ctx, tree));
+        return;
+    }
+    vreg_t b = pop_value(low);
+    vreg_t a = pop_value(low);
+    IrOp ir_op = op == '+' ? IR_ADD: op == '-' ? IR_SUB: op == '*' ? IR_MUL
+                 : op == '/' ? IR_DIV: IR_MOD;
+    push_value(low, add_value(low, ir_op, a, b));
+}
+
+static void lower_comp(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    Lowering* low = walk->pass;
+    node_t tree = frame->node;
+
+    if (frame->step < 2) {
+        visit_node(walk, frame->step ? SECONDCHILD(ctx, tree): FIRSTCHILD(ctx, tree));
+        return;
+    }
+    const char* symbol = ident_name(ctx, NODE_VAL(ctx, tree).ident);
+    int i = 0;
+    while (comparisons[i].symbol && strcmp(comparisons[i].symbol, symbol)) {
+        i++;
+    }
+    vreg_t b = pop_value(low);
+    vreg_t a = pop_value(low);
+    push_value(low, add_value(low, comparisons[i].op, a, b));
+}
+
+static void lower_logic(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    Lowering* low = walk->pass;
+    node_t tree = frame->node;
+    bool is_and = NODE_LABEL(ctx, tree) == And;
+    // blocks and variable are kept in the frame between the steps
+    int* join = &frame->data[0];
+    int* result = &frame->data[1];
+
+    switch (frame->step) {
+        case 0:
+            visit_node(walk, FIRSTCHILD(ctx, tree));
+            return;
+        case 1: {
+            vreg_t left = pop_value(low);
+            // the result is known if the left member is enough
+            if ((*result = add_var(low, (IrVar){.promoted = true})) == -1) {
+                return;
+            }
+            add_access(low, IR_STORE, *result, add_const(low, !is_and), NO_VREG);
+            int right = add_block(low);
+            if ((*join = add_block(low)) == -1) {
+                return;
+            }
+            add_branch(low, left, is_and ? right: *join, is_and ? *join: right);
+            start_block(low, right);
+            visit_node(walk, SECONDCHILD(ctx, tree));
+            return;
+        }
+        default:
+            add_access(low, IR_STORE, *result,
+                       add_value(low, IR_BOOL, pop_value(low), NO_VREG), NO_VREG);
+            add_jump(low, *join);
+            start_block(low, *join);
+            push_value(low, add_access(low, IR_LOAD, *result, NO_VREG, NO_VREG));
+    }
+}
+
+static void lower_not(Walk* walk, Frame* frame) {
+    Lowering* low = walk->pass;
+    if (frame->step == 0) {
+        visit_node(walk, FIRSTCHILD(walk->ctx, frame->node));
+        return;
+    }
+    push_value(low, add_value(low, IR_NOT, pop_value(low), NO_VREG));
+}
+
+static void lower_return(Walk* walk, Frame* frame) {
+    Lowering* low = walk->pass;
+    node_t value = FIRSTCHILD(walk->ctx, frame->node);
+    if (low->scope->fun->r_type == T_VOID || !value) {
+        add_ret(low, NO_VREG);
+        return;
+    }
+    if (frame->step == 0) {
+        visit_node(walk, value);
+        return;
+    }
+    add_ret(low, pop_value(low));
+}
+
+static void lower_if(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    Lowering* low = walk->pass;
+    node_t tree = frame->node;
+    int* next = &frame->data[0]; // block of the else, or after the 'if'
+    int* join = &frame->data[1]; // block after the 'if', with an else
+
+    switch (frame->step) {
+        case 0:
+            visit_node(walk, FIRSTCHILD(ctx, tree));
+            return;
+        case 1: {
+            int then = add_block(low);
+            if ((*next = add_block(low)) == -1) {
+                return;
+            }
+            add_branch(low, pop_value(low), then, *next);
+            start_block(low, then);
+            visit_node(walk, SECONDCHILD(ctx, tree));
+            return;
+        }
+        case 2:
+            if (NODE_LABEL(ctx, THIRDCHILD(ctx, tree)) != Else) {
+                add_jump(low, *next);
+                start_block(low, *next);
+                return;
+            }
+            if ((*join = add_block(low)) == -1) {
+                return;
+            }
+            add_jump(low, *join);
+            start_block(low, *next);
+            visit_list(walk, instructions_head(ctx, THIRDCHILD(ctx, tree)));
+            return;
+        default:
+            add_jump(low, *join);
+            start_block(low, *join);
+    }
+}
+
+static void lower_while(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    Lowering* low = walk->pass;
+    node_t tree = frame->node;
+    int* head = &frame->data[0];
+    int* exit = &frame->data[1];
+
+    switch (frame->step) {
+        case 0:
+            if ((*head = add_block(low)) == -1) {
+                return;
+            }
+            add_jump(low, *head);
+            start_block(low, *head);
+            visit_node(walk, FIRSTCHILD(ctx, tree));
+            return;
+        case 1: {
+            int body = add_block(low);
+            if ((*exit = add_block(low)) == -1) {
+                return;
+            }
+            add_branch(low, pop_value(low), body, *exit);
+            start_block(low, body);
+            visit_list(walk, instructions_head(ctx, SECONDCHILD(ctx, tree)));
+            return;
+        }
+        default:
+            add_jump(low, *head);
+            start_block(low, *exit);
+    }
+}
+
+static int lower_tree(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    Lowering* low = walk->pass;
+    node_t tree = frame->node;
+    switch (NODE_LABEL(ctx, tree)) {
+        case SuiteInstr:
+            // a nested bloc is visited as one of the instructions
+            if (frame->step == 0) {
+                visit_list(walk, FIRSTCHILD(ctx, tree));
+            }
+            break;
+        case Else:
+            if (frame->step == 0) {
+                visit_list(walk, instructions_head(ctx, FIRSTCHILD(ctx, tree)));
+            }
+            break;
+        case Assignation: lower_assign(walk, frame); break;
+        case Ident: lower_ident(walk, frame); break;
+        case Num: push_value(low, add_const(low, NODE_VAL(ctx, tree).num)); break;
+        case DivStar:
+        case AddSub: lower_arithmetic(walk, frame); break;
+        case Return: lower_return(walk, frame); break;
+        case Order:
+        case Eq: lower_comp(walk, frame); break;
+        case And:
+        case Or: lower_logic(walk, frame); break;
+        case Negation: lower_not(walk, frame); break;
+        case If: lower_if(walk, frame); break;
+        case While: lower_while(walk, frame); break;
+        default: break;
+    }
+    return !low->failed;
+}
+
+static node_t instructions_head(Context* ctx, node_t tree) {
+    if (tree && NODE_LABEL(ctx, tree) == SuiteInstr) {
+        return FIRSTCHILD(ctx, tree);
+    }
+    return tree;
+}
+
+int build_ir(Context* ctx, const Scope* scope, node_t node, IrFunction* ir) {
+    *ir = (IrFunction){.fun = scope->fun, .nb_vregs = 1};
+    Lowering low = {.ctx = ctx, .ir = ir, .scope = scope};
+    int res = add_block(&low) != -1;
+    if (res) {
+        start_block(&low, 0);
+        res = declare_vars(&low);
+    }
+    if (res) {
+        node_t head_instr = FIRSTCHILD(ctx, SECONDCHILD(ctx, SECONDCHILD(ctx, node)));
+        Walk walk;
+        init_walk(&walk, ctx, lower_tree, &low);
+        res = walk_tree(&walk, instructions_head(ctx, head_instr));
+        free_walk(&walk);
+        // the end of the function returns nothing, or 0 for main
+        bool is_main = !strcmp(ident_name(ctx, scope->fun->name), "main");
+        add_ret(&low, is_main ? add_const(&low, 0): NO_VREG);
+        res = res && !low.failed;
+    }
+    res = res && build_ssa(ctx, ir, low.layout, low.nb_layout);
+    free(low.values);
+    free(low.layout);
+    return res;
+}
+
+int add_operands(Context* ctx, IrFunction* ir, int nb_operands) {
+    if (ir->nb_operands + nb_operands > ir->max_operands) {
+        int next_len = ir->max_operands ? ir->max_operands: INIT_LENGTH;
+        while (next_len < ir->nb_operands + nb_operands) {
+            next_len *= 2;
+        }
+        vreg_t* operands = realloc(ir->operands, next_len * sizeof(vreg_t));
+        if (!operands) {
+            memory_error(ctx);
+            return -1;
+        }
+        ir->operands = operands;
+        ir->max_operands = next_len;
+    }
+    int first = ir->nb_operands;
+    for (int i = 0; i < nb_operands; i++) {
+        ir->operands[first + i] = NO_VREG;
+    }
+    ir->nb_operands += nb_operands;
+    return first;
+}
+
+static int number_dominators(const IrFunction* ir, int* order) {
+    int nb_blocks = ir->nb_blocks;
+    // children of each block in the dominator tree, and blocks to enter or,
+    // when negative, to leave
+    int* first_child = malloc(4 * nb_blocks * sizeof(int));
+    if (!first_child) {
+        return 0;
+    }
+    int* next_child = first_child + nb_blocks;
+    int* stack = next_child + nb_blocks;
+    for (int b = 0; b < nb_blocks; b++) {
+        first_child[b] = -1;
+    }
+    for (int b = nb_blocks - 1; b > 0; b--) {
+        next_child[b] = first_child[ir->blocks[b].idom];
+        first_child[ir->blocks[b].idom] = b;
+    }
+
+    int number = 0, depth = 0;
+    stack[depth++] = 0;
+    while (depth) {
+        int top = stack[--depth];
+        if (top < 0) {
+            order[2*(-top - 1) + 1] = number++;
+            continue;
+        }
+        order[2*top] = number++;
+        stack[depth++] = -top - 1;
+        for (int child = first_child[top]; child != -1; child = next_child[child]) {
+            stack[depth++] = child;
+        }
+    }
+    free(first_child);
+    return 1;
+}
+
+static bool dominates(const int* order, int dom, int block) {
+    return order[2*dom] <= order[2*block] && order[2*block + 1] <= order[2*dom + 1];
+}
+
+static bool has_operands(const IrFunction* ir, const IrInstr* instr) {
+    bool var = instr->var >= 0 && instr->var < ir->nb_vars;
+    switch (instr->op) {
+        case IR_NEG: case IR_NOT: case IR_BOOL: case IR_BRANCH:
+            return instr->a != NO_VREG;
+        case IR_ADD: case IR_SUB: case IR_MUL: case IR_DIV: case IR_MOD:
+        case IR_EQ: case IR_NE: case IR_LT: case IR_LE: case IR_GT: case IR_GE:
+            return instr->a != NO_VREG && instr->b != NO_VREG;
+        case IR_PARAM: case IR_ADDR:
+            return var;
+        case IR_LOAD:
+            return var && !ir->vars[instr->var].promoted
+                   && (instr->a != NO_VREG) == ir->vars[instr->var].array;
+        case IR_STORE:
+            return var && !ir->vars[instr->var].promoted && instr->a != NO_VREG
+                   && (instr->b != NO_VREG) == ir->vars[instr->var].array;
+        case IR_CALL:
+        case IR_PHI:
+            for (int i = 0; i < instr->nb_operands; i++) {
+                if (ir->operands[instr->first_operand + i] == NO_VREG) {
+                    return false;
+                }
+            }
+            return true;
+        default:
+            return true;
+    }
+}
+
+static bool defined_before(const IrFunction* ir, const int* order,
+                           const int* defs, vreg_t reg, int block, int index) {
+    if (reg <= NO_VREG || reg >= ir->nb_vregs || defs[2*reg] == -1) {
+        return false;
+    }
+    if (defs[2*reg] == block) {
+        return defs[2*reg + 1] < index;
+    }
+    return dominates(order, defs[2*reg], block);
+}
+
+static int verify_blocks(const IrFunction* ir, char* why, size_t size) {
+    static const int nb_succs[] = {[IR_JUMP] = 1, [IR_BRANCH] = 2, [IR_RET] = 0};
+    if (!ir->nb_blocks || ir->blocks[0].nb_preds) {
+        snprintf(why, size, "the entry block is missing or jumped to");
+        return 0;
+    }
+    for (int b = 0; b < ir->nb_blocks; b++) {
+        const IrBlock* block = &ir->blocks[b];
+        if (!block->nb_instrs || !is_terminator(block->instrs[block->nb_instrs - 1].op)) {
+            snprintf(why, size, "b%d does not end with a terminator", b);
+            return 0;
+        }
+        for (int i = 0; i < block->nb_instrs; i++) {
+            const IrInstr* instr = &block->instrs[i];
+            if (i < block->nb_instrs - 1 && is_terminator(instr->op)) {
+                snprintf(why, size, "b%d has a terminator before its end", b);
+                return 0;
+            }
+            if (instr->op == IR_PHI && i && block->instrs[i - 1].op != IR_PHI) {
+                snprintf(why, size, "b%d has a phi after an instruction", b);
+                return 0;
+            }
+            if (instr->op == IR_PHI && instr->nb_operands != block->nb_preds) {
+                snprintf(why, size, "b%d has a phi without an operand by predecessor", b);
+                return 0;
+            }
+        }
+        if (block->nb_succs != nb_succs[block->instrs[block->nb_instrs - 1].op]) {
+            snprintf(why, size, "b%d has the wrong number of successors", b);
+            return 0;
+        }
+        // each edge is a successor of its source and a predecessor of its
+        // target, as many times
+        for (int i = 0; i < block->nb_succs; i++) {
+            int succ = block->succs[i];
+            if (succ < 0 || succ >= ir->nb_blocks) {
+                snprintf(why, size, "b%d jumps out of the function", b);
+                return 0;
+            }
+            int nb_edges = 0, nb_preds = 0;
+            for (int j = 0; j < block->nb_succs; j++) {
+                nb_edges += block->succs[j] == succ;
+            }
+            for (int j = 0; j < ir->blocks[succ].nb_preds; j++) {
+                nb_preds += ir->blocks[succ].preds[j] == b;
+            }
+            if (nb_edges != nb_preds) {
+                snprintf(why, size, "b%d is not a predecessor of b%d", b, succ);
+                return 0;
+            }
+        }
+        for (int i = 0; i < block->nb_preds; i++) {
+            int pred = block->preds[i];
+            if (pred < 0 || pred >= ir->nb_blocks
+                || (ir->blocks[pred].succs[0] != b
+                    && (ir->blocks[pred].nb_succs < 2 || ir->blocks[pred].succs[1] != b))) {
+                snprintf(why, size, "b%d is not a successor of its predecessor", b);
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+static int verify_registers(const IrFunction* ir, char* why, size_t size) {
+    int* idom = malloc(ir->nb_blocks * sizeof(int));
+    // numbers of each block in the dominator tree
+    int* order = malloc(2 * ir->nb_blocks * sizeof(int));
+    // block and index defining each register
+    int* defs = malloc(2 * ir->nb_vregs * sizeof(int));
+    int res = 0;
+    if (!idom || !order || !defs || !compute_dominators(ir, idom)) {
+        snprintf(why, size, "run out of memory");
+        goto end;
+    }
+    for (int b = 0; b < ir->nb_blocks; b++) {
+        if (idom[b] == -2) {
+            snprintf(why, size, "b%d cannot be reached", b);
+            goto end;
+        }
+        if (idom[b] != ir->blocks[b].idom) {
+            snprintf(why, size, "b%d has the wrong immediate dominator", b);
+            goto end;
+        }
+    }
+    if (!number_dominators(ir, order)) {
+        snprintf(why, size, "run out of memory");
+        goto end;
+    }
+    for (int i = 0; i < 2 * ir->nb_vregs; i++) {
+        defs[i] = -1;
+    }
+    for (int b = 0; b < ir->nb_blocks; b++) {
+        const IrBlock* block = &ir->blocks[b];
+        for (int i = 0; i < block->nb_instrs; i++) {
+            vreg_t dst = block->instrs[i].dst;
+            if (dst == NO_VREG) {
+                continue;
+            }
+            if (dst < 0 || dst >= ir->nb_vregs || defs[2*dst] != -1) {
+                snprintf(why, size, "v%d is defined twice, or out of range", dst);
+                goto end;
+            }
+            defs[2*dst] = b;
+            defs[2*dst + 1] = i;
+        }
+    }
+    for (int b = 0; b < ir->nb_blocks; b++) {
+        const IrBlock* block = &ir->blocks[b];
+        for (int i = 0; i < block->nb_instrs; i++) {
+            const IrInstr* instr = &block->instrs[i];
+            if (!has_operands(ir, instr)) {
+                snprintf(why, size, "b%d: %s misses operands", b, op_names[instr->op]);
+                goto end;
+            }
+            if (instr->op == IR_PHI) {
+                // the operand of a predecessor is used at its end
+                for (int j = 0; j < instr->nb_operands; j++) {
+                    int pred = block->preds[j];
+                    if (!defined_before(ir, order, defs,
+                                        ir->operands[instr->first_operand + j],
+                                        pred, ir->blocks[pred].nb_instrs)) {
+                        snprintf(why, size, "b%d: phi v%d uses a register not defined "
+                                 "in b%d", b, instr->dst, pred);
+                        goto end;
+                    }
+                }
+                continue;
+            }
+            vreg_t uses[2] = {instr->a, instr->b};
+            for (int j = 0; j < 2; j++) {
+                if (uses[j] != NO_VREG && !defined_before(ir, order, defs, uses[j], b, i)) {
+                    snprintf(why, size, "b%d: %s uses v%d before its definition",
+                             b, op_names[instr->op], uses[j]);
+                    goto end;
+                }
+            }
+            for (int j = 0; instr->op == IR_CALL && j < instr->nb_operands; j++) {
+                vreg_t use = ir->operands[instr->first_operand + j];
+                if (!defined_before(ir, order, defs, use, b, i)) {
+                    snprintf(why, size, "b%d: call uses v%d before its definition", b, use);
+                    goto end;
+                }
+            }
+        }
+    }
+    res = 1;
+end:
+    free(idom);
+    free(order);
+    free(defs);
+    return res;
+}
+
+int verify_ir(const IrFunction* ir, char* why, size_t size) {
+    return verify_blocks(ir, why, size) && verify_registers(ir, why, size);
+}
+
+static void print_var(Context* ctx, const IrFunction* ir, int var) {
+    if (ir->vars[var].entry) {
+        printf("%s", ident_name(ctx, ir->vars[var].name));
+    } else {
+        printf("t%d", var);
+    }
+}
+
+static void print_instr(Context* ctx, const IrFunction* ir, const IrInstr* instr) {
+    printf("\t");
+    if (instr->dst != NO_VREG) {
+        printf("v%d = ", instr->dst);
+    }
+    printf("%s", op_names[instr->op]);
+    switch (instr->op) {
+        case IR_CONST:
+            printf(" %ld", instr->imm);
+            break;
+        case IR_PARAM:
+        case IR_ADDR:
+            printf(" ");
+            print_var(ctx, ir, instr->var);
+            break;
+        case IR_LOAD:
+        case IR_STORE:
+            printf(" ");
+            print_var(ctx, ir, instr->var);
+            if (instr->op == IR_LOAD ? instr->a: instr->b) {
+                printf("[v%d]", instr->op == IR_LOAD ? instr->a: instr->b);
+            }
+            if (instr->op == IR_STORE) {
+                printf(", v%d", instr->a);
+            }
+            break;
+        case IR_CALL:
+            printf(" %s(", ident_name(ctx, instr->callee));
+            for (int i = 0; i < instr->nb_operands; i++) {
+                printf(i ? ", v%d": "v%d", ir->operands[instr->first_operand + i]);
+            }
+            printf(")");
+            break;
+        case IR_PHI:
+            printf(" ");
+            print_var(ctx, ir, instr->var);
+            break;
+        case IR_RET:
+            if (instr->a) {
+                printf(" v%d", instr->a);
+            }
+            break;
+        default:
+            if (instr->a) {
+                printf(" v%d", instr->a);
+            }
+            if (instr->b) {
+                printf(", v%d", instr->b);
+            }
+    }
+}
+
+void print_ir(Context* ctx, const IrFunction* ir) {
+    printf("function %s\n", ident_name(ctx, ir->fun->name));
+    for (int b = 0; b < ir->nb_blocks; b++) {
+        const IrBlock* block = &ir->blocks[b];
+        printf("b%d:", b);
+        for (int i = 0; i < block->nb_preds; i++) {
+            printf(i ? ", b%d": "\t; preds b%d", block->preds[i]);
+        }
+        if (block->idom != -1) {
+            printf(block->nb_preds ? "; idom b%d": "\t; idom b%d", block->idom);
+        }
+        printf("\n");
+        for (int i = 0; i < block->nb_instrs; i++) {
+            const IrInstr* instr = &block->instrs[i];
+            print_instr(ctx, ir, instr);
+            if (instr->op == IR_PHI) {
+                for (int j = 0; j < instr->nb_operands; j++) {
+                    printf("%s[b%d: v%d]", j ? ", ": " ", block->preds[j],
+                           ir->operands[instr->first_operand + j]);
+                }
+            } else if (instr->op == IR_JUMP) {
+                printf(" b%d", block->succs[0]);
+            } else if (instr->op == IR_BRANCH) {
+                printf(", b%d, b%d", block->succs[0], block->succs[1]);
+            }
+            printf("\n");
+        }
+    }
+    printf("\n");
+}
+
+void free_ir(IrFunction* ir) {
+    for (int b = 0; b < ir->nb_blocks; b++) {
+        free(ir->blocks[b].instrs);
+        free(ir->blocks[b].preds);
+    }
+    free(ir->blocks);
+    free(ir->vars);
+    free(ir->operands);
+    *ir = (IrFunction){0};
+}
@@ -0,0 +1,207 @@
+#include "jit.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "assemble.h"
+#include "builtins.h"
+#include "errors.h"
+
+#define PAGE_SIZE 0x1000
+
+// entry called from C: the functions of tpcc and the builtins do not keep
+// the registers C expects to be kept, rbx being changed by putint. As in an
+// executable, rax is 0 if main returns nothing
+static const char entry[] = "\n_run:\n"
+                            "\tpush\trbx\n"
+                            "\tpush\trbp\n"
+                            "\tpush\tr12\n"
+                            "\tpush\tr13\n"
+                            "\tpush\tr14\n"
+                            "\tpush\tr15\n"
+                            "\txor \trax, rax\n"
+                            "\tcall\tmain\n"
+                            "\tpop \tr15\n"
+                            "\tpop \tr14\n"
+                            "\tpop \tr13\n"
+                            "\tpop \tr12\n"
+                            "\tpop \trbp\n"
+                            "\tpop \trbx\n"
+                            "\tret\n";
+
+/**
+ * @brief Compare labels by their offset in the code
+ *
+ * @param a first label
+ * @param b second label
+ * @return negative, 0 or positive as for qsort
+ */
+static int compare_offsets(const void* a, const void* b);
+
+/**
+ * @brief Tell if a label of the code is one of the labels inside a builtin
+ *        of the program, such as `print_zero` in `putint`, which are not
+ *        functions
+ *
+ * @param obj assembled program
+ * @param sym label of the code
+ * @return 1 if the label is inside a builtin
+ *         0 if it is a function entry
+ */
+static int is_builtin_label(const Object* obj, const AsmSymbol* sym);
+
+/**
+ * @brief Write the functions of the code in `/tmp/perf-<pid>.map`, for perf
+ *        to name the samples taken in the code. Each function of the
+ *        program, builtin or the entry `_run` covers the code up to the next
+ *        one, its own labels included
+ *
+ * @param ctx compilation context
+ * @param obj assembled program
+ * @param text address of the code
+ * @return 1 if success
+ *         0 if fail
+ */
+static int write_perf_map(Context* ctx, const Object* obj,
+                          const unsigned char* text);
+
+/**
+ * @brief Place an assembled program in memory and call it from its entry
+ *
+ * @param ctx compilation context, whose status is set to the result of main
+ * @param obj assembled program
+ * @return 1 if the program ran
+ *         0 if it cannot be loaded
+ */
+static int load_and_run(Context* ctx, Object* obj);
+
+
+static inline size_t align_up(size_t value, size_t align) {
+    return (value + align - 1) & ~(align - 1);
+}
+
+static int compare_offsets(const void* a, const void* b) {
+    size_t offset_a = (*(const AsmSymbol* const*)a)->offset;
+    size_t offset_b = (*(const AsmSymbol* const*)b)->offset;
+    return (offset_a > offset_b) - (offset_a < offset_b);
+}
+
+static int is_builtin_label(const Object* obj, const AsmSymbol* sym) {
+    for (const EmbeddedBuiltin* builtin = embedded_builtins; builtin->name;
+         builtin++) {
+        if (find_symbol(obj, builtin->name) == -1) {
+            continue;
+        }
+        if (strlen(builtin->name) == (size_t)sym->len
+            && !memcmp(builtin->name, sym->name, sym->len)) {
+            return 0;
+        }
+        // the labels of the builtins start their lines
+        const char* line = builtin->nasm;
+        while (line) {
+            if (!strncmp(line, sym->name, sym->len) && line[sym->len] == ':') {
+                return 1;
+            }
+            line = strchr(line, '\n');
+            line = line ? line + 1: NULL;
+        }
+    }
+    return 0;
+}
+
+static int write_perf_map(Context* ctx, const Object* obj,
+                          const unsigned char* text) {
+    const AsmSymbol** labels = malloc(sizeof(*labels)*obj->nb_symbols);
+    if (!labels) {
+        memory_error(ctx);
+        return 0;
+    }
+    int nb_labels = 0;
+    for (int i = 0; i < obj->nb_symbols; i++) {
+        const AsmSymbol* sym = &obj->symbols[i];
+        if (sym->section == SECTION_TEXT && sym->parent == -1
+            && !is_builtin_label(obj, sym)) {
+            labels[nb_labels++] = sym;
+        }
+    }
+    qsort(labels, nb_labels, sizeof(*labels), compare_offsets);
+
+    char filename[64];
+    snprintf(filename, 64, "/tmp/perf-%d.map", (int)getpid());
+    FILE* map = fopen(filename, "w");
+    if (!map) {
+        fprintf(ctx->err, "Cannot open file '%s'\n", filename);
+        free(labels);
+        return 0;
+    }
+    for (int i = 0; i < nb_labels; i++) {
+        size_t end = i + 1 < nb_labels ? labels[i + 1]->offset: obj->text_len;
+        // labels of the same address name the code once
+        if (end > labels[i]->offset) {
+            fprintf(map, "%lx %zx %.*s\n",
+                    (unsigned long)(uintptr_t)(text + labels[i]->offset),
+                    end - labels[i]->offset, labels[i]->len, labels[i]->name);
+        }
+    }
+    fclose(map);
+    free(labels);
+    return 1;
+}
+
+static int load_and_run(Context* ctx, Object* obj) {
+    int start = find_symbol(obj, "_run");
+    // the globals are addressed on 32 bits, as in the executables, so both
+    // sections are mapped in the first 2 GiB
+    size_t text_len = align_up(obj->text_len, PAGE_SIZE);
+    size_t len = text_len + align_up(obj->bss_len, PAGE_SIZE);
+    unsigned char* text = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+    if (text == MAP_FAILED) {
+        memory_error(ctx);
+        return 0;
+    }
+    if (!place_object(ctx, obj, (uintptr_t)text, (uintptr_t)text + text_len)) {
+        munmap(text, len);
+        return 0;
+    }
+    memcpy(text, obj->text, obj->text_len);
+    if (mprotect(text, text_len, PROT_READ | PROT_EXEC)) {
+        memory_error(ctx);
+        munmap(text, len);
+        return 0;
+    }
+    if (ctx->perf_map && !write_perf_map(ctx, obj, text)) {
+        munmap(text, len);
+        return 0;
+    }
+
+    // the program writes straight to the standard output
+    fflush(stdout);
+    long (*run)(void) = (long (*)(void))(text + obj->symbols[start].offset);
+    ctx->status = run();
+    munmap(text, len);
+    return 1;
+}
+
+int run_program(Context* ctx, const char* nasm, size_t len) {
+    // the entry follows the program, so that errors keep the lines of nasm
+    size_t source_len = len + sizeof(entry) - 1;
+    char* source = malloc(source_len);
+    if (!source) {
+        memory_error(ctx);
+        return 0;
+    }
+    memcpy(source, nasm, len);
+    memcpy(source + len, entry, sizeof(entry) - 1);
+
+    Object obj;
+    int res = assemble(ctx, &obj, source, source_len)
+              && load_and_run(ctx, &obj);
+    free_object(&obj);
+    free(source);
+    return res;
+}
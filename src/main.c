@@ -1,58 +1,50 @@
 #include <stdio.h>
 #include <stdlib.h>
 
-#include "sematic.h"
-#include "tree.h"
 #include "args.h"
-#include "parser.h"
-#include "table.h"
+#include "batch.h"
+#include "context.h"
 #include "errors.h"
-#include "gen_nasm.h"
-
-#define SYNTAX_ERROR   1
-#define SEMANTIC_ERROR 2
-#define OTHER_ERROR    3
+#include "server.h"
+#include "tpcc.h"
 
 /**
  * @brief Display help message
  */
 void print_help(void) {
-    printf("Usage: ./tpcc [OPTION...] FILE\n"
-           "Check if syntax of given file is valid, according to the grammar defined in parser.y\n\n"
+    printf("Usage: ./tpcc [OPTION...] [FILE...]\n"
+           "Check if syntax of given files is valid, according to the grammar defined in parser.y\n\n"
            "With no FILE, FILE is the standard input\n\n"
            "  -t, --tree\t\tprint abstract tree of the given file\n"
            "  -s, --symbols\t\tprint associated symbol tables\n"
+           "  -j, --jobs N\t\tcompile up to N files, or the functions of a file on N\n"
+           "\t\t\tthreads, at the same time\n"
+           "      --stats\t\tprint statistics of the compilation\n"
+           "      --tokens\t\tprint tokens of the given file\n"
+           "      --lexer=NAME\tscan with the flex (default) or fast lexer\n"
+           "      --stream\t\tcompile each function as soon as it is parsed\n"
+           "      --asm-comments=LEVEL\n"
+           "\t\t\tcomment the nasm with none (default), brief or full\n"
+           "\t\t\tcomments\n"
+           "      --format=FORMAT\twrite nasm (asm, default), an ELF64 object (obj)\n"
+           "\t\t\tor a static executable (exe), without nasm nor ld\n"
+           "      --run\t\trun the program in memory, exiting with the result\n"
+           "\t\t\tof main, without writing any file\n"
+           "      --perf-map\twrite /tmp/perf-<pid>.map, naming the functions run\n"
+           "\t\t\tfor perf\n"
+           "      --codegen=NAME\tgenerate the functions from the tree (walk, default)\n"
+           "\t\t\tor from their IR in SSA form (ir)\n"
+           "      --dump-ir\t\tprint the IR of each function\n"
+           "      --cache-dir=DIR\treuse the nasm of unchanged functions cached in DIR\n"
+           "      --cache-stats\tprint statistics of the cache\n"
+           "      --server=PATH\tserve compile requests on the socket PATH\n"
+           "      --client=PATH\tcompile the files through the server on PATH\n"
+           "      --repeat=N\tsend each file N times to the server, on as many\n"
+           "\t\t\tconnections as jobs, and print the rate of requests\n"
            "  -h, --help\t\tdisplay this help message and exit\n"
            );
 }
 
-/**
- * @brief Parse file and fill the abstract tree
- * 
- * @param args command line arguments
- * @param AST abstract tree to fill
- * @param print_tree indicate to print the tree
- * @return result of parser, 1 if error else 0
- */
-int parse(Args args, Node** AST, bool print_tree) {
-    int res;
-    // choose input source 
-    if (!args.source) {
-        res = parse_file(stdin, AST);
-    } else {
-        res = parse_file(args.source, AST);
-    }
-    
-    // print tree if no error
-    if (!res && print_tree) {
-        printTree(*AST);
-    }
-    if (args.source) {
-        fclose(args.source);
-    }
-    return res;
-}
-
 int main(int argc, char* argv[]) {
     Args args = parse_args(argc, argv);
     if (args.err) {
@@ -65,52 +57,56 @@ int main(int argc, char* argv[]) {
         return EXIT_SUCCESS;
     }
 
-    // parsing input
-    Node* AST = NULL;
-    int res = parse(args, &AST, args.tree);
+    // compile requests of clients until killed
+    if (args.server) {
+        return run_server(args.server, args.jobs);
+    }
+
+    const char* name = args.nb_files ? args.files[0]: NULL;
+    Context ctx;
+    init_context(&ctx, name ? name: "stdin");
+    ctx.print_tree = args.tree;
+    ctx.print_symbols = args.symbols;
+    ctx.print_stats = args.stats;
+    ctx.print_tokens = args.tokens;
+    ctx.fast_lexer = args.fast_lexer;
+    ctx.stream_functions = args.stream;
+    ctx.cache_dir = args.cache_dir;
+    ctx.print_cache_stats = args.cache_stats;
+    ctx.comments = args.comments;
+    ctx.format = args.format;
+    ctx.codegen = args.codegen;
+    ctx.dump_ir = args.dump_ir;
+    ctx.perf_map = args.perf_map;
+    ctx.jobs = args.jobs;
 
-    // input error
-    if (res) {
-        deleteTree(AST);
-        return res;
+    if (args.repeat) {
+        return run_load(&ctx, args.client, args.files, args.nb_files,
+                        args.repeat, args.jobs);
+    }
+    if (args.client) {
+        return run_client(&ctx, args.client, args.files, args.nb_files);
     }
-    // input was correctly parsed, proceed to the next step
-    init_error(args.name ? args.name: "stdin");
 
-    // initiate structures to check semantic and generate nasm
-    int err_globals, err_functions;
-    Table globals;
-    FunctionCollection functions;
-    err_globals = init_table(&globals);
-    err_functions = init_function_collection(&functions);
+    // several files, compiled in parallel
+    if (args.nb_files > 1) {
+        return compile_batch(&ctx, args.files, args.nb_files, args.jobs);
+    }
 
-    // error while initiating structures for semantic
-    if (!err_functions || !err_globals) {
-        deleteTree(AST);
-        print_rapport();
-        return OTHER_ERROR;
+    int res = compile_file(&ctx, name);
+    // the program run is the only one writing on the standard output
+    if (ctx.format == FORMAT_RUN) {
+        return res ? res: ctx.status;
     }
-    // error while filling symbol tables
-    if (!create_tables(&globals, &functions, AST)) {
-        deleteTree(AST);
-        print_rapport();
-        return SEMANTIC_ERROR;
+    // syntax errors are reported by the parser itself
+    if (res != SYNTAX_ERROR && res != OTHER_ERROR) {
+        print_rapport(&ctx);
     }
-    // print symbol tables
-    if (args.symbols) {
-        puts("globals:");
-        print_table(globals);
-        print_collection(functions);
+    if (ctx.print_stats && res != OTHER_ERROR) {
+        print_stats(&ctx);
     }
-    // generating nasm if sematic is correct
-    if (check_sem(&globals, &functions, AST)) {
-        gen_nasm(args.name, &globals, &functions, AST);
+    if (ctx.print_cache_stats && res != OTHER_ERROR) {
+        print_cache_stats(&ctx);
     }
-    // free allocated memory for semantic structures
-    free_collection(&functions);
-    free_table(&globals);
-
-    deleteTree(AST);
-    print_rapport();
-    return fatal_error() ? SEMANTIC_ERROR: res;
+    return res;
 }
@@ -4,16 +4,14 @@
 #include <stdlib.h>
 
 #include "tree.h"
-#include "args.h"
+#include "context.h"
+#include "intern.h"
+#include "lexer.h"
 #include "parser.h"
+#include "stream.h"
 
-int yylex(void);
-void yyerror(Node** tree, char* msg);
-
-extern int lineno;
-extern int colno;
-extern int prevcolno;
-extern FILE *yyin;
+// the parser stack grows on the heap, so nesting is only bounded by memory
+#define YYMAXDEPTH 100000000
 
 /**
  * @brief Set a value with the type of int
@@ -21,220 +19,346 @@ extern FILE *yyin;
 Value to_int(int n);
 
 /**
- * @brief Set a value with the type of char*
+ * @brief Set a value with an identifier, interned in the context
+ */
+static Value make_ident(Context* ctx, const char* text, size_t len);
+
+/**
+ * @brief Set a value with an identifier
  */
-Value to_str(char* str);
+Value to_ident(Context* ctx, const char* str);
+
+/**
+ * @brief Set a value with an identifier, from a token of the source
+ */
+Value span_to_ident(Context* ctx, Span span);
+
+/**
+ * @brief Wrap a parsed function in a 'DeclFonct' node added to the list, or
+ *        compile it at once if streamed, then return NO_NODE
+ */
+static node_t add_function(Context* ctx, node_t list, node_t head);
 
 %}
+%code requires {
+#include "context.h"
+#include "source.h"
+#include "tree.h"
+}
+%code {
+int flex_lex(YYSTYPE* lval, void* scanner);
+int fast_lex(YYSTYPE* lval, void* scanner);
+static int yylex(YYSTYPE* lval, void* scanner, Context* ctx);
+void yyerror(void* scanner, Context* ctx, node_t* tree, char* msg);
+}
 %union{
-    Node *node;
-    char ident[64];
-    char carac[3];
+    node_t node;
+    Span span;
     int num;
 }
 
-%parse-param {Node** tree}
+%define api.pure full
+%lex-param {void* scanner} {Context* ctx}
+%parse-param {void* scanner} {Context* ctx} {node_t* tree}
 
 %type <node> Prog DeclVars Declarateurs DeclFoncts DeclFonct EnTeteFonct Parametres ListTypVar Corps SuiteInstr Instr Exp TB FB M E T F LValue ListExp Arguments
 
-%type <key_word> IF WHILE RETURN ELSE
-%type <ident> TYPE VOID AND OR EQ ORDER ADDSUB DIVSTAR IDENT
-%type <carac> CHARACTER
+%type <span> TYPE VOID AND OR EQ ORDER ADDSUB DIVSTAR IDENT CHARACTER
 %type <num> NUM  
 
 %token IF WHILE RETURN ELSE TYPE VOID AND OR EQ ORDER ADDSUB DIVSTAR CHARACTER IDENT NUM 
 
 %expect 1
 %%
-Prog:  DeclVars DeclFoncts                  { Node* prog = makeNode(Prog);
-                                             addChild(prog, $1);
-                                             addChild(prog, $2);
+Prog:  DeclVars DeclFoncts                  { node_t prog = makeNode(ctx, Prog);
+                                             addChild(ctx, prog, $1);
+                                             addChild(ctx, prog, $2);
                                              *tree = prog;
                                              }
     ;
 DeclVars:
-       DeclVars TYPE Declarateurs ';'       { Node* t = makeNodeWithValue(to_str($2), Type);
-                                              addChild(t, $3);
-                                              addChild($1, t); }
-    |                                       { $$ = makeNode(DeclVars); }
+       DeclVars TYPE Declarateurs ';'       { node_t t = makeNodeWithValue(ctx, span_to_ident(ctx, $2), Type);
+                                              addChild(ctx, t, $3);
+                                              addChild(ctx, $1, t); }
+    |                                       { $$ = makeNode(ctx, DeclVars); }
     ;
 Declarateurs:
-       Declarateurs ',' IDENT               { addSibling($$, makeNodeWithValue(to_str($3), Ident)); }  
-    |  Declarateurs ',' IDENT '[' NUM ']'   { Node* t = makeNodeWithValue(to_str($3), Ident);
-                                              setAsArray(t);
-                                              addChild(t, makeNodeWithValue(to_int($5), Num));
-                                              addSibling($$, t); }
-    |  IDENT '[' NUM ']'                    { $$ = makeNodeWithValue(to_str($1), Ident);
-                                              setAsArray($$);
-                                              addChild($$, makeNodeWithValue(to_int($3), Num)); }
-    |  IDENT                                { $$ = makeNodeWithValue(to_str($1), Ident); }
+       Declarateurs ',' IDENT               { addSibling(ctx, $$, makeNodeWithValue(ctx, span_to_ident(ctx, $3), Ident)); }  
+    |  Declarateurs ',' IDENT '[' NUM ']'   { node_t t = makeNodeWithValue(ctx, span_to_ident(ctx, $3), Ident);
+                                              setAsArray(ctx, t);
+                                              addChild(ctx, t, makeNodeWithValue(ctx, to_int($5), Num));
+                                              addSibling(ctx, $$, t); }
+    |  IDENT '[' NUM ']'                    { $$ = makeNodeWithValue(ctx, span_to_ident(ctx, $1), Ident);
+                                              setAsArray(ctx, $$);
+                                              addChild(ctx, $$, makeNodeWithValue(ctx, to_int($3), Num)); }
+    |  IDENT                                { $$ = makeNodeWithValue(ctx, span_to_ident(ctx, $1), Ident); }
     ;
 DeclFoncts:
        DeclFoncts DeclFonct                 { $$ = $1;
-                                              Node* node = makeNode(DeclFonct);
-                                              addChild(node, $2);
-                                              addChild($$, node); }
-    |  DeclFonct                            { $$ = makeNode(DeclFoncts);
-                                              addChild($$, makeNode(DeclFonct));
-                                              addChild(FIRSTCHILD($$), $1); }
+                                              add_function(ctx, $$, $2); }
+    |  DeclFonct                            { // globals are complete, their DeclVars is below on the stack
+                                              if (ctx->stream) {
+                                                  start_stream(ctx, $<node>0);
+                                              }
+                                              node_t node = add_function(ctx, NO_NODE, $1);
+                                              $$ = makeNode(ctx, DeclFoncts);
+                                              if (node != NO_NODE) {
+                                                  addChild(ctx, $$, node);
+                                              } }
     ;
 DeclFonct:
-       EnTeteFonct Corps                    { $$ = makeNode(EnTeteFonct);
-                                              addChild($$, $1);
-                                              addSibling($$, $2); }
+       EnTeteFonct Corps                    { $$ = makeNode(ctx, EnTeteFonct);
+                                              addChild(ctx, $$, $1);
+                                              addSibling(ctx, $$, $2); }
     ;
 EnTeteFonct:
-       TYPE IDENT '(' Parametres ')'        { $$ = makeNodeWithValue(to_str($1), Type);
-                                              addSibling($$, makeNodeWithValue(to_str($2), Ident));
-                                              addSibling($$, $4); }
-|      VOID IDENT '(' Parametres ')'        { $$ = makeNodeWithValue(to_str($1), Void);
-                                              addSibling($$, makeNodeWithValue(to_str($2), Ident));
-                                              addSibling($$, $4); }
+       TYPE IDENT '(' Parametres ')'        { $$ = makeNodeWithValue(ctx, span_to_ident(ctx, $1), Type);
+                                              addSibling(ctx, $$, makeNodeWithValue(ctx, span_to_ident(ctx, $2), Ident));
+                                              addSibling(ctx, $$, $4); }
+|      VOID IDENT '(' Parametres ')'        { $$ = makeNodeWithValue(ctx, span_to_ident(ctx, $1), Void);
+                                              addSibling(ctx, $$, makeNodeWithValue(ctx, span_to_ident(ctx, $2), Ident));
+                                              addSibling(ctx, $$, $4); }
     ;
 Parametres:
-       VOID                                 { $$ = makeNodeWithValue(to_str($1), Void); }
-    |  ListTypVar                           { $$ = makeNode(ListTypVar);
-                                              addChild($$, $1); }
+       VOID                                 { $$ = makeNodeWithValue(ctx, span_to_ident(ctx, $1), Void); }
+    |  ListTypVar                           { $$ = makeNode(ctx, ListTypVar);
+                                              addChild(ctx, $$, $1); }
     ;
 ListTypVar:
        ListTypVar ',' TYPE IDENT            { $$ = $1;
-                                              Node* t = makeNodeWithValue(to_str($3), Type);
-                                              addChild(t, makeNodeWithValue(to_str($4), Ident));
-                                              addSibling($$, t); }
+                                              node_t t = makeNodeWithValue(ctx, span_to_ident(ctx, $3), Type);
+                                              addChild(ctx, t, makeNodeWithValue(ctx, span_to_ident(ctx, $4), Ident));
+                                              addSibling(ctx, $$, t); }
     |  ListTypVar ',' TYPE IDENT '[' ']'    { $$ = $1;
-                                              Node* t = makeNodeWithValue(to_str($3), Type);
-                                              Node* ident = makeNodeWithValue(to_str($4), Ident);
-                                              setAsArray(ident);
-                                              addChild(t, ident);
-                                              addSibling($$, t); }
-    |  TYPE IDENT '[' ']'                   { $$ = makeNodeWithValue(to_str($1), Type);
-                                              Node* ident = makeNodeWithValue(to_str($2), Ident);
-                                              setAsArray(ident);
-                                              addChild($$, ident); }
-    |  TYPE IDENT                           { $$ = makeNodeWithValue(to_str($1), Type);
-                                              addChild($$, makeNodeWithValue(to_str($2), Ident)); }
-    ;
-
-Corps: '{' DeclVars SuiteInstr '}'          { $$ = makeNode(Corps);
-                                              addChild($$, $2);
-                                              addSibling($2, $3);}
+                                              node_t t = makeNodeWithValue(ctx, span_to_ident(ctx, $3), Type);
+                                              node_t ident = makeNodeWithValue(ctx, span_to_ident(ctx, $4), Ident);
+                                              setAsArray(ctx, ident);
+                                              addChild(ctx, t, ident);
+                                              addSibling(ctx, $$, t); }
+    |  TYPE IDENT '[' ']'                   { $$ = makeNodeWithValue(ctx, span_to_ident(ctx, $1), Type);
+                                              node_t ident = makeNodeWithValue(ctx, span_to_ident(ctx, $2), Ident);
+                                              setAsArray(ctx, ident);
+                                              addChild(ctx, $$, ident); }
+    |  TYPE IDENT                           { $$ = makeNodeWithValue(ctx, span_to_ident(ctx, $1), Type);
+                                              addChild(ctx, $$, makeNodeWithValue(ctx, span_to_ident(ctx, $2), Ident)); }
+    ;
+
+Corps: '{' DeclVars SuiteInstr '}'          { $$ = makeNode(ctx, Corps);
+                                              addChild(ctx, $$, $2);
+                                              addSibling(ctx, $2, $3);}
     ;
 SuiteInstr:
        SuiteInstr Instr                     { $$ = $1;
-                                              addChild($$, $2); }
-    |                                       { $$ = makeNode(SuiteInstr); }
+                                              addChild(ctx, $$, $2); }
+    |                                       { $$ = makeNode(ctx, SuiteInstr); }
     ;
 Instr:
-       LValue '=' Exp ';'                   { $$ = makeNodeWithValue(to_str("="), Assignation);
-                                              addChild($$, $1);
-                                              addSibling(FIRSTCHILD($$), $3); }
-    |  IF '(' Exp ')' Instr                 { $$ = makeNode(If);
-                                              addChild($$, $3);
-                                              addSibling($3, $5); 
-                                              addChild($$, makeNode(EmptyInstr)); }
-    |  IF '(' Exp ')' Instr ELSE Instr      { $$ = makeNode(If);
-                                              addChild($$, $3);
-                                              addSibling($3, $5);
-                                              Node* e = makeNode(Else);
-                                              addChild($$, e);
-                                              addChild(e, $7); }
-    |  WHILE '(' Exp ')' Instr              { $$ = makeNode(While);
-                                              addChild($$, $3);
-                                              addChild($$, $5); }
-    |  IDENT '(' Arguments ')' ';'          { $$ = makeNodeWithValue(to_str($1), Ident);
-                                              addChild($$, $3); }
-    |  RETURN Exp ';'                       { $$ = makeNode(Return);
-                                              addChild($$, $2); }
-    |  RETURN ';'                           { $$ = makeNode(Return); }
+       LValue '=' Exp ';'                   { $$ = makeNodeWithValue(ctx, to_ident(ctx, "="), Assignation);
+                                              addChild(ctx, $$, $1);
+                                              addSibling(ctx, FIRSTCHILD(ctx, $$), $3); }
+    |  IF '(' Exp ')' Instr                 { $$ = makeNode(ctx, If);
+                                              addChild(ctx, $$, $3);
+                                              addSibling(ctx, $3, $5); 
+                                              addChild(ctx, $$, makeNode(ctx, EmptyInstr)); }
+    |  IF '(' Exp ')' Instr ELSE Instr      { $$ = makeNode(ctx, If);
+                                              addChild(ctx, $$, $3);
+                                              addSibling(ctx, $3, $5);
+                                              node_t e = makeNode(ctx, Else);
+                                              addChild(ctx, $$, e);
+                                              addChild(ctx, e, $7); }
+    |  WHILE '(' Exp ')' Instr              { $$ = makeNode(ctx, While);
+                                              addChild(ctx, $$, $3);
+                                              addChild(ctx, $$, $5); }
+    |  IDENT '(' Arguments ')' ';'          { $$ = makeNodeWithValue(ctx, span_to_ident(ctx, $1), Ident);
+                                              addChild(ctx, $$, $3); }
+    |  RETURN Exp ';'                       { $$ = makeNode(ctx, Return);
+                                              addChild(ctx, $$, $2); }
+    |  RETURN ';'                           { $$ = makeNode(ctx, Return); }
     |  '{' SuiteInstr '}'                   { $$ = $2; }
-    |  ';'                                  { $$ = makeNode(EmptyInstr); }
+    |  ';'                                  { $$ = makeNode(ctx, EmptyInstr); }
     ;
-Exp :  Exp OR TB                            { Node* n = makeNode(Or);
-                                              addChild(n, $1);
-                                              addChild(n, $3);
+Exp :  Exp OR TB                            { node_t n = makeNode(ctx, Or);
+                                              addChild(ctx, n, $1);
+                                              addChild(ctx, n, $3);
                                               $$ = n; }
     |  TB                                   { $$ = $1; }
     ;
-TB  :  TB AND FB                            { Node* n = makeNode(And);
-                                              addChild(n, $1);
-                                              addChild(n, $3);
+TB  :  TB AND FB                            { node_t n = makeNode(ctx, And);
+                                              addChild(ctx, n, $1);
+                                              addChild(ctx, n, $3);
                                               $$ = n; }
     |  FB                                   { $$ = $1; }
     ;
-FB  :  FB EQ M                              { Node* n = makeNodeWithValue(to_str($2), Eq);
-                                              addChild(n, $1);
-                                              addChild(n, $3);
+FB  :  FB EQ M                              { node_t n = makeNodeWithValue(ctx, span_to_ident(ctx, $2), Eq);
+                                              addChild(ctx, n, $1);
+                                              addChild(ctx, n, $3);
                                               $$ = n; }
     |  M                                    { $$ = $1; }
     ;
-M   :  M ORDER E                            { Node* n = makeNodeWithValue(to_str($2), Order);
-                                              addChild(n, $1);
-                                              addChild(n, $3);
+M   :  M ORDER E                            { node_t n = makeNodeWithValue(ctx, span_to_ident(ctx, $2), Order);
+                                              addChild(ctx, n, $1);
+                                              addChild(ctx, n, $3);
                                               $$ = n; }
     |  E                                    { $$ = $1; }
     ;
-E   :  E ADDSUB T                           { Node* n = makeNodeWithValue(to_str($2), AddSub);
-                                              addChild(n, $1);
-                                              addChild(n, $3);
+E   :  E ADDSUB T                           { node_t n = makeNodeWithValue(ctx, span_to_ident(ctx, $2), AddSub);
+                                              addChild(ctx, n, $1);
+                                              addChild(ctx, n, $3);
                                               $$ = n; }
     |  T                                    { $$ = $1; }
     ;    
-T   :  T DIVSTAR F                          { Node* n = makeNodeWithValue(to_str($2), DivStar);
-                                              addChild(n, $1);
-                                              addChild(n, $3);
+T   :  T DIVSTAR F                          { node_t n = makeNodeWithValue(ctx, span_to_ident(ctx, $2), DivStar);
+                                              addChild(ctx, n, $1);
+                                              addChild(ctx, n, $3);
                                               $$ = n; } 
     |  F                                    { $$ = $1; }
     ;
-F   :  ADDSUB F                             { $$ = makeNodeWithValue(to_str($1), AddSub); 
-                                              addChild($$, $2); }
-    |  '!' F                                { $$ = makeNodeWithValue(to_str("!"), Negation); 
-                                              addChild($$, $2); }
+F   :  ADDSUB F                             { $$ = makeNodeWithValue(ctx, span_to_ident(ctx, $1), AddSub); 
+                                              addChild(ctx, $$, $2); }
+    |  '!' F                                { $$ = makeNodeWithValue(ctx, to_ident(ctx, "!"), Negation); 
+                                              addChild(ctx, $$, $2); }
     |  '(' Exp ')'                          { $$ = $2; }
-    |  NUM                                  { $$ = makeNodeWithValue(to_int($1), Num); }
-    |  CHARACTER                            { $$ = makeNodeWithValue(to_str($1), Character); }
+    |  NUM                                  { $$ = makeNodeWithValue(ctx, to_int($1), Num); }
+    |  CHARACTER                            { $$ = makeNodeWithValue(ctx, span_to_ident(ctx, $1), Character); }
     |  LValue                               { $$ = $1; }
-    |  IDENT '(' Arguments  ')'             { $$ = makeNodeWithValue(to_str($1), Ident);
-                                              addChild($$, $3); }
+    |  IDENT '(' Arguments  ')'             { $$ = makeNodeWithValue(ctx, span_to_ident(ctx, $1), Ident);
+                                              addChild(ctx, $$, $3); }
     ;
 LValue:
-       IDENT                                { $$ = makeNodeWithValue(to_str($1), Ident); }
-    |  IDENT '[' Exp ']'                    { $$ = makeNodeWithValue(to_str($1), Ident); 
-                                              addChild($$, $3); }
+       IDENT                                { $$ = makeNodeWithValue(ctx, span_to_ident(ctx, $1), Ident); }
+    |  IDENT '[' Exp ']'                    { $$ = makeNodeWithValue(ctx, span_to_ident(ctx, $1), Ident); 
+                                              addChild(ctx, $$, $3); }
     ;
 Arguments:
-       ListExp                              { $$ = makeNode(ListExp); 
-                                              addChild($$, $1); }
-    |                                       { $$ = makeNode(NoParametres); }
+       ListExp                              { $$ = makeNode(ctx, ListExp); 
+                                              addChild(ctx, $$, $1); }
+    |                                       { $$ = makeNode(ctx, NoParametres); }
     ;
 ListExp:
        ListExp ',' Exp                      { $$ = $1;
-                                              addSibling($$, $3); }
+                                              addSibling(ctx, $$, $3); }
     |  Exp                                  { $$ = $1; }
     ;
 %%
 
-Value to_str(char* val) {
-    if (strlen(val) >= IDENT_LEN) {
-        yyerror(NULL, "identifier too long");
-        exit(1);
+static Value make_ident(Context* ctx, const char* text, size_t len) {
+    if (len >= IDENT_LEN) {
+        // the parser stops at the next token, so the process can go on
+        yyerror(NULL, ctx, NULL, "identifier too long");
+        ctx->parse_error = true;
+        len = IDENT_LEN - 1;
     }
     Value v;
-    strcpy(v.ident, val);
+    if ((v.ident = intern(ctx, text, len)) == -1) {
+        printf("Run out of memory\n");
+        exit(3);
+    }
     return v;
 }
 
+Value to_ident(Context* ctx, const char* val) {
+    return make_ident(ctx, val, strlen(val));
+}
+
+Value span_to_ident(Context* ctx, Span span) {
+    return make_ident(ctx, ctx->source + span.offset, span.len);
+}
+
 Value to_int(int n) {
     return (Value){.num = n};
 }
 
+static node_t add_function(Context* ctx, node_t list, node_t head) {
+    node_t node = makeNode(ctx, DeclFonct);
+    addChild(ctx, node, head);
+    if (ctx->stream) {
+        stream_function(ctx, node);
+        return NO_NODE;
+    }
+    if (list != NO_NODE) {
+        addChild(ctx, list, node);
+    }
+    return node;
+}
+
+/**
+ * @brief Read the next token with the scanner chosen by the context
+ */
+static int yylex(YYSTYPE* lval, void* scanner, Context* ctx) {
+    // an error already reported by an action
+    if (ctx->parse_error) {
+        return YYerror;
+    }
+    return ctx->fast_lexer ? fast_lex(lval, scanner): flex_lex(lval, scanner);
+}
+
 /**
  * @brief Print error with the line and column where the error was triggered
  */
-void yyerror(Node** tree, char* msg) {
-    fprintf(stderr, "%s at %d:%d\n", msg, lineno, prevcolno);
+void yyerror(void* scanner, Context* ctx, node_t* tree, char* msg) {
+    fprintf(ctx->err, "%s at %d:%d\n", msg, ctx->lineno, ctx->prevcolno);
+}
+
+/**
+ * @brief Create the scanner chosen by the context
+ */
+static int open_scanner(Context* ctx, Source* source, void** scanner) {
+    return ctx->fast_lexer ? init_fast_scanner(ctx, source, scanner)
+                           : init_scanner(ctx, source, scanner);
 }
 
-int parse_file(FILE* source, Node** tree) {
-    yyin = source;
-    return yyparse(tree);
+/**
+ * @brief Free the scanner chosen by the context
+ */
+static void close_scanner(Context* ctx, void* scanner) {
+    if (ctx->fast_lexer) {
+        free_fast_scanner(scanner);
+    } else {
+        free_scanner(scanner);
+    }
+}
+
+int parse_source(Context* ctx, Source* source, node_t* tree) {
+    void* scanner;
+    if (!open_scanner(ctx, source, &scanner)) {
+        return 2;
+    }
+    // a streamed tree only holds the globals and a function at a time
+    if (!init_tree(&ctx->tree, ctx->stream ? 0: source->len)) {
+        printf("Run out of memory\n");
+        exit(3);
+    }
+    int res = yyparse(scanner, ctx, tree);
+    close_scanner(ctx, scanner);
+    return res;
+}
+
+int print_tokens(Context* ctx, Source* source) {
+    void* scanner;
+    if (!open_scanner(ctx, source, &scanner)) {
+        return 0;
+    }
+    YYSTYPE lval;
+    int token;
+    while ((token = yylex(&lval, scanner, ctx))) {
+        printf("%d:%d:%d\t%d", ctx->lineno, ctx->colno, ctx->prevcolno, token);
+        switch (token) {
+            case NUM:
+                printf("\t%d", lval.num);
+                break;
+            case TYPE: case VOID: case AND: case OR: case EQ: case ORDER:
+            case ADDSUB: case DIVSTAR: case IDENT: case CHARACTER:
+                printf("\t%.*s", (int)lval.span.len, ctx->source + lval.span.offset);
+                break;
+            default:
+                break;
+        }
+        putchar('\n');
+    }
+    printf("%d:%d:%d\tEOF\n", ctx->lineno, ctx->colno, ctx->prevcolno);
+    close_scanner(ctx, scanner);
+    // the parser scans the source again from its start
+    ctx->lineno = 1;
+    ctx->colno = ctx->prevcolno = 0;
+    return 1;
 }
@@ -0,0 +1,1387 @@
+#include "peephole.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "emit.h"
+
+#define MAX_WINDOW 4            // lines matched by a rule at most
+#define MAX_OPS 3               // operands of an instruction at most
+#define NB_VARS 6               // variables of the rules, from $a to $f
+#define MAX_SCAN 32             // instructions read to know if a register
+                                // or the flags are dead
+#define NB_REGISTERS 16
+
+typedef struct {                // text in a line, or written by a rule
+    const char* text;           // first character, NULL if none
+    int len;                    // length of the text
+} Slice;
+
+typedef enum {                  // kinds of lines of the nasm
+    LINE_OTHER,                 // empty line or comment, skipped by the rules
+    LINE_LABEL,                 // label
+    LINE_INSTR,                 // instruction
+} LineKind;
+
+typedef enum {                  // how an instruction uses its operands
+    USE_MOVE,                   // writes its first operand from its second
+    USE_PUSH,                   // pushes its operand
+    USE_POP,                    // pops its operand
+    USE_UPDATE,                 // reads its operands, then writes the first
+    USE_COMPARE,                // reads its operands
+    USE_EXTEND,                 // extends rax into rdx
+    USE_DIVIDE,                 // reads and writes rax and rdx
+    USE_JUMP,                   // jumps to its label
+    USE_BRANCH,                 // jumps to its label, or goes on
+    USE_CALL,                   // calls a function
+    USE_RETURN,                 // returns from the function
+    USE_UNKNOWN,                // unknown, or with unknown operands
+} Use;
+
+typedef enum {                  // how an instruction uses the flags
+    FLAGS_SET,                  // sets them, or leaves the function
+    FLAGS_KEPT,                 // leaves them as they are
+    FLAGS_READ,                 // may read them
+} FlagUse;
+
+#define ANY_OPS -1              // arity of the mnemonics with operands
+
+typedef struct {                // mnemonic known by the optimizer
+    const char* name;           // name, or prefix of the conditional ones,
+                                // NULL for the unknown ones
+    int len;                    // length of the name
+    bool prefix;                // if the name is a prefix
+    int nb_ops;                 // number of operands, or ANY_OPS
+    Use use;                    // use of the operands
+    FlagUse flags;              // use of the flags
+} Mnemonic;
+
+typedef struct {                // registers an instruction reads and writes
+    unsigned uses;              // registers read, a bit by register
+    unsigned defs;              // registers written without being read
+    bool barrier;               // if unknown, or a jump
+} Effect;
+
+typedef struct {                // line of the nasm of a function
+    LineKind kind;              // kind of the line
+    Slice text;                 // line as generated, with its new line
+    Slice name;                 // mnemonic of the instruction, or name of
+                                // the label
+    Slice ops[MAX_OPS];         // operands of the instruction
+    int nb_ops;                 // number of operands, -1 if not understood
+    const Mnemonic* mnemonic;   // mnemonic of the instruction, NULL in a
+                                // pattern where it is a variable
+    Effect effect;              // registers read and written, once known
+    bool known_effect;          // if the effect is known
+    bool rewritten;             // if written from its mnemonic and operands
+                                // instead of its text
+    int prev;                   // previous line kept, -1 for the first one
+    int next;                   // next line kept, -1 for the last one
+} Line;
+
+typedef struct {                // label of the function
+    Slice name;                 // name of the label, NULL text if the
+                                // bucket is empty
+    int line;                   // line of the label
+} LabelEntry;
+
+typedef struct {                // nasm of a function being rewritten
+    Line* lines;                // lines of the nasm, in the order read
+    int nb_lines;               // number of lines
+    int first;                  // first line kept, -1 if none
+    LabelEntry* labels;         // labels of the function, hashed by name
+    int nb_buckets;             // size of labels, a power of 2
+    Arena arena;                // text of the rewritten instructions
+    bool failed;                // if a rewriting failed due to memory error
+    size_t counts[NB_PEEPHOLE_RULES]; // times each rule was applied
+} Peephole;
+
+typedef struct {                // lines matched by the pattern of a rule
+    Slice vars[NB_VARS];        // values of the variables
+    unsigned bound;             // variables bound, a bit by variable
+    int lines[MAX_WINDOW];      // matched lines, in order
+    int nb_lines;               // number of matched lines
+    int after;                  // first line of code after the matched
+                                // ones, -1 if none
+} Match;
+
+typedef bool (*Guard)(Peephole* p, Match* m);
+
+/*
+ * A line of a pattern is written as in nasm, where `$a` to `$f` match any
+ * text, the same each time they are used, `name:` matches a label, and `*`
+ * any instruction. A line of a replacement is written from the values of
+ * its variables, and `@n` is the n-th matched line, unchanged. Replacements
+ * are written in the last matched lines, so that labels keep their line
+ */
+typedef struct {                // rewriting of a window of lines
+    const char* name;           // name of the rule, in the statistics
+    const char* pattern[MAX_WINDOW + 1]; // lines matched, NULL ended
+    const char* replace[MAX_WINDOW + 1]; // lines written instead, NULL ended
+    Guard guard;                // condition on the matched lines, NULL if
+                                // they are always rewritten
+} Rule;
+
+enum {                          // numbers of the registers
+    RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+    R8, R9, R10, R11, R12, R13, R14, R15
+};
+
+#define BIT(reg) (1u << (reg))
+
+// registers changed by a function, but for the returned value
+#define SCRATCH_REGS (BIT(RCX) | BIT(RDX) | BIT(RSI) | BIT(RDI) | BIT(R8) \
+                      | BIT(R9) | BIT(R10) | BIT(R11))
+
+// names of the registers, by size of 8, 4, 2 and 1 bytes
+static const char* register_names[NB_REGISTERS][4] = {
+    {"rax", "eax", "ax", "al"},     {"rcx", "ecx", "cx", "cl"},
+    {"rdx", "edx", "dx", "dl"},     {"rbx", "ebx", "bx", "bl"},
+    {"rsp", "esp", "sp", "spl"},    {"rbp", "ebp", "bp", "bpl"},
+    {"rsi", "esi", "si", "sil"},    {"rdi", "edi", "di", "dil"},
+    {"r8", "r8d", "r8w", "r8b"},    {"r9", "r9d", "r9w", "r9b"},
+    {"r10", "r10d", "r10w", "r10b"}, {"r11", "r11d", "r11w", "r11b"},
+    {"r12", "r12d", "r12w", "r12b"}, {"r13", "r13d", "r13w", "r13b"},
+    {"r14", "r14d", "r14w", "r14b"}, {"r15", "r15d", "r15w", "r15b"},
+};
+
+#define MNEMONIC(name, nb_ops, use, flags) {name, sizeof(name) - 1, false, nb_ops, use, flags}
+#define CONDITIONAL(prefix, nb_ops, use, flags) {prefix, sizeof(prefix) - 1, true, nb_ops, use, flags}
+
+// mnemonics of the generated nasm, the first one of the right name and
+// arity is taken, the last one if none
+static const Mnemonic mnemonics[] = {
+    MNEMONIC("mov", 2, USE_MOVE, FLAGS_KEPT),
+    MNEMONIC("movzx", 2, USE_MOVE, FLAGS_KEPT),
+    MNEMONIC("movsx", 2, USE_MOVE, FLAGS_KEPT),
+    MNEMONIC("lea", 2, USE_MOVE, FLAGS_KEPT),
+    MNEMONIC("push", 1, USE_PUSH, FLAGS_KEPT),
+    MNEMONIC("pop", 1, USE_POP, FLAGS_KEPT),
+    MNEMONIC("add", ANY_OPS, USE_UPDATE, FLAGS_SET),
+    MNEMONIC("sub", ANY_OPS, USE_UPDATE, FLAGS_SET),
+    MNEMONIC("and", ANY_OPS, USE_UPDATE, FLAGS_SET),
+    MNEMONIC("or", ANY_OPS, USE_UPDATE, FLAGS_SET),
+    MNEMONIC("xor", ANY_OPS, USE_UPDATE, FLAGS_SET),
+    MNEMONIC("shl", ANY_OPS, USE_UPDATE, FLAGS_SET),
+    MNEMONIC("shr", ANY_OPS, USE_UPDATE, FLAGS_SET),
+    MNEMONIC("sar", ANY_OPS, USE_UPDATE, FLAGS_SET),
+    MNEMONIC("sal", ANY_OPS, USE_UPDATE, FLAGS_SET),
+    MNEMONIC("neg", ANY_OPS, USE_UPDATE, FLAGS_SET),
+    MNEMONIC("not", ANY_OPS, USE_UPDATE, FLAGS_KEPT),
+    MNEMONIC("adc", ANY_OPS, USE_UPDATE, FLAGS_READ),
+    MNEMONIC("sbb", ANY_OPS, USE_UPDATE, FLAGS_READ),
+    MNEMONIC("inc", ANY_OPS, USE_UPDATE, FLAGS_READ),
+    MNEMONIC("dec", ANY_OPS, USE_UPDATE, FLAGS_READ),
+    MNEMONIC("cmp", ANY_OPS, USE_COMPARE, FLAGS_SET),
+    MNEMONIC("test", ANY_OPS, USE_COMPARE, FLAGS_SET),
+    MNEMONIC("cqo", 0, USE_EXTEND, FLAGS_KEPT),
+    MNEMONIC("imul", 1, USE_DIVIDE, FLAGS_SET),
+    MNEMONIC("imul", ANY_OPS, USE_UPDATE, FLAGS_SET),
+    MNEMONIC("idiv", 1, USE_DIVIDE, FLAGS_SET),
+    MNEMONIC("div", 1, USE_DIVIDE, FLAGS_SET),
+    MNEMONIC("mul", 1, USE_DIVIDE, FLAGS_SET),
+    MNEMONIC("jmp", 1, USE_JUMP, FLAGS_READ),
+    MNEMONIC("call", ANY_OPS, USE_CALL, FLAGS_SET),
+    MNEMONIC("ret", 0, USE_RETURN, FLAGS_SET),
+    CONDITIONAL("j", 1, USE_BRANCH, FLAGS_READ),
+    CONDITIONAL("set", ANY_OPS, USE_UPDATE, FLAGS_READ),
+    CONDITIONAL("cmov", ANY_OPS, USE_UPDATE, FLAGS_READ),
+    {NULL, 0, false, ANY_OPS, USE_UNKNOWN, FLAGS_READ}
+};
+
+#define NB_MNEMONICS (int)(sizeof(mnemonics) / sizeof(mnemonics[0]))
+#define UNKNOWN (&mnemonics[NB_MNEMONICS - 1])
+
+// lines of the patterns of the rules, read once
+static Line patterns[NB_PEEPHOLE_RULES][MAX_WINDOW];
+static int pattern_lengths[NB_PEEPHOLE_RULES];
+// rules whose first and second lines of pattern may be a line, by the
+// mnemonic of the instruction, then for a label and for no line, a bit by
+// rule
+#define SLOT_LABEL NB_MNEMONICS
+#define SLOT_NONE (NB_MNEMONICS + 1)
+static unsigned fitting_rules[2][NB_MNEMONICS + 2];
+static pthread_once_t patterns_once = PTHREAD_ONCE_INIT;
+
+// conditional jumps and their opposites
+static const char* inverted_jumps[][2] = {
+    {"je", "jne"}, {"jne", "je"}, {"jl", "jge"}, {"jge", "jl"},
+    {"jle", "jg"}, {"jg", "jle"}, {"jz", "jnz"}, {"jnz", "jz"},
+    {"jb", "jae"}, {"jae", "jb"}, {"jbe", "ja"}, {"ja", "jbe"},
+    {NULL, NULL}
+};
+
+static bool guard_inverted_jump(Peephole* p, Match* m);
+static bool guard_popped_register(Peephole* p, Match* m);
+static bool guard_push_over(Peephole* p, Match* m);
+static bool guard_self_move(Peephole* p, Match* m);
+static bool guard_dead_move(Peephole* p, Match* m);
+static bool guard_constant_element(Peephole* p, Match* m);
+static bool guard_forward_move(Peephole* p, Match* m);
+static bool guard_overwritten_move(Peephole* p, Match* m);
+static bool guard_load_push(Peephole* p, Match* m);
+static bool guard_forward_operand(Peephole* p, Match* m);
+static bool guard_constant_scale(Peephole* p, Match* m);
+static bool guard_frame_address(Peephole* p, Match* m);
+static bool guard_forward_address(Peephole* p, Match* m);
+static bool guard_element(Peephole* p, Match* m);
+static bool guard_address_load(Peephole* p, Match* m);
+static bool guard_address_store(Peephole* p, Match* m);
+static bool guard_reused_value(Peephole* p, Match* m);
+
+// rules, tried in order at each line
+static const Rule rules[] = {
+    {"jump-next",        {"jmp $a", "$a:"},
+                         {"@1"}, NULL},
+    {"jump-over-jump",   {"$c $a", "jmp $b", "$a:"},
+                         {"$d $b", "@2"}, guard_inverted_jump},
+    {"unreachable",      {"jmp $a", "*"},
+                         {"@0"}, NULL},
+    {"after-return",     {"ret", "*"},
+                         {"@0"}, NULL},
+    {"push-pop",         {"push $a", "pop $a"},
+                         {NULL}, NULL},
+    {"push-pop-move",    {"push $a", "pop $b"},
+                         {"mov $b, $a"}, guard_popped_register},
+    {"push-over",        {"push $a", "*", "pop $b"},
+                         {"mov $b, $a", "@1"}, guard_push_over},
+    {"self-move",        {"mov $a, $a"},
+                         {NULL}, guard_self_move},
+    {"dead-move",        {"mov $a, $b"},
+                         {NULL}, guard_dead_move},
+    {"forward-move",     {"mov $a, $b", "mov $c, $a"},
+                         {"mov $c, $b"}, guard_forward_move},
+    {"overwritten-move", {"mov $a, $b", "mov $a, $c"},
+                         {"@1"}, guard_overwritten_move},
+    {"popped-move",      {"mov $a, $b", "pop $a"},
+                         {"@1"}, guard_self_move},
+    {"load-push",        {"mov $a, $b", "push $a"},
+                         {"push $b"}, guard_load_push},
+    {"forward-operand",  {"mov $a, $b", "$c $d, $a"},
+                         {"$c $d, $b"}, guard_forward_operand},
+    {"constant-scale",   {"mov $a, $b", "imul $a, $c"},
+                         {"mov $a, $d"}, guard_constant_scale},
+    {"frame-address",    {"mov $a, rbp", "sub $a, $b"},
+                         {"lea $a, [rbp - $b]"}, guard_frame_address},
+    {"forward-address",  {"lea $a, $b", "mov $c, $a"},
+                         {"lea $c, $b"}, guard_forward_address},
+    {"constant-element", {"mov $a, $d", "lea $b, [rbp - $c]", "sub $b, $a"},
+                         {"@0", "lea $b, [rbp - $e]"}, guard_constant_element},
+    {"local-element",    {"imul $a, 8", "lea $b, [rbp - $c]", "sub $b, $a"},
+                         {"neg $a", "lea $b, [rbp + $a*8 - $c]"}, guard_element},
+    {"global-element",   {"imul $a, 8", "mov $b, globals", "add $b, $c", "add $b, $a"},
+                         {"@1", "lea $b, [$b + $a*8 + $c]"}, guard_element},
+    {"address-load",     {"lea $a, $b", "mov $c, qword [$a]"},
+                         {"mov $c, qword $b"}, guard_address_load},
+    {"address-store",    {"lea $a, $b", "pop qword [$a]"},
+                         {"pop qword $b"}, guard_address_store},
+    {"reused-value",     {"mov $a, $b", "*", "mov $a, $b"},
+                         {"@0", "@1"}, guard_reused_value},
+};
+
+_Static_assert(sizeof(rules) / sizeof(rules[0]) == NB_PEEPHOLE_RULES,
+               "NB_PEEPHOLE_RULES is the number of rules");
+_Static_assert(NB_PEEPHOLE_RULES <= 32, "the rules are a bit in an unsigned");
+
+/**
+ * @brief Read the nasm of a function as lines, and index its labels
+ *
+ * @param p peephole optimizer
+ * @param nasm nasm of the function
+ * @param len length of the nasm
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+static int read_lines(Peephole* p, const char* nasm, size_t len);
+
+/**
+ * @brief Split a line into a label or an instruction and its operands,
+ *        leaving out its comment
+ *
+ * @param line line whose text is read
+ */
+static void parse_line(Line* line);
+
+/**
+ * @brief Split the code of an instruction into its mnemonic and operands
+ *
+ * @param line line of the instruction
+ * @param cur start of the code
+ * @param end end of the code, before its comment
+ */
+static void parse_instruction(Line* line, const char* cur, const char* end);
+
+/**
+ * @brief Give the mnemonic of an instruction
+ *
+ * @param name name of the instruction
+ * @param nb_ops number of its operands
+ * @return mnemonic, the unknown one if none
+ */
+static const Mnemonic* find_mnemonic(Slice name, int nb_ops);
+
+/**
+ * @brief Read the patterns of the rules as lines, once for all the
+ *        functions
+ */
+static void read_patterns(void);
+
+/**
+ * @brief Give the line of a label of the function
+ *
+ * @param p peephole optimizer
+ * @param name name of the label
+ * @return line of the label
+ *         -1 if the function has no such label
+ */
+static int find_label(const Peephole* p, Slice name);
+
+/**
+ * @brief Give the next line of code, label or instruction, after a line
+ *
+ * @param p peephole optimizer
+ * @param line line kept
+ * @return next line of code
+ *         -1 if none
+ */
+static int next_code(const Peephole* p, int line);
+
+/**
+ * @brief Give the previous line of code, label or instruction, before a line
+ *
+ * @param p peephole optimizer
+ * @param line line kept
+ * @return previous line of code
+ *         -1 if none
+ */
+static int prev_code(const Peephole* p, int line);
+
+/**
+ * @brief Give the slot of a line in `fitting_rules`
+ *
+ * @param p peephole optimizer
+ * @param line line of code, -1 if none
+ * @return slot of the line
+ */
+static int slot_of(const Peephole* p, int line);
+
+/**
+ * @brief Match the pattern of a rule at a line, and check its guard
+ *
+ * @param p peephole optimizer
+ * @param rule rule to match
+ * @param line first line of the window
+ * @param m variables and lines matched
+ * @return true if the rule applies
+ */
+static bool match_rule(Peephole* p, const Rule* rule, int line, Match* m);
+
+/**
+ * @brief Tell if a line has the kind, the mnemonic and the number of
+ *        operands of a line of a pattern
+ *
+ * @param pattern line of the pattern
+ * @param line line of the nasm
+ * @return true if it may match
+ */
+static bool fits_line(const Line* pattern, const Line* line);
+
+/**
+ * @brief Match the text of a line of a pattern, which it fits
+ *
+ * @param m variables bound by the previous lines
+ * @param pattern line of the pattern
+ * @param line line of the nasm
+ * @return true if it matches
+ */
+static bool match_line(Match* m, const Line* pattern, const Line* line);
+
+/**
+ * @brief Match a text of a pattern, binding its variables
+ *
+ * @param m variables bound so far
+ * @param pattern text of the pattern
+ * @param text text to match
+ * @return true if it matches
+ */
+static bool match_text(Match* m, Slice pattern, Slice text);
+
+/**
+ * @brief Write the replacement of a matched rule in place of its lines
+ *
+ * @param p peephole optimizer
+ * @param rule matched rule
+ * @param m variables and lines matched
+ * @return line from where rules are tried again
+ *         -2 if fail due to memory error
+ */
+static int rewrite(Peephole* p, const Rule* rule, const Match* m);
+
+/**
+ * @brief Apply the rules to the lines of a function until none applies
+ *
+ * @param p peephole optimizer
+ */
+static void optimize(Peephole* p);
+
+/**
+ * @brief Write the lines kept, the rewritten instructions with the layout
+ *        of the generated ones
+ *
+ * @param ctx compilation context
+ * @param p peephole optimizer
+ */
+static void write_lines(Context* ctx, const Peephole* p);
+
+/**
+ * @brief Tell which registers an instruction reads and writes
+ *
+ * @param line line of the instruction, with its mnemonic
+ * @return registers read and written
+ */
+static Effect effect_of(const Line* line);
+
+/**
+ * @brief Give the registers a line reads and writes, told once by line
+ *
+ * @param p peephole optimizer
+ * @param line line of code
+ * @return registers read and written
+ */
+static Effect effect_at(Peephole* p, int line);
+
+/**
+ * @brief Tell if a register is written before being read, on every path
+ *        from a line
+ *
+ * @param p peephole optimizer
+ * @param line first line of code of the paths, -1 if none
+ * @param reg number of the register
+ * @param budget instructions left to read, shared by the paths
+ * @return true if its value is not used, false if unknown
+ */
+static bool is_dead(Peephole* p, int line, int reg, int* budget);
+
+/**
+ * @brief Tell if the flags are set again before being read from a line
+ *
+ * @param p peephole optimizer
+ * @param line first line of code, -1 if none
+ * @return true if they are not used, false if unknown
+ */
+static bool flags_dead(const Peephole* p, int line);
+
+/**
+ * @brief Give the number and the size of a register
+ *
+ * @param word name of the register
+ * @param size index of its size in `register_names`, 0 for 8 bytes
+ * @return number of the register
+ *         -1 if the word is not a register
+ */
+static int find_register(Slice word, int* size);
+
+/**
+ * @brief Give the number of a register of 64 bits
+ *
+ * @param s operand
+ * @return number of the register
+ *         -1 if the operand is not a register of 64 bits
+ */
+static int register_of(Slice s);
+
+/**
+ * @brief Give the registers read by an operand, as a register or in an
+ *        address
+ *
+ * @param s operand
+ * @return registers, a bit by register
+ */
+static unsigned registers_in(Slice s);
+
+/**
+ * @brief Read a decimal integer
+ *
+ * @param s operand
+ * @param value integer read
+ * @return true if the operand is an integer of 32 bits
+ */
+static bool read_number(Slice s, long* value);
+
+/**
+ * @brief Bind a variable to an integer, written in the arena
+ *
+ * @param p peephole optimizer
+ * @param m variables of the match
+ * @param var index of the variable
+ * @param value integer
+ * @return true if success
+ *         false if fail due to memory error
+ */
+static bool bind_number(Peephole* p, Match* m, int var, long value);
+
+static inline bool is_word_char(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+           || (c >= '0' && c <= '9') || c == '_' || c == '.';
+}
+
+static inline bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline bool is_text(Slice s, const char* text) {
+    return s.len == (int)strlen(text) && !memcmp(s.text, text, s.len);
+}
+
+static inline bool is_memory(Slice s) {
+    return memchr(s.text, '[', s.len) != NULL;
+}
+
+// memory of 8 bytes, whose size is written
+static inline bool is_qword(Slice s) {
+    return s.len > 6 && !memcmp(s.text, "qword ", 6) && is_memory(s);
+}
+
+// if `mov dst, src` can be written
+static bool can_move(Slice dst, Slice src) {
+    long value;
+    if (register_of(dst) >= 0) {
+        return !is_memory(src) || is_qword(src) || src.text[0] == '[';
+    }
+    return is_qword(dst) && (register_of(src) >= 0 || read_number(src, &value));
+}
+
+// if an operation on dst with src, as `add dst, src`, can be written
+static bool can_operate(Slice dst, Slice src) {
+    long value;
+    if (register_of(dst) >= 0) {
+        return register_of(src) >= 0 || is_qword(src) || read_number(src, &value);
+    }
+    return is_qword(dst) && (register_of(src) >= 0 || read_number(src, &value));
+}
+
+static bool guard_inverted_jump(Peephole* p, Match* m) {
+    for (int i = 0; inverted_jumps[i][0]; i++) {
+        if (is_text(m->vars[2], inverted_jumps[i][0])) {
+            m->vars[3] = (Slice){inverted_jumps[i][1], strlen(inverted_jumps[i][1])};
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool guard_popped_register(Peephole* p, Match* m) {
+    return !((registers_in(m->vars[0]) | registers_in(m->vars[1])) & BIT(RSP))
+           && can_move(m->vars[1], m->vars[0]);
+}
+
+static bool guard_push_over(Peephole* p, Match* m) {
+    // the instruction neither uses the stack nor what is popped
+    const Line* line = &p->lines[m->lines[1]];
+    Effect e = effect_at(p, m->lines[1]);
+    unsigned popped = registers_in(m->vars[1]);
+    bool memory = false;
+    for (int i = 0; i < line->nb_ops; i++) {
+        memory = memory || is_memory(line->ops[i]);
+    }
+    if (e.barrier || ((e.uses | e.defs | popped | registers_in(m->vars[0])) & BIT(RSP))
+        || !can_move(m->vars[1], m->vars[0])) {
+        return false;
+    }
+    if (register_of(m->vars[1]) >= 0) {
+        return !((e.uses | e.defs) & popped);
+    }
+    return !memory && !(e.defs & popped);
+}
+
+static bool guard_self_move(Peephole* p, Match* m) {
+    return register_of(m->vars[0]) >= 0;
+}
+
+static bool guard_dead_move(Peephole* p, Match* m) {
+    int reg = register_of(m->vars[0]);
+    int budget = MAX_SCAN;
+    return reg >= 0 && reg != RSP && reg != RBP
+           && is_dead(p, m->after, reg, &budget);
+}
+
+static bool guard_constant_element(Peephole* p, Match* m) {
+    // the address is rbp - (offset + index), the index is kept
+    int index = register_of(m->vars[0]);
+    int base = register_of(m->vars[1]);
+    long offset, scaled;
+    return index >= 0 && base >= 0 && index != base && base != RSP
+           && read_number(m->vars[2], &offset) && read_number(m->vars[3], &scaled)
+           && offset + scaled >= 0 && offset + scaled <= INT32_MAX
+           && flags_dead(p, m->after) && bind_number(p, m, 4, offset + scaled);
+}
+
+static bool guard_forward_move(Peephole* p, Match* m) {
+    int reg = register_of(m->vars[0]);
+    int budget = MAX_SCAN;
+    return reg >= 0 && !(registers_in(m->vars[2]) & BIT(reg))
+           && can_move(m->vars[2], m->vars[1])
+           && is_dead(p, m->after, reg, &budget);
+}
+
+static bool guard_overwritten_move(Peephole* p, Match* m) {
+    int reg = register_of(m->vars[0]);
+    return reg >= 0 && !(registers_in(m->vars[2]) & BIT(reg));
+}
+
+static bool guard_load_push(Peephole* p, Match* m) {
+    int reg = register_of(m->vars[0]);
+    Slice value = m->vars[1];
+    long number;
+    int budget = MAX_SCAN;
+    return reg >= 0 && reg != RSP && !(registers_in(value) & BIT(RSP))
+           && (register_of(value) >= 0 || is_qword(value) || read_number(value, &number))
+           && is_dead(p, m->after, reg, &budget);
+}
+
+static bool guard_forward_operand(Peephole* p, Match* m) {
+    static const char* operations[] = {"add", "sub", "cmp", "and", "or", "xor", NULL};
+    int reg = register_of(m->vars[0]);
+    int budget = MAX_SCAN;
+    bool operation = false;
+    for (int i = 0; operations[i]; i++) {
+        operation = operation || is_text(m->vars[2], operations[i]);
+    }
+    return operation && reg >= 0 && !(registers_in(m->vars[3]) & BIT(reg))
+           && can_operate(m->vars[3], m->vars[1])
+           && is_dead(p, m->after, reg, &budget);
+}
+
+static bool guard_constant_scale(Peephole* p, Match* m) {
+    long value, scale;
+    return register_of(m->vars[0]) >= 0 && read_number(m->vars[1], &value)
+           && read_number(m->vars[2], &scale) && flags_dead(p, m->after)
+           && bind_number(p, m, 3, value * scale);
+}
+
+static bool guard_frame_address(Peephole* p, Match* m) {
+    int reg = register_of(m->vars[0]);
+    long offset;
+    return reg >= 0 && reg != RSP && read_number(m->vars[1], &offset)
+           && offset >= 0 && flags_dead(p, m->after);
+}
+
+static bool guard_forward_address(Peephole* p, Match* m) {
+    int reg = register_of(m->vars[0]);
+    int budget = MAX_SCAN;
+    return reg >= 0 && register_of(m->vars[2]) >= 0
+           && is_dead(p, m->after, reg, &budget);
+}
+
+static bool guard_element(Peephole* p, Match* m) {
+    // the index is changed, or no longer scaled
+    int index = register_of(m->vars[0]);
+    int base = register_of(m->vars[1]);
+    long offset;
+    int budget = MAX_SCAN;
+    return index >= 0 && base >= 0 && index != base && index != RSP
+           && base != RSP && read_number(m->vars[2], &offset) && offset >= 0
+           && flags_dead(p, m->after) && is_dead(p, m->after, index, &budget);
+}
+
+static bool guard_address_load(Peephole* p, Match* m) {
+    int reg = register_of(m->vars[0]);
+    int dst = register_of(m->vars[2]);
+    int budget = MAX_SCAN;
+    return reg >= 0 && dst >= 0
+           && (dst == reg || is_dead(p, m->after, reg, &budget));
+}
+
+static bool guard_address_store(Peephole* p, Match* m) {
+    int reg = register_of(m->vars[0]);
+    int budget = MAX_SCAN;
+    return reg >= 0 && is_dead(p, m->after, reg, &budget);
+}
+
+static bool guard_reused_value(Peephole* p, Match* m) {
+    // the instruction changes neither the register nor the value
+    Effect e = effect_at(p, m->lines[1]);
+    int reg = register_of(m->vars[0]);
+    unsigned value = registers_in(m->vars[1]);
+    return reg >= 0 && !is_memory(m->vars[1]) && !(value & BIT(reg))
+           && !e.barrier && !(e.defs & (BIT(reg) | value));
+}
+
+int write_peephole(Context* ctx, const char* nasm, size_t len) {
+    Peephole p = {.lines = NULL, .labels = NULL, .failed = false};
+    pthread_once(&patterns_once, read_patterns);
+    init_arena(&p.arena);
+    int res = read_lines(&p, nasm, len);
+    if (res) {
+        optimize(&p);
+        res = !p.failed;
+    }
+    if (res) {
+        write_lines(ctx, &p);
+        for (int i = 0; i < NB_PEEPHOLE_RULES; i++) {
+            ctx->stats.peephole_rules[i] += p.counts[i];
+        }
+    }
+    free(p.lines);
+    free(p.labels);
+    free_arena(&p.arena);
+    return res;
+}
+
+const char* peephole_rule_name(int rule) {
+    return rules[rule].name;
+}
+
+static int read_lines(Peephole* p, const char* nasm, size_t len) {
+    int nb_lines = 0;
+    for (const char* cur = nasm; cur < nasm + len; nb_lines++) {
+        const char* end = memchr(cur, '\n', nasm + len - cur);
+        cur = end ? end + 1: nasm + len;
+    }
+    if (nb_lines && !(p->lines = malloc(nb_lines * sizeof(Line)))) {
+        return 0;
+    }
+    int nb_labels = 0;
+    const char* cur = nasm;
+    for (int i = 0; i < nb_lines; i++) {
+        const char* end = memchr(cur, '\n', nasm + len - cur);
+        end = end ? end + 1: nasm + len;
+        Line* line = &p->lines[i];
+        line->text = (Slice){cur, end - cur};
+        line->rewritten = false;
+        line->prev = i - 1;
+        line->next = i + 1 < nb_lines ? i + 1: -1;
+        parse_line(line);
+        nb_labels += line->kind == LINE_LABEL;
+        cur = end;
+    }
+    p->nb_lines = nb_lines;
+    p->first = nb_lines ? 0: -1;
+
+    // labels are never removed, so they keep their line
+    p->nb_buckets = 8;
+    while (p->nb_buckets < 2 * nb_labels) {
+        p->nb_buckets *= 2;
+    }
+    if (!(p->labels = calloc(p->nb_buckets, sizeof(LabelEntry)))) {
+        return 0;
+    }
+    for (int i = 0; i < nb_lines; i++) {
+        if (p->lines[i].kind == LINE_LABEL && find_label(p, p->lines[i].name) < 0) {
+            Slice name = p->lines[i].name;
+            unsigned hash = 2166136261u;
+            for (int c = 0; c < name.len; c++) {
+                hash = (hash ^ (unsigned char)name.text[c]) * 16777619u;
+            }
+            int bucket = hash & (p->nb_buckets - 1);
+            while (p->labels[bucket].name.text) {
+                bucket = (bucket + 1) & (p->nb_buckets - 1);
+            }
+            p->labels[bucket] = (LabelEntry){name, i};
+        }
+    }
+    return 1;
+}
+
+static void parse_line(Line* line) {
+    const char* cur = line->text.text;
+    const char* end = cur + line->text.len;
+    if (end > cur && end[-1] == '\n') {
+        end--;
+    }
+    // the comment starts at a semicolon out of quotes
+    const char* code_end = cur;
+    char quote = 0;
+    for (; code_end < end && (quote || *code_end != ';'); code_end++) {
+        if (quote && *code_end == quote) {
+            quote = 0;
+        } else if (!quote && (*code_end == '\'' || *code_end == '"')) {
+            quote = *code_end;
+        }
+    }
+    while (cur < code_end && is_blank(*cur)) {
+        cur++;
+    }
+    while (code_end > cur && is_blank(code_end[-1])) {
+        code_end--;
+    }
+    line->kind = LINE_OTHER;
+    line->nb_ops = 0;
+    line->mnemonic = UNKNOWN;
+    line->known_effect = false;
+    if (cur == code_end) {
+        return;
+    }
+    const char* word = cur;
+    while (word < code_end && !is_blank(*word)) {
+        word++;
+    }
+    if (word == code_end && word[-1] == ':') {
+        line->kind = LINE_LABEL;
+        line->name = (Slice){cur, word - 1 - cur};
+        return;
+    }
+    parse_instruction(line, cur, code_end);
+}
+
+static void parse_instruction(Line* line, const char* cur, const char* end) {
+    const char* word = cur;
+    while (cur < end && !is_blank(*cur)) {
+        cur++;
+    }
+    line->kind = LINE_INSTR;
+    line->name = (Slice){word, cur - word};
+    line->nb_ops = 0;
+    line->mnemonic = UNKNOWN;
+    line->known_effect = false;
+    while (cur < end) {
+        while (cur < end && is_blank(*cur)) {
+            cur++;
+        }
+        // operands are separated by commas out of brackets and quotes
+        const char* op = cur;
+        int depth = 0;
+        char quote = 0;
+        for (; cur < end && (quote || depth || *cur != ','); cur++) {
+            if (quote) {
+                quote = *cur == quote ? 0: quote;
+            } else if (*cur == '\'' || *cur == '"') {
+                quote = *cur;
+            } else {
+                depth += (*cur == '[') - (*cur == ']');
+            }
+        }
+        const char* op_end = cur;
+        while (op_end > op && is_blank(op_end[-1])) {
+            op_end--;
+        }
+        if (line->nb_ops == MAX_OPS || op_end == op) {
+            line->nb_ops = -1;
+            return;
+        }
+        line->ops[line->nb_ops++] = (Slice){op, op_end - op};
+        if (cur < end) {
+            cur++; // comma
+        }
+    }
+    line->mnemonic = find_mnemonic(line->name, line->nb_ops);
+}
+
+static const Mnemonic* find_mnemonic(Slice name, int nb_ops) {
+    const Mnemonic* mn = mnemonics;
+    for (; mn->name; mn++) {
+        bool same = mn->prefix ? mn->len < name.len: mn->len == name.len;
+        if (same && !memcmp(mn->name, name.text, mn->len)
+            && (mn->nb_ops == nb_ops || (mn->nb_ops == ANY_OPS && nb_ops > 0))) {
+            break;
+        }
+    }
+    return mn;
+}
+
+static void read_patterns(void) {
+    for (int rule = 0; rule < NB_PEEPHOLE_RULES; rule++) {
+        int i = 0;
+        for (; rules[rule].pattern[i]; i++) {
+            Line* line = &patterns[rule][i];
+            const char* text = rules[rule].pattern[i];
+            *line = (Line){.text = {text, strlen(text)}};
+            parse_line(line);
+            if (line->kind == LINE_INSTR && !strcmp(text, "*")) {
+                line->kind = LINE_OTHER; // any instruction
+            } else if (line->kind == LINE_INSTR && line->name.text[0] == '$') {
+                line->mnemonic = NULL;
+            }
+        }
+        pattern_lengths[rule] = i;
+
+        for (int j = 0; j < 2; j++) {
+            const Line* pattern = &patterns[rule][j];
+            for (int slot = 0; slot <= SLOT_NONE; slot++) {
+                bool fits = j >= i;
+                if (j < i && pattern->kind == LINE_LABEL) {
+                    fits = slot == SLOT_LABEL;
+                } else if (j < i) {
+                    fits = slot < NB_MNEMONICS && (pattern->kind == LINE_OTHER
+                           || !pattern->mnemonic || pattern->mnemonic == &mnemonics[slot]);
+                }
+                fitting_rules[j][slot] |= (unsigned)fits << rule;
+            }
+        }
+    }
+}
+
+static int find_label(const Peephole* p, Slice name) {
+    unsigned hash = 2166136261u;
+    for (int c = 0; c < name.len; c++) {
+        hash = (hash ^ (unsigned char)name.text[c]) * 16777619u;
+    }
+    int bucket = hash & (p->nb_buckets - 1);
+    for (; p->labels[bucket].name.text; bucket = (bucket + 1) & (p->nb_buckets - 1)) {
+        Slice label = p->labels[bucket].name;
+        if (label.len == name.len && !memcmp(label.text, name.text, name.len)) {
+            return p->labels[bucket].line;
+        }
+    }
+    return -1;
+}
+
+static int next_code(const Peephole* p, int line) {
+    line = p->lines[line].next;
+    while (line >= 0 && p->lines[line].kind == LINE_OTHER) {
+        line = p->lines[line].next;
+    }
+    return line;
+}
+
+static int prev_code(const Peephole* p, int line) {
+    line = p->lines[line].prev;
+    while (line >= 0 && p->lines[line].kind == LINE_OTHER) {
+        line = p->lines[line].prev;
+    }
+    return line;
+}
+
+static int slot_of(const Peephole* p, int line) {
+    if (line < 0) {
+        return SLOT_NONE;
+    }
+    if (p->lines[line].kind == LINE_LABEL) {
+        return SLOT_LABEL;
+    }
+    return p->lines[line].mnemonic - mnemonics;
+}
+
+static bool match_rule(Peephole* p, const Rule* rule, int line, Match* m) {
+    // the lines are told apart by their mnemonics before their text
+    int index = rule - rules;
+    m->nb_lines = 0;
+    for (int i = 0; i < pattern_lengths[index]; i++) {
+        if (line < 0 || !fits_line(&patterns[index][i], &p->lines[line])) {
+            return false;
+        }
+        m->lines[m->nb_lines++] = line;
+        line = next_code(p, line);
+    }
+    m->after = line;
+    m->bound = 0;
+    for (int i = 0; i < m->nb_lines; i++) {
+        if (!match_line(m, &patterns[index][i], &p->lines[m->lines[i]])) {
+            return false;
+        }
+    }
+    return !rule->guard || rule->guard(p, m);
+}
+
+static bool fits_line(const Line* pattern, const Line* line) {
+    switch (pattern->kind) {
+    case LINE_OTHER:
+        return line->kind == LINE_INSTR;
+    case LINE_LABEL:
+        return line->kind == LINE_LABEL;
+    default:
+        return line->kind == LINE_INSTR && line->nb_ops == pattern->nb_ops
+               && (!pattern->mnemonic || (pattern->mnemonic == line->mnemonic
+                   && pattern->name.len == line->name.len
+                   && !memcmp(pattern->name.text, line->name.text, line->name.len)));
+    }
+}
+
+static bool match_line(Match* m, const Line* pattern, const Line* line) {
+    if (pattern->kind == LINE_OTHER) {
+        return true;
+    }
+    if (pattern->kind == LINE_LABEL || !pattern->mnemonic) {
+        if (!match_text(m, pattern->name, line->name)) {
+            return false;
+        }
+    }
+    for (int op = 0; op < pattern->nb_ops; op++) {
+        if (!match_text(m, pattern->ops[op], line->ops[op])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool match_text(Match* m, Slice pattern, Slice text) {
+    int pos = 0;
+    int len = pattern.len;
+    for (int i = 0; i < len;) {
+        if (pattern.text[i] != '$' || i + 1 == len) {
+            if (pos == text.len || text.text[pos] != pattern.text[i]) {
+                return false;
+            }
+            pos++;
+            i++;
+            continue;
+        }
+        // a variable runs to the next character of the pattern
+        int index = pattern.text[i + 1] - 'a';
+        Slice* var = &m->vars[index];
+        i += 2;
+        int end = text.len;
+        if (i < len) {
+            const char* next = memchr(text.text + pos, pattern.text[i], text.len - pos);
+            if (!next) {
+                return false;
+            }
+            end = next - text.text;
+        }
+        Slice value = {text.text + pos, end - pos};
+        if (!value.len) {
+            return false;
+        }
+        if (m->bound >> index & 1) {
+            if (var->len != value.len || memcmp(var->text, value.text, value.len)) {
+                return false;
+            }
+        } else {
+            *var = value;
+            m->bound |= 1u << index;
+        }
+        pos = end;
+    }
+    return pos == text.len;
+}
+
+static int rewrite(Peephole* p, const Rule* rule, const Match* m) {
+    Line replaced[MAX_WINDOW];
+    int nb_replaced = 0;
+    for (; rule->replace[nb_replaced]; nb_replaced++) {
+        const char* cur = rule->replace[nb_replaced];
+        Line* line = &replaced[nb_replaced];
+        if (cur[0] == '@') {
+            *line = p->lines[m->lines[cur[1] - '0']];
+            continue;
+        }
+        // the variables are written in the text of the instruction
+        int len = 0;
+        for (const char* c = cur; *c; c++) {
+            len += *c == '$' ? m->vars[*++c - 'a'].len: 1;
+        }
+        char* text = arena_alloc(&p->arena, len);
+        if (!text) {
+            return -2;
+        }
+        char* out = text;
+        for (const char* c = cur; *c; c++) {
+            if (*c == '$') {
+                Slice var = m->vars[*++c - 'a'];
+                memcpy(out, var.text, var.len);
+                out += var.len;
+            } else {
+                *out++ = *c;
+            }
+        }
+        parse_instruction(line, text, text + len);
+        line->rewritten = true;
+    }
+
+    // the replacement takes the last lines, the first ones are removed
+    int removed = m->nb_lines - nb_replaced;
+    int restart = nb_replaced ? m->lines[removed]: prev_code(p, m->lines[0]);
+    for (int i = 0; i < m->nb_lines; i++) {
+        Line* line = &p->lines[m->lines[i]];
+        if (i >= removed) {
+            int prev = line->prev;
+            int next = line->next;
+            *line = replaced[i - removed];
+            line->prev = prev;
+            line->next = next;
+            continue;
+        }
+        if (line->prev >= 0) {
+            p->lines[line->prev].next = line->next;
+        } else {
+            p->first = line->next;
+        }
+        if (line->next >= 0) {
+            p->lines[line->next].prev = line->prev;
+        }
+    }
+    // rules of two lines ending at the rewritten lines may apply now, the
+    // longer ones are left to the next pass
+    if (restart >= 0 && prev_code(p, restart) >= 0) {
+        restart = prev_code(p, restart);
+    }
+    return restart;
+}
+
+static void optimize(Peephole* p) {
+    bool changed = true;
+    // rules looking forward may apply after a rewriting further down
+    while (changed && !p->failed) {
+        changed = false;
+        int line = p->first;
+        if (line >= 0 && p->lines[line].kind == LINE_OTHER) {
+            line = next_code(p, line);
+        }
+        while (line >= 0) {
+            Match m;
+            unsigned candidates = fitting_rules[0][slot_of(p, line)]
+                                  & fitting_rules[1][slot_of(p, next_code(p, line))];
+            int rule = 0;
+            while (rule < NB_PEEPHOLE_RULES && !((candidates >> rule & 1)
+                                                 && match_rule(p, &rules[rule], line, &m))) {
+                rule++;
+            }
+            if (rule == NB_PEEPHOLE_RULES) {
+                line = next_code(p, line);
+                continue;
+            }
+            p->counts[rule]++;
+            changed = true;
+            line = rewrite(p, &rules[rule], &m);
+            if (line == -2) {
+                p->failed = true;
+                return;
+            }
+            if (line < 0) {
+                line = p->first;
+                if (line >= 0 && p->lines[line].kind == LINE_OTHER) {
+                    line = next_code(p, line);
+                }
+            }
+        }
+    }
+}
+
+static void write_lines(Context* ctx, const Peephole* p) {
+    for (int i = p->first; i >= 0; i = p->lines[i].next) {
+        const Line* line = &p->lines[i];
+        if (!line->rewritten) {
+            // the lines kept one after the other are written at once
+            const char* end = line->text.text + line->text.len;
+            for (int next = line->next; next >= 0 && !p->lines[next].rewritten
+                 && p->lines[next].text.text == end; next = p->lines[next].next) {
+                end += p->lines[next].text.len;
+                i = next;
+            }
+            emit_bytes(ctx, line->text.text, end - line->text.text);
+            continue;
+        }
+        EMIT(ctx, "\t");
+        emit_bytes(ctx, line->name.text, line->name.len);
+        if (line->nb_ops > 0 && line->name.len < 4) {
+            emit_bytes(ctx, "    ", 4 - line->name.len);
+        }
+        for (int op = 0; op < line->nb_ops; op++) {
+            emit(ctx, op ? ", ": "\t");
+            emit_bytes(ctx, line->ops[op].text, line->ops[op].len);
+        }
+        EMIT(ctx, "\n");
+    }
+}
+
+static Effect effect_at(Peephole* p, int line) {
+    Line* l = &p->lines[line];
+    if (!l->known_effect) {
+        l->effect = effect_of(l);
+        l->known_effect = true;
+    }
+    return l->effect;
+}
+
+static Effect effect_of(const Line* line) {
+    Effect e = {.uses = 0, .defs = 0, .barrier = false};
+    if (line->kind != LINE_INSTR) {
+        e.barrier = line->kind == LINE_LABEL;
+        return e;
+    }
+    const Slice* ops = line->ops;
+    int nb_ops = line->nb_ops;
+    for (int i = 0; i < nb_ops; i++) {
+        e.uses |= registers_in(ops[i]);
+    }
+    // a register of 32 bits is written whole, but not one of 8 or 16 bits,
+    // and the registers of an address are read
+    int size = 0;
+    int reg = nb_ops ? find_register(ops[0], &size): -1;
+    unsigned dst = reg >= 0 ? BIT(reg): 0;
+    unsigned partial = nb_ops && (reg < 0 || size > 1) ? registers_in(ops[0]): 0;
+
+    switch (line->mnemonic->use) {
+    case USE_MOVE:
+        e.uses = registers_in(ops[1]) | partial;
+        e.defs = dst;
+        break;
+    case USE_PUSH:
+        e.uses |= BIT(RSP);
+        e.defs = BIT(RSP);
+        break;
+    case USE_POP:
+        e.uses = BIT(RSP) | partial;
+        e.defs = BIT(RSP) | dst;
+        break;
+    case USE_UPDATE:
+        // the destination is read, then written
+        e.defs = dst;
+        break;
+    case USE_COMPARE:
+        break;
+    case USE_EXTEND:
+        e.uses = BIT(RAX);
+        e.defs = BIT(RDX);
+        break;
+    case USE_DIVIDE:
+        e.uses |= BIT(RAX) | BIT(RDX);
+        e.defs = BIT(RAX) | BIT(RDX);
+        break;
+    default:
+        e.barrier = true;
+        break;
+    }
+    return e;
+}
+
+static bool is_dead(Peephole* p, int line, int reg, int* budget) {
+    for (; line >= 0 && (*budget)-- > 0; line = next_code(p, line)) {
+        const Line* l = &p->lines[line];
+        if (l->kind == LINE_LABEL) {
+            continue;
+        }
+        switch (l->mnemonic->use) {
+        case USE_JUMP:
+            line = find_label(p, l->ops[0]);
+            if (line < 0) {
+                return false;
+            }
+            continue;
+        case USE_BRANCH: {
+            // both the target and the next instruction are followed
+            int target = find_label(p, l->ops[0]);
+            if (target < 0 || !is_dead(p, target, reg, budget)) {
+                return false;
+            }
+            continue;
+        }
+        case USE_RETURN:
+            return BIT(reg) & SCRATCH_REGS;
+        case USE_CALL:
+            // the call returns in rax, and r10 and r11 are changed by the
+            // functions and the system calls of the builtins
+            return BIT(reg) & (BIT(RAX) | BIT(R10) | BIT(R11));
+        default:
+            break;
+        }
+        Effect e = effect_at(p, line);
+        if (e.barrier || e.uses & BIT(reg)) {
+            return false;
+        }
+        if (e.defs & BIT(reg)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool flags_dead(const Peephole* p, int line) {
+    for (int n = 0; line >= 0 && n < MAX_SCAN; line = next_code(p, line), n++) {
+        const Line* l = &p->lines[line];
+        if (l->kind == LINE_LABEL) {
+            continue;
+        }
+        if (l->mnemonic->flags != FLAGS_KEPT) {
+            return l->mnemonic->flags == FLAGS_SET;
+        }
+    }
+    return false;
+}
+
+static int find_register(Slice word, int* size) {
+    const char* w = word.text;
+    if (word.len < 2 || word.len > 4) {
+        return -1;
+    }
+    if (w[0] == 'r' && w[1] >= '0' && w[1] <= '9') {
+        // r8 to r15, with a suffix for the smaller sizes
+        static const char suffixes[] = "dwb";
+        int digits = w[1] == '1' && word.len > 2 && w[2] >= '0' && w[2] <= '9' ? 2: 1;
+        int reg = digits == 2 ? 10 + w[2] - '0': w[1] - '0';
+        const char* suffix = memchr(suffixes, w[word.len - 1], 3);
+        if (reg < R8 || reg >= NB_REGISTERS || word.len > digits + 2
+            || (word.len == digits + 2 && !suffix)) {
+            return -1;
+        }
+        *size = word.len == digits + 1 ? 0: suffix - suffixes + 1;
+        return reg;
+    }
+    for (int reg = RAX; reg < R8; reg++) {
+        for (int i = 0; i < 4; i++) {
+            const char* name = register_names[reg][i];
+            if (name[0] == w[0] && name[1] == w[1] && (int)strlen(name) == word.len
+                && !memcmp(name, w, word.len)) {
+                *size = i;
+                return reg;
+            }
+        }
+    }
+    return -1;
+}
+
+static int register_of(Slice s) {
+    int size;
+    int reg = find_register(s, &size);
+    return reg >= 0 && size == 0 ? reg: -1;
+}
+
+static unsigned registers_in(Slice s) {
+    unsigned regs = 0;
+    for (int i = 0; i < s.len;) {
+        if (s.text[i] == '\'' || s.text[i] == '"') {
+            const char* close = memchr(s.text + i + 1, s.text[i], s.len - i - 1);
+            i = close ? close - s.text + 1: s.len;
+            continue;
+        }
+        if (!is_word_char(s.text[i])) {
+            i++;
+            continue;
+        }
+        Slice word = {s.text + i, 0};
+        while (i < s.len && is_word_char(s.text[i])) {
+            i++;
+            word.len++;
+        }
+        int size;
+        int reg = find_register(word, &size);
+        if (reg >= 0) {
+            regs |= BIT(reg);
+        }
+    }
+    return regs;
+}
+
+static bool read_number(Slice s, long* value) {
+    int i = s.len && s.text[0] == '-';
+    if (i == s.len || s.len - i > 10) {
+        return false;
+    }
+    long abs = 0;
+    for (; i < s.len; i++) {
+        if (s.text[i] < '0' || s.text[i] > '9') {
+            return false;
+        }
+        abs = abs * 10 + (s.text[i] - '0');
+    }
+    *value = s.text[0] == '-' ? -abs: abs;
+    return *value >= INT32_MIN && *value <= INT32_MAX;
+}
+
+static bool bind_number(Peephole* p, Match* m, int var, long value) {
+    char digits[24];
+    int len = snprintf(digits, sizeof(digits), "%ld", value);
+    char* text = arena_alloc(&p->arena, len);
+    if (!text) {
+        p->failed = true;
+        return false;
+    }
+    memcpy(text, digits, len);
+    m->vars[var] = (Slice){text, len};
+    return true;
+}
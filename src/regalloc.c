@@ -0,0 +1,375 @@
+#include "regalloc.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {                // use of a register of the IR
+    int block;                  // block of the use
+    int pos;                    // position of the use, the end of the
+                                // predecessor for the operands of phis
+} Use;
+
+typedef struct {                // uses of the registers of the IR
+    int* first;                 // first use of each register, its uses
+                                // ending at the first use of the next one
+    Use* uses;                  // uses, register by register
+} Uses;
+
+typedef struct {                // positions where a value lives
+    vreg_t reg;                 // register of the IR
+    int start;                  // first position, where it is defined
+    int end;                    // last position, where it is used
+} Interval;
+
+/**
+ * @brief Number the instructions in the order of the blocks, and count the
+ *        calls before each of them
+ *
+ * @param ir IR of the function
+ * @param firsts set to the position of the first instruction of each
+ *               block, with an entry more for the end of the function
+ * @param calls set to the number of calls before each position, with an
+ *              entry more than there are instructions
+ */
+static void number_instructions(const IrFunction* ir, int* firsts, int* calls);
+
+/**
+ * @brief Gather the uses of each register of the IR. The operands of the
+ *        phis are used at the end of the predecessors
+ *
+ * @param ir IR of the function
+ * @param firsts position of the first instruction of each block
+ * @param uses uses to fill, freed by the caller
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+static int collect_uses(const IrFunction* ir, const int* firsts, Uses* uses);
+
+/**
+ * @brief Extend an interval to a position
+ *
+ * @param interval interval of a value
+ * @param pos position where the value lives
+ */
+static void extend_interval(Interval* interval, int pos);
+
+/**
+ * @brief Compute the interval of each register of the IR, over the
+ *        instructions numbered in the order of the blocks. From each of its
+ *        uses, a value lives back through the predecessors up to the block
+ *        defining it, which dominates them, loops included
+ *
+ * @param ir IR of the function
+ * @param firsts position of the first instruction of each block
+ * @param uses uses of each register
+ * @param intervals interval of each register, filled
+ * @param blocks set to the block defining each register
+ * @param marks last register walked through each block, NO_VREG at first
+ * @param stack blocks left to walk, one entry by block
+ */
+static void compute_intervals(const IrFunction* ir, const int* firsts,
+                              const Uses* uses, Interval* intervals,
+                              int* blocks, vreg_t* marks, int* stack);
+
+/**
+ * @brief Compare intervals by their start, for qsort
+ *
+ * @param a first interval
+ * @param b second interval
+ * @return negative, 0 or positive as for qsort
+ */
+static int compare_starts(const void* a, const void* b);
+
+/**
+ * @brief Choose a free register of the processor for a value
+ *
+ * @param active value holding each register of the processor
+ * @param kept if the value lives across a call
+ * @param hint preferred register, -1 if none
+ * @return register chosen
+ *         -1 if none is free
+ */
+static int choose_register(const vreg_t* active, bool kept, int hint);
+
+/**
+ * @brief Give the registers of the processor to the intervals, sorted by
+ *        their start, spilling the ones living the longest when they run
+ *        out. A phi prefers the register of one of its operands, and the
+ *        operands the register of their phi, to spare their copies
+ *
+ * @param ir IR of the function
+ * @param sorted intervals sorted by their start
+ * @param nb_sorted number of intervals
+ * @param intervals interval of each register of the IR
+ * @param calls number of calls before each position
+ * @param defs instruction defining each register of the IR
+ * @param hints preferred register of each register of the IR, -1 if none
+ * @param alloc locations to fill
+ */
+static void scan_intervals(const IrFunction* ir, const Interval* sorted,
+                           int nb_sorted, const Interval* intervals,
+                           const int* calls, const IrInstr** defs, int* hints,
+                           RegAlloc* alloc);
+
+
+static void number_instructions(const IrFunction* ir, int* firsts, int* calls) {
+    int pos = 0;
+    calls[0] = 0;
+    for (int b = 0; b < ir->nb_blocks; b++) {
+        const IrBlock* block = &ir->blocks[b];
+        firsts[b] = pos;
+        for (int i = 0; i < block->nb_instrs; i++, pos++) {
+            calls[pos + 1] = calls[pos] + (block->instrs[i].op == IR_CALL);
+        }
+    }
+    firsts[ir->nb_blocks] = pos;
+}
+
+static int collect_uses(const IrFunction* ir, const int* firsts, Uses* uses) {
+    uses->first = calloc(ir->nb_vregs + 1, sizeof(int));
+    if (!uses->first) {
+        return 0;
+    }
+    // the uses of each register are counted, then written one after the
+    // other, in two passes over the instructions
+    for (int pass = 0; pass < 2; pass++) {
+        for (int b = 0; b < ir->nb_blocks; b++) {
+            const IrBlock* block = &ir->blocks[b];
+            for (int i = 0; i < block->nb_instrs; i++) {
+                const IrInstr* instr = &block->instrs[i];
+                bool phi = instr->op == IR_PHI;
+                vreg_t regs[2] = {phi ? NO_VREG: instr->a, phi ? NO_VREG: instr->b};
+                for (int j = 0; j < 2 + instr->nb_operands; j++) {
+                    vreg_t reg = j < 2 ? regs[j]: ir->operands[instr->first_operand + j - 2];
+                    if (reg == NO_VREG) {
+                        continue;
+                    }
+                    if (!pass) {
+                        uses->first[reg + 1]++;
+                        continue;
+                    }
+                    int pred = phi ? block->preds[j - 2]: b;
+                    uses->uses[uses->first[reg]++] = (Use){
+                        .block = pred,
+                        .pos = phi ? firsts[pred + 1] - 1: firsts[b] + i};
+                }
+            }
+        }
+        if (!pass) {
+            // each register is given the end of the uses of the previous one
+            for (vreg_t reg = 0; reg < ir->nb_vregs; reg++) {
+                uses->first[reg + 1] += uses->first[reg];
+            }
+            int nb_uses = uses->first[ir->nb_vregs];
+            if (!(uses->uses = malloc((nb_uses ? nb_uses: 1) * sizeof(Use)))) {
+                return 0;
+            }
+        }
+    }
+    // each register now starts where the next one does, as its uses were
+    // written
+    for (vreg_t reg = ir->nb_vregs; reg > 0; reg--) {
+        uses->first[reg] = uses->first[reg - 1];
+    }
+    uses->first[0] = 0;
+    return 1;
+}
+
+static void extend_interval(Interval* interval, int pos) {
+    if (pos < interval->start) {
+        interval->start = pos;
+    }
+    if (pos > interval->end) {
+        interval->end = pos;
+    }
+}
+
+static void compute_intervals(const IrFunction* ir, const int* firsts,
+                              const Uses* uses, Interval* intervals,
+                              int* blocks, vreg_t* marks, int* stack) {
+    for (vreg_t reg = 0; reg < ir->nb_vregs; reg++) {
+        intervals[reg] = (Interval){.reg = reg, .start = INT_MAX, .end = -1};
+    }
+    for (int b = 0; b < ir->nb_blocks; b++) {
+        const IrBlock* block = &ir->blocks[b];
+        for (int i = 0; i < block->nb_instrs; i++) {
+            const IrInstr* instr = &block->instrs[i];
+            // the phis are defined at once, at the start of the block
+            if (instr->dst != NO_VREG) {
+                int pos = firsts[b] + (instr->op == IR_PHI ? 0: i);
+                intervals[instr->dst].start = intervals[instr->dst].end = pos;
+                blocks[instr->dst] = b;
+            }
+        }
+    }
+    for (vreg_t reg = 1; reg < ir->nb_vregs; reg++) {
+        Interval* interval = &intervals[reg];
+        if (interval->end < 0) {
+            continue;
+        }
+        // the walk stops at the block defining the value
+        marks[blocks[reg]] = reg;
+        int depth = 0;
+        for (int u = uses->first[reg]; u < uses->first[reg + 1]; u++) {
+            const Use* use = &uses->uses[u];
+            extend_interval(interval, use->pos);
+            if (marks[use->block] != reg) {
+                marks[use->block] = reg;
+                stack[depth++] = use->block;
+            }
+        }
+        // the value lives at the start of each block walked, and at the end
+        // of their predecessors
+        while (depth) {
+            int b = stack[--depth];
+            extend_interval(interval, firsts[b]);
+            for (int i = 0; i < ir->blocks[b].nb_preds; i++) {
+                int pred = ir->blocks[b].preds[i];
+                extend_interval(interval, firsts[pred + 1] - 1);
+                if (marks[pred] != reg) {
+                    marks[pred] = reg;
+                    stack[depth++] = pred;
+                }
+            }
+        }
+    }
+}
+
+static int compare_starts(const void* a, const void* b) {
+    const Interval* first = a;
+    const Interval* second = b;
+    if (first->start != second->start) {
+        return first->start < second->start ? -1: 1;
+    }
+    return first->reg - second->reg;
+}
+
+static int choose_register(const vreg_t* active, bool kept, int hint) {
+    if (hint >= 0 && active[hint] == NO_VREG && (!kept || hint < NB_KEPT_REGS)) {
+        return hint;
+    }
+    // the registers changed by the calls first, they need no saving
+    for (int reg = NB_KEPT_REGS; !kept && reg < NB_REGS; reg++) {
+        if (active[reg] == NO_VREG) {
+            return reg;
+        }
+    }
+    for (int reg = 0; reg < NB_KEPT_REGS; reg++) {
+        if (active[reg] == NO_VREG) {
+            return reg;
+        }
+    }
+    return -1;
+}
+
+static void scan_intervals(const IrFunction* ir, const Interval* sorted,
+                           int nb_sorted, const Interval* intervals,
+                           const int* calls, const IrInstr** defs, int* hints,
+                           RegAlloc* alloc) {
+    vreg_t active[NB_REGS] = {NO_VREG};
+    for (int k = 0; k < nb_sorted && sorted[k].end >= 0; k++) {
+        const Interval* cur = &sorted[k];
+        // a value used where another one is defined can give it its register
+        for (int reg = 0; reg < NB_REGS; reg++) {
+            if (active[reg] != NO_VREG && intervals[active[reg]].end <= cur->start) {
+                active[reg] = NO_VREG;
+            }
+        }
+        bool kept = calls[cur->end] > calls[cur->start + 1];
+        const IrInstr* def = defs[cur->reg];
+        int hint = hints[cur->reg];
+        for (int i = 0; def->op == IR_PHI && i < def->nb_operands; i++) {
+            int loc = alloc->locs[ir->operands[def->first_operand + i]];
+            if (loc >= 0 && loc < NB_REGS && active[loc] == NO_VREG) {
+                hint = loc;
+            }
+        }
+        int reg = choose_register(active, kept, hint);
+        if (reg < 0) {
+            // the value living the longest is spilled
+            for (int i = 0; i < (kept ? NB_KEPT_REGS: NB_REGS); i++) {
+                if (reg < 0 || intervals[active[i]].end > intervals[active[reg]].end) {
+                    reg = i;
+                }
+            }
+            if (intervals[active[reg]].end <= cur->end) {
+                alloc->locs[cur->reg] = NB_REGS + alloc->nb_slots++;
+                continue;
+            }
+            alloc->locs[active[reg]] = NB_REGS + alloc->nb_slots++;
+        }
+        alloc->locs[cur->reg] = reg;
+        alloc->used |= 1U << reg;
+        active[reg] = cur->reg;
+        for (int i = 0; def->op == IR_PHI && i < def->nb_operands; i++) {
+            vreg_t operand = ir->operands[def->first_operand + i];
+            if (alloc->locs[operand] < 0 && hints[operand] < 0) {
+                hints[operand] = reg;
+            }
+        }
+    }
+}
+
+int allocate_registers(const IrFunction* ir, RegAlloc* alloc) {
+    int nb_instrs = 0;
+    for (int b = 0; b < ir->nb_blocks; b++) {
+        nb_instrs += ir->blocks[b].nb_instrs;
+    }
+    alloc->locs = malloc(ir->nb_vregs * sizeof(int));
+    alloc->nb_slots = 0;
+    alloc->used = 0;
+    Uses uses = {0};
+    // intervals of the registers, then sorted by their start
+    Interval* intervals = malloc(2 * ir->nb_vregs * sizeof(Interval));
+    int* firsts = malloc((ir->nb_blocks + 1) * sizeof(int));
+    int* calls = malloc((nb_instrs + 1) * sizeof(int));
+    const IrInstr** defs = malloc(ir->nb_vregs * sizeof(IrInstr*));
+    int* hints = malloc(ir->nb_vregs * sizeof(int));
+    int* blocks = malloc(ir->nb_vregs * sizeof(int));
+    vreg_t* marks = malloc(ir->nb_blocks * sizeof(vreg_t));
+    int* stack = malloc(ir->nb_blocks * sizeof(int));
+    int res = alloc->locs && intervals && firsts && calls && defs && hints
+              && blocks && marks && stack;
+    if (res) {
+        number_instructions(ir, firsts, calls);
+        res = collect_uses(ir, firsts, &uses);
+    }
+    if (res) {
+        for (int b = 0; b < ir->nb_blocks; b++) {
+            marks[b] = NO_VREG;
+        }
+        compute_intervals(ir, firsts, &uses, intervals, blocks, marks, stack);
+        for (vreg_t reg = 0; reg < ir->nb_vregs; reg++) {
+            alloc->locs[reg] = -1;
+            hints[reg] = -1;
+        }
+        for (int b = 0; b < ir->nb_blocks; b++) {
+            const IrBlock* block = &ir->blocks[b];
+            for (int i = 0; i < block->nb_instrs; i++) {
+                defs[block->instrs[i].dst] = &block->instrs[i];
+            }
+        }
+        Interval* sorted = &intervals[ir->nb_vregs];
+        memcpy(sorted, &intervals[1], (ir->nb_vregs - 1) * sizeof(Interval));
+        qsort(sorted, ir->nb_vregs - 1, sizeof(Interval), compare_starts);
+        scan_intervals(ir, sorted, ir->nb_vregs - 1, intervals, calls, defs,
+                       hints, alloc);
+    }
+    free(uses.first);
+    free(uses.uses);
+    free(intervals);
+    free(firsts);
+    free(calls);
+    free(defs);
+    free(hints);
+    free(blocks);
+    free(marks);
+    free(stack);
+    return res;
+}
+
+void free_regalloc(RegAlloc* alloc) {
+    free(alloc->locs);
+    alloc->locs = NULL;
+}
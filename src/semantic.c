@@ -7,26 +7,20 @@
 #include "table.h"
 #include "errors.h"
 #include "types.h"
+#include "walk.h"
 
 #define SEM_ERR  0
 #define SEM_GOOD 1
 
 /**
- * @brief Sort a table of entries using the lexicographic order
+ * @brief Sort a table of entries by the ids of their names
  * 
  * @param table 
  */
 static void sort_table(Table* table);
 
 /**
- * @brief Sort both local and parameter tables using the lexicographic order
- * 
- * @param collection 
- */
-static void sort_collection(FunctionCollection* collection);
-
-/**
- * @brief Sort tables of globals and functions
+ * @brief Sort tables of globals and of functions locals
  * 
  * @param globals 
  * @param collection 
@@ -37,173 +31,149 @@ static void sort_tables(Table* globals, FunctionCollection* collection);
  * @brief Check if the main function is correct, according to its parameters
  *        and its return type
  * 
+ * @param ctx compilation context
  * @param collection collection of function
  * @return 0 in case of error else 1 if success
  */
-static int check_main(const FunctionCollection* collection);
+static int check_main(Context* ctx, const FunctionCollection* collection);
 
 /**
  * @brief Search for declared but non-used symbols in a sigle table
  * 
+ * @param ctx compilation context
  * @param table table to search the symbol
  * @param source symbol's identifier
  */
-static void search_unused_symbol_table(const Table* table, const char* source);
+static void search_unused_symbol_table(Context* ctx, const Table* table,
+                                       const char* source);
 
 /**
  * @brief Search for declared but non-used symbols in the global's tables and
  *        for functions
  * 
+ * @param ctx compilation context
  * @param globals global's table 
  * @param collection collection of functions
  */
-static void search_unused_symbols(const Table* globals,
+static void search_unused_symbols(Context* ctx, const Table* globals,
                                   const FunctionCollection* collection);
 
 /**
  * @brief Check if types are valid when assigning a value to a LValue
  * 
- * @param globals global's table
- * @param collection collection of functions
- * @param fun current function where the assignation is done
- * @param tree head node of the assignation (with the 'Assignation' label)
+ * @param walk walk checking the instructions of a function
+ * @param frame frame of the assignation (with the 'Assignation' label)
  * @return 0 in case of error else 1 if success
  */
-static int check_assignation_types(const Table* globals,
-                                   const FunctionCollection* collection,
-                                   const Function* fun, Node* tree);
+static int check_assignation_types(Walk* walk, Frame* frame);
 
 /**
  * @brief Check if the return type is the correct, according to function
  *        declaration
  * 
- * @param globals global's table
- * @param collection collection of functions
- * @param fun current functin where the return is done
- * @param tree head node of the return (with the 'Return' label)
- *             the 'type' attribute of the node is set according to the function
- *             prototype or raise an exception
+ * @param walk walk checking the instructions of a function
+ * @param frame frame of the return (with the 'Return' label)
+ *              the 'type' attribute of the node is set according to the
+ *              function prototype or raise an exception
  * @return 0 in case of error else 1 if success
  */
-static int check_return_type(const Table* globals, const FunctionCollection* collection,
-                             const Function* fun, Node* tree);
+static int check_return_type(Walk* walk, Frame* frame);
 
 /**
  * @brief Check if the parameters to a function are correct, in terms of 
- *        order, number and type
+ *        order, number and type. Each step checks the parameter visited
+ *        by the previous one, and schedules the next one
  * 
- * @param globals global's table
- * @param collection collection of functions
- * @param fun current function where the other function call is
+ * @param walk walk checking the instructions of a function
+ * @param frame frame of the call, whose cursor is the current parameter
  * @param called function to be called
- * @param tree head node of parameters, either with the 'NoParam' label or 
- *             'ListExp' for a list of parameters
  * @return 0 in case of error else 1 if success
  */
-static int check_parameters(const Table* globals, const FunctionCollection* collection,
-                            const Function* fun, const Function* called, Node* tree);
+static int check_parameters(Walk* walk, Frame* frame, const Function* called);
 
 /**
  * @brief Check if an entry (a variable) is correctly used
  * 
- * @param globals global's table
- * @param collection collection of functions
- * @param fun current function where this entry is used
- * @param tree node with the 'Ident' label
+ * @param walk walk checking the instructions of a function
+ * @param frame frame of the node with the 'Ident' label
  * @param entry used entry
  * @return 0 in case of error else 1 if success
  */
-static int check_entry_use(const Table* globals, const FunctionCollection* collection,
-                           const Function* fun, Node* tree, const Entry* entry);
+static int check_entry_use(Walk* walk, Frame* frame, const Entry* entry);
 
 /**
  * @brief Check if a function is correctly used
  * 
- * @param globals global's table
- * @param collection collection of functions
- * @param fun current function where the function is called
- * @param tree node with the 'Ident' label
+ * @param walk walk checking the instructions of a function
+ * @param frame frame of the node with the 'Ident' label
  * @param function function to be called
  * @return 0 in case of error else 1 if success
  */
-static int check_function_use(const Table* globals, const FunctionCollection* collection,
-                              const Function* fun, Node* tree, const Function* function);
+static int check_function_use(Walk* walk, Frame* frame, Function* function);
 
 /**
  * @brief Get the type of an identifier and if it is correctly used.
  *        This also applied for function
  * 
- * @param globals global's table
- * @param collection collection of functions
- * @param fun current function 
- * @param ident identifier to look for
- * @param tree node with the 'Ident' label
+ * @param walk walk checking the instructions of a function
+ * @param frame frame of the node with the 'Ident' label
  * @return 0 in case of error else 1 if success
  */
-static int ident_type(const Table* globals, const FunctionCollection* collection,
-                      const Function* fun, Node* tree);
+static int ident_type(Walk* walk, Frame* frame);
 
 /**
  * @brief Check the user correctly perform arithmetics. This verification is
  *        type-based
  * 
- * @param globals global's table
- * @param collection collection of functions
- * @param fun current function where the arithmetic is performed
- * @param tree head node of the arthmetic. Its label must be one of the
- *             following: 'Eq', 'Order, 'Or', 'And', 'Negation', 'DivStar'
- *             or 'AddSub'
+ * @param walk walk checking the instructions of a function
+ * @param frame frame of the arthmetic. Its label must be one of the
+ *              following: 'Eq', 'Order, 'Or', 'And', 'Negation', 'DivStar'
+ *              or 'AddSub'
  * @return 0 in case of error else 1 if success
  */
-static int check_arithm_type(const Table* globals, const FunctionCollection* collection,
-                             const Function* fun, Node* tree);
+static int check_arithm_type(Walk* walk, Frame* frame);
 
 /**
  * @brief Check types for condition
  * 
- * @param globals global's table
- * @param collection collection of function
- * @param fun current function where the condition is evaludated
- * @param tree head node with the 'If' or 'While' label
+ * @param walk walk checking the instructions of a function
+ * @param frame frame of the node with the 'If' or 'While' label
  * @return 0 in case of error else 1 if success
  */
-static int check_cond_type(const Table* globals, const FunctionCollection* collection,
-                           const Function* fun, Node* tree);
+static int check_cond_type(Walk* walk, Frame* frame);
 
 /**
- * @brief Check if instructions are correcly typed
+ * @brief Check if instructions are correcly typed. Visit of the walk over
+ *        the instructions of a function
  * 
- * @param globals global's table
- * @param collection collection of functions
- * @param fun current function
- * @param tree head node of the instruction
+ * @param walk walk checking the instructions, with the 'Scope' of the
+ *             function
+ * @param frame frame of the instruction
  * @return 0 in case of error else 1 if success
  */
-static int check_tree(const Table* globals, const FunctionCollection* collection,
-                      const Function* fun, Node* tree);
+static int check_tree(Walk* walk, Frame* frame);
 
 /**
- * @brief Check instructions and their siblings
+ * @brief Check types in the instructions of a function
  * 
- * @param globals global's table
- * @param collection collection of functions
- * @param fun current function
- * @param tree head node of the instructions
+ * @param ctx compilation context
+ * @param walk walk checking the instructions, with the scope of the function
+ * @param node head node of the function (the 'DeclFonct' label)
  * @return 0 in case of error else 1 if success
  */
-static int check_instructions(const Table* globals, const FunctionCollection* collection,
-                              const Function* fun, Node* tree);
+static int check_function_types(Context* ctx, Walk* walk, node_t node);
 
 /**
  * @brief Main function for checking types
  * 
+ * @param ctx compilation context
  * @param globals global's tables
  * @param collection collection of functions
  * @param tree head node of the programm (the 'Prog' label)
  * @return 0 in case of error else 1 if success
  */
-static int check_types(const Table* globals, const FunctionCollection* collection,
-                       Node* tree);
+static int check_types(Context* ctx, const Table* globals,
+                       const FunctionCollection* collection, node_t tree);
 
 static void sort_table(Table* table) {
     // sort table based on the entrie's name
@@ -211,16 +181,9 @@ static void sort_table(Table* table) {
     table->sorted = true;
 }
 
-static void sort_collection(FunctionCollection* collection) {
-    // sort collection based on the function's name
-    qsort(collection->funcs, collection->cur_len, sizeof(Function),
-          compare_functions);
-    collection->sorted = true;
-}
-
 static void sort_tables(Table* globals, FunctionCollection* collection) {
     sort_table(globals);
-    sort_collection(collection);
+    // functions are already indexed by name, so only their locals are sorted
     for (int i = 0; i < collection->cur_len; i++) {
         // dont sort parameters in order to correctly check the variables
         // in the call
@@ -228,66 +191,74 @@ static void sort_tables(Table* globals, FunctionCollection* collection) {
     }
 }
 
-static int check_main(const FunctionCollection* collection) {
-    Function* start_fun = get_function(collection, "main");
+static int check_main(Context* ctx, const FunctionCollection* collection) {
+    Function* start_fun = get_function(collection, intern(ctx, "main", 4));
     if (!start_fun) {
         // no main function found
-        error(ERROR, "no start function found");
+        error(ctx, ERROR, "no start function found");
         return SEM_ERR;
     }
     if (start_fun->r_type != T_INT) {
         // wrong return type
-        wrong_rtype_error(ERROR, "main", start_fun->r_type, T_INT,
+        wrong_rtype_error(ctx, ERROR, "main", start_fun->r_type, T_INT,
                           start_fun->decl_line, start_fun->decl_col);
         return SEM_ERR;
     }
     if (start_fun->parameters.cur_len) {
         // parameters given while main require no parameters
-        error(ERROR, "main must take no parameters");
+        error(ctx, ERROR, "main must take no parameters");
         return SEM_ERR;
     }
     return SEM_GOOD;
 }
 
-static void search_unused_symbol_table(const Table* table, const char* source) {
+static void search_unused_symbol_table(Context* ctx, const Table* table,
+                                       const char* source) {
     for (int i = 0; i < table->cur_len; i++) {
         Entry entry = table->array[i];
         if (!entry.is_used) {
             if (source) {
-                unused_symbol_in_function(source, entry.name, entry.decl_line,
-                                          entry.decl_col);    
+                unused_symbol_in_function(ctx, source,
+                                          ident_name(ctx, entry.name),
+                                          entry.decl_line, entry.decl_col);    
             } else {
-                unused_symbol(entry.name, entry.decl_line, entry.decl_col);
+                unused_symbol(ctx, ident_name(ctx, entry.name), entry.decl_line,
+                              entry.decl_col);
             }
         }
     }
 }
 
-static void search_unused_symbols(const Table* globals,
+static void search_unused_symbols(Context* ctx, const Table* globals,
                                   const FunctionCollection* collection) {
-    search_unused_symbol_table(globals, NULL);
+    search_unused_symbol_table(ctx, globals, NULL);
     for (int i = 0; i < collection->cur_len; i++) {
         Function fun = collection->funcs[i];
-        search_unused_symbol_table(&fun.parameters, fun.name);
-        search_unused_symbol_table(&fun.locals, fun.name);
+        const char* name = ident_name(ctx, fun.name);
+        search_unused_symbol_table(ctx, &fun.parameters, name);
+        search_unused_symbol_table(ctx, &fun.locals, name);
     }
 }
 
-static int check_assignation_types(const Table* globals, const FunctionCollection* collection,
-                                   const Function* fun, Node* tree) {
-    if (!check_tree(globals, collection, fun, FIRSTCHILD(tree))) return SEM_ERR;
-    if (!check_tree(globals, collection, fun, SECONDCHILD(tree))) return SEM_ERR;
+static int check_assignation_types(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    node_t tree = frame->node;
+    if (frame->step < 2) {
+        // check the lvalue, then the value
+        visit_node(walk, frame->step ? SECONDCHILD(ctx, tree) : FIRSTCHILD(ctx, tree));
+        return SEM_GOOD;
+    }
 
-    t_type t_dest = FIRSTCHILD(tree)->type;
-    t_type t_value = SECONDCHILD(tree)->type;
+    t_type t_dest = NODE_TYPE(ctx, FIRSTCHILD(ctx, tree));
+    t_type t_value = NODE_TYPE(ctx, SECONDCHILD(ctx, tree));
 
     // if we tried to assign an int to a char, display a warning
     if (t_dest == T_CHAR && t_value == T_INT) {
-        assignation_error(WARNING,
-                          FIRSTCHILD(tree)->val.ident,
-                          FIRSTCHILD(tree)->type,
-                          SECONDCHILD(tree)->type,
-                          tree->lineno, tree->colno);
+        assignation_error(ctx, WARNING,
+                          ident_name(ctx, NODE_VAL(ctx, FIRSTCHILD(ctx, tree)).ident),
+                          NODE_TYPE(ctx, FIRSTCHILD(ctx, tree)),
+                          NODE_TYPE(ctx, SECONDCHILD(ctx, tree)),
+                          NODE_LINENO(ctx, tree), NODE_COLNO(ctx, tree));
         // when its a warning we continue
         return SEM_GOOD;
     } else if (t_dest != t_value || (is_array(t_dest) && is_array(t_value))) { // two types are different
@@ -295,36 +266,39 @@ static int check_assignation_types(const Table* globals, const FunctionCollectio
             || is_array(t_dest)                         // if one of them is either an array 
             || is_array(t_value)                        // 
             || t_value == T_VOID) {                     // if we tried to assign a void value
-            assignation_error(ERROR,
-                              FIRSTCHILD(tree)->val.ident,
-                              FIRSTCHILD(tree)->type,
-                              SECONDCHILD(tree)->type,
-                              tree->lineno, tree->colno);
+            assignation_error(ctx, ERROR,
+                              ident_name(ctx, NODE_VAL(ctx, FIRSTCHILD(ctx, tree)).ident),
+                              NODE_TYPE(ctx, FIRSTCHILD(ctx, tree)),
+                              NODE_TYPE(ctx, SECONDCHILD(ctx, tree)),
+                              NODE_LINENO(ctx, tree), NODE_COLNO(ctx, tree));
             return SEM_ERR;
         }
     }
     return SEM_GOOD;
 }
 
-static int check_return_type(const Table* globals, const FunctionCollection* collection,
-                              const Function* fun, Node* tree) {
+static int check_return_type(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    const Function* fun = ((const Scope*)walk->pass)->fun;
+    node_t tree = frame->node;
     t_type child_type;
     
     // if the user is returning a value 
-    if (FIRSTCHILD(tree)) {
+    if (FIRSTCHILD(ctx, tree)) {
         // forbid to return when the return type of the function is void
         if (fun->r_type == T_VOID) {
-            line_error(ERROR, "void expression not allowed in return", tree->lineno, tree->colno);
+            line_error(ctx, ERROR, "void expression not allowed in return", NODE_LINENO(ctx, tree), NODE_COLNO(ctx, tree));
             return SEM_ERR;
         }
 
         // check return expression
-        if (!check_tree(globals, collection, fun, FIRSTCHILD(tree))) {
-            return SEM_ERR;
+        if (!frame->step) {
+            visit_node(walk, FIRSTCHILD(ctx, tree));
+            return SEM_GOOD;
         }
         
         // assigning the return type
-        child_type = FIRSTCHILD(tree)->type;
+        child_type = NODE_TYPE(ctx, FIRSTCHILD(ctx, tree));
     } else {
         // If nothing is return then is void by default
         child_type = T_VOID;
@@ -334,297 +308,367 @@ static int check_return_type(const Table* globals, const FunctionCollection* col
     if (fun->r_type != child_type) {
         // check if it is a cast from an int to char
         if (fun->r_type == T_CHAR && child_type == T_INT) {
-            wrong_rtype_error(WARNING, fun->name, child_type, fun->r_type,
-                              tree->lineno, tree->colno);
+            wrong_rtype_error(ctx, WARNING, ident_name(ctx, fun->name), child_type,
+                              fun->r_type, NODE_LINENO(ctx, tree), NODE_COLNO(ctx, tree));
             return SEM_GOOD; // when its a warning we continue
         } else if (!(fun->r_type == T_INT && child_type == T_CHAR)) {
             // if it's not a cast from a char to an int (which is valid)
-            wrong_rtype_error(ERROR, fun->name, child_type, fun->r_type,
-                              tree->lineno, tree->colno);
+            wrong_rtype_error(ctx, ERROR, ident_name(ctx, fun->name), child_type,
+                              fun->r_type, NODE_LINENO(ctx, tree), NODE_COLNO(ctx, tree));
             return SEM_ERR;
         }
     }
     return SEM_GOOD;
 }
 
-static int check_parameters(const Table* globals, const FunctionCollection* collection,
-                             const Function* fun, const Function* called, Node* tree) {
-    Node* head = tree;
-    Entry entry;
-    int i;
-    
-    // looping over each given parameters and the expected ones
-    for (i = 0; head != NULL && i < called->parameters.cur_len; i++) {
-        
-        // if there is an error while checking sub-expression
-        if (!check_tree(globals, collection, fun, head)) {
-            return SEM_ERR;
-        }
-        
-        entry = called->parameters.array[i];
+static int check_parameters(Walk* walk, Frame* frame, const Function* called) {
+    Context* ctx = walk->ctx;
+    node_t head = frame->cursor;
+    int i = frame->data[0];
+
+    // the parameter of the previous step has been checked
+    if (frame->step) {
+        Entry entry = called->parameters.array[i];
 
         // one of them is an array
-        if (is_array(head->type) || is_array(entry.type)) {
+        if (is_array(NODE_TYPE(ctx, head)) || is_array(entry.type)) {
             // if one of them is not an array
-            if (!(is_array(entry.type) && is_array(head->type))) {
-                invalid_parameter_type(ERROR, called->name, entry.name,
-                                       entry.type, head->type, head->lineno,
-                                       head->colno);
+            if (!(is_array(entry.type) && is_array(NODE_TYPE(ctx, head)))) {
+                invalid_parameter_type(ctx, ERROR, ident_name(ctx, called->name),
+                                       ident_name(ctx, entry.name),
+                                       entry.type, NODE_TYPE(ctx, head), NODE_LINENO(ctx, head),
+                                       NODE_COLNO(ctx, head));
                 return SEM_ERR;
             }
             // both are arrays but from different types
-            if ((is_int(head->type) && is_char(entry.type))
-                || (is_char(head->type) && is_int(entry.type))) {
-                invalid_parameter_type(ERROR, called->name, entry.name,
-                                       entry.type, head->type, head->lineno,
-                                       head->colno);
+            if ((is_int(NODE_TYPE(ctx, head)) && is_char(entry.type))
+                || (is_char(NODE_TYPE(ctx, head)) && is_int(entry.type))) {
+                invalid_parameter_type(ctx, ERROR, ident_name(ctx, called->name),
+                                       ident_name(ctx, entry.name),
+                                       entry.type, NODE_TYPE(ctx, head), NODE_LINENO(ctx, head),
+                                       NODE_COLNO(ctx, head));
                 return SEM_ERR;
             }
         } else {
-            // tw different types
-            if (head->type != entry.type) {
-                // implicit cast
-                if (entry.type == T_INT && head->type == T_CHAR) {
-                    head = head->nextSibling;
-                    continue;
-                }
+            // tw different types, except for the implicit cast from char to int
+            if (NODE_TYPE(ctx, head) != entry.type
+                && !(entry.type == T_INT && NODE_TYPE(ctx, head) == T_CHAR)) {
                 ErrorType err_type = ERROR;
                 
                 // warning cast from int to char
-                if (entry.type == T_CHAR && head->type == T_INT) {
+                if (entry.type == T_CHAR && NODE_TYPE(ctx, head) == T_INT) {
                     err_type = WARNING;
                 }
-                invalid_parameter_type(err_type, called->name, entry.name,
-                                       entry.type, head->type, head->lineno,
-                                       head->colno);
+                invalid_parameter_type(ctx, err_type, ident_name(ctx, called->name),
+                                       ident_name(ctx, entry.name),
+                                       entry.type, NODE_TYPE(ctx, head), NODE_LINENO(ctx, head),
+                                       NODE_COLNO(ctx, head));
                 return err_type == WARNING;
             }
         }
-        head = head->nextSibling;
+        head = NEXTSIBLING(ctx, head);
+        i++;
+    }
+
+    // looping over each given parameters and the expected ones
+    if (head != NO_NODE && i < called->parameters.cur_len) {
+        frame->cursor = head;
+        frame->data[0] = i;
+        visit_node(walk, head);
+        return SEM_GOOD;
     }
     // if there is not enough or too much given parameters
-    if (head != NULL || i != called->parameters.cur_len) {
-        incorrect_function_call(called->name, tree->lineno, tree->colno);
+    if (head != NO_NODE || i != called->parameters.cur_len) {
+        node_t tree = FIRSTCHILD(ctx, FIRSTCHILD(ctx, frame->node));
+        incorrect_function_call(ctx, ident_name(ctx, called->name), NODE_LINENO(ctx, tree),
+                                NODE_COLNO(ctx, tree));
         return SEM_ERR;
     }
     return SEM_GOOD;
 }
 
-static int check_entry_use(const Table* globals, const FunctionCollection* collection,
-                           const Function* fun, Node* tree, const Entry* entry) {
-    if (FIRSTCHILD(tree)) {
+static int check_entry_use(Walk* walk, Frame* frame, const Entry* entry) {
+    Context* ctx = walk->ctx;
+    node_t tree = frame->node;
+    if (FIRSTCHILD(ctx, tree)) {
         // either entry is an array and user tries to access it
         // or the user think its a function which entry is not
 
         // eliminate cases where is a function
-        if (FIRSTCHILD(tree)->label == NoParametres || FIRSTCHILD(tree)->label == ListExp) {
-            incorrect_symbol_use(entry->name, entry->type,
-                                 T_FUNCTION, tree->lineno, tree->colno);
+        if (NODE_LABEL(ctx, FIRSTCHILD(ctx, tree)) == NoParametres || NODE_LABEL(ctx, FIRSTCHILD(ctx, tree)) == ListExp) {
+            incorrect_symbol_use(ctx, ident_name(ctx, entry->name), entry->type,
+                                 T_FUNCTION, NODE_LINENO(ctx, tree), NODE_COLNO(ctx, tree));
             return SEM_ERR;
         }
 
         // if its an array
         if (is_array(entry->type)) {
             // check if the sub-expression is an integer to access the array
-            if (!check_tree(globals, collection, fun, FIRSTCHILD(tree))) return SEM_ERR;
+            if (!frame->step) {
+                visit_node(walk, FIRSTCHILD(ctx, tree));
+                return SEM_GOOD;
+            }
 
-            if (FIRSTCHILD(tree)->type != T_INT && FIRSTCHILD(tree)->type != T_CHAR) {
-                incorrect_array_access(entry->name, FIRSTCHILD(tree)->type,
-                                       tree->lineno, tree->colno);
+            if (NODE_TYPE(ctx, FIRSTCHILD(ctx, tree)) != T_INT && NODE_TYPE(ctx, FIRSTCHILD(ctx, tree)) != T_CHAR) {
+                incorrect_array_access(ctx, ident_name(ctx, entry->name),
+                                       NODE_TYPE(ctx, FIRSTCHILD(ctx, tree)), NODE_LINENO(ctx, tree),
+                                       NODE_COLNO(ctx, tree));
                 return SEM_ERR;
             }
             // else the access is valid and the node type is the array type
-            tree->type = T_INT;
+            NODE_TYPE(ctx, tree) = T_INT;
             if (is_char(entry->type)) {
-                tree->type = T_CHAR;
+                NODE_TYPE(ctx, tree) = T_CHAR;
             }
             return SEM_GOOD;
         } else {
             // an non-array entry should not be used as so
-            incorrect_symbol_use(entry->name, entry->type, T_ARRAY,
-                                 tree->lineno, tree->colno);
+            incorrect_symbol_use(ctx, ident_name(ctx, entry->name), entry->type, T_ARRAY,
+                                 NODE_LINENO(ctx, tree), NODE_COLNO(ctx, tree));
         }
     }
     // if its not a function the user tried to call or an array he tried to access
     // its the variable itself
-    tree->type = entry->type;
+    NODE_TYPE(ctx, tree) = entry->type;
     return SEM_GOOD;
 }
 
-static int check_function_use(const Table* globals, const FunctionCollection* collection,
-                              const Function* fun, Node* tree, const Function* function) {
+static int check_function_use(Walk* walk, Frame* frame, Function* function) {
+    Context* ctx = walk->ctx;
+    node_t tree = frame->node;
     // check first if we tried to call the function
-    if (!FIRSTCHILD(tree)) { // function's name is used as a variable
-        incorrect_symbol_use(function->name, T_FUNCTION, T_ARRAY, tree->lineno,
-                             tree->colno);
+    if (!FIRSTCHILD(ctx, tree)) { // function's name is used as a variable
+        incorrect_symbol_use(ctx, ident_name(ctx, function->name), T_FUNCTION,
+                             T_ARRAY, NODE_LINENO(ctx, tree), NODE_COLNO(ctx, tree));
         return SEM_ERR;
     }
 
     // else the user tries to call it
     // check if there are parameters
-    if (FIRSTCHILD(tree)->label == NoParametres) {  // if no parameters are given
+    if (NODE_LABEL(ctx, FIRSTCHILD(ctx, tree)) == NoParametres) {  // if no parameters are given
         if (function->parameters.cur_len) {         // if the function requires parameters 
-            incorrect_function_call(function->name, tree->lineno, tree->colno);
+            incorrect_function_call(ctx, ident_name(ctx, function->name),
+                                    NODE_LINENO(ctx, tree), NODE_COLNO(ctx, tree));
             return SEM_ERR;
         }
-    } else if (FIRSTCHILD(tree)->label == ListExp) {
-        if (!check_parameters(globals, collection, fun, function, FIRSTCHILD(FIRSTCHILD(tree))))
+    } else if (NODE_LABEL(ctx, FIRSTCHILD(ctx, tree)) == ListExp) {
+        if (!frame->step) {
+            frame->cursor = FIRSTCHILD(ctx, FIRSTCHILD(ctx, tree));
+            frame->data[0] = 0;
+        }
+        if (!check_parameters(walk, frame, function))
             return SEM_ERR;
+        if (visit_scheduled(walk)) {
+            return SEM_GOOD; // a parameter remains to be checked
+        }
     } else {
         // the user tries to access the function as an array
-        incorrect_symbol_use(function->name, T_FUNCTION,
-                             T_ARRAY, tree->lineno, tree->colno);
+        incorrect_symbol_use(ctx, ident_name(ctx, function->name), T_FUNCTION,
+                             T_ARRAY, NODE_LINENO(ctx, tree), NODE_COLNO(ctx, tree));
         return SEM_ERR;
     }
     // the function can be called
     // the type value of the node is the return value of the function
-    tree->type = function->r_type;
+    NODE_TYPE(ctx, tree) = function->r_type;
+    // every called function is marked, builtins are written if called only
+    function->is_used = true;
     return SEM_GOOD;
 }
 
-static int ident_type(const Table* globals, const FunctionCollection* collection,
-                      const Function* fun, Node* tree) {
+static int ident_type(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    const Scope* scope = walk->pass;
+    node_t tree = frame->node;
     // check first if the identifier is a global, a parameter or a local
     // variable
-    Entry* entry = find_entry(globals, fun, tree->val.ident);
+    Entry* entry = find_entry(scope->globals, scope->fun, NODE_VAL(ctx, tree).ident);
     if (entry) {
-        return check_entry_use(globals, collection, fun, tree, entry);
+        return check_entry_use(walk, frame, entry);
     }
     // check if the identifer is a function
-    Function* function = get_function(collection, tree->val.ident);
+    Function* function = get_function(scope->collection, NODE_VAL(ctx, tree).ident);
     if (!function) {
         // not a function: it must be an error
-        use_of_undeclare_symbol(ERROR, tree->val.ident, tree->lineno, tree->colno);
+        use_of_undeclare_symbol(ctx, ERROR, ident_name(ctx, NODE_VAL(ctx, tree).ident),
+                                NODE_LINENO(ctx, tree), NODE_COLNO(ctx, tree));
         return SEM_ERR;
     }
-    return check_function_use(globals, collection, fun, tree, function);
+    return check_function_use(walk, frame, function);
 }
 
-static int check_arithm_type(const Table* globals, const FunctionCollection* collection,
-                              const Function* fun, Node* tree) {
-    if (!check_tree(globals, collection, fun, FIRSTCHILD(tree))) return SEM_ERR;
-    if (!check_tree(globals, collection, fun, SECONDCHILD(tree))) return SEM_ERR;
+static int check_arithm_type(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    node_t tree = frame->node;
+    if (frame->step < 2) {
+        // check the operands, the second one may not exist
+        visit_node(walk, frame->step ? SECONDCHILD(ctx, tree) : FIRSTCHILD(ctx, tree));
+        return SEM_GOOD;
+    }
     
-    t_type ltype = FIRSTCHILD(tree)->type;
+    t_type ltype = NODE_TYPE(ctx, FIRSTCHILD(ctx, tree));
     // check first for unary operator like plus, minus or negation
-    if (tree->label == AddSub) {
+    if (NODE_LABEL(ctx, tree) == AddSub) {
         // no second child = unary plus or minus
-        if (!(SECONDCHILD(tree))) {
+        if (!(SECONDCHILD(ctx, tree))) {
             // invalid type for unary opertation
             if (ltype != T_INT && ltype != T_CHAR) {
-                invalid_operation(tree->val.ident, ltype,
-                                  tree->lineno, tree->colno);
+                invalid_operation(ctx, ident_name(ctx, NODE_VAL(ctx, tree).ident), ltype,
+                                  NODE_LINENO(ctx, tree), NODE_COLNO(ctx, tree));
                 return SEM_ERR;
             }
-            tree->type = ltype;
+            NODE_TYPE(ctx, tree) = ltype;
             return SEM_GOOD;
         }
-    } else if (tree->label == Negation) {
+    } else if (NODE_LABEL(ctx, tree) == Negation) {
         if (ltype != T_INT && ltype != T_CHAR) {
-                invalid_operation(tree->val.ident, ltype,
-                                  tree->lineno, tree->colno);
+                invalid_operation(ctx, ident_name(ctx, NODE_VAL(ctx, tree).ident), ltype,
+                                  NODE_LINENO(ctx, tree), NODE_COLNO(ctx, tree));
                 return SEM_ERR;
             }
-            tree->type = ltype;
+            NODE_TYPE(ctx, tree) = ltype;
             return SEM_GOOD;
     }
-    t_type rtype = SECONDCHILD(tree)->type;
+    t_type rtype = NODE_TYPE(ctx, SECONDCHILD(ctx, tree));
     if (ltype != T_INT && ltype != T_CHAR) {
-        invalid_operation(tree->val.ident, ltype,
-                            tree->lineno, tree->colno);
+        invalid_operation(ctx, ident_name(ctx, NODE_VAL(ctx, tree).ident), ltype,
+                            NODE_LINENO(ctx, tree), NODE_COLNO(ctx, tree));
         return SEM_ERR;
     } else if (rtype != T_INT && rtype != T_CHAR) {
-        invalid_operation(tree->val.ident, rtype,
-                          tree->lineno, tree->colno);
+        invalid_operation(ctx, ident_name(ctx, NODE_VAL(ctx, tree).ident), rtype,
+                          NODE_LINENO(ctx, tree), NODE_COLNO(ctx, tree));
         return SEM_ERR;
     }
     // all operations are cast to integer
-    tree->type = T_INT;
+    NODE_TYPE(ctx, tree) = T_INT;
     return SEM_GOOD;
 }
 
-static int check_cond_type(const Table* globals, const FunctionCollection* collection,
-                           const Function* fun, Node* tree) {
-    // check conditions
-    if (!check_tree(globals, collection, fun, FIRSTCHILD(tree))) return SEM_ERR;
-    if (FIRSTCHILD(tree)->type != T_INT && FIRSTCHILD(tree)->type != T_CHAR) {
-        invalid_condition(FIRSTCHILD(tree)->type, tree->lineno,
-                          tree->colno);
-        return SEM_ERR;
-    }
-
-    // check code block in if of while
-    if (!check_instructions(globals, collection, fun, SECONDCHILD(tree))) {
-        return SEM_ERR;
-    }
-    if (tree->label == If) {
-        // check for else
-        if (!check_instructions(globals, collection, fun, THIRDCHILD(tree))) {
-            return SEM_ERR;
-        }
+static int check_cond_type(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    node_t tree = frame->node;
+    switch (frame->step) {
+        case 0:
+            // check conditions
+            visit_node(walk, FIRSTCHILD(ctx, tree));
+            return SEM_GOOD;
+        case 1:
+            if (NODE_TYPE(ctx, FIRSTCHILD(ctx, tree)) != T_INT && NODE_TYPE(ctx, FIRSTCHILD(ctx, tree)) != T_CHAR) {
+                invalid_condition(ctx, NODE_TYPE(ctx, FIRSTCHILD(ctx, tree)), NODE_LINENO(ctx, tree),
+                                  NODE_COLNO(ctx, tree));
+                return SEM_ERR;
+            }
+            // check code block in if of while
+            visit_list(walk, SECONDCHILD(ctx, tree));
+            return SEM_GOOD;
+        case 2:
+            if (NODE_LABEL(ctx, tree) == If) {
+                // check for else
+                visit_list(walk, THIRDCHILD(ctx, tree));
+            }
+            return SEM_GOOD;
+        default:
+            return SEM_GOOD;
     }
-    return SEM_GOOD;
 }
 
 // tree is the first instruction of the function
-static int check_tree(const Table* globals, const FunctionCollection* collection,
-                      const Function* fun, Node* tree) {
-    if (!tree) return SEM_GOOD; // no more instructions
-    switch (tree->label) {
-        case SuiteInstr: return check_instructions(globals, collection, fun, FIRSTCHILD(tree));
-        case Assignation: return check_assignation_types(globals, collection, fun, tree);
-        case Character: tree->type = set_type(tree->type, T_CHAR); return SEM_GOOD;
-        case Num: tree->type = set_type(tree->type, T_INT); return SEM_GOOD;
-        case Ident: return ident_type(globals, collection, fun, tree);
-        case Return: return check_return_type(globals, collection, fun, tree);
+static int check_tree(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    node_t tree = frame->node;
+    switch (NODE_LABEL(ctx, tree)) {
+        case SuiteInstr: case Else:
+            if (!frame->step) {
+                visit_list(walk, FIRSTCHILD(ctx, tree));
+            }
+            return SEM_GOOD;
+        case Assignation: return check_assignation_types(walk, frame);
+        case Character: NODE_TYPE(ctx, tree) = set_type(NODE_TYPE(ctx, tree), T_CHAR); return SEM_GOOD;
+        case Num: NODE_TYPE(ctx, tree) = set_type(NODE_TYPE(ctx, tree), T_INT); return SEM_GOOD;
+        case Ident: return ident_type(walk, frame);
+        case Return: return check_return_type(walk, frame);
         case Eq: case Order:
         case Or: case And: case Negation:
-        case DivStar: case AddSub: return check_arithm_type(globals, collection, fun, tree);
-        case If: case While: return check_cond_type(globals, collection, fun, tree);
-        case Else: return check_instructions(globals, collection, fun, FIRSTCHILD(tree));
+        case DivStar: case AddSub: return check_arithm_type(walk, frame);
+        case If: case While: return check_cond_type(walk, frame);
         default: return SEM_GOOD;
     }
 }
 
-static int check_instructions(const Table* globals, const FunctionCollection* collection,
-                               const Function* fun, Node* tree) {
-    if (!tree) return SEM_GOOD; // no more instructions to parse
-
-    for (; tree;) {
-        if (!check_tree(globals, collection, fun, tree)) {
-            return SEM_ERR;
-        }
-        tree = tree->nextSibling;
+static int check_function_types(Context* ctx, Walk* walk, node_t node) {
+    Scope* scope = walk->pass;
+    node_t name = SECONDCHILD(ctx, FIRSTCHILD(ctx, node));
+    scope->fun = get_function(scope->collection, NODE_VAL(ctx, name).ident);
+    if (!scope->fun) {
+        use_of_undeclare_symbol(ctx, ERROR, ident_name(ctx, NODE_VAL(ctx, name).ident),
+                                NODE_LINENO(ctx, name), NODE_COLNO(ctx, name));
+        return SEM_ERR;
     }
-    return SEM_GOOD;
-}
-
-static int check_types(const Table* globals, const FunctionCollection* collection, Node* tree) {
-    Node* decl_fonct_node = FIRSTCHILD(SECONDCHILD(tree)), *head_instr;
-    Function* fun;
 
-    for (; decl_fonct_node;) {
-        Node* node = SECONDCHILD(FIRSTCHILD(decl_fonct_node));
-        fun = get_function(collection, node->val.ident);
-        if (!fun) {
-            use_of_undeclare_symbol(ERROR, node->val.ident, node->lineno, node->colno);
-            return SEM_ERR;
-        }
+    node_t head_instr = FIRSTCHILD(ctx, SECONDCHILD(ctx, SECONDCHILD(ctx, node)));
+    return walk_tree(walk, head_instr);
+}
 
-        head_instr = FIRSTCHILD(SECONDCHILD(SECONDCHILD(decl_fonct_node)));
-        if (!check_instructions(globals, collection, fun, head_instr)) {
-            return SEM_ERR;
+static int check_types(Context* ctx, const Table* globals,
+                       const FunctionCollection* collection, node_t tree) {
+    node_t decl_fonct_node = FIRSTCHILD(ctx, SECONDCHILD(ctx, tree));
+    Scope scope = {.globals = globals, .collection = collection};
+    Walk walk;
+    int res = SEM_GOOD;
+
+    // the functions share the stack of the walk
+    init_walk(&walk, ctx, check_tree, &scope);
+    for (; decl_fonct_node; decl_fonct_node = NEXTSIBLING(ctx, decl_fonct_node)) {
+        if (!check_function_types(ctx, &walk, decl_fonct_node)) {
+            res = SEM_ERR;
+            break;
         }
-        decl_fonct_node = decl_fonct_node->nextSibling;
     }
-    return SEM_GOOD;
+    free_walk(&walk);
+    return res;
 }
 
-int check_sem(Table* globals, FunctionCollection* collection, Node* tree) {
+int check_sem(Context* ctx, Table* globals, FunctionCollection* collection, node_t tree) {
     sort_tables(globals, collection);
-    if (!check_main(collection)) return SEM_ERR;
+    if (!check_main(ctx, collection)) return SEM_ERR;
     
     // no real need to check this one, its only for "notes"
-    search_unused_symbols(globals, collection);
-    return check_types(globals, collection, tree);
+    search_unused_symbols(ctx, globals, collection);
+    return check_types(ctx, globals, collection, tree);
+}
+
+void check_function_unused(Context* ctx, Function* fun) {
+    if (!fun->locals.sorted) {
+        sort_table(&fun->locals);
+    }
+    const char* name = ident_name(ctx, fun->name);
+    search_unused_symbol_table(ctx, &fun->parameters, name);
+    search_unused_symbol_table(ctx, &fun->locals, name);
+}
+
+int check_function_sem(Context* ctx, Table* globals, FunctionCollection* collection,
+                       Function* fun, node_t node) {
+    // globals are complete once the first function is declared
+    if (!globals->sorted) {
+        sort_table(globals);
+    }
+    if (!fun->locals.sorted) {
+        sort_table(&fun->locals);
+    }
+
+    Scope scope = {.globals = globals, .collection = collection};
+    Walk walk;
+    init_walk(&walk, ctx, check_tree, &scope);
+    int res = check_function_types(ctx, &walk, node);
+    free_walk(&walk);
+    return res;
+}
+
+int check_sem_end(Context* ctx, Table* globals,
+                  const FunctionCollection* collection) {
+    if (!check_main(ctx, collection)) return SEM_ERR;
+    if (!globals->sorted) {
+        sort_table(globals);
+    }
+    search_unused_symbol_table(ctx, globals, NULL);
+    return SEM_GOOD;
 }
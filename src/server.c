@@ -0,0 +1,780 @@
+#define _GNU_SOURCE // fopencookie
+
+#include "server.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "batch.h"
+#include "binary.h"
+#include "errors.h"
+#include "gen_nasm.h"
+#include "source.h"
+#include "tpcc.h"
+
+#define ASM_BUFFER_SIZE (1 << 16)
+
+typedef struct {                // stream writing chunks of a reply
+    int fd;                     // connection of the client
+    ReplyKind kind;             // kind of the written chunks
+} ChunkStream;
+
+typedef struct {                // state shared by the workers of a server
+    int fd;                     // listening socket
+} Server;
+
+typedef struct {                // source sent by a client
+    const char* name;           // name used in diagnostics
+    char* path;                 // absolute path read by the server, NULL if
+                                // the source is sent
+    Source source;              // source sent if no path
+} Input;
+
+typedef struct {                // requests sent by a load generator
+    const Context* options;     // options sent with each request
+    const char* path;           // path of the socket of the server
+    Input* inputs;              // sources, sent in turn
+    int nb_inputs;              // number of sources
+    int nb_requests;            // number of requests to send
+    atomic_int next;            // next request to send
+    atomic_int failed;          // requests left without a reply
+    double* latencies;          // latency of each request, in seconds
+} Load;
+
+/**
+ * @brief Send a whole buffer on a connection
+ *
+ * @param fd connection
+ * @param data buffer to send
+ * @param len length of the buffer
+ * @return 1 if success
+ *         0 if the connection is lost
+ */
+static int send_all(int fd, const void* data, size_t len);
+
+/**
+ * @brief Receive a whole buffer from a connection
+ *
+ * @param fd connection
+ * @param data buffer to fill
+ * @param len length of the buffer
+ * @return 1 if success
+ *         0 if the connection is lost or closed
+ */
+static int recv_all(int fd, void* data, size_t len);
+
+/**
+ * @brief Send a chunk of a reply
+ *
+ * @param fd connection of the client
+ * @param kind kind of the chunk
+ * @param data data of the chunk
+ * @param len length of the data
+ * @return 1 if success
+ *         0 if the connection is lost
+ */
+static int send_chunk(int fd, ReplyKind kind, const void* data, size_t len);
+
+/**
+ * @brief Write function of a stream sending chunks
+ *
+ * @param cookie ChunkStream of the stream
+ * @param buf data to send
+ * @param size size of the data
+ * @return size if success
+ *         -1 if the connection is lost
+ */
+static ssize_t write_chunks(void* cookie, const char* buf, size_t size);
+
+/**
+ * @brief Open a stream whose writes are sent as chunks of a reply
+ *
+ * @param chunks state of the stream, kept until it is closed
+ * @param fd connection of the client
+ * @param kind kind of the chunks
+ * @return opened stream, NULL if memory runs out
+ */
+static FILE* open_chunks(ChunkStream* chunks, int fd, ReplyKind kind);
+
+/**
+ * @brief Receive a request and load its source
+ *
+ * @param fd connection of the client
+ * @param req set to the received request
+ * @param strings set to the allocated strings of the request, the name, the
+ *                path and the cache directory, each ended by a null byte
+ * @param source set to the sent source, if the request has no path
+ * @return 1 if success
+ *         0 if the connection is closed or memory runs out
+ */
+static int recv_request(int fd, Request* req, char** strings, Source* source);
+
+/**
+ * @brief Load a source file, then close it
+ *
+ * @param source loaded source
+ * @param file opened source file
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+static int load_file(Source* source, FILE* file);
+
+/**
+ * @brief Compile a request and send its reply
+ *
+ * @param fd connection of the client
+ * @param arena arena of the worker, reused from a request to the next
+ * @return 1 if the client can send another request
+ *         0 if the connection is closed
+ */
+static int serve_request(int fd, Arena* arena);
+
+/**
+ * @brief Worker serving connections until the process is killed
+ *
+ * @param server shared state of the server
+ * @return NULL
+ */
+static void* serve(void* server);
+
+/**
+ * @brief Connect to a server
+ *
+ * @param path path of the socket of the server
+ * @return connection, -1 if the server cannot be reached
+ */
+static int connect_server(const char* path);
+
+/**
+ * @brief Prepare the source of a file to send. Files are read by the server
+ *        through their absolute path, the standard input is sent
+ *
+ * @param input prepared source
+ * @param name path of the source file, NULL for the standard input
+ * @return 1 if success
+ *         0 if the file cannot be found or read
+ */
+static int prepare_input(Input* input, const char* name);
+
+/**
+ * @brief Send a compile request
+ *
+ * @param fd connection of the server
+ * @param options context whose options are sent
+ * @param cache_dir absolute cache directory, NULL if none
+ * @param input source of the request
+ * @return 1 if success
+ *         0 if the connection is lost
+ */
+static int send_request(int fd, const Context* options, const char* cache_dir,
+                        const Input* input);
+
+/**
+ * @brief Receive the reply of a request. Its nasm is written in a file
+ *        opened with the first chunk of nasm
+ *
+ * @param fd connection of the server
+ * @param asm_name name of the nasm file, NULL to drop the nasm
+ * @param asm_out set to the nasm file, if opened
+ * @param diagnostics diagnostics target, NULL to drop them
+ * @param result set to the result of the compilation
+ * @return 1 if success
+ *         0 if the connection is lost
+ */
+static int recv_reply(int fd, const char* asm_name, FILE** asm_out,
+                      FILE* diagnostics, Result* result);
+
+/**
+ * @brief Compute the absolute path of the cache directory, which may not
+ *        exist yet
+ *
+ * @param cache_dir cache directory, NULL if none
+ * @param path set to the absolute path
+ * @return path, or NULL if there is no cache directory
+ */
+static const char* absolute_dir(const char* cache_dir, char* path);
+
+/**
+ * @brief Print the rapport and the statistics of a compilation done by a
+ *        server, as if it was done by this process
+ *
+ * @param options context giving the options of the compilation
+ * @param name name of the source
+ * @param result result of the compilation
+ * @param named if the name is printed before the rapport
+ */
+static void print_result(const Context* options, const char* name,
+                         const Result* result, bool named);
+
+/**
+ * @brief Worker of a load generator, sending requests on its connection
+ *        until all are sent
+ *
+ * @param load shared state of the load generator
+ * @return NULL
+ */
+static void* send_load(void* load);
+
+/**
+ * @brief Send the requests of a load generator, then print the rate of
+ *        requests and their latencies
+ *
+ * @param load prepared load generator
+ * @param jobs number of connections at the same time
+ * @return 0 if every request succeeded
+ *         OTHER_ERROR else
+ */
+static int measure_load(Load* load, int jobs);
+
+/**
+ * @brief Compare two latencies, to sort them
+ *
+ * @param a
+ * @param b
+ * @return comparison of the latencies
+ */
+static int compare_latencies(const void* a, const void* b);
+
+static int send_all(int fd, const void* data, size_t len) {
+    const char* cur = data;
+    while (len) {
+        // a client leaving must not kill the server
+        ssize_t sent = send(fd, cur, len, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return 0;
+        }
+        cur += sent;
+        len -= sent;
+    }
+    return 1;
+}
+
+static int recv_all(int fd, void* data, size_t len) {
+    char* cur = data;
+    while (len) {
+        ssize_t received = recv(fd, cur, len, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return 0;
+        }
+        cur += received;
+        len -= received;
+    }
+    return 1;
+}
+
+static int send_chunk(int fd, ReplyKind kind, const void* data, size_t len) {
+    const char* cur = data;
+    do {
+        ReplyChunk chunk = {.kind = kind, .len = len < UINT32_MAX ? len: UINT32_MAX};
+        if (!send_all(fd, &chunk, sizeof(chunk))
+            || !send_all(fd, cur, chunk.len)) {
+            return 0;
+        }
+        cur += chunk.len;
+        len -= chunk.len;
+    } while (len);
+    return 1;
+}
+
+static ssize_t write_chunks(void* cookie, const char* buf, size_t size) {
+    ChunkStream* chunks = cookie;
+    return send_chunk(chunks->fd, chunks->kind, buf, size) ? (ssize_t)size: -1;
+}
+
+static FILE* open_chunks(ChunkStream* chunks, int fd, ReplyKind kind) {
+    *chunks = (ChunkStream){.fd = fd, .kind = kind};
+    return fopencookie(chunks, "w", (cookie_io_functions_t){.write = write_chunks});
+}
+
+static int load_file(Source* source, FILE* file) {
+    int loaded = load_source(source, file);
+    fclose(file);
+    return loaded;
+}
+
+static int recv_request(int fd, Request* req, char** strings, Source* source) {
+    *strings = NULL;
+    *source = (Source){0};
+    if (!recv_all(fd, req, sizeof(*req)) || req->version != SERVER_VERSION
+        || req->comments > COMMENTS_FULL) {
+        return 0;
+    }
+    size_t len = (size_t)req->name_len + req->path_len + req->cache_dir_len;
+    char* cur = *strings = malloc(len + 3);
+    if (!cur || !recv_all(fd, cur, len)) {
+        free(*strings);
+        return 0;
+    }
+    // each string gets its own null byte
+    memmove(cur + req->name_len + req->path_len + 2,
+            cur + req->name_len + req->path_len, req->cache_dir_len);
+    memmove(cur + req->name_len + 1, cur + req->name_len, req->path_len);
+    cur[req->name_len] = '\0';
+    cur[req->name_len + req->path_len + 1] = '\0';
+    cur[len + 2] = '\0';
+    if (req->path_len) {
+        return 1;
+    }
+    // the scanner reads the source in place, followed by its padding
+    if (!(source->text = calloc(req->source_len + SOURCE_PADDING, 1))) {
+        free(*strings);
+        return 0;
+    }
+    source->len = req->source_len;
+    source->size = req->source_len + SOURCE_PADDING;
+    if (!recv_all(fd, source->text, source->len)) {
+        free_source(source);
+        free(*strings);
+        return 0;
+    }
+    return 1;
+}
+
+static int serve_request(int fd, Arena* arena) {
+    Request req;
+    char* strings;
+    Source source;
+    if (!recv_request(fd, &req, &strings, &source)) {
+        return 0;
+    }
+    const char* path = strings + req.name_len + 1;
+    const char* cache_dir = path + req.path_len + 1;
+
+    Context ctx;
+    init_context(&ctx, strings);
+    ctx.print_stats = req.flags & REQUEST_STATS;
+    ctx.print_cache_stats = req.flags & REQUEST_CACHE_STATS;
+    ctx.fast_lexer = req.flags & REQUEST_FAST_LEXER;
+    ctx.stream_functions = req.flags & REQUEST_STREAM;
+    ctx.codegen = req.flags & REQUEST_CODEGEN_IR ? CODEGEN_IR: CODEGEN_WALK;
+    ctx.comments = req.comments;
+    ctx.cache_dir = req.cache_dir_len ? cache_dir: NULL;
+    ctx.arena = arena;
+
+    ChunkStream diagnostics, nasm;
+    ctx.err = open_chunks(&diagnostics, fd, CHUNK_DIAGNOSTICS);
+    FILE* out = open_chunks(&nasm, fd, CHUNK_ASM);
+    Result result = {.res = OTHER_ERROR};
+    FILE* file;
+    if (!ctx.err || !out) {
+        if (ctx.err) {
+            fclose(ctx.err);
+        }
+        ctx.err = stderr;
+        memory_error(&ctx);
+    } else if (req.path_len && !(file = fopen(path, "r"))) {
+        fprintf(ctx.err, "Cannot open file '%s'\n", ctx.filename);
+    } else if (req.path_len && !load_file(&source, file)) {
+        memory_error(&ctx);
+    } else if (ctx.stream_functions) {
+        setvbuf(out, NULL, _IOFBF, ASM_BUFFER_SIZE);
+        result.res = tpcc_compile_stream(&ctx, &source, out);
+    } else {
+        char* asm_text;
+        result.res = tpcc_compile_source(&ctx, &source, &asm_text);
+        if (asm_text) {
+            fputs(asm_text, out);
+            free(asm_text);
+        }
+    }
+    free_source(&source);
+    free(strings);
+
+    // the result follows the last chunks of nasm and diagnostics
+    bool sent = out && !fclose(out);
+    if (ctx.err != stderr) {
+        sent = !fclose(ctx.err) && sent;
+    }
+    memcpy(result.error_count, ctx.error_count, sizeof(result.error_count));
+    result.stats = ctx.stats;
+    return sent && send_chunk(fd, CHUNK_RESULT, &result, sizeof(result));
+}
+
+static void* serve(void* server) {
+    const Server* s = server;
+    Arena arena;
+    init_arena(&arena);
+    for (;;) {
+        int fd = accept(s->fd, NULL, NULL);
+        if (fd < 0) {
+            continue;
+        }
+        // a client can send several requests on its connection
+        while (serve_request(fd, &arena)) {}
+        close(fd);
+    }
+    free_arena(&arena);
+    return NULL;
+}
+
+int run_server(const char* path, int jobs) {
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path is too long : %s\n", path);
+        return OTHER_ERROR;
+    }
+    strcpy(addr.sun_path, path);
+
+    Server server;
+    // a socket left by a killed server is replaced, not any other file
+    struct stat st;
+    if (!lstat(path, &st) && S_ISSOCK(st.st_mode)) {
+        unlink(path);
+    }
+    server.fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server.fd < 0 || bind(server.fd, (struct sockaddr*)&addr, sizeof(addr))
+        || listen(server.fd, SOMAXCONN)) {
+        fprintf(stderr, "Cannot listen on '%s' : %s\n", path, strerror(errno));
+        return OTHER_ERROR;
+    }
+
+    for (int i = 1; i < jobs; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, serve, &server)) {
+            break;
+        }
+        pthread_detach(thread);
+    }
+    serve(&server);
+    return 0;
+}
+
+static int connect_server(const char* path) {
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path is too long : %s\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr))) {
+        fprintf(stderr, "Cannot connect to '%s' : %s\n", path, strerror(errno));
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    return fd;
+}
+
+static int prepare_input(Input* input, const char* name) {
+    *input = (Input){.name = name ? name: "stdin"};
+    if (name) {
+        // the server may not run in the current directory
+        if (!(input->path = realpath(name, NULL))) {
+            fprintf(stderr, "Cannot open file '%s'\n", name);
+            return 0;
+        }
+        return 1;
+    }
+    if (!load_source(&input->source, stdin)) {
+        fprintf(stderr, "error while allocating memory\n");
+        return 0;
+    }
+    return 1;
+}
+
+static int send_request(int fd, const Context* options, const char* cache_dir,
+                        const Input* input) {
+    Request req = {
+        .version = SERVER_VERSION,
+        .flags = (options->print_stats ? REQUEST_STATS: 0)
+                 | (options->print_cache_stats ? REQUEST_CACHE_STATS: 0)
+                 | (options->fast_lexer ? REQUEST_FAST_LEXER: 0)
+                 | (options->stream_functions ? REQUEST_STREAM: 0)
+                 | (options->codegen == CODEGEN_IR ? REQUEST_CODEGEN_IR: 0),
+        .name_len = strlen(input->name),
+        .path_len = input->path ? strlen(input->path): 0,
+        .cache_dir_len = cache_dir ? strlen(cache_dir): 0,
+        .comments = options->comments,
+        .source_len = input->path ? 0: input->source.len
+    };
+    return send_all(fd, &req, sizeof(req))
+           && send_all(fd, input->name, req.name_len)
+           && send_all(fd, input->path, req.path_len)
+           && send_all(fd, cache_dir, req.cache_dir_len)
+           && send_all(fd, input->source.text, req.source_len);
+}
+
+static int recv_reply(int fd, const char* asm_name, FILE** asm_out,
+                      FILE* diagnostics, Result* result) {
+    char buffer[ASM_BUFFER_SIZE];
+    ReplyChunk chunk;
+    while (recv_all(fd, &chunk, sizeof(chunk))) {
+        if (chunk.kind == CHUNK_RESULT) {
+            return chunk.len == sizeof(*result) && recv_all(fd, result, chunk.len);
+        }
+        while (chunk.len) {
+            size_t len = chunk.len < ASM_BUFFER_SIZE ? chunk.len: ASM_BUFFER_SIZE;
+            if (!recv_all(fd, buffer, len)) {
+                return 0;
+            }
+            chunk.len -= len;
+            if (chunk.kind == CHUNK_DIAGNOSTICS && diagnostics) {
+                fwrite(buffer, 1, len, diagnostics);
+            } else if (chunk.kind == CHUNK_ASM && asm_name) {
+                if (!*asm_out && !(*asm_out = fopen(asm_name, "w"))) {
+                    // the nasm is dropped, as a local compilation does
+                    asm_name = NULL;
+                    continue;
+                }
+                fwrite(buffer, 1, len, *asm_out);
+            }
+        }
+    }
+    return 0;
+}
+
+static const char* absolute_dir(const char* cache_dir, char* path) {
+    char cwd[PATH_MAX];
+    if (!cache_dir) {
+        return NULL;
+    }
+    if (cache_dir[0] == '/' || !getcwd(cwd, PATH_MAX)) {
+        return cache_dir;
+    }
+    // a directory too deep is given as it is
+    int len = snprintf(path, PATH_MAX, "%s/%s", cwd, cache_dir);
+    return len > 0 && len < PATH_MAX ? path: cache_dir;
+}
+
+static void print_result(const Context* options, const char* name,
+                         const Result* result, bool named) {
+    Context ctx = *options;
+    ctx.filename = name;
+    memcpy(ctx.error_count, result->error_count, sizeof(ctx.error_count));
+    ctx.stats = result->stats;
+    // syntax errors are reported by the parser itself
+    if (result->res != SYNTAX_ERROR && result->res != OTHER_ERROR) {
+        if (named) {
+            printf("%s:\n", name);
+        }
+        print_rapport(&ctx);
+    }
+    if (result->res == OTHER_ERROR) {
+        return;
+    }
+    if (named && result->res == SYNTAX_ERROR
+        && (ctx.print_stats || ctx.print_cache_stats)) {
+        printf("%s:\n", name);
+    }
+    if (ctx.print_stats) {
+        print_stats(&ctx);
+    }
+    if (ctx.print_cache_stats) {
+        print_cache_stats(&ctx);
+    }
+}
+
+int run_client(const Context* options, const char* path, char* files[],
+               int nb_files) {
+    char cache_dir[PATH_MAX];
+    const char* dir = absolute_dir(options->cache_dir, cache_dir);
+    // only the earliest of the files written to the same file is compiled
+    int* shared = malloc(sizeof(int)*(nb_files ? nb_files: 1));
+    if (!shared) {
+        fprintf(stderr, "error while allocating memory\n");
+        return OTHER_ERROR;
+    }
+    if (!shared_outputs(options->format, files, nb_files, shared)) {
+        free(shared);
+        return OTHER_ERROR;
+    }
+    int fd = connect_server(path);
+    if (fd < 0) {
+        free(shared);
+        return OTHER_ERROR;
+    }
+
+    int res = 0;
+    for (int i = 0; i < (nb_files ? nb_files: 1); i++) {
+        const char* name = nb_files ? files[i]: NULL;
+        if (nb_files && shared[i] != -1) {
+            shared_output_error(options->format, name, files[shared[i]]);
+            res = OTHER_ERROR;
+            continue;
+        }
+        Input input;
+        if (!prepare_input(&input, name)) {
+            res = OTHER_ERROR;
+            continue;
+        }
+        char asm_name[PATH_MAX];
+        if (!output_name(name, options->format, asm_name, PATH_MAX)) {
+            fprintf(stderr, "File name too long '%s'\n", name);
+            free(input.path);
+            free_source(&input.source);
+            res = OTHER_ERROR;
+            continue;
+        }
+        // the nasm is assembled here once received
+        bool assembled = options->format != FORMAT_NASM;
+        char* nasm = NULL;
+        size_t nasm_len = 0;
+        FILE* asm_out = NULL;
+        if (assembled && !(asm_out = open_memstream(&nasm, &nasm_len))) {
+            fprintf(stderr, "error while allocating memory\n");
+            free(input.path);
+            free_source(&input.source);
+            res = OTHER_ERROR;
+            continue;
+        }
+        Result result;
+        bool replied = send_request(fd, options, dir, &input)
+                       && recv_reply(fd, asm_name, &asm_out, stderr, &result);
+        free(input.path);
+        free_source(&input.source);
+        if (asm_out) {
+            fclose(asm_out);
+        }
+        if (!replied) {
+            fprintf(stderr, "Lost connection to '%s'\n", path);
+            if (!assembled) {
+                remove(asm_name);
+            }
+            free(nasm);
+            res = OTHER_ERROR;
+            break;
+        }
+        // functions streamed before the error do not make a program
+        if (result.res && options->stream_functions && !assembled) {
+            remove(asm_name);
+        }
+        if (!result.res && assembled) {
+            Context ctx = *options;
+            ctx.filename = input.name;
+            if (!write_binary(&ctx, asm_name, nasm, nasm_len)) {
+                result.res = OTHER_ERROR;
+            }
+        }
+        free(nasm);
+        print_result(options, input.name, &result, nb_files > 1);
+        if (result.res > res) {
+            res = result.res;
+        }
+    }
+    close(fd);
+    free(shared);
+    return res;
+}
+
+static void* send_load(void* load) {
+    Load* l = load;
+    char cache_dir[PATH_MAX];
+    const char* dir = absolute_dir(l->options->cache_dir, cache_dir);
+    int fd = connect_server(l->path);
+    int index;
+    while (fd >= 0 && (index = atomic_fetch_add(&l->next, 1)) < l->nb_requests) {
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        Result result;
+        FILE* asm_out = NULL;
+        if (!send_request(fd, l->options, dir, &l->inputs[index % l->nb_inputs])
+            || !recv_reply(fd, NULL, &asm_out, NULL, &result)) {
+            atomic_fetch_add(&l->failed, 1);
+            break;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        l->latencies[index] = (end.tv_sec - start.tv_sec)
+                              + (end.tv_nsec - start.tv_nsec) / 1e9;
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    // requests taken by a failed worker are not sent by another one
+    while ((index = atomic_fetch_add(&l->next, 1)) < l->nb_requests) {
+        atomic_fetch_add(&l->failed, 1);
+    }
+    return NULL;
+}
+
+static int compare_latencies(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static int measure_load(Load* load, int jobs) {
+    pthread_t* workers = malloc(jobs * sizeof(pthread_t));
+    int nb_workers = 0;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (; workers && nb_workers < jobs; nb_workers++) {
+        if (pthread_create(&workers[nb_workers], NULL, send_load, load)) {
+            break;
+        }
+    }
+    if (!nb_workers) {
+        // no thread could be started, send from the current one
+        send_load(load);
+    }
+    for (int i = 0; i < nb_workers; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    free(workers);
+    double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    int failed = atomic_load(&load->failed);
+    int done = load->nb_requests - failed;
+    // failed requests have no latency, so they are sorted first and skipped
+    qsort(load->latencies, load->nb_requests, sizeof(double), compare_latencies);
+    const double* latencies = load->latencies + failed;
+    printf("Load:\n"
+           "-----\n");
+    printf("%-20s%d\n", "requests", done);
+    printf("%-20s%d\n", "failed", failed);
+    printf("%-20s%.0f\n", "requests/s", elapsed > 0 ? done / elapsed: 0);
+    if (done) {
+        printf("%-20s%.0f\n", "p50 latency (us)", latencies[done / 2] * 1e6);
+        printf("%-20s%.0f\n", "p99 latency (us)", latencies[(done - 1) * 99 / 100] * 1e6);
+        printf("%-20s%.0f\n", "max latency (us)", latencies[done - 1] * 1e6);
+    }
+    return failed ? OTHER_ERROR: 0;
+}
+
+int run_load(const Context* options, const char* path, char* files[],
+             int nb_files, int repeat, int jobs) {
+    int nb_inputs = nb_files ? nb_files: 1;
+    Load load = {.options = options, .path = path, .nb_inputs = nb_inputs,
+                 .nb_requests = nb_inputs * repeat,
+                 .inputs = calloc(nb_inputs, sizeof(Input)),
+                 .latencies = calloc(nb_inputs * repeat, sizeof(double))};
+    atomic_init(&load.next, 0);
+    atomic_init(&load.failed, 0);
+    int res = OTHER_ERROR, nb_ready = 0;
+    if (!load.inputs || !load.latencies) {
+        fprintf(stderr, "error while allocating memory\n");
+    } else {
+        while (nb_ready < nb_inputs
+               && prepare_input(&load.inputs[nb_ready], nb_files ? files[nb_ready]: NULL)) {
+            nb_ready++;
+        }
+        if (nb_ready == nb_inputs) {
+            res = measure_load(&load, jobs);
+        }
+    }
+    for (int i = 0; i < nb_ready; i++) {
+        free(load.inputs[i].path);
+        free_source(&load.inputs[i].source);
+    }
+    free(load.inputs);
+    free(load.latencies);
+    return res;
+}
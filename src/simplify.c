@@ -0,0 +1,417 @@
+#include "simplify.h"
+
+#include <limits.h>
+#include <stdbool.h>
+
+#include "errors.h"
+#include "intern.h"
+#include "walk.h"
+
+typedef struct {                // pass simplifying the expressions
+    Walk effects;               // walk looking for side effects in a subtree
+} Simplifier;
+
+/**
+ * @brief Get the value of a character, with its quotes
+ *
+ * @param carac character, as `'a'` or `'\n'`
+ * @return value of the character
+ */
+static int character_value(const char* carac);
+
+/**
+ * @brief Check if a node is a number of a given value
+ *
+ * @param ctx compilation context
+ * @param node
+ * @param value
+ * @return true if the node is the number
+ */
+static bool is_num(Context* ctx, node_t node, int value);
+
+/**
+ * @brief Check if a node can only be 0 or 1
+ *
+ * @param ctx compilation context
+ * @param node
+ * @return true if the node is a comparison or a boolean operation
+ */
+static bool is_boolean(Context* ctx, node_t node);
+
+/**
+ * @brief Turn a node into a number, if the value fits in one. The type of
+ *        the node is kept
+ *
+ * @param ctx compilation context
+ * @param node node to turn into a number
+ * @param value value of the number, computed on 64 bits as when run
+ */
+static void set_num(Context* ctx, node_t node, long long value);
+
+/**
+ * @brief Check if the evaluation of a node alone may have a side effect: a
+ *        call, or a division which may trap
+ *
+ * @param ctx compilation context
+ * @param node
+ * @return true if it may have one
+ */
+static bool is_effect(Context* ctx, node_t node);
+
+/**
+ * @brief Visit of the walk looking for side effects, which stops on the
+ *        first one
+ *
+ * @param walk
+ * @param frame
+ * @return 0 if the node has a side effect, 1 otherwise
+ */
+static int find_effect(Walk* walk, Frame* frame);
+
+/**
+ * @brief Check if a node reads or writes an element of an array
+ *
+ * @param ctx compilation context
+ * @param node
+ * @return true if it does
+ */
+static bool is_access(Context* ctx, node_t node);
+
+/**
+ * @brief Visit of the walk looking for side effects or accesses to array
+ *        elements, which stops on the first one
+ *
+ * @param walk
+ * @param frame
+ * @return 0 if the node has one, 1 otherwise
+ */
+static int find_trap(Walk* walk, Frame* frame);
+
+/**
+ * @brief Remove the double negations at the head of an expression whose
+ *        value is only compared to 0
+ *
+ * @param ctx compilation context
+ * @param node expression
+ */
+static void strip_double_negation(Context* ctx, node_t node);
+
+/**
+ * @brief Simplify an addition, a substraction or a unary plus or minus
+ *
+ * @param simp
+ * @param node
+ */
+static void simplify_add_sub(Simplifier* simp, node_t node);
+
+/**
+ * @brief Simplify a multiplication, a division or a modulo, reporting a
+ *        division by zero
+ *
+ * @param simp
+ * @param node
+ */
+static void simplify_div_star(Simplifier* simp, node_t node);
+
+/**
+ * @brief Simplify a comparison of two constants
+ *
+ * @param ctx compilation context
+ * @param node
+ */
+static void simplify_comp(Context* ctx, node_t node);
+
+/**
+ * @brief Simplify a `&&` or a `||` whose operands are constants
+ *
+ * @param simp
+ * @param node
+ */
+static void simplify_logic(Simplifier* simp, node_t node);
+
+/**
+ * @brief Simplify a negation of a constant or of another negation
+ *
+ * @param ctx compilation context
+ * @param node
+ */
+static void simplify_negation(Context* ctx, node_t node);
+
+/**
+ * @brief Visit of the walk simplifying a node after its children
+ *
+ * @param walk
+ * @param frame
+ * @return 1
+ */
+static int simplify_node(Walk* walk, Frame* frame);
+
+static int character_value(const char* carac) {
+    if (carac[1] != '\\') {
+        return (unsigned char)carac[1];
+    }
+    switch (carac[2]) {
+        case 'n': return '\n';
+        case 't': return '\t';
+        case 'r': return '\r';
+        case '0': return '\0';
+        default: return carac[2]; // quote and backslash
+    }
+}
+
+static bool is_num(Context* ctx, node_t node, int value) {
+    return NODE_LABEL(ctx, node) == Num && NODE_VAL(ctx, node).num == value;
+}
+
+static bool is_boolean(Context* ctx, node_t node) {
+    switch (NODE_LABEL(ctx, node)) {
+        case And: case Or: case Eq: case Order: case Negation:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void set_num(Context* ctx, node_t node, long long value) {
+    // larger values are left to be computed when run
+    if (value < INT_MIN || value > INT_MAX) {
+        return;
+    }
+    NODE_LABEL(ctx, node) = Num;
+    NODE_VAL(ctx, node).num = value;
+    FIRSTCHILD(ctx, node) = NO_NODE;
+}
+
+static bool is_effect(Context* ctx, node_t node) {
+    node_t first = FIRSTCHILD(ctx, node);
+    switch (NODE_LABEL(ctx, node)) {
+        case Ident:
+            return first && (NODE_LABEL(ctx, first) == ListExp
+                             || NODE_LABEL(ctx, first) == NoParametres);
+        case DivStar:
+            return ident_name(ctx, NODE_VAL(ctx, node).ident)[0] != '*'
+                   && (NODE_LABEL(ctx, NEXTSIBLING(ctx, first)) != Num
+                       || is_num(ctx, NEXTSIBLING(ctx, first), 0));
+        default:
+            return false;
+    }
+}
+
+static int find_effect(Walk* walk, Frame* frame) {
+    if (is_effect(walk->ctx, frame->node)) {
+        return 0;
+    }
+    if (frame->step == 0) {
+        visit_list(walk, FIRSTCHILD(walk->ctx, frame->node));
+    }
+    return 1;
+}
+
+static bool is_access(Context* ctx, node_t node) {
+    node_t first = FIRSTCHILD(ctx, node);
+    return NODE_LABEL(ctx, node) == Ident && first
+           && NODE_LABEL(ctx, first) != ListExp
+           && NODE_LABEL(ctx, first) != NoParametres;
+}
+
+static int find_trap(Walk* walk, Frame* frame) {
+    if (is_access(walk->ctx, frame->node)) {
+        return 0;
+    }
+    return find_effect(walk, frame);
+}
+
+void init_effects(Walk* walk, Context* ctx) {
+    init_walk(walk, ctx, find_effect, NULL);
+}
+
+void init_traps(Walk* walk, Context* ctx) {
+    init_walk(walk, ctx, find_trap, NULL);
+}
+
+bool has_side_effect(Walk* effects, node_t node) {
+    Context* ctx = effects->ctx;
+    return is_effect(ctx, node)
+           || (effects->visit == find_trap && is_access(ctx, node))
+           || !walk_tree(effects, FIRSTCHILD(ctx, node));
+}
+
+static void strip_double_negation(Context* ctx, node_t node) {
+    while (NODE_LABEL(ctx, node) == Negation
+           && NODE_LABEL(ctx, FIRSTCHILD(ctx, node)) == Negation) {
+        replaceNode(ctx, node, FIRSTCHILD(ctx, FIRSTCHILD(ctx, node)));
+    }
+}
+
+static void simplify_add_sub(Simplifier* simp, node_t node) {
+    Context* ctx = simp->effects.ctx;
+    char op = ident_name(ctx, NODE_VAL(ctx, node).ident)[0];
+    node_t left = FIRSTCHILD(ctx, node);
+    node_t right = NEXTSIBLING(ctx, left);
+    if (right) {
+        if (NODE_LABEL(ctx, left) == Num && NODE_LABEL(ctx, right) == Num) {
+            long long a = NODE_VAL(ctx, left).num, b = NODE_VAL(ctx, right).num;
+            set_num(ctx, node, op == '+' ? a + b: a - b);
+        } else if (is_num(ctx, right, 0)) {
+            replaceNode(ctx, node, left);
+        } else if (op == '+' && is_num(ctx, left, 0)) {
+            replaceNode(ctx, node, right);
+        } else if (is_num(ctx, left, 0)) {
+            // 0 - x is simplified as -x
+            FIRSTCHILD(ctx, node) = left = right;
+            ctx->tree.last_siblings[right] = right;
+            right = NO_NODE;
+        }
+        if (right) {
+            return;
+        }
+    }
+
+    if (op == '+') {
+        replaceNode(ctx, node, left);
+    } else if (NODE_LABEL(ctx, left) == Num) {
+        set_num(ctx, node, -(long long)NODE_VAL(ctx, left).num);
+    } else if (NODE_LABEL(ctx, left) == AddSub && !SECONDCHILD(ctx, left)
+               && ident_name(ctx, NODE_VAL(ctx, left).ident)[0] == '-') {
+        replaceNode(ctx, node, FIRSTCHILD(ctx, left));
+    }
+}
+
+static void simplify_div_star(Simplifier* simp, node_t node) {
+    Context* ctx = simp->effects.ctx;
+    const char* op = ident_name(ctx, NODE_VAL(ctx, node).ident);
+    node_t left = FIRSTCHILD(ctx, node);
+    node_t right = NEXTSIBLING(ctx, left);
+    bool constants = NODE_LABEL(ctx, left) == Num && NODE_LABEL(ctx, right) == Num;
+    long long a = NODE_VAL(ctx, left).num, b = NODE_VAL(ctx, right).num;
+
+    if (op[0] == '*') {
+        if (constants) {
+            set_num(ctx, node, a * b);
+        } else if (is_num(ctx, right, 1)) {
+            replaceNode(ctx, node, left);
+        } else if (is_num(ctx, left, 1)) {
+            replaceNode(ctx, node, right);
+        } else if ((is_num(ctx, right, 0) && !has_side_effect(&simp->effects, left))
+                   || (is_num(ctx, left, 0) && !has_side_effect(&simp->effects, right))) {
+            set_num(ctx, node, 0);
+        }
+        return;
+    }
+    if (is_num(ctx, right, 0)) {
+        division_by_zero(ctx, op, NODE_LINENO(ctx, node), NODE_COLNO(ctx, node));
+    } else if (constants) {
+        // truncated as idiv does, INT_MIN / -1 does not fit and is kept
+        set_num(ctx, node, op[0] == '/' ? a / b: a % b);
+    } else if (is_num(ctx, right, 1)) {
+        if (op[0] == '/') {
+            replaceNode(ctx, node, left);
+        } else if (!has_side_effect(&simp->effects, left)) {
+            set_num(ctx, node, 0);
+        }
+    }
+}
+
+static void simplify_comp(Context* ctx, node_t node) {
+    node_t left = FIRSTCHILD(ctx, node);
+    node_t right = NEXTSIBLING(ctx, left);
+    if (NODE_LABEL(ctx, left) != Num || NODE_LABEL(ctx, right) != Num) {
+        return;
+    }
+    const char* op = ident_name(ctx, NODE_VAL(ctx, node).ident);
+    int a = NODE_VAL(ctx, left).num, b = NODE_VAL(ctx, right).num;
+    bool res;
+    switch (op[0]) {
+        case '=': res = a == b; break;
+        case '!': res = a != b; break;
+        case '<': res = op[1] == '=' ? a <= b: a < b; break;
+        default: res = op[1] == '=' ? a >= b: a > b; break;
+    }
+    set_num(ctx, node, res);
+}
+
+static void simplify_logic(Simplifier* simp, node_t node) {
+    Context* ctx = simp->effects.ctx;
+    node_t left = FIRSTCHILD(ctx, node);
+    node_t right = NEXTSIBLING(ctx, left);
+    // the value of a `||` when one of its operands is not 0
+    bool absorbing = NODE_LABEL(ctx, node) == Or;
+    strip_double_negation(ctx, left);
+    strip_double_negation(ctx, right);
+
+    if (NODE_LABEL(ctx, left) == Num) {
+        // the right operand is not evaluated when the left one decides
+        if ((NODE_VAL(ctx, left).num != 0) == absorbing) {
+            set_num(ctx, node, absorbing);
+        } else if (NODE_LABEL(ctx, right) == Num) {
+            set_num(ctx, node, NODE_VAL(ctx, right).num != 0);
+        }
+    } else if (NODE_LABEL(ctx, right) == Num
+               && (NODE_VAL(ctx, right).num != 0) == absorbing
+               && !has_side_effect(&simp->effects, left)) {
+        set_num(ctx, node, absorbing);
+    }
+}
+
+static void simplify_negation(Context* ctx, node_t node) {
+    node_t operand = FIRSTCHILD(ctx, node);
+    strip_double_negation(ctx, operand);
+    if (NODE_LABEL(ctx, operand) == Num) {
+        set_num(ctx, node, !NODE_VAL(ctx, operand).num);
+    } else if (NODE_LABEL(ctx, operand) == Negation
+               && is_boolean(ctx, FIRSTCHILD(ctx, operand))) {
+        // !!x is x when x is already 0 or 1
+        replaceNode(ctx, node, FIRSTCHILD(ctx, operand));
+    }
+}
+
+static int simplify_node(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    Simplifier* simp = walk->pass;
+    node_t node = frame->node;
+    if (frame->step == 0) {
+        visit_list(walk, FIRSTCHILD(ctx, node));
+        return 1;
+    }
+    switch (NODE_LABEL(ctx, node)) {
+        case Character:
+            NODE_LABEL(ctx, node) = Num;
+            NODE_VAL(ctx, node).num = character_value(ident_name(ctx, NODE_VAL(ctx, node).ident));
+            break;
+        case AddSub: simplify_add_sub(simp, node); break;
+        case DivStar: simplify_div_star(simp, node); break;
+        case Order:
+        case Eq: simplify_comp(ctx, node); break;
+        case And:
+        case Or: simplify_logic(simp, node); break;
+        case Negation: simplify_negation(ctx, node); break;
+        case If:
+        case While: strip_double_negation(ctx, FIRSTCHILD(ctx, node)); break;
+        default: break;
+    }
+    return 1;
+}
+
+void simplify_function(Context* ctx, node_t node) {
+    Simplifier simp;
+    Walk walk;
+    init_effects(&simp.effects, ctx);
+    init_walk(&walk, ctx, simplify_node, &simp);
+    // the body of the function, after its header
+    walk_tree(&walk, SECONDCHILD(ctx, node));
+    free_walk(&walk);
+    free_walk(&simp.effects);
+}
+
+void simplify_tree(Context* ctx, node_t tree) {
+    Simplifier simp;
+    Walk walk;
+    init_effects(&simp.effects, ctx);
+    init_walk(&walk, ctx, simplify_node, &simp);
+    node_t first = FIRSTCHILD(ctx, SECONDCHILD(ctx, tree));
+    for (node_t node = first; node != NO_NODE; node = NEXTSIBLING(ctx, node)) {
+        walk_tree(&walk, SECONDCHILD(ctx, node));
+    }
+    free_walk(&walk);
+    free_walk(&simp.effects);
+}
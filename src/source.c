@@ -0,0 +1,109 @@
+#include "source.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define READ_CHUNK 4096
+
+/**
+ * @brief Map a regular file in memory. Padding is given by the zeros ending
+ *        the last page, so the file is only mapped if they fit in it
+ * 
+ * @param source loaded source
+ * @param file file to map
+ * @return 1 if success
+ *         0 if the file cannot be mapped
+ */
+static int map_source(Source* source, FILE* file);
+
+/**
+ * @brief Read a file into a buffer, until its end
+ * 
+ * @param source loaded source
+ * @param file file to read
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+static int read_source(Source* source, FILE* file);
+
+static int map_source(Source* source, FILE* file) {
+    struct stat st;
+    long page = sysconf(_SC_PAGESIZE);
+    if (fstat(fileno(file), &st) || !S_ISREG(st.st_mode) || page <= 0) {
+        return 0;
+    }
+    // bytes left in the last page after the end of the file
+    long left = st.st_size % page ? page - st.st_size % page: 0;
+    if (left < SOURCE_PADDING) {
+        return 0;
+    }
+    // private mapping since flex writes in its buffer while scanning
+    size_t size = st.st_size + SOURCE_PADDING;
+    char* text = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                      fileno(file), 0);
+    if (text == MAP_FAILED) {
+        return 0;
+    }
+    *source = (Source){.text   = text,
+                       .len    = st.st_size,
+                       .size   = size,
+                       .mapped = true};
+    return 1;
+}
+
+static int read_source(Source* source, FILE* file) {
+    size_t size = READ_CHUNK, len = 0;
+    char* text = malloc(size), *temp;
+    while (text) {
+        len += fread(text + len, 1, size - len - SOURCE_PADDING, file);
+        // buffer not filled, end of file reached
+        if (len + SOURCE_PADDING < size) {
+            break;
+        }
+        size *= 2;
+        temp = realloc(text, size);
+        if (!temp) {
+            free(text);
+        }
+        text = temp;
+    }
+    if (!text) {
+        return 0;
+    }
+    memset(text + len, 0, SOURCE_PADDING);
+    *source = (Source){.text   = text,
+                       .len    = len,
+                       .size   = size,
+                       .mapped = false};
+    return 1;
+}
+
+int load_source(Source* source, FILE* file) {
+    return map_source(source, file) || read_source(source, file);
+}
+
+int copy_source(Source* source, const char* src, size_t len) {
+    char* text = malloc(len + SOURCE_PADDING);
+    if (!text) {
+        return 0;
+    }
+    memcpy(text, src, len);
+    memset(text + len, 0, SOURCE_PADDING);
+    *source = (Source){.text   = text,
+                       .len    = len,
+                       .size   = len + SOURCE_PADDING,
+                       .mapped = false};
+    return 1;
+}
+
+void free_source(Source* source) {
+    if (source->mapped) {
+        munmap(source->text, source->size);
+    } else {
+        free(source->text);
+    }
+    source->text = NULL;
+}
@@ -0,0 +1,642 @@
+#include "ssa.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "errors.h"
+
+typedef struct {                // list of blocks
+    int* blocks;
+    int len;
+    int max_len;
+} BlockList;
+
+typedef struct {                // value of a variable before a block
+    int var;                    // renamed variable
+    vreg_t value;               // value it had
+} Undo;
+
+/**
+ * @brief Append a block to a list
+ *
+ * @param list list of blocks
+ * @param block block to append
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+static int append_block(BlockList* list, int block);
+
+/**
+ * @brief Drop the blocks which cannot be reached from the entry, keep the
+ *        other ones in the order they are laid out, and remove the edges
+ *        coming from dropped blocks
+ *
+ * @param ctx compilation context
+ * @param ir IR of the function
+ * @param layout blocks in the order they are written
+ * @param nb_layout number of blocks in layout
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+static int keep_reachable(Context* ctx, IrFunction* ir, const int* layout,
+                          int nb_layout);
+
+/**
+ * @brief Compute the dominance frontier of each block, the blocks where
+ *        its dominance ends
+ *
+ * @param ir IR of the function, with its immediate dominators
+ * @param frontiers list of each block, filled
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+static int compute_frontiers(const IrFunction* ir, BlockList* frontiers);
+
+/**
+ * @brief Insert the phis of the promoted variables, on the iterated
+ *        dominance frontier of the blocks storing them
+ *
+ * @param ctx compilation context
+ * @param ir IR of the function
+ * @param frontiers dominance frontier of each block
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+static int insert_phis(Context* ctx, IrFunction* ir, const BlockList* frontiers);
+
+/**
+ * @brief Rename the promoted variables along the dominator tree: loads
+ *        become the value the variable holds there, stores change it, and
+ *        phis take the value of each predecessor
+ *
+ * @param ctx compilation context
+ * @param ir IR of the function, with its phis
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+static int rename_vars(Context* ctx, IrFunction* ir);
+
+/**
+ * @brief Remove the instructions whose value is not used by an instruction
+ *        with side effects, the stores, calls, divisions and terminators,
+ *        even through phis. Registers are then numbered again in order
+ *
+ * @param ctx compilation context
+ * @param ir IR of the function
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+static int remove_dead_code(Context* ctx, IrFunction* ir);
+
+/**
+ * @brief Tell if an instruction is kept even if its value is not used
+ *
+ * @param op operation of the instruction
+ * @return true for stores, calls, divisions, which may fault, and
+ *         terminators
+ */
+static bool has_effect(IrOp op);
+
+/**
+ * @brief Mark the registers used by an instruction as live, and queue the
+ *        ones not marked yet
+ *
+ * @param ir IR of the function
+ * @param instr instruction using the registers
+ * @param live if each register is live
+ * @param work queue of the registers whose operands are to mark
+ * @param nb_work length of the queue
+ * @return length of the queue
+ */
+static int mark_uses(const IrFunction* ir, const IrInstr* instr, bool* live,
+                     vreg_t* work, int nb_work);
+
+/**
+ * @brief Find the closest common dominator of two blocks
+ *
+ * @param idom immediate dominator of each block
+ * @param order index of each block in postorder
+ * @param a first block
+ * @param b second block
+ * @return common dominator
+ */
+static int intersect(const int* idom, const int* order, int a, int b);
+
+
+static int append_block(BlockList* list, int block) {
+    if (list->len == list->max_len) {
+        int max_len = list->max_len ? list->max_len * 2: 4;
+        int* blocks = realloc(list->blocks, max_len * sizeof(int));
+        if (!blocks) {
+            return 0;
+        }
+        list->blocks = blocks;
+        list->max_len = max_len;
+    }
+    list->blocks[list->len++] = block;
+    return 1;
+}
+
+static int keep_reachable(Context* ctx, IrFunction* ir, const int* layout,
+                          int nb_layout) {
+    int* index = malloc(ir->nb_blocks * sizeof(int));
+    int* stack = malloc(ir->nb_blocks * sizeof(int));
+    IrBlock* blocks = malloc(ir->nb_blocks * sizeof(IrBlock));
+    if (!index || !stack || !blocks) {
+        memory_error(ctx);
+        free(index);
+        free(stack);
+        free(blocks);
+        return 0;
+    }
+    // -2 for blocks not reached, -1 for blocks reached but not placed yet
+    for (int b = 0; b < ir->nb_blocks; b++) {
+        index[b] = -2;
+    }
+    int depth = 0;
+    stack[depth++] = 0;
+    index[0] = -1;
+    while (depth) {
+        const IrBlock* block = &ir->blocks[stack[--depth]];
+        for (int i = 0; i < block->nb_succs; i++) {
+            if (index[block->succs[i]] == -2) {
+                index[block->succs[i]] = -1;
+                stack[depth++] = block->succs[i];
+            }
+        }
+    }
+    int nb_blocks = 0;
+    for (int i = 0; i < nb_layout; i++) {
+        if (index[layout[i]] == -1) {
+            index[layout[i]] = nb_blocks;
+            blocks[nb_blocks++] = ir->blocks[layout[i]];
+        }
+    }
+    for (int b = 0; b < ir->nb_blocks; b++) {
+        if (index[b] == -2) {
+            free(ir->blocks[b].instrs);
+            free(ir->blocks[b].preds);
+        }
+    }
+    for (int b = 0; b < nb_blocks; b++) {
+        IrBlock* block = &blocks[b];
+        for (int i = 0; i < block->nb_succs; i++) {
+            block->succs[i] = index[block->succs[i]];
+        }
+        int nb_preds = 0;
+        for (int i = 0; i < block->nb_preds; i++) {
+            if (index[block->preds[i]] >= 0) {
+                block->preds[nb_preds++] = index[block->preds[i]];
+            }
+        }
+        block->nb_preds = nb_preds;
+    }
+    free(ir->blocks);
+    ir->blocks = blocks;
+    ir->nb_blocks = ir->max_blocks = nb_blocks;
+    free(index);
+    free(stack);
+    return 1;
+}
+
+static int intersect(const int* idom, const int* order, int a, int b) {
+    while (a != b) {
+        while (order[a] < order[b]) {
+            a = idom[a];
+        }
+        while (order[b] < order[a]) {
+            b = idom[b];
+        }
+    }
+    return a;
+}
+
+int compute_dominators(const IrFunction* ir, int* idom) {
+    int nb_blocks = ir->nb_blocks;
+    int* order = malloc(nb_blocks * sizeof(int));       // postorder index
+    int* postorder = malloc(nb_blocks * sizeof(int));   // blocks in postorder
+    int* stack = malloc(nb_blocks * sizeof(int));
+    int* next = malloc(nb_blocks * sizeof(int));        // next successor to
+                                                        // visit in the stack
+    if (!order || !postorder || !stack || !next) {
+        free(order);
+        free(postorder);
+        free(stack);
+        free(next);
+        return 0;
+    }
+    for (int b = 0; b < nb_blocks; b++) {
+        order[b] = -1;
+        idom[b] = -2;
+    }
+    int nb_visited = 0, depth = 0;
+    if (nb_blocks) {
+        stack[depth] = 0;
+        next[depth++] = 0;
+        order[0] = nb_blocks; // visited, numbered once its successors are
+    }
+    while (depth) {
+        int b = stack[depth - 1];
+        if (next[depth - 1] < ir->blocks[b].nb_succs) {
+            int succ = ir->blocks[b].succs[next[depth - 1]++];
+            if (order[succ] == -1) {
+                order[succ] = nb_blocks;
+                stack[depth] = succ;
+                next[depth++] = 0;
+            }
+            continue;
+        }
+        order[b] = nb_visited;
+        postorder[nb_visited++] = b;
+        depth--;
+    }
+
+    // Cooper, Harvey and Kennedy: idoms are refined in reverse postorder
+    // until they are stable
+    if (nb_blocks) {
+        idom[0] = 0;
+    }
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int i = nb_visited - 2; i >= 0; i--) {
+            int b = postorder[i];
+            int new_idom = -1;
+            for (int j = 0; j < ir->blocks[b].nb_preds; j++) {
+                int pred = ir->blocks[b].preds[j];
+                if (idom[pred] == -2) {
+                    continue;
+                }
+                new_idom = new_idom == -1 ? pred: intersect(idom, order, pred, new_idom);
+            }
+            if (new_idom != idom[b]) {
+                idom[b] = new_idom;
+                changed = true;
+            }
+        }
+    }
+    if (nb_blocks) {
+        idom[0] = -1;
+    }
+    free(order);
+    free(postorder);
+    free(stack);
+    free(next);
+    return 1;
+}
+
+static int compute_frontiers(const IrFunction* ir, BlockList* frontiers) {
+    for (int b = 0; b < ir->nb_blocks; b++) {
+        const IrBlock* block = &ir->blocks[b];
+        if (block->nb_preds < 2) {
+            continue;
+        }
+        // b is in the frontier of the blocks from each predecessor up to
+        // its dominator
+        for (int i = 0; i < block->nb_preds; i++) {
+            for (int runner = block->preds[i]; runner != block->idom;
+                 runner = ir->blocks[runner].idom) {
+                BlockList* frontier = &frontiers[runner];
+                if (frontier->len && frontier->blocks[frontier->len - 1] == b) {
+                    continue;
+                }
+                if (!append_block(frontier, b)) {
+                    return 0;
+                }
+            }
+        }
+    }
+    return 1;
+}
+
+static int insert_phis(Context* ctx, IrFunction* ir, const BlockList* frontiers) {
+    int nb_blocks = ir->nb_blocks;
+    int* has_phi = malloc(nb_blocks * sizeof(int));     // last var with a phi
+    int* queued = malloc(nb_blocks * sizeof(int));      // last var queued
+    int* nb_phis = calloc(nb_blocks, sizeof(int));
+    BlockList work = {0};
+    BlockList phis = {0};                               // pairs of block, var
+    int res = 0;
+    bool reported = false;
+    if (!has_phi || !queued || !nb_phis) {
+        goto end;
+    }
+    for (int b = 0; b < nb_blocks; b++) {
+        has_phi[b] = queued[b] = -1;
+    }
+    for (int var = 0; var < ir->nb_vars; var++) {
+        if (!ir->vars[var].promoted) {
+            continue;
+        }
+        work.len = 0;
+        for (int b = 0; b < nb_blocks; b++) {
+            const IrBlock* block = &ir->blocks[b];
+            for (int i = 0; i < block->nb_instrs; i++) {
+                if (block->instrs[i].op == IR_STORE && block->instrs[i].var == var) {
+                    if (!append_block(&work, b)) {
+                        goto end;
+                    }
+                    queued[b] = var;
+                    break;
+                }
+            }
+        }
+        // a phi stores the variable too
+        while (work.len) {
+            int b = work.blocks[--work.len];
+            for (int i = 0; i < frontiers[b].len; i++) {
+                int d = frontiers[b].blocks[i];
+                if (has_phi[d] == var) {
+                    continue;
+                }
+                has_phi[d] = var;
+                nb_phis[d]++;
+                if (!append_block(&phis, d) || !append_block(&phis, var)) {
+                    goto end;
+                }
+                if (queued[d] != var) {
+                    queued[d] = var;
+                    if (!append_block(&work, d)) {
+                        goto end;
+                    }
+                }
+            }
+        }
+    }
+
+    // phis come first in their block, in the order of the variables
+    int* first = calloc(nb_blocks, sizeof(int));
+    if (!first) {
+        goto end;
+    }
+    for (int b = 0; b < nb_blocks; b++) {
+        IrBlock* block = &ir->blocks[b];
+        if (!nb_phis[b]) {
+            continue;
+        }
+        IrInstr* instrs = malloc((block->nb_instrs + nb_phis[b]) * sizeof(IrInstr));
+        if (!instrs) {
+            free(first);
+            goto end;
+        }
+        memcpy(instrs + nb_phis[b], block->instrs, block->nb_instrs * sizeof(IrInstr));
+        free(block->instrs);
+        block->instrs = instrs;
+        block->nb_instrs += nb_phis[b];
+        block->max_instrs = block->nb_instrs;
+    }
+    for (int i = 0; i < phis.len; i += 2) {
+        int b = phis.blocks[i];
+        IrBlock* block = &ir->blocks[b];
+        int operand = add_operands(ctx, ir, block->nb_preds);
+        if (operand == -1) {
+            reported = true;
+            free(first);
+            goto end;
+        }
+        block->instrs[first[b]++] = (IrInstr){.op = IR_PHI,
+                                              .dst = ir->nb_vregs++,
+                                              .var = phis.blocks[i + 1],
+                                              .first_operand = operand,
+                                              .nb_operands = block->nb_preds};
+    }
+    free(first);
+    res = 1;
+end:
+    if (!res && !reported) {
+        memory_error(ctx);
+    }
+    free(has_phi);
+    free(queued);
+    free(nb_phis);
+    free(work.blocks);
+    free(phis.blocks);
+    return res;
+}
+
+static int rename_vars(Context* ctx, IrFunction* ir) {
+    int nb_blocks = ir->nb_blocks;
+    vreg_t* repl = malloc(ir->nb_vregs * sizeof(vreg_t));   // value of loads
+    vreg_t* cur = calloc(ir->nb_vars ? ir->nb_vars: 1, sizeof(vreg_t));
+    int* first_child = malloc(nb_blocks * sizeof(int));     // dominator tree
+    int* next_child = malloc(nb_blocks * sizeof(int));
+    int* mark = malloc(nb_blocks * sizeof(int));            // undo log length
+    int* stack = malloc(2 * nb_blocks * sizeof(int));       // once entering
+                                                            // and leaving
+    Undo* undo = NULL;
+    int nb_undo = 0, max_undo = 0;
+    int res = 0;
+    if (!repl || !cur || !first_child || !next_child || !mark || !stack) {
+        goto end;
+    }
+    for (vreg_t v = 0; v < ir->nb_vregs; v++) {
+        repl[v] = v;
+    }
+    for (int b = 0; b < nb_blocks; b++) {
+        first_child[b] = -1;
+    }
+    for (int b = nb_blocks - 1; b > 0; b--) {
+        next_child[b] = first_child[ir->blocks[b].idom];
+        first_child[ir->blocks[b].idom] = b;
+    }
+
+    int depth = 0;
+    stack[depth++] = 0;
+    while (depth) {
+        int top = stack[--depth];
+        if (top < 0) {
+            // the values of the block are out of scope once left
+            for (; nb_undo > mark[-top - 1]; nb_undo--) {
+                cur[undo[nb_undo - 1].var] = undo[nb_undo - 1].value;
+            }
+            continue;
+        }
+        IrBlock* block = &ir->blocks[top];
+        mark[top] = nb_undo;
+        for (int i = 0; i < block->nb_instrs; i++) {
+            IrInstr* instr = &block->instrs[i];
+            if (instr->op != IR_PHI) {
+                instr->a = repl[instr->a];
+                instr->b = repl[instr->b];
+            }
+            if (instr->op == IR_CALL) {
+                for (int j = 0; j < instr->nb_operands; j++) {
+                    vreg_t* operand = &ir->operands[instr->first_operand + j];
+                    *operand = repl[*operand];
+                }
+            }
+            if ((instr->op != IR_PHI && instr->op != IR_LOAD && instr->op != IR_STORE)
+                || !ir->vars[instr->var].promoted) {
+                continue;
+            }
+            if (instr->op == IR_LOAD) {
+                repl[instr->dst] = cur[instr->var];
+                instr->op = IR_NOP;
+                continue;
+            }
+            if (nb_undo == max_undo) {
+                int max_len = max_undo ? max_undo * 2: 16;
+                Undo* temp = realloc(undo, max_len * sizeof(Undo));
+                if (!temp) {
+                    goto end;
+                }
+                undo = temp;
+                max_undo = max_len;
+            }
+            undo[nb_undo++] = (Undo){.var = instr->var, .value = cur[instr->var]};
+            // values are kept as they are: the stored register is the value
+            if (instr->op == IR_PHI) {
+                cur[instr->var] = instr->dst;
+            } else {
+                cur[instr->var] = instr->a;
+                instr->op = IR_NOP;
+            }
+        }
+        for (int i = 0; i < block->nb_succs; i++) {
+            IrBlock* succ = &ir->blocks[block->succs[i]];
+            int pred = 0;
+            while (succ->preds[pred] != top) {
+                pred++;
+            }
+            for (int j = 0; j < succ->nb_instrs && succ->instrs[j].op == IR_PHI; j++) {
+                IrInstr* phi = &succ->instrs[j];
+                ir->operands[phi->first_operand + pred] = cur[phi->var];
+            }
+        }
+        stack[depth++] = -top - 1;
+        for (int child = first_child[top]; child != -1; child = next_child[child]) {
+            stack[depth++] = child;
+        }
+    }
+    res = 1;
+end:
+    if (!res) {
+        memory_error(ctx);
+    }
+    free(repl);
+    free(cur);
+    free(first_child);
+    free(next_child);
+    free(mark);
+    free(stack);
+    free(undo);
+    return res;
+}
+
+static bool has_effect(IrOp op) {
+    return op == IR_STORE || op == IR_CALL || op == IR_DIV || op == IR_MOD
+           || is_terminator(op);
+}
+
+static int mark_uses(const IrFunction* ir, const IrInstr* instr, bool* live,
+                     vreg_t* work, int nb_work) {
+    vreg_t uses[2] = {instr->a, instr->b};
+    for (int i = 0; i < 2 + instr->nb_operands; i++) {
+        vreg_t use = i < 2 ? uses[i]: ir->operands[instr->first_operand + i - 2];
+        if (use != NO_VREG && !live[use]) {
+            live[use] = true;
+            work[nb_work++] = use;
+        }
+    }
+    return nb_work;
+}
+
+static int remove_dead_code(Context* ctx, IrFunction* ir) {
+    // block and index of the definition of each register
+    int* defs = malloc(2 * ir->nb_vregs * sizeof(int));
+    bool* live = calloc(ir->nb_vregs, sizeof(bool));
+    vreg_t* work = malloc(ir->nb_vregs * sizeof(vreg_t));
+    vreg_t* number = calloc(ir->nb_vregs, sizeof(vreg_t));
+    if (!defs || !live || !work || !number) {
+        memory_error(ctx);
+        free(defs);
+        free(live);
+        free(work);
+        free(number);
+        return 0;
+    }
+    int nb_work = 0;
+    for (int b = 0; b < ir->nb_blocks; b++) {
+        const IrBlock* block = &ir->blocks[b];
+        for (int i = 0; i < block->nb_instrs; i++) {
+            const IrInstr* instr = &block->instrs[i];
+            if (instr->dst != NO_VREG) {
+                defs[2*instr->dst] = b;
+                defs[2*instr->dst + 1] = i;
+            }
+            if (has_effect(instr->op)) {
+                nb_work = mark_uses(ir, instr, live, work, nb_work);
+            }
+        }
+    }
+    // the operands of a live value are live
+    while (nb_work) {
+        vreg_t reg = work[--nb_work];
+        const IrInstr* instr = &ir->blocks[defs[2*reg]].instrs[defs[2*reg + 1]];
+        nb_work = mark_uses(ir, instr, live, work, nb_work);
+    }
+
+    // registers are numbered in the order they are defined
+    vreg_t nb_vregs = 1;
+    for (int b = 0; b < ir->nb_blocks; b++) {
+        IrBlock* block = &ir->blocks[b];
+        int nb_instrs = 0;
+        for (int i = 0; i < block->nb_instrs; i++) {
+            IrInstr* instr = &block->instrs[i];
+            if (instr->op == IR_NOP
+                || (!has_effect(instr->op) && instr->dst != NO_VREG && !live[instr->dst])) {
+                continue;
+            }
+            if (instr->dst != NO_VREG) {
+                number[instr->dst] = nb_vregs++;
+            }
+            block->instrs[nb_instrs++] = *instr;
+        }
+        block->nb_instrs = nb_instrs;
+    }
+    for (int b = 0; b < ir->nb_blocks; b++) {
+        IrBlock* block = &ir->blocks[b];
+        for (int i = 0; i < block->nb_instrs; i++) {
+            IrInstr* instr = &block->instrs[i];
+            instr->dst = number[instr->dst];
+            instr->a = number[instr->a];
+            instr->b = number[instr->b];
+            for (int j = 0; j < instr->nb_operands; j++) {
+                vreg_t* operand = &ir->operands[instr->first_operand + j];
+                *operand = number[*operand];
+            }
+        }
+    }
+    ir->nb_vregs = nb_vregs;
+    free(defs);
+    free(live);
+    free(work);
+    free(number);
+    return 1;
+}
+
+int build_ssa(Context* ctx, IrFunction* ir, const int* layout, int nb_layout) {
+    if (!keep_reachable(ctx, ir, layout, nb_layout)) {
+        return 0;
+    }
+    int* idom = malloc(ir->nb_blocks * sizeof(int));
+    BlockList* frontiers = calloc(ir->nb_blocks, sizeof(BlockList));
+    int res = idom && frontiers && compute_dominators(ir, idom);
+    if (res) {
+        for (int b = 0; b < ir->nb_blocks; b++) {
+            ir->blocks[b].idom = idom[b];
+        }
+        res = compute_frontiers(ir, frontiers);
+    }
+    if (!res) {
+        memory_error(ctx);
+    }
+    res = res && insert_phis(ctx, ir, frontiers) && rename_vars(ctx, ir)
+          && remove_dead_code(ctx, ir);
+    for (int b = 0; frontiers && b < ir->nb_blocks; b++) {
+        free(frontiers[b].blocks);
+    }
+    free(frontiers);
+    free(idom);
+    return res;
+}
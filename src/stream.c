@@ -0,0 +1,345 @@
+#include "stream.h"
+
+#include <limits.h>
+#include <stdlib.h>
+
+#include "dead_code.h"
+#include "errors.h"
+#include "gen_nasm.h"
+#include "sematic.h"
+#include "simplify.h"
+#include "walk.h"
+
+#define INIT_PENDING 8
+
+/**
+ * @brief Find the lowest node of a tree. Visit of a walk whose pass is the
+ *        lowest node found
+ *
+ * @param walk
+ * @param frame frame of the visited node
+ * @return 1
+ */
+static int lowest_node(Walk* walk, Frame* frame);
+
+/**
+ * @brief Keep a function to compile it once all functions are declared
+ *
+ * @param ctx compilation context
+ * @param stream
+ * @param node head node of the function (the 'DeclFonct' label)
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+static int add_pending(Context* ctx, Stream* stream, node_t node);
+
+/**
+ * @brief Check and generate a function whose calls are all declared. Only
+ *        its signature is kept afterwards
+ *
+ * @param ctx compilation context
+ * @param stream
+ * @param node head node of the function (the 'DeclFonct' label)
+ */
+static void compile_function(Context* ctx, Stream* stream, node_t node);
+
+/**
+ * @brief Hold the next diagnostics until the source is parsed, as a syntax
+ *        error cancels them and the whole tree reports them in another
+ *        order
+ *
+ * @param ctx compilation context
+ * @param stream
+ * @param kind part of the compilation held
+ * @param fun index of the function in the collection, -1 for the globals
+ */
+static void hold_diagnostics(Context* ctx, Stream* stream, HeldKind kind,
+                             int fun);
+
+/**
+ * @brief Report the next diagnostics again. Those held since
+ *        `hold_diagnostics` are not counted until they are reported
+ *
+ * @param ctx compilation context
+ * @param stream
+ */
+static void release_diagnostics(Context* ctx, Stream* stream);
+
+/**
+ * @brief Compare held sections by their kind, then by their function
+ *
+ * @param a first section
+ * @param b second section
+ * @return negative, 0 or positive as for qsort
+ */
+static int compare_sections(const void* a, const void* b);
+
+/**
+ * @brief Report the held diagnostics of a kind, up to a function, and
+ *        count them
+ *
+ * @param ctx compilation context
+ * @param stream stream whose sections are sorted
+ * @param kind part of the compilation reported
+ * @param last index of the last function reported
+ */
+static void report_sections(Context* ctx, Stream* stream, HeldKind kind,
+                            int last);
+
+static int lowest_node(Walk* walk, Frame* frame) {
+    node_t* lowest = walk->pass;
+    if (frame->step) {
+        return 1;
+    }
+    if (frame->node < *lowest) {
+        *lowest = frame->node;
+    }
+    visit_list(walk, FIRSTCHILD(walk->ctx, frame->node));
+    return 1;
+}
+
+static int add_pending(Context* ctx, Stream* stream, node_t node) {
+    if (stream->nb_pending == stream->max_pending) {
+        int max_pending = stream->max_pending ? stream->max_pending * 2: INIT_PENDING;
+        node_t* pending = realloc(stream->pending, max_pending * sizeof(node_t));
+        if (!pending) {
+            memory_error(ctx);
+            return 0;
+        }
+        stream->pending = pending;
+        stream->max_pending = max_pending;
+    }
+    stream->pending[stream->nb_pending++] = node;
+    return 1;
+}
+
+static void compile_function(Context* ctx, Stream* stream, node_t node) {
+    node_t name = SECONDCHILD(ctx, FIRSTCHILD(ctx, node));
+    Function* fun = get_function(&stream->functions, NODE_VAL(ctx, name).ident);
+    int index = fun - stream->functions.funcs;
+    // as for the whole tree, the functions after the first failing one are
+    // not checked
+    if (index > stream->failed_at) {
+        return;
+    }
+    hold_diagnostics(ctx, stream, HELD_CHECKS, index);
+    if (!check_function_sem(ctx, &stream->globals, &stream->functions, fun, node)) {
+        stream->failed = true;
+        stream->failed_at = index;
+    } else if (!stream->failed) {
+        simplify_function(ctx, node);
+        if (eliminate_dead_code(ctx, fun, node)) {
+            gen_nasm_function(ctx, &stream->globals, &stream->functions, node);
+        } else {
+            memory_error(ctx);
+            stream->failed = true;
+        }
+    }
+    release_diagnostics(ctx, stream);
+    if (stream->failed) {
+        return;
+    }
+
+    // the size of the locals is kept in the table, for calls
+    free(fun->locals.array);
+    fun->locals.array = NULL;
+    fun->locals.cur_len = fun->locals.max_len = 0;
+}
+
+static void hold_diagnostics(Context* ctx, Stream* stream, HeldKind kind,
+                             int fun) {
+    if (stream->nb_sections == stream->max_sections) {
+        int max_sections = stream->max_sections ? stream->max_sections * 2
+                                                : INIT_PENDING;
+        HeldSection* sections = realloc(stream->sections,
+                                        max_sections * sizeof(HeldSection));
+        if (!sections) {
+            // the diagnostics are reported at once
+            memory_error(ctx);
+            stream->failed = true;
+            return;
+        }
+        stream->sections = sections;
+        stream->max_sections = max_sections;
+    }
+    fflush(stream->held);
+    HeldSection* section = &stream->sections[stream->nb_sections++];
+    *section = (HeldSection){.kind = kind, .fun = fun, .start = stream->held_len};
+    for (int i = 0; i < NB_ERROR_TYPES; i++) {
+        section->count[i] = ctx->error_count[i];
+    }
+    stream->err = ctx->err;
+    ctx->err = stream->held;
+}
+
+static void release_diagnostics(Context* ctx, Stream* stream) {
+    if (ctx->err != stream->held) {
+        return;
+    }
+    ctx->err = stream->err;
+    fflush(stream->held);
+    HeldSection* section = &stream->sections[stream->nb_sections - 1];
+    section->end = stream->held_len;
+    for (int i = 0; i < NB_ERROR_TYPES; i++) {
+        section->count[i] = ctx->error_count[i] - section->count[i];
+        ctx->error_count[i] -= section->count[i];
+    }
+}
+
+static int compare_sections(const void* a, const void* b) {
+    const HeldSection* x = a;
+    const HeldSection* y = b;
+    if (x->kind != y->kind) {
+        return x->kind < y->kind ? -1: 1;
+    }
+    if (x->fun != y->fun) {
+        return x->fun < y->fun ? -1: 1;
+    }
+    return (x->start > y->start) - (x->start < y->start);
+}
+
+static void report_sections(Context* ctx, Stream* stream, HeldKind kind,
+                            int last) {
+    for (int i = 0; i < stream->nb_sections; i++) {
+        const HeldSection* section = &stream->sections[i];
+        if (section->kind != kind || section->fun > last) {
+            continue;
+        }
+        fwrite(stream->held_buf + section->start, 1,
+               section->end - section->start, ctx->err);
+        for (int j = 0; j < NB_ERROR_TYPES; j++) {
+            ctx->error_count[j] += section->count[j];
+        }
+    }
+}
+
+int init_stream(Context* ctx, Stream* stream, FILE* out) {
+    *stream = (Stream){.out = out, .failed_at = INT_MAX};
+    if (!init_table(ctx, &stream->globals)) {
+        return 0;
+    }
+    if (!init_function_collection(ctx, &stream->functions)) {
+        free_table(&stream->globals);
+        return 0;
+    }
+    if (!(stream->held = open_memstream(&stream->held_buf, &stream->held_len))) {
+        memory_error(ctx);
+        free_stream(stream);
+        return 0;
+    }
+    return 1;
+}
+
+void free_stream(Stream* stream) {
+    free_collection(&stream->functions);
+    free_table(&stream->globals);
+    free(stream->pending);
+    stream->pending = NULL;
+    if (stream->held) {
+        fclose(stream->held);
+        stream->held = NULL;
+    }
+    free(stream->held_buf);
+    stream->held_buf = NULL;
+    free(stream->sections);
+    stream->sections = NULL;
+}
+
+void start_stream(Context* ctx, node_t node) {
+    Stream* stream = ctx->stream;
+    if (ctx->print_tree) {
+        printTree(ctx, node);
+    }
+    hold_diagnostics(ctx, stream, HELD_DECLARATIONS, -1);
+    int declared = create_globals_table(ctx, &stream->globals, &stream->functions,
+                                        node);
+    release_diagnostics(ctx, stream);
+    if (!declared) {
+        // as for the whole tree, only the declarations are reported
+        stream->failed = stream->stopped = true;
+        return;
+    }
+    if (ctx->print_symbols) {
+        puts("globals:");
+        print_table(ctx, stream->globals);
+    }
+    gen_nasm_init(ctx, stream->out, &stream->globals, &stream->functions);
+}
+
+void stream_function(Context* ctx, node_t node) {
+    Stream* stream = ctx->stream;
+
+    // nodes of the function are the last ones made
+    node_t lowest = node;
+    Walk walk;
+    init_walk(&walk, ctx, lowest_node, &lowest);
+    walk_tree(&walk, node);
+    free_walk(&walk);
+
+    bool pending = false;
+    if (!stream->stopped) {
+        if (ctx->print_tree) {
+            printTree(ctx, node);
+        }
+        int forward_calls = 0;
+        int index = stream->functions.cur_len;
+        hold_diagnostics(ctx, stream, HELD_DECLARATIONS, index);
+        int declared = create_function_tables(ctx, &stream->globals,
+                                              &stream->functions, node,
+                                              &forward_calls);
+        release_diagnostics(ctx, stream);
+        if (!declared) {
+            // as for the whole tree, only the declarations are reported
+            stream->failed = stream->stopped = true;
+        } else {
+            Function* fun = &stream->functions.funcs[index];
+            if (ctx->print_symbols) {
+                print_function(ctx, fun);
+            }
+            hold_diagnostics(ctx, stream, HELD_UNUSED, index);
+            check_function_unused(ctx, fun);
+            release_diagnostics(ctx, stream);
+            if (forward_calls) {
+                // resolved once all functions are declared
+                if (!add_pending(ctx, stream, node)) {
+                    stream->failed = true;
+                }
+                pending = true;
+            } else {
+                compile_function(ctx, stream, node);
+            }
+        }
+    }
+    if (!pending) {
+        truncate_tree(&ctx->tree, lowest);
+    }
+}
+
+void cancel_stream(Context* ctx) {
+    // the held diagnostics are not counted yet
+    ctx->stream->nb_sections = 0;
+}
+
+int end_stream(Context* ctx) {
+    Stream* stream = ctx->stream;
+    for (int i = 0; i < stream->nb_pending && !stream->stopped; i++) {
+        compile_function(ctx, stream, stream->pending[i]);
+    }
+
+    fflush(stream->held);
+    qsort(stream->sections, stream->nb_sections, sizeof(HeldSection),
+          compare_sections);
+    report_sections(ctx, stream, HELD_DECLARATIONS, INT_MAX);
+    // main is looked for even after an error in a function, as for the
+    // whole tree
+    if (stream->stopped || !check_sem_end(ctx, &stream->globals, &stream->functions)) {
+        return 0;
+    }
+    report_sections(ctx, stream, HELD_UNUSED, INT_MAX);
+    report_sections(ctx, stream, HELD_CHECKS, stream->failed_at);
+    if (!stream->failed) {
+        // the used builtins are known once every call is
+        gen_nasm_end(ctx, &stream->functions);
+    }
+    return !stream->failed;
+}
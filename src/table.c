@@ -6,6 +6,7 @@
 
 #include "errors.h"
 #include "types.h"
+#include "walk.h"
 
 #define NB_BUILTIN 4
 #define CALL_OFFSET 16
@@ -20,6 +21,13 @@ typedef struct {        // structure for builtin function
     t_type param;       // parameter type
 } builtin;
 
+typedef struct {        // symbols seen by the body of a function
+    Table* globals;     // global variables
+    Function* fun;      // function, with its parameters and locals
+    FunctionCollection* collection;
+    int forward_calls;  // calls to functions not declared yet
+} Usage;
+
 // array of builtin
 static const builtin builtin_funcs[NB_BUILTIN] = {
     {.name = "getint",  .r_type = T_INT,  .param = T_VOID},
@@ -31,107 +39,135 @@ static const builtin builtin_funcs[NB_BUILTIN] = {
 /**
  * @brief Compute size of variable in bytes based on its type
  * 
+ * @param ctx compilation context
  * @param type value type
  * @param node declaration node
  * @return size in bytes
  */
-static int compute_size(t_type type, Node* node);
+static int compute_size(const Context* ctx, t_type type, node_t node);
 
 /**
  * @brief Create an entry strucutre that gives intels about a variable
  * 
+ * @param ctx compilation context
  * @param type type of variable
  * @param node node contains the variable name
  * @return created entry
  */
-static int init_entry(Entry* entry, t_type type, Node* node);
+static int init_entry(Context* ctx, Entry* entry, t_type type, node_t node);
 
 /**
  * @brief Allocate more memory for a table
  * 
+ * @param ctx compilation context
  * @param table table to realloc
  * @return 1 if success
  *         0 if fail due to memory error
  */
-static int realloc_table(Table* table);
+static int realloc_table(Context* ctx, Table* table);
+
+/**
+ * @brief Set the index of a function in the collection, to find it by its
+ *        name in constant time
+ * 
+ * @param ctx compilation context
+ * @param collection collection of the function
+ * @param name name of the function
+ * @param index index of the function in the collection
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+static int index_function(Context* ctx, FunctionCollection* collection,
+                          ident_t name, int index);
 
 /**
  * @brief Insert an entry in the table
  * 
+ * @param ctx compilation context
  * @param table table to insert
  * @param entry entry to be inserted
  * @return 1 if success
  *         0 if error due to memory error
  */
-static int insert_entry(Table* table, Entry entry, int new_address);
+static int insert_entry(Context* ctx, Table* table, Entry entry,
+                        int new_address);
 
 /**
  * @brief Assign to the given function its return type
  * 
+ * @param ctx compilation context
  * @param fun function to assign
  * @param node type node
  */
-static void assing_rtype(Function* fun, Node* node);
+static void assing_rtype(Context* ctx, Function* fun, node_t node);
 
 /**
  * @brief Initiate parameters lists from functions
  * 
+ * @param ctx compilation context
  * @param table table to store the parameters
  * @param node head node of the list
  * @return 1 if success
  *         0 if error due to memory error
  */
-static int init_param_list(Table* table, Node* node);
+static int init_param_list(Context* ctx, Table* table, node_t node);
 
 /**
  * @brief Create a structure for intels about functions
  * 
+ * @param ctx compilation context
  * @param node return type of function
  * @return created function
  */
-static int init_function(Function* fun, Node* node, Table* globals);
+static int init_function(Context* ctx, Function* fun, node_t node,
+                         Table* globals);
 
 /**
  * @brief Allocate more memory for a collection
  * 
+ * @param ctx compilation context
  * @param collection collection to re alloc
  * @return 1 if success
  *         0 if fail due to memory error 
  */
-static int realloc_collection(FunctionCollection* collection);
+static int realloc_collection(Context* ctx, FunctionCollection* collection);
 
 /**
  * @brief Insert function in collection
  * 
+ * @param ctx compilation context
  * @param collection collection to insert
  * @param fun function to insert
  * @return 1 if success
  *         0 if error due to memory error
  */
-static int insert_function(FunctionCollection* collection, Function fun);
+static int insert_function(Context* ctx, FunctionCollection* collection,
+                           Function fun);
 
 /**
  * @brief Initialise a variable collection of given type
  * 
+ * @param ctx compilation context
  * @param table table to store entries
  * @param type type of the following variables
  * @param node head node
  * @return 1 if success
  *         0 if fail due to memory error
  */
-static int decl_var(Table* table, FunctionCollection* coll, t_type type,
-                    Node* node, Table* parameters);
+static int decl_var(Context* ctx, Table* table, FunctionCollection* coll,
+                    t_type type, node_t node, Table* parameters);
 
 /**
  * @brief Initialise a collection of variables of differents types
  * 
+ * @param ctx compilation context
  * @param table table to store the variables
  * @param node head node
  * @return 1 if success
  *         0 if fail due to memory error
  */
-static int decl_vars(Table* table, FunctionCollection* coll, Node* node,
-                     Table* parameters);
+static int decl_vars(Context* ctx, Table* table, FunctionCollection* coll,
+                     node_t node, Table* parameters);
 
 /**
  * @brief Get the type object from its identifiant
@@ -139,62 +175,93 @@ static int decl_vars(Table* table, FunctionCollection* coll, Node* node,
  * @param ident type identifiant
  * @return type
  */
-static t_type get_type(char ident[IDENT_LEN]);
+static t_type get_type(const char* ident);
 
 /**
  * @brief Create a builtin function according to the given specification
  * 
+ * @param ctx compilation context
  * @param fun function to create
  * @param spe indications to create the function
  * @return 1 if success
  *         0 if fail due to memory error
  */
-static int create_builtin_function(Function* fun, builtin spe);
+static int create_builtin_function(Context* ctx, Function* fun, builtin spe);
 
 /**
  * @brief Create and insert all builtin functions
  * 
+ * @param ctx compilation context
  * @param coll collection to insert the functions
  * @return 1 if success
  *         0 if fail due to memory error
  */
-static int insert_builtin_functions(FunctionCollection* coll);
+static int insert_builtin_functions(Context* ctx, FunctionCollection* coll);
 
-int compare_entries(const void* entry1, const void* entry2) {
-    return strcmp(((Entry*)entry1)->name, ((Entry*)entry2)->name);
+/**
+ * @brief Check if the identifiers used by an instruction are declared, and
+ *        mark them as used. Visit of the walk over the body of a function
+ * 
+ * @param walk walk over the body, with the 'Usage' of the function
+ * @param frame frame of the visited node
+ * @return 0 in case of error else 1 if success
+ */
+static int check_used(Walk* walk, Frame* frame);
+
+/**
+ * @brief Create the symbol tables of a function and insert it in the
+ *        collection
+ * 
+ * @param ctx compilation context
+ * @param walk walk checking the use of the identifiers
+ * @param globals table for globals variables
+ * @param collection collection of functions
+ * @param node head node with the 'DeclFonct' label
+ * @param forward_calls set to the number of calls to functions which are
+ *                      not declared yet, if not NULL
+ * @return 1 if success
+ *         0 if fail due to memory error
+ */
+static int decl_function(Context* ctx, Walk* walk, Table* globals,
+                         FunctionCollection* collection, node_t node,
+                         int* forward_calls);
+
+/**
+ * @brief Compare 2 identifiers by their ids
+ */
+static int compare_idents(ident_t ident1, ident_t ident2) {
+    return (ident1 > ident2) - (ident1 < ident2);
 }
 
-int compare_functions(const void* fun1, const void* fun2) {
-    return strcmp(((Function*)fun1)->name, ((Function*)fun2)->name);
+int compare_entries(const void* entry1, const void* entry2) {
+    return compare_idents(((Entry*)entry1)->name, ((Entry*)entry2)->name);
 }
 
 int compare_ident_entry(const void* ident, const void* entry) {
-    return strcmp((char*)ident, ((Entry*)entry)->name);
+    return compare_idents(*(ident_t*)ident, ((Entry*)entry)->name);
 }
 
-int compare_ident_fun(const void* ident, const void* fun) {
-    return strcmp((char*)ident, ((Function*)fun)->name);
-}
 
-static int compute_size(t_type type, Node* node) {
+static int compute_size(const Context* ctx, t_type type, node_t node) {
     int size = 8; // size of int and char is on 8 bytes 
     int additionnal = 1;
-    if (is_array(node->type) && FIRSTCHILD(node)) {
-        additionnal = FIRSTCHILD(node)->val.num;
+    if (is_array(NODE_TYPE(ctx, node)) && FIRSTCHILD(ctx, node)) {
+        additionnal = NODE_VAL(ctx, FIRSTCHILD(ctx, node)).num;
     }
     return size*additionnal;
 }
 
-static int init_entry(Entry* entry, t_type type, Node* node) {
-    entry->decl_line = node->lineno;            // set declaration line
-    entry->decl_col = node->colno;              // set declaration colunm
+static int init_entry(Context* ctx, Entry* entry, t_type type, node_t node) {
+    entry->decl_line = NODE_LINENO(ctx, node);            // set declaration line
+    entry->decl_col = NODE_COLNO(ctx, node);              // set declaration colunm
     entry->is_used = false;                     // set as unused
-    entry->type = set_type(type, node->type);   // set its type
-    strcpy(entry->name, node->val.ident);       // set its name
+    entry->type = set_type(type, NODE_TYPE(ctx, node));   // set its type
+    entry->name = NODE_VAL(ctx, node).ident;              // set its name
 
-    entry->size = compute_size(type, node);     // variable size
+    entry->size = compute_size(ctx, type, node);     // variable size
     if (!entry->size) {
-        incorrect_array_decl(entry->name, node->lineno, node->colno);
+        incorrect_array_decl(ctx, ident_name(ctx, entry->name), NODE_LINENO(ctx, node),
+                             NODE_COLNO(ctx, node));
         return SEM_ERR;
     }
     entry->address = -1;                        // address to be known when
@@ -203,12 +270,12 @@ static int init_entry(Entry* entry, t_type type, Node* node) {
     return SEM_GOOD;
 }
 
-static int realloc_table(Table* table) {
+static int realloc_table(Context* ctx, Table* table) {
     int next_len = table->max_len + DEFAULT_LENGTH;
 
     Entry* temp = realloc(table->array, sizeof(Entry)*next_len);
     if (!temp) {
-        memory_error();
+        memory_error(ctx);
         return SEM_ERR;
     }
     table->array = temp;
@@ -216,21 +283,23 @@ static int realloc_table(Table* table) {
     return SEM_GOOD;
 }
 
-static int insert_entry(Table* table, Entry entry, int new_address) {
+static int insert_entry(Context* ctx, Table* table, Entry entry,
+                        int new_address) {
     if (!table) return SEM_ERR;
     int index;
 
     // check if an entry with the same name is already declared
     if ((index = is_in_table(table, entry.name)) != -1) {
         // trigger a semantic error of type 'already_declared'
-        already_declared_error(entry.name, entry.decl_line, entry.decl_col,
+        already_declared_error(ctx, ident_name(ctx, entry.name),
+                               entry.decl_line, entry.decl_col,
                                table->array[index].decl_col);
         return SEM_ERR;
     }
 
     // if there is no place remaining, realloc the array
     if (table->cur_len == table->max_len) {
-        if (!realloc_table(table)) return SEM_ERR;
+        if (!realloc_table(ctx, table)) return SEM_ERR;
     }
 
     // set the entry address
@@ -243,90 +312,89 @@ static int insert_entry(Table* table, Entry entry, int new_address) {
     return SEM_GOOD;
 }
 
-static void assing_rtype(Function* fun, Node* node) {
-    if (!strcmp(node->val.ident, "int")) {
+static void assing_rtype(Context* ctx, Function* fun, node_t node) {
+    const char* type = ident_name(ctx, NODE_VAL(ctx, node).ident);
+    if (!strcmp(type, "int")) {
         fun->r_type = T_INT;
-    } else if (!strcmp(node->val.ident, "char")) {
+    } else if (!strcmp(type, "char")) {
         fun->r_type = T_CHAR;
     } else {
         fun->r_type = T_VOID;
     }
 }
 
-static int init_param_list(Table* table, Node* node) {
-    if (!node) {
-        return SEM_GOOD;
-    }
-    
-    int new_address;
-    Entry entry;
-    t_type type = get_type(node->val.ident);
-    if (!init_entry(&entry, type, FIRSTCHILD(node))) {
-        return SEM_ERR;
-    }
+static int init_param_list(Context* ctx, Table* table, node_t node) {
+    // an error on a parameter after the first one is reported, but the
+    // function is still declared with the parameters before it
+    for (node_t head = node; node; node = NEXTSIBLING(ctx, node)) {
+        int new_address;
+        Entry entry;
+        t_type type = get_type(ident_name(ctx, NODE_VAL(ctx, node).ident));
+        if (!init_entry(ctx, &entry, type, FIRSTCHILD(ctx, node))) {
+            return node == head ? SEM_ERR : SEM_GOOD;
+        }
 
-    // According to AMD64 call convetions in nasm, the first 6-th parameters
-    // must be given to function using 6 registers. Any other parameters must be
-    // given using the stack.
-    // Parameters address's change to adapt them if they are before or after
-    // the stack saving register 'rbp'. When a function is called, there is
-    // a 16 bytes offset 'CALL_OFFSET'
-
-    if (table->cur_len < N_REG_PARAM) {
-        // parameters 1 to 6
-        new_address = table->total_bytes + entry.size;
-        table->offset += entry.size;
-    } else if (table->cur_len == N_REG_PARAM) {
-        // 6-th parameter
-        new_address = CALL_OFFSET;
-    } else {
-        // 7-th parameter and go on
-        new_address = table->array[table->cur_len - 1].address + entry.size;
-    }
+        // According to AMD64 call convetions in nasm, the first 6-th parameters
+        // must be given to function using 6 registers. Any other parameters must be
+        // given using the stack.
+        // Parameters address's change to adapt them if they are before or after
+        // the stack saving register 'rbp'. When a function is called, there is
+        // a 16 bytes offset 'CALL_OFFSET'
+
+        if (table->cur_len < N_REG_PARAM) {
+            // parameters 1 to 6
+            new_address = table->total_bytes + entry.size;
+            table->offset += entry.size;
+        } else if (table->cur_len == N_REG_PARAM) {
+            // 6-th parameter
+            new_address = CALL_OFFSET;
+        } else {
+            // 7-th parameter and go on
+            new_address = table->array[table->cur_len - 1].address + entry.size;
+        }
 
-    if (!insert_entry(table, entry, new_address)) {
-        return SEM_ERR;
+        if (!insert_entry(ctx, table, entry, new_address)) {
+            return node == head ? SEM_ERR : SEM_GOOD;
+        }
     }
-    
-    // initiate the next parameter
-    init_param_list(table, node->nextSibling);
     return SEM_GOOD;
 }
 
-static int init_function(Function* fun, Node* node, Table* globals) {
+static int init_function(Context* ctx, Function* fun, node_t node,
+                         Table* globals) {
     fun->is_used = false;                             // set function as unsused
-    fun->decl_line = node->lineno;                    // set declaration line
-    fun->decl_col = node->colno;                      // set declaration column
-    assing_rtype(fun, node);                          // set return type
-    strcpy(fun->name, node->nextSibling->val.ident);  // set name
+    fun->decl_line = NODE_LINENO(ctx, node);                    // set declaration line
+    fun->decl_col = NODE_COLNO(ctx, node);                      // set declaration column
+    assing_rtype(ctx, fun, node);                     // set return type
+    fun->name = NODE_VAL(ctx, NEXTSIBLING(ctx, node)).ident;         // set name
 
     int index;
     // check if a function or a global variable with the same name is already 
     // declared
     if ((index = is_in_table(globals, fun->name)) != -1) {
         // trigger a semantic error
-        already_declared_error(fun->name, fun->decl_line, fun->decl_col,
-                               globals->array[index].decl_line);
+        already_declared_error(ctx, ident_name(ctx, fun->name), fun->decl_line,
+                               fun->decl_col, globals->array[index].decl_line);
         return SEM_ERR;
     }
 
     // create table to store parameter entries
-    if (!init_table(&fun->parameters)) {
+    if (!init_table(ctx, &fun->parameters)) {
         // memory error while creating the parameters table
         return SEM_ERR;
     }
-    if (node->nextSibling->nextSibling->label == ListTypVar) {
+    if (NODE_LABEL(ctx, NEXTSIBLING(ctx, NEXTSIBLING(ctx, node))) == ListTypVar) {
         // insert parameter entries
-        if (!init_param_list(&fun->parameters,
-                             node->nextSibling->nextSibling->firstChild)) {
-            free(&fun->parameters);
+        if (!init_param_list(ctx, &fun->parameters,
+                             FIRSTCHILD(ctx, NEXTSIBLING(ctx, NEXTSIBLING(ctx, node))))) {
+            free_table(&fun->parameters);
             return SEM_ERR;
         }
     }
 
     // create table to store local entries
-    if (!init_table(&fun->locals)) {
-        free(fun->parameters.array);
+    if (!init_table(ctx, &fun->locals)) {
+        free_table(&fun->parameters);
         return SEM_ERR;
     }
 
@@ -335,13 +403,13 @@ static int init_function(Function* fun, Node* node, Table* globals) {
     return SEM_GOOD;
 }
 
-static int realloc_collection(FunctionCollection* collection) {
+static int realloc_collection(Context* ctx, FunctionCollection* collection) {
     int next_len = collection->max_len + DEFAULT_LENGTH;
 
     Function* temp = (Function*)realloc(collection->funcs,
                                         sizeof(Function)*next_len);
     if (!temp) {
-        memory_error();
+        memory_error(ctx);
         return SEM_ERR;
     }
 
@@ -351,22 +419,46 @@ static int realloc_collection(FunctionCollection* collection) {
     return SEM_GOOD;
 }
 
-static int insert_function(FunctionCollection* collection, Function fun) {
+static int index_function(Context* ctx, FunctionCollection* collection,
+                          ident_t name, int index) {
+    if (name >= collection->nb_indexes) {
+        int next_len = collection->nb_indexes*2 > name ? collection->nb_indexes*2
+                                                       : name + DEFAULT_LENGTH;
+        int* temp = realloc(collection->indexes, sizeof(int)*next_len);
+        if (!temp) {
+            memory_error(ctx);
+            return SEM_ERR;
+        }
+        for (int i = collection->nb_indexes; i < next_len; i++) {
+            temp[i] = -1;
+        }
+        collection->indexes = temp;
+        collection->nb_indexes = next_len;
+    }
+    collection->indexes[name] = index;
+    return SEM_GOOD;
+}
+
+static int insert_function(Context* ctx, FunctionCollection* collection,
+                           Function fun) {
     if (!collection) return SEM_ERR;
     int index;
     // check if a function with the same name is already declared
     if ((index = is_in_collection(collection, fun.name)) != -1) {
         // trigger a semantic error
-        already_declared_error(fun.name, fun.decl_line, fun.decl_col,
-                               collection->funcs[index].decl_line);
+        already_declared_error(ctx, ident_name(ctx, fun.name), fun.decl_line,
+                               fun.decl_col, collection->funcs[index].decl_line);
         return SEM_ERR;
     }
 
     if (collection->cur_len == collection->max_len) {
-        if (!realloc_collection(collection)) {
+        if (!realloc_collection(ctx, collection)) {
             return SEM_ERR;
         }
     }
+    if (!index_function(ctx, collection, fun.name, collection->cur_len)) {
+        return SEM_ERR;
+    }
 
     // update collection's data
     collection->funcs[collection->cur_len] = fun;
@@ -374,106 +466,111 @@ static int insert_function(FunctionCollection* collection, Function fun) {
     return SEM_GOOD;
 }
 
-static int decl_var(Table* table, FunctionCollection* coll, t_type type,
-                    Node* node, Table* parameters) {
-    if (!node) {
-        return SEM_GOOD;
-    }
-
-    Entry entry;
-    int index;
-    if (!init_entry(&entry, type, node)) {
-        return SEM_ERR;
-    }
-
-    // declare a local variable
-    if (parameters) {
-        // check if the local entry is already declared
-        if ((index = is_in_table(parameters, entry.name)) != -1) {
-            // trigger a semantic error
-            already_declared_error(entry.name, entry.decl_line, entry.decl_col,
-                                parameters->array[index].decl_line);
-            return SEM_ERR;
-        }
-        if (!insert_entry(table, entry, table->total_bytes)) {
-            return SEM_ERR;
-        }
-    } else { // declare a global variable
-        // check if the global variable is already declared
-        if ((index = is_in_collection(coll, entry.name)) != -1) {
-            // trigger a semantic error
-            redefinition_of_builtin_functions(entry.name, entry.decl_line,
-                                              entry.decl_col);
+static int decl_var(Context* ctx, Table* table, FunctionCollection* coll,
+                    t_type type, node_t node, Table* parameters) {
+    for (; node; node = NEXTSIBLING(ctx, node)) {
+        Entry entry;
+        int index;
+        if (!init_entry(ctx, &entry, type, node)) {
             return SEM_ERR;
         }
-        if (!insert_entry(table, entry, table->total_bytes)) {
-            return SEM_ERR;
+
+        // declare a local variable
+        if (parameters) {
+            // check if the local entry is already declared
+            if ((index = is_in_table(parameters, entry.name)) != -1) {
+                // trigger a semantic error
+                already_declared_error(ctx, ident_name(ctx, entry.name),
+                                       entry.decl_line, entry.decl_col,
+                                       parameters->array[index].decl_line);
+                return SEM_ERR;
+            }
+            if (!insert_entry(ctx, table, entry, table->total_bytes)) {
+                return SEM_ERR;
+            }
+        } else { // declare a global variable
+            // check if the global variable is already declared
+            if ((index = is_in_collection(coll, entry.name)) != -1) {
+                // trigger a semantic error
+                redefinition_of_builtin_functions(ctx, ident_name(ctx, entry.name),
+                                                  entry.decl_line, entry.decl_col);
+                return SEM_ERR;
+            }
+            if (!insert_entry(ctx, table, entry, table->total_bytes)) {
+                return SEM_ERR;
+            }
         }
     }
-    return decl_var(table, coll, type, node->nextSibling, parameters);
+    return SEM_GOOD;
 }
 
-static t_type get_type(char ident[IDENT_LEN]) {
+static t_type get_type(const char* ident) {
     if (!strcmp("int", ident)) return T_INT;
     return T_CHAR; 
 }
 
-static int decl_vars(Table* table, FunctionCollection* coll, Node* node,
-                     Table* parameters) {
-    if (!node) {
-        return SEM_GOOD;
-    }
-    t_type type = get_type(node->val.ident);
-    if (!decl_var(table, coll, type, FIRSTCHILD(node), parameters)) {
-        return SEM_ERR;
+static int decl_vars(Context* ctx, Table* table, FunctionCollection* coll,
+                     node_t node, Table* parameters) {
+    for (; node; node = NEXTSIBLING(ctx, node)) {
+        t_type type = get_type(ident_name(ctx, NODE_VAL(ctx, node).ident));
+        if (!decl_var(ctx, table, coll, type, FIRSTCHILD(ctx, node), parameters)) {
+            return SEM_ERR;
+        }
     }
-    return decl_vars(table, coll, node->nextSibling, parameters);
+    return SEM_GOOD;
 }
 
-static int check_used(Table* globals, Function* fun, FunctionCollection* coll,
-                      Node* node) {
-    if (!node) return SEM_GOOD;
-
-    if (node->label == Ident) {
+static int check_used(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    Usage* usage = walk->pass;
+    node_t node = frame->node;
+    if (frame->step) {
+        return SEM_GOOD; // children are checked
+    }
+    if (NODE_LABEL(ctx, node) == Ident) {
         // check if there is a child, so ident can whenever be an array or a function
-        if (FIRSTCHILD(node)) {
+        if (FIRSTCHILD(ctx, node)) {
             // definitively a function
-            if (FIRSTCHILD(node)->label == NoParametres || FIRSTCHILD(node)->label == ListExp) {
-                Function* f = get_function(coll, node->val.ident);
+            if (NODE_LABEL(ctx, FIRSTCHILD(ctx, node)) == NoParametres || NODE_LABEL(ctx, FIRSTCHILD(ctx, node)) == ListExp) {
+                Function* f = get_function(usage->collection, NODE_VAL(ctx, node).ident);
                 if (!f) {
-                    use_of_undeclare_symbol(WARNING, node->val.ident,
-                                            node->lineno, node->colno);
+                    usage->forward_calls++;
+                    use_of_undeclare_symbol(ctx, WARNING,
+                                            ident_name(ctx, NODE_VAL(ctx, node).ident),
+                                            NODE_LINENO(ctx, node), NODE_COLNO(ctx, node));
                 } else {
-                    if (f->decl_line != node->lineno) {
+                    if (f->decl_line != NODE_LINENO(ctx, node)) {
                         f->is_used = true;
                     }
                 }
+                // the following siblings are not checked either
+                break_list(walk);
                 return SEM_GOOD;
             }
         }
-        Entry* entry = find_entry(globals, fun, node->val.ident);
+        Entry* entry = find_entry(usage->globals, usage->fun, NODE_VAL(ctx, node).ident);
         if (!entry) {
-            use_of_undeclare_symbol(ERROR, node->val.ident, node->lineno,
-                                    node->colno);
+            use_of_undeclare_symbol(ctx, ERROR, ident_name(ctx, NODE_VAL(ctx, node).ident),
+                                    NODE_LINENO(ctx, node), NODE_COLNO(ctx, node));
             return SEM_ERR;
         }
-        if (entry->decl_line != node->lineno) {
+        if (entry->decl_line != NODE_LINENO(ctx, node)) {
             entry->is_used = true;
         }
     }
-    if (!check_used(globals, fun, coll, FIRSTCHILD(node))) return SEM_ERR;
-    return check_used(globals, fun, coll, node->nextSibling);
+    visit_list(walk, FIRSTCHILD(ctx, node));
+    return SEM_GOOD;
 }
 
-static int create_builtin_function(Function* fun, builtin spe) {
+static int create_builtin_function(Context* ctx, Function* fun, builtin spe) {
     // set function default value
     *fun = (Function){.decl_col = -1,
                       .decl_line = -1,
                       .is_used = false,
-                      .r_type = spe.r_type
+                      .r_type = spe.r_type,
+                      .name = intern(ctx, spe.name, strlen(spe.name))
                       };
-    strcpy(fun->name, spe.name);
-    if (!init_table(&fun->parameters)) {
+    if (fun->name == -1 || !init_table(ctx, &fun->parameters)) {
         return SEM_ERR;
     }
     if (spe.param != T_VOID) {
@@ -482,35 +579,36 @@ static int create_builtin_function(Function* fun, builtin spe) {
                               .decl_col = -1,
                               .decl_line = -1,
                               .is_used = true,
-                              .name = "arg",
+                              .name = intern(ctx, "arg", 3),
                               .size = 8,
                               .type = spe.param};
-        if (!insert_entry(&fun->parameters, entry, 0)) {
+        if (entry.name == -1
+            || !insert_entry(ctx, &fun->parameters, entry, 0)) {
             free_table(&fun->parameters);
             return SEM_ERR;
         }
     }
-    if (!init_table(&fun->locals)) {
+    if (!init_table(ctx, &fun->locals)) {
         free_table(&fun->parameters);
         return SEM_ERR;
     }
     return SEM_GOOD;
 }
 
-static int insert_builtin_functions(FunctionCollection* coll) {
+static int insert_builtin_functions(Context* ctx, FunctionCollection* coll) {
     for (int i = 0; i < NB_BUILTIN; i++) {
         Function fun;
-        if (!create_builtin_function(&fun, builtin_funcs[i])) {
+        if (!create_builtin_function(ctx, &fun, builtin_funcs[i])) {
             return SEM_ERR;
         }
-        if (!insert_function(coll, fun)) {
+        if (!insert_function(ctx, coll, fun)) {
             return SEM_ERR;
         }
     }
     return SEM_GOOD;
 }
 
-int init_table(Table* table) {
+int init_table(Context* ctx, Table* table) {
     if (!table) return SEM_ERR;
 
     // set table default values
@@ -521,7 +619,7 @@ int init_table(Table* table) {
 
     table->array = (Entry*)malloc(sizeof(Entry)*DEFAULT_LENGTH);
     if (!table->array) {
-        memory_error();
+        memory_error(ctx);
         table->max_len = 0;
         return SEM_ERR;
     }
@@ -529,11 +627,11 @@ int init_table(Table* table) {
     return SEM_GOOD;
 }
 
-int is_in_table(const Table* table, const char ident[IDENT_LEN]) {
+int is_in_table(const Table* table, ident_t ident) {
     if (!table || !table->cur_len) return -1;
 
     for (int i = 0; i < table->cur_len; i++) {
-        if (!strcmp(table->array[i].name, ident)) {
+        if (table->array[i].name == ident) {
             return i;
         }
     }
@@ -541,7 +639,7 @@ int is_in_table(const Table* table, const char ident[IDENT_LEN]) {
 }
 
 Entry* find_entry(const Table* globals, const Function* fun,
-                  const char ident[IDENT_LEN]) {
+                  ident_t ident) {
     Entry* entry;
 
     // check if the entry is known as a parameter, a local or a global variable
@@ -551,36 +649,37 @@ Entry* find_entry(const Table* globals, const Function* fun,
     return NULL;
 }
 
-Entry* get_entry(const Table* table, const char ident[IDENT_LEN]) {
+Entry* get_entry(const Table* table, ident_t ident) {
     if (!table || !table->cur_len) return NULL;
 
     // choose the fastest method to find an entry
     if (table->sorted) {
-        // uses stdlib bsearch function on lexical order
-        return bsearch(ident, table->array, table->cur_len, sizeof(Entry),
+        // uses stdlib bsearch function on identifiers ids
+        return bsearch(&ident, table->array, table->cur_len, sizeof(Entry),
                        compare_ident_entry);
     } 
     int index = is_in_table(table, ident);
     return index == -1 ? NULL: &(table->array[index]);
 }
 
-int init_function_collection(FunctionCollection* collection) {
+int init_function_collection(Context* ctx, FunctionCollection* collection) {
     if (!collection) return SEM_ERR;
 
     // collection default values
-    collection->sorted = false;
     collection->cur_len = 0;
+    collection->nb_indexes = 0;
+    collection->indexes = NULL;
 
     collection->funcs = (Function*)malloc(sizeof(Function)*DEFAULT_LENGTH);
     if (!collection->funcs) {
-        memory_error();
+        memory_error(ctx);
         collection->max_len = 0;
         return SEM_ERR;
     }
     collection->max_len = DEFAULT_LENGTH;
     
-    if (!insert_builtin_functions(collection)) {
-        memory_error();
+    if (!insert_builtin_functions(ctx, collection)) {
+        memory_error(ctx);
         free_collection(collection);
         return SEM_ERR;
     }
@@ -588,27 +687,13 @@ int init_function_collection(FunctionCollection* collection) {
 }
 
 int is_in_collection(const FunctionCollection* collection,
-                     const char ident[IDENT_LEN]) {
-    if (!collection || !collection->cur_len) return -1;
-
-    for (int i = 0; i < collection->cur_len; i++) {
-        if (!strcmp(collection->funcs[i].name, ident)) {
-            return i;
-        }
-    }
-    return -1;
+                     ident_t ident) {
+    if (!collection || ident < 0 || ident >= collection->nb_indexes) return -1;
+    return collection->indexes[ident];
 }
 
 Function* get_function(const FunctionCollection* collection,
-                       const char ident[IDENT_LEN]) {
-    if (!collection || !collection->cur_len) return NULL;
-    
-    // choose the fastest method to find an entry
-    if (collection->sorted) {
-        // uses stdlib bsearch function on lexical order
-        return bsearch(ident, collection->funcs, collection->cur_len,
-                       sizeof(Function), compare_ident_fun);
-    }
+                       ident_t ident) {
     int index = is_in_collection(collection, ident);
     return index == -1 ? NULL: &(collection->funcs[index]);
 }
@@ -618,92 +703,126 @@ void free_table(Table* table) {
     free(table->array); 
 }
 
+void free_function(Function* fun) {
+    if (!fun) return;
+    free_table(&fun->parameters);
+    free_table(&fun->locals);
+}
+
 void free_collection(FunctionCollection* collection) {
     if (!collection) return;
 
     for (int i = 0; i < collection->cur_len; i++) {
-        free(collection->funcs[i].parameters.array);
-        free(collection->funcs[i].locals.array);
+        free_function(&collection->funcs[i]);
     }
     free(collection->funcs);
+    free(collection->indexes);
 }
 
-int create_tables(Table* globals, FunctionCollection* collection, Node* node) {
+static int decl_function(Context* ctx, Walk* walk, Table* globals,
+                         FunctionCollection* collection, node_t node,
+                         int* forward_calls) {
+    Function fun;
+    if (!init_function(ctx, &fun, FIRSTCHILD(ctx, FIRSTCHILD(ctx, node)), globals)) {
+        return SEM_ERR;
+    }
+
+    node_t head_decl_vars = FIRSTCHILD(ctx, FIRSTCHILD(ctx, SECONDCHILD(ctx, node)));
+    // insert local entries
+    if (!decl_vars(ctx, &fun.locals, collection, head_decl_vars,
+                   &fun.parameters)) {
+        free_function(&fun);
+        return SEM_ERR;
+    }
+    // insert function in collection, which then owns its tables
+    if (!insert_function(ctx, collection, fun)) {
+        free_function(&fun);
+        return SEM_ERR;
+    }
+    // check if any of the variables are defined before being use
+    Usage usage = {.globals = globals, .collection = collection, .fun = &fun};
+    walk->pass = &usage;
+    int res = walk_tree(walk, SECONDCHILD(ctx, node));
+    if (forward_calls) {
+        *forward_calls = usage.forward_calls;
+    }
+    return res;
+}
+
+int create_tables(Context* ctx, Table* globals, FunctionCollection* collection,
+                  node_t node) {
     // main function to create symbol tables
-    static bool is_globals_done = false;
     if (!node) {
         return SEM_GOOD;
     }
 
-    int err;
-    // declaration of variables
-    if (node->label == DeclVars) {
-        // declaration of global variables
-        if (!is_globals_done) {
-            err = decl_vars(globals, collection, FIRSTCHILD(node), NULL);
-            is_globals_done = true;
-        } else {
-            err = decl_vars(&(collection->funcs[collection->cur_len - 1].locals),
-                            collection, FIRSTCHILD(node),
-                            &(collection->funcs[collection->cur_len - 1].parameters));
-        }
-        if (!err) return SEM_ERR;
-        return create_tables(globals, collection, node->nextSibling);
-    } else if (node->label == DeclFonct) { // declaration of function
-        Function fun;
-        if (!init_function(&fun, FIRSTCHILD(FIRSTCHILD(node)), globals)) {
-            return SEM_ERR;
-        }
+    // declaration of global variables
+    if (!create_globals_table(ctx, globals, collection, FIRSTCHILD(ctx, node))) {
+        return SEM_ERR;
+    }
 
-        Node* head_decl_vars = FIRSTCHILD(FIRSTCHILD(SECONDCHILD(node)));
-        // insert local entries
-        if (!decl_vars(&fun.locals, collection, head_decl_vars, &fun.parameters)) {
+    // declaration of functions, which share the stack of their walks
+    Walk walk;
+    init_walk(&walk, ctx, check_used, NULL);
+    node_t decl_fonct_node = FIRSTCHILD(ctx, SECONDCHILD(ctx, node));
+    for (; decl_fonct_node; decl_fonct_node = NEXTSIBLING(ctx, decl_fonct_node)) {
+        if (!decl_function(ctx, &walk, globals, collection, decl_fonct_node, NULL)) {
+            free_walk(&walk);
             return SEM_ERR;
         }
-        // insert function in collection
-        if (!insert_function(collection, fun)) {
-            return SEM_ERR;
-        }
-        // check if any of the variables are defined before being use
-        if (!check_used(globals, &fun, collection, SECONDCHILD(node))) {
-            return SEM_ERR;
-        }
-        return create_tables(globals, collection, node->nextSibling);
     }
-    // continue to parse the tree
-    return create_tables(globals, collection, FIRSTCHILD(node)) &&
-           create_tables(globals, collection, node->nextSibling);
+    free_walk(&walk);
+    return SEM_GOOD;
+}
+
+int create_globals_table(Context* ctx, Table* globals,
+                         FunctionCollection* collection, node_t node) {
+    return decl_vars(ctx, globals, collection, FIRSTCHILD(ctx, node), NULL);
 }
 
-void print_table(Table table) {
+int create_function_tables(Context* ctx, Table* globals,
+                           FunctionCollection* collection, node_t node,
+                           int* forward_calls) {
+    Walk walk;
+    init_walk(&walk, ctx, check_used, NULL);
+    int res = decl_function(ctx, &walk, globals, collection, node, forward_calls);
+    free_walk(&walk);
+    return res;
+}
+
+void print_table(const Context* ctx, Table table) {
     for (int i = 0; i < table.cur_len; i++) {
         printf("type: %4s | decl_line: %3d | size: %5d | array: %s | name: %s\n",
             table.array[i].type == T_INT ? "int": "char",
             table.array[i].decl_line, 
             table.array[i].size,
             is_array(table.array[i].type) ? "true": "false",
-            table.array[i].name);
+            ident_name(ctx, table.array[i].name));
     }
 }
 
-void print_collection(FunctionCollection collection) {
+void print_function(const Context* ctx, const Function* fun) {
+    t_type type = fun->r_type;
+    putchar('\n'); 
+    
+    printf("%s %s() - Parameters:\n",
+            type == T_INT ? "int" : (type == T_CHAR ? "char": "void"),
+            ident_name(ctx, fun->name));
+    
+    print_table(ctx, fun->parameters);
+
+    printf("%s %s() - Locals:\n",
+            type == T_INT ? "int" : (type == T_CHAR ? "char": "void"),
+            ident_name(ctx, fun->name));
+    print_table(ctx, fun->locals);
+}
+
+void print_collection(const Context* ctx, FunctionCollection collection) {
     for (int i = 0; i < collection.cur_len; i++) {
         // do not print builtin functions
         if (collection.funcs[i].decl_line == -1) {
             continue;
         }
-        t_type type = collection.funcs[i].r_type;
-        putchar('\n'); 
-        
-        printf("%s %s() - Parameters:\n",
-                type == T_INT ? "int" : (type == T_CHAR ? "char": "void"),
-                collection.funcs[i].name);
-        
-        print_table(collection.funcs[i].parameters);
-
-        printf("%s %s() - Locals:\n",
-                type == T_INT ? "int" : (type == T_CHAR ? "char": "void"),
-                collection.funcs[i].name);
-        print_table(collection.funcs[i].locals);
+        print_function(ctx, &collection.funcs[i]);
     }
 }
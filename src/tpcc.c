@@ -0,0 +1,203 @@
+#include "tpcc.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "arena.h"
+#include "cache.h"
+#include "dead_code.h"
+#include "errors.h"
+#include "gen_nasm.h"
+#include "intern.h"
+#include "parser.h"
+#include "sematic.h"
+#include "simplify.h"
+#include "stream.h"
+#include "table.h"
+#include "tree.h"
+
+/**
+ * @brief Check semantic of the tree and generate its nasm
+ * 
+ * @param ctx compilation context
+ * @param AST abstract tree of the program
+ * @param out_buf set to the generated nasm
+ * @return 0 if success
+ *         SEMANTIC_ERROR or OTHER_ERROR else
+ */
+static int compile_tree(Context* ctx, node_t AST, char** out_buf) {
+    // initiate structures to check semantic and generate nasm
+    int err_globals, err_functions;
+    Table globals;
+    FunctionCollection functions;
+    err_globals = init_table(ctx, &globals);
+    err_functions = init_function_collection(ctx, &functions);
+
+    // error while initiating structures for semantic
+    if (!err_functions || !err_globals) {
+        return OTHER_ERROR;
+    }
+    // error while filling symbol tables
+    if (!create_tables(ctx, &globals, &functions, AST)) {
+        free_collection(&functions);
+        free_table(&globals);
+        return SEMANTIC_ERROR;
+    }
+    // print symbol tables
+    if (ctx->print_symbols) {
+        puts("globals:");
+        print_table(ctx, globals);
+        print_collection(ctx, functions);
+    }
+    // generating nasm if sematic is correct
+    int res = 0;
+    if (check_sem(ctx, &globals, &functions, AST)) {
+        simplify_tree(ctx, AST);
+        size_t out_len;
+        FILE* out = NULL;
+        if (!eliminate_dead_tree(ctx, &functions, AST)
+            || !(out = open_memstream(out_buf, &out_len))) {
+            memory_error(ctx);
+            res = OTHER_ERROR;
+        } else {
+            gen_nasm(ctx, out, &globals, &functions, AST);
+            fclose(out);
+        }
+    }
+    // free allocated memory for semantic structures
+    free_collection(&functions);
+    free_table(&globals);
+    return res;
+}
+
+int tpcc_compile_buffer(Context* ctx, const char* src, size_t len,
+                        char** out_buf) {
+    *out_buf = NULL;
+
+    // the scanner needs a padded buffer it can write in
+    Source source;
+    if (!copy_source(&source, src, len)) {
+        memory_error(ctx);
+        return OTHER_ERROR;
+    }
+    int res = tpcc_compile_source(ctx, &source, out_buf);
+    free_source(&source);
+    return res;
+}
+
+/**
+ * @brief Parse a source and compile its tree, whose identifiers are
+ *        allocated in the arena of the context
+ * 
+ * @param ctx compilation context
+ * @param source source code
+ * @param out_buf set to the generated nasm
+ * @return 0 if success
+ *         SYNTAX_ERROR, SEMANTIC_ERROR or OTHER_ERROR else
+ */
+static int compile_source(Context* ctx, Source* source, char** out_buf) {
+    if (ctx->print_tokens && !print_tokens(ctx, source)) {
+        memory_error(ctx);
+        return OTHER_ERROR;
+    }
+    // parsing input
+    node_t AST = NO_NODE;
+    if (parse_source(ctx, source, &AST)) {
+        if (ctx->stream) {
+            cancel_stream(ctx);
+        }
+        return SYNTAX_ERROR;
+    }
+    // functions were compiled while parsing, only the fix-up is left
+    if (ctx->stream) {
+        if (!end_stream(ctx)) {
+            return SEMANTIC_ERROR;
+        }
+        return fatal_error(ctx) ? SEMANTIC_ERROR: 0;
+    }
+    // print tree if no error
+    if (ctx->print_tree) {
+        printTree(ctx, AST);
+    }
+
+    // input was correctly parsed, proceed to the next step
+    int res = compile_tree(ctx, AST, out_buf);
+    if (res) {
+        return res;
+    }
+    return fatal_error(ctx) ? SEMANTIC_ERROR: 0;
+}
+
+/**
+ * @brief Parse a source and compile each function as soon as it is parsed
+ * 
+ * @param ctx compilation context
+ * @param source source code
+ * @param out nasm target
+ * @return 0 if success
+ *         SYNTAX_ERROR, SEMANTIC_ERROR or OTHER_ERROR else
+ */
+static int stream_source(Context* ctx, Source* source, FILE* out) {
+    // the collection interns the names of the builtins in the arena
+    Stream stream;
+    if (!init_stream(ctx, &stream, out)) {
+        return OTHER_ERROR;
+    }
+    char* out_buf = NULL;
+    ctx->stream = &stream;
+    int res = compile_source(ctx, source, &out_buf);
+    ctx->stream = NULL;
+    free_stream(&stream);
+    return res;
+}
+
+/**
+ * @brief Compile a source in the arena of the context, or in a temporary
+ *        one, then free the tree and its identifiers
+ * 
+ * @param ctx compilation context
+ * @param source source code
+ * @param out_buf set to the generated nasm, if not streamed
+ * @param out nasm target if streamed, else NULL
+ * @return 0 if success
+ *         SYNTAX_ERROR, SEMANTIC_ERROR or OTHER_ERROR else
+ */
+static int compile_in_arena(Context* ctx, Source* source, char** out_buf,
+                            FILE* out) {
+    // use a temporary arena if the caller does not give one to reuse
+    Arena arena;
+    bool own_arena = !ctx->arena;
+    if (own_arena) {
+        init_arena(&arena);
+        ctx->arena = &arena;
+    }
+
+    int res = out ? stream_source(ctx, source, out)
+                  : compile_source(ctx, source, out_buf);
+    close_cache(ctx, !res);
+
+    // the whole tree and its identifiers are freed at once
+    ctx->stats.arena_bytes = ctx->arena->bytes;
+    ctx->stats.arena_chunks = ctx->arena->nb_chunks;
+    ctx->stats.tree_nodes = ctx->tree.nb_nodes ? ctx->tree.nb_nodes - 1: 0;
+    ctx->stats.tree_bytes = tree_bytes(&ctx->tree);
+    free_tree(&ctx->tree);
+    free_intern_table(&ctx->idents);
+    if (own_arena) {
+        free_arena(&arena);
+        ctx->arena = NULL;
+    } else {
+        reset_arena(ctx->arena);
+    }
+    return res;
+}
+
+int tpcc_compile_source(Context* ctx, Source* source, char** out_buf) {
+    *out_buf = NULL;
+    return compile_in_arena(ctx, source, out_buf, NULL);
+}
+
+int tpcc_compile_stream(Context* ctx, Source* source, FILE* out) {
+    return compile_in_arena(ctx, source, NULL, out);
+}
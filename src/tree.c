@@ -2,10 +2,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "context.h"
 #include "tree.h"
-
-extern int lineno;       // from lexer
-extern int colno;        // from lexer
+#include "walk.h"
 
 static const char *StringFromLabel[] = {
     [If] = "if",
@@ -44,112 +43,205 @@ static const char *StringFromLabel[] = {
     [EmptyInstr] = "empty_instr"
 };
 
-Node *makeNode(label_t label) {
-    Node *node = malloc(sizeof(Node));
-    if (!node) {
-        printf("Run out of memory\n");
-        exit(3);
+/**
+ * @brief Grow the columns of a tree. Columns keep their nodes, even if
+ *        one of them cannot grow
+ * 
+ * @param t tree to grow
+ * @param max_nodes new capacity
+ * @return 0 if it runs out of memory, 1 otherwise
+ */
+static int grow_tree(Tree* t, node_t max_nodes) {
+    void* column;
+    if (!(column = realloc(t->labels, max_nodes * sizeof(*t->labels)))) return 0;
+    t->labels = column;
+    if (!(column = realloc(t->types, max_nodes * sizeof(*t->types)))) return 0;
+    t->types = column;
+    if (!(column = realloc(t->vals, max_nodes * sizeof(*t->vals)))) return 0;
+    t->vals = column;
+    if (!(column = realloc(t->linenos, max_nodes * sizeof(*t->linenos)))) return 0;
+    t->linenos = column;
+    if (!(column = realloc(t->colnos, max_nodes * sizeof(*t->colnos)))) return 0;
+    t->colnos = column;
+    if (!(column = realloc(t->first_children, max_nodes * sizeof(*t->first_children)))) return 0;
+    t->first_children = column;
+    if (!(column = realloc(t->next_siblings, max_nodes * sizeof(*t->next_siblings)))) return 0;
+    t->next_siblings = column;
+    if (!(column = realloc(t->last_siblings, max_nodes * sizeof(*t->last_siblings)))) return 0;
+    t->last_siblings = column;
+    t->max_nodes = max_nodes;
+    return 1;
+}
+
+int init_tree(Tree* t, size_t len) {
+    // a node takes about four characters of the source
+    *t = (Tree){0};
+    if (!grow_tree(t, len / 4 + 64)) {
+        free_tree(t);
+        return 0;
     }
-    node->label = label;
-    node->firstChild = node->nextSibling = NULL;
-    node->lineno = lineno;
-    node->colno = colno;
-    node->type = T_NONE;
-    return node;
+    // NO_NODE has neither child nor sibling
+    t->first_children[NO_NODE] = t->next_siblings[NO_NODE] = NO_NODE;
+    t->last_siblings[NO_NODE] = NO_NODE;
+    t->nb_nodes = 1;
+    return 1;
 }
 
-Node *makeNodeWithValue(Value val, label_t label) {
-    Node *node = malloc(sizeof(Node));
-    if (!node) {
+void free_tree(Tree* t) {
+    free(t->labels);
+    free(t->types);
+    free(t->vals);
+    free(t->linenos);
+    free(t->colnos);
+    free(t->first_children);
+    free(t->next_siblings);
+    free(t->last_siblings);
+    *t = (Tree){0};
+}
+
+void truncate_tree(Tree* t, node_t nb_nodes) {
+    // new nodes set all their columns, so freed ones are not cleared
+    if (nb_nodes > NO_NODE && nb_nodes < t->nb_nodes) {
+        t->nb_nodes = nb_nodes;
+    }
+}
+
+size_t tree_bytes(const Tree* t) {
+    return (size_t)t->max_nodes * (sizeof(*t->labels) + sizeof(*t->types)
+                                   + sizeof(*t->vals) + sizeof(*t->linenos)
+                                   + sizeof(*t->colnos) + 3 * sizeof(node_t));
+}
+
+node_t makeNodeWithValue(Context* ctx, Value val, label_t label) {
+    Tree* t = &ctx->tree;
+    if (t->nb_nodes == t->max_nodes
+        && (t->max_nodes > UINT32_MAX / 2 || !grow_tree(t, t->max_nodes * 2))) {
         printf("Run out of memory\n");
         exit(3);
     }
-    node->label = label;
-    node->val = val;
-    node->firstChild = node->nextSibling = NULL;
-    node->lineno = lineno;
-    node->colno = colno;
-    node->type = T_NONE;
+    node_t node = t->nb_nodes++;
+    t->labels[node] = label;
+    t->types[node] = T_NONE;
+    t->vals[node] = val;
+    t->linenos[node] = ctx->lineno;
+    t->colnos[node] = ctx->colno;
+    t->first_children[node] = t->next_siblings[node] = NO_NODE;
+    t->last_siblings[node] = NO_NODE;
     return node;
 }
 
-void setAsArray(Node* node) {
-    node->type = T_ARRAY;
+node_t makeNode(Context* ctx, label_t label) {
+    return makeNodeWithValue(ctx, (Value){0}, label);
 }
 
-void addSibling(Node *node, Node *sibling) {
-    Node *curr = node;
-    while (curr->nextSibling != NULL) {
-        curr = curr->nextSibling;
+void setAsArray(Context* ctx, node_t node) {
+    NODE_TYPE(ctx, node) = T_ARRAY;
+}
+
+/**
+ * @brief Find the last node of a sibling chain, starting from the tail
+ *        cached by its head. The cache may be late if nodes were appended
+ *        through a previous node of the chain, so it is updated
+ * 
+ * @param t tree of the chain
+ * @param node head of the chain
+ * @return last node of the chain
+ */
+static node_t lastOfChain(Tree* t, node_t node) {
+    node_t curr = t->last_siblings[node] ? t->last_siblings[node]: node;
+    while (t->next_siblings[curr] != NO_NODE) {
+        curr = t->next_siblings[curr];
     }
-    curr->nextSibling = sibling;
+    t->last_siblings[node] = curr;
+    return curr;
 }
 
-void addChild(Node *parent, Node *child) {
-    if (parent->firstChild == NULL) {
-        parent->firstChild = child;
+void addSibling(Context* ctx, node_t node, node_t sibling) {
+    Tree* t = &ctx->tree;
+    t->next_siblings[lastOfChain(t, node)] = sibling;
+    t->last_siblings[node] = lastOfChain(t, sibling);
+}
+
+void addChild(Context* ctx, node_t parent, node_t child) {
+    if (FIRSTCHILD(ctx, parent) == NO_NODE) {
+        FIRSTCHILD(ctx, parent) = child;
     }
     else {
-        addSibling(parent->firstChild, child);
+        addSibling(ctx, FIRSTCHILD(ctx, parent), child);
     }
 }
 
-void deleteTree(Node *node) {
-    if (!node) {
-        return;
-    }
-    if (node->firstChild) {
-        deleteTree(node->firstChild);
-    }
-    if (node->nextSibling) {
-        deleteTree(node->nextSibling);
-    }
-    free(node);
+void replaceNode(Context* ctx, node_t node, node_t by) {
+    NODE_LABEL(ctx, node) = NODE_LABEL(ctx, by);
+    NODE_VAL(ctx, node) = NODE_VAL(ctx, by);
+    FIRSTCHILD(ctx, node) = FIRSTCHILD(ctx, by);
 }
 
 /**
  * @brief Fonction display the value of a node
  * 
+ * @param ctx compilation context, which gives identifiers names
  * @param node 
  */
-static void printNode(Node* node) {
-    switch (node->label) {
+static void printNode(Context* ctx, node_t node) {
+    switch (NODE_LABEL(ctx, node)) {
         case Num:
-            printf("%d (Num)", node->val.num);
+            printf("%d (Num)", NODE_VAL(ctx, node).num);
             break;
         case Character:
-            printf("%s (Character)", node->val.ident);
+            printf("%s (Character)", ident_name(ctx, NODE_VAL(ctx, node).ident));
             break;
         case Ident: case Type: case Or: case And:
         case Eq: case Order: case DivStar: case AddSub:
         case Negation: case Assignation:
-            printf("%s (%s)", node->val.ident, StringFromLabel[node->label]);
+            printf("%s (%s)", ident_name(ctx, NODE_VAL(ctx, node).ident),
+                   StringFromLabel[NODE_LABEL(ctx, node)]);
             break;
         default:
-            printf("%s", StringFromLabel[node->label]);
+            printf("%s", StringFromLabel[NODE_LABEL(ctx, node)]);
             break;
     }
-    if (is_array(node->type)) {
+    if (is_array(NODE_TYPE(ctx, node))) {
         puts("[]");
     } else {
         putchar('\n');
     }
 }
 
-void printTree(Node *node) {
-    static bool rightmost[128]; // tells if node is rightmost sibling
-    static int depth = 0;       // depth of current node
-    for (int i = 1; i < depth; i++) { // 2502 = vertical line
-        printf(rightmost[i] ? "    " : "\u2502   ");
+/**
+ * @brief Display a node, after the branches leading to it from the root.
+ *        Visit of the walk printing the tree
+ * 
+ * @param walk walk printing the tree, whose frames are the ancestors of the
+ *             node
+ * @param frame frame of the node
+ * @return 1
+ */
+static int printSubTree(Walk* walk, Frame* frame) {
+    Context* ctx = walk->ctx;
+    if (frame->step) {
+        return 1; // children are displayed
     }
-    if (depth > 0) { // 2514 = L form; 2500 = horizontal line; 251c = vertical line and right horiz 
-        printf(rightmost[depth] ? "\u2514\u2500\u2500 " : "\u251c\u2500\u2500 ");
+    // frames of the lists of siblings are between the frames of the nodes
+    int depth = 0;
+    for (int i = 0; i < walk->depth - 1; i++) {
+        if (walk->frames[i].list) continue;
+        if (depth > 0) { // 2502 = vertical line
+            printf(NEXTSIBLING(ctx, walk->frames[i].node) ? "\u2502   " : "    ");
+        }
+        depth++;
     }
-    printNode(node);
-    depth++;
-    for (Node *child = node->firstChild; child != NULL; child = child->nextSibling) {
-        rightmost[depth] = (child->nextSibling) ? false : true;
-        printTree(child);
+    if (depth > 0) { // 2514 = L form; 2500 = horizontal line; 251c = vertical line and right horiz 
+        printf(NEXTSIBLING(ctx, frame->node) ? "\u251c\u2500\u2500 " : "\u2514\u2500\u2500 ");
     }
-    depth--;
+    printNode(ctx, frame->node);
+    visit_list(walk, FIRSTCHILD(ctx, frame->node));
+    return 1;
+}
+
+void printTree(Context* ctx, node_t node) {
+    Walk walk;
+    init_walk(&walk, ctx, printSubTree, NULL);
+    walk_tree(&walk, node);
+    free_walk(&walk);
 }
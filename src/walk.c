@@ -0,0 +1,115 @@
+#include "walk.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define INIT_DEPTH 64
+
+/**
+ * @brief Push a frame on the stack of a walk, growing it if needed
+ *
+ * @param walk
+ * @param node visited node, or first node of the list
+ * @param list if the frame visits a list of siblings
+ */
+static void push_frame(Walk* walk, node_t node, bool list);
+
+static void push_frame(Walk* walk, node_t node, bool list) {
+    if (walk->depth == walk->max_depth) {
+        int max_depth = walk->max_depth ? walk->max_depth * 2: INIT_DEPTH;
+        Frame* frames = realloc(walk->frames, max_depth * sizeof(Frame));
+        if (!frames) {
+            printf("Run out of memory\n");
+            exit(3);
+        }
+        walk->frames = frames;
+        walk->max_depth = max_depth;
+    }
+    walk->frames[walk->depth++] = (Frame){.node = node, .list = list};
+}
+
+void init_walk(Walk* walk, Context* ctx, Visit visit, void* pass) {
+    *walk = (Walk){.ctx = ctx, .visit = visit, .pass = pass};
+}
+
+void free_walk(Walk* walk) {
+    free(walk->frames);
+    walk->frames = NULL;
+    walk->depth = walk->max_depth = 0;
+}
+
+int walk_tree(Walk* walk, node_t first) {
+    walk->depth = 0;
+    push_frame(walk, first, true);
+    while (walk->depth) {
+        Frame* frame = &walk->frames[walk->depth - 1];
+        if (frame->list) {
+            // visit the next node of the list, or end it
+            node_t node = frame->node;
+            if (!node) {
+                walk->depth--;
+                continue;
+            }
+            frame->node = NEXTSIBLING(walk->ctx, node);
+            push_frame(walk, node, false);
+            continue;
+        }
+
+        walk->schedule = SCHEDULE_NONE;
+        if (!walk->visit(walk, frame)) {
+            return 0;
+        }
+        // frames are pushed after the step, so frame is still valid here
+        frame->step++;
+        node_t node = walk->scheduled;
+        switch (walk->schedule) {
+            case SCHEDULE_NONE:
+                walk->depth--;
+                break;
+            case SCHEDULE_BREAK:
+                walk->depth--;
+                if (walk->depth && walk->frames[walk->depth - 1].list) {
+                    walk->depth--;
+                }
+                break;
+            case SCHEDULE_NODE:
+                if (node) {
+                    push_frame(walk, node, false);
+                }
+                break;
+            case SCHEDULE_LIST:
+                push_frame(walk, node, true);
+                break;
+            case SCHEDULE_REVERSED_LIST:
+                // the last pushed node is the first one visited
+                for (; node; node = NEXTSIBLING(walk->ctx, node)) {
+                    push_frame(walk, node, false);
+                }
+                break;
+        }
+    }
+    return 1;
+}
+
+void visit_node(Walk* walk, node_t node) {
+    walk->schedule = SCHEDULE_NODE;
+    walk->scheduled = node;
+}
+
+void visit_list(Walk* walk, node_t first) {
+    walk->schedule = SCHEDULE_LIST;
+    walk->scheduled = first;
+}
+
+void visit_reversed_list(Walk* walk, node_t first) {
+    walk->schedule = SCHEDULE_REVERSED_LIST;
+    walk->scheduled = first;
+}
+
+void break_list(Walk* walk) {
+    walk->schedule = SCHEDULE_BREAK;
+}
+
+bool visit_scheduled(const Walk* walk) {
+    return walk->schedule != SCHEDULE_NONE && walk->schedule != SCHEDULE_BREAK;
+}